@@ -1,6 +1,7 @@
 #pragma once
 
 #include "imodule.h"
+#include <sigc++/signal.h>
 
 namespace map
 {
@@ -29,6 +30,15 @@ public:
     // for the currently loaded map, regardless whether it is due for a save or not.
     // Call the "runAutosaveCheck" method to see if an autosave is overdue.
     virtual void performAutosave() = 0;
+
+    // The map is captured in memory when an automatic save is performed, the files
+    // are then written to disk in the background. This method blocks until any
+    // pending background save has finished, reporting errors if there are any.
+    virtual void finishPendingSave() = 0;
+
+    // Signal emitted while an automatic save is written to disk, passing the
+    // progress fraction in the range [0..1]. Might be emitted from any thread.
+    virtual sigc::signal<void(float)>& signal_saveProgress() = 0;
 };
 
 constexpr const char* const RKEY_AUTOSAVE_SNAPSHOTS_ENABLED = "user/ui/map/autoSaveSnapshots";
@@ -36,6 +46,10 @@ constexpr const char* const RKEY_AUTOSAVE_SNAPSHOTS_FOLDER = "user/ui/map/snapsh
 constexpr const char* const RKEY_AUTOSAVE_MAX_SNAPSHOT_FOLDER_SIZE = "user/ui/map/maxSnapshotFolderSize";
 constexpr const char* const RKEY_AUTOSAVE_SNAPSHOT_FOLDER_SIZE_HISTORY = "user/ui/map/snapshotFolderSizeHistory";
 
+// If enabled, the regular (non-snapshot) autosave only appends the changes to a journal
+// next to the autosave file, which is merged into the file when the map is loaded again
+constexpr const char* const RKEY_AUTOSAVE_JOURNAL_ENABLED = "user/ui/map/autoSaveJournal";
+
 }
 
 constexpr const char* const MODULE_AUTOSAVER("AutomaticMapSaver");
@@ -13,6 +13,9 @@ class Plane3;
 
 const std::string RKEY_ENABLE_TEXTURE_LOCK("user/ui/brush/textureLock");
 
+// The implementation used to classify winding points against planes: "auto", "avx2", "sse2" or "scalar"
+const std::string RKEY_BRUSH_PLANE_KERNEL("user/ui/brush/planeKernel");
+
 namespace brush
 {
 
@@ -316,6 +319,9 @@ public:
 
 	// Method used internally to recalculate the brush windings
 	virtual void evaluateBRep() const = 0;
+
+	// Returns true if the face planes changed since the last B-rep evaluation
+	virtual bool needsBRepEvaluation() const = 0;
 };
 
 // Forward-declare the Brush object, only accessible from main binary
@@ -136,6 +136,19 @@ public:
     }
 };
 
+/// Counters of the file lookups performed by the VFS since it has been initialised
+struct LookupStatistics
+{
+    /// Number of lookups resolved through the archive index
+    std::size_t indexHits = 0;
+
+    /// Number of lookups resolved by a loose file in a directory
+    std::size_t directoryHits = 0;
+
+    /// Number of lookups which didn't find the file
+    std::size_t misses = 0;
+};
+
 /**
  * Main interface for the virtual filesystem.
  *
@@ -232,6 +245,9 @@ public:
     // Gets the file info structure for the given VFS file.
     // The info structure will be empty if the file was not located in the current VFS tree
     virtual vfs::FileInfo getFileInfo(const std::string& vfsRelativePath) = 0;
+
+    // Returns the lookup counters, to measure how many requests are served by the archive index
+    virtual LookupStatistics getLookupStatistics() const = 0;
 };
 
 }
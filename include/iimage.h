@@ -3,6 +3,8 @@
 #include "igl.h"
 #include "imodule.h"
 
+#include <vector>
+
 typedef unsigned char byte;
 
 class Texture;
@@ -111,11 +113,36 @@ public:
      */
     virtual ImagePtr imageFromVFS(const std::string& vfsPath) const = 0;
 
+    /**
+     * \brief
+     * Returns the VFS path of the file imageFromVFS() would load for the given
+     * name, including prefix and extension, or an empty string if there is no
+     * matching file.
+     */
+    virtual std::string findImageInVFS(const std::string& vfsPath) const = 0;
+
     /**
      * \brief
      * Load an image from a filesystem path.
      */
     virtual ImagePtr imageFromFile(const std::string& filename) const = 0;
+
+    /**
+     * \brief
+     * Load a batch of images from VFS paths, decoding them concurrently.
+     *
+     * The returned vector holds one image per requested path, in the same
+     * order. Images which could not be loaded are represented by an empty
+     * pointer.
+     */
+    virtual std::vector<ImagePtr> imagesFromVFS(const std::vector<std::string>& vfsPaths) const = 0;
+
+    /**
+     * \brief
+     * Load a batch of images from filesystem paths, decoding them concurrently.
+     * The result is ordered like the imagesFromVFS() one.
+     */
+    virtual std::vector<ImagePtr> imagesFromFiles(const std::vector<std::string>& filenames) const = 0;
 };
 
 const char* const MODULE_IMAGELOADER("ImageLoader");
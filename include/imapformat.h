@@ -53,6 +53,16 @@ public:
      * Creates and returns a primitive node according to the encountered token.
      */
     virtual scene::INodePtr parse(parser::DefTokeniser& tok) const = 0;
+
+    /**
+     * Returns true if parse() may be called from a worker thread. Parsers that need
+     * to access the material manager or the render system (e.g. to look up image
+     * dimensions) must return false, map readers will parse on the main thread then.
+     */
+    virtual bool canParseOnWorkerThread() const
+    {
+        return true;
+    }
 };
 typedef std::shared_ptr<PrimitiveParser> PrimitiveParserPtr;
 
@@ -120,6 +130,21 @@ public:
     // Patch export methods
     virtual void beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream) = 0;
     virtual void endWritePatch(const IPatchNodePtr& patch, std::ostream& stream) = 0;
+
+    /**
+     * Optional: creates an independent writer used to export a single top-level
+     * entity including its primitives (or a sequence of primitives not belonging
+     * to any entity) to a separate stream, possibly on a worker thread.
+     * The returned writer must produce the same output as this writer would,
+     * after writing <entityNumber> entities up to and including endWriteEntity().
+     *
+     * Writers returning an empty pointer (the default) are always
+     * called in scene traversal order on the calling thread.
+     */
+    virtual std::shared_ptr<IMapWriter> createEntityWriter(std::size_t entityNumber)
+    {
+        return std::shared_ptr<IMapWriter>();
+    }
 };
 typedef std::shared_ptr<IMapWriter> IMapWriterPtr;
 
@@ -278,6 +303,12 @@ typedef std::shared_ptr<IMapFormatManager> IMapFormatManagerPtr;
 // Portable Map Format Name is used across module boundaries
 const char* const PORTABLE_MAP_FORMAT_NAME("Portable");
 
+// If enabled, map readers may parse the entity blocks on several threads
+constexpr const char* const RKEY_MAP_PARALLEL_LOADING = "user/ui/map/parallelLoading";
+
+// If enabled, the map exporter lets supporting map writers serialise entities on several threads
+constexpr const char* const RKEY_MAP_PARALLEL_SAVING = "user/ui/map/parallelSaving";
+
 } // namespace map
 
 const char* const MODULE_MAPFORMATMANAGER("MapFormatManager");
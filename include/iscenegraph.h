@@ -84,6 +84,18 @@ public:
 	// A specific node has changed its bounds
 	virtual void nodeBoundsChanged(const scene::INodePtr& node) = 0;
 
+	/**
+	 * Starts collecting the nodes passed to nodeBoundsChanged() instead of
+	 * updating the space partition right away. The collected nodes are relinked
+	 * in one batch before the next volume traversal, or when endBoundsChangeBatch()
+	 * is called. This is used during manipulations, where lots of nodes are
+	 * changing their bounds at once. Calls are not nested.
+	 */
+	virtual void beginBoundsChangeBatch() = 0;
+
+	// Relinks all collected nodes and returns to updating the space partition immediately
+	virtual void endBoundsChangeBatch() = 0;
+
 	// A walker class to be used in "foreachNodeInVolume"
 	class Walker
 	{
@@ -129,6 +141,49 @@ public:
 };
 typedef std::shared_ptr<Cloneable> CloneablePtr;
 
+namespace detail
+{
+	inline bool& sceneNotificationsSuppressed()
+	{
+		thread_local bool suppressed = false;
+		return suppressed;
+	}
+}
+
+// Returns true if scene change notifications are suppressed on the calling thread
+inline bool sceneNotificationsSuppressed()
+{
+	return detail::sceneNotificationsSuppressed();
+}
+
+/**
+ * While an instance of this class is alive, SceneChangeNotify() and the
+ * texture change signals of brushes and patches are not sent from the
+ * calling thread. This is used when nodes are constructed outside the
+ * scene on worker threads; the code doing so is responsible for sending
+ * a single notification from the main thread afterwards.
+ */
+class ScopedSceneNotificationSuppressor
+{
+private:
+	bool _previous;
+
+public:
+	ScopedSceneNotificationSuppressor() :
+		_previous(detail::sceneNotificationsSuppressed())
+	{
+		detail::sceneNotificationsSuppressed() = true;
+	}
+
+	~ScopedSceneNotificationSuppressor()
+	{
+		detail::sceneNotificationsSuppressed() = _previous;
+	}
+
+	ScopedSceneNotificationSuppressor(const ScopedSceneNotificationSuppressor&) = delete;
+	ScopedSceneNotificationSuppressor& operator=(const ScopedSceneNotificationSuppressor&) = delete;
+};
+
 } // namespace
 
 // Accessor to the singleton scenegraph, used for the main map
@@ -140,5 +195,8 @@ inline scene::Graph& GlobalSceneGraph()
 
 inline void SceneChangeNotify()
 {
-	GlobalSceneGraph().sceneChanged();
+	if (!scene::sceneNotificationsSuppressed())
+	{
+		GlobalSceneGraph().sceneChanged();
+	}
 }
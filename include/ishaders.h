@@ -530,6 +530,50 @@ public:
     virtual float getValue(float index) = 0;
 };
 
+/// Progress of the textures being loaded in the background and their memory usage
+struct TextureStreamingStatistics
+{
+    /// Number of textures waiting to be decoded or being decoded
+    std::size_t pendingDecodes = 0;
+
+    /// Number of decoded textures waiting to be uploaded to OpenGL
+    std::size_t pendingUploads = 0;
+
+    /// Number of streamed textures currently uploaded
+    std::size_t uploadedTextures = 0;
+
+    /// Estimated video memory used by the uploaded textures, in bytes
+    std::size_t textureMemory = 0;
+
+    /// The configured texture memory budget in bytes, 0 if unlimited
+    std::size_t textureMemoryBudget = 0;
+
+    /// Number of textures which have been released to stay within the budget
+    std::size_t evictedTextures = 0;
+};
+
+/**
+ * Downscaled version of a material's editor image, stored in a texture atlas.
+ * Used by the texture browsers to draw previews without loading the full
+ * resolution images.
+ */
+struct MaterialThumbnail
+{
+    /// GL texture number of the atlas page, 0 while the thumbnail is not available
+    GLuint textureNum = 0;
+
+    /// Texture coordinates of the thumbnail's corners within the atlas page
+    float s0 = 0, t0 = 0;
+    float s1 = 0, t1 = 0;
+
+    /// Dimensions of the full resolution editor image, 0 while they're unknown
+    std::size_t imageWidth = 0;
+    std::size_t imageHeight = 0;
+
+    /// True if the editor image could not be loaded, such that no thumbnail will ever be available
+    bool failed = false;
+};
+
 constexpr const char* const MODULE_SHADERSYSTEM = "MaterialManager";
 
 /**
@@ -651,6 +695,44 @@ public:
 
     // Reload the textures used by the active shaders
     virtual void reloadImages() = 0;
+
+    /**
+     * Uploads the textures which have been decoded in the background, as long
+     * as the per-frame time budget allows. Needs to be called with an active
+     * GL context, usually at the start of a frame. Returns true if there are
+     * still textures waiting to be decoded or uploaded, i.e. another frame
+     * should be drawn to show them.
+     */
+    virtual bool processTextureUploads() = 0;
+
+    // Returns the current state of the background texture loading
+    virtual TextureStreamingStatistics getTextureStreamingStatistics() = 0;
+
+    /**
+     * Returns the thumbnail of the given material's editor image, as drawn by
+     * the given view (e.g. a texture browser). Missing thumbnails are generated
+     * in the background, or loaded from the on-disk thumbnail cache, and
+     * uploaded by processTextureUploads(). The atlas location is only valid
+     * until the next processTextureUploads() call.
+     */
+    virtual MaterialThumbnail getMaterialThumbnail(const std::string& materialName, const void* view) = 0;
+
+    /**
+     * Returns the thumbnail of the given material if it has been requested
+     * before, without generating it. Can be used to get the image dimensions
+     * of materials which are not drawn.
+     */
+    virtual MaterialThumbnail findMaterialThumbnail(const std::string& materialName) = 0;
+
+    /**
+     * Starts drawing a new frame in the given view. The thumbnails a view has
+     * requested in its current or previous frame are kept in the atlas, the
+     * least recently drawn other ones are dropped when it runs out of space.
+     */
+    virtual void beginThumbnailFrame(const void* view) = 0;
+
+    // To be called when a view drawing thumbnails is destroyed
+    virtual void releaseThumbnailView(const void* view) = 0;
 };
 
 inline IMaterialManager& GlobalMaterialManager()
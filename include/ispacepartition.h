@@ -1,16 +1,23 @@
 #ifndef _ISPACE_PARTITION_H_
 #define _ISPACE_PARTITION_H_
 
-#include <list>
+#include <functional>
 #include <vector>
 #include "imodule.h"
 
 // Forward declaration
 class AABB;
+class VolumeTest;
 
 namespace scene
 {
 
+/**
+ * Registry key selecting the space partition implementation used by the scenegraph,
+ * valid values are "octree" (the default) and "aabbtree" (a dynamic bounding volume tree).
+ */
+const char* const RKEY_SPACE_PARTITION_TYPE = "user/ui/scenegraph/spacePartition";
+
 // Some forward declarations to avoid including all the headers
 class INode;
 typedef std::shared_ptr<INode> INodePtr;
@@ -44,7 +51,7 @@ public:
 	typedef std::vector<ISPNodePtr> NodeList;
 
 	// The members
-	typedef std::list<INodePtr> MemberList;
+	typedef std::vector<INodePtr> MemberList;
 
 	// Get the parent node (can be NULL for the root node)
 	virtual ISPNodePtr getParent() const = 0;
@@ -52,7 +59,7 @@ public:
 	// The maximum bounds of this node
 	virtual const AABB& getBounds() const = 0;
 
-	// The child nodes of this node (either 8 or 0)
+	// The child nodes of this node (8 or 0 for the octree)
 	virtual const NodeList& getChildNodes() const = 0;
 
 	// Returns true if no more child nodes are below this one
@@ -75,10 +82,16 @@ typedef std::shared_ptr<ISPNode> ISPNodePtr;
  * Note: It's not allowed to call link() for nodes which are already linked into the tree.
  * It's safe to call unlink() for any node at any time, even multiple times in a row.
  * The unlink() method will return true if the node had been linked before.
+ *
+ * The tree returned by getRoot() is meant for inspection and debug visualisation,
+ * scene traversal is using foreachMemberInVolume() which is considerably faster.
  */
 class ISpacePartitionSystem
 {
 public:
+	// Visitor function invoked for the members, return false to stop traversal
+	using MemberVisitor = std::function<bool(const INodePtr&)>;
+
 	virtual ~ISpacePartitionSystem() {}
 
 	// Links this node into the SP tree. Returns the node it ends up being associated with
@@ -88,6 +101,15 @@ public:
 	// (node had been linked before)
 	virtual bool unlink(const scene::INodePtr& sceneNode) = 0;
 
+	// Moves the given nodes to the places matching their current bounds.
+	// Nodes which are not linked into the tree are ignored.
+	virtual void relink(const std::vector<scene::INodePtr>& sceneNodes) = 0;
+
+	// Invokes the visitor for every member of those SP nodes intersecting the given volume
+	// (the members of the root node are always visited). Returns false if the visitor
+	// returned false, which stops the traversal immediately.
+	virtual bool foreachMemberInVolume(const VolumeTest& volume, const MemberVisitor& visitor) const = 0;
+
 	// Returns the root node of this SP tree (the largest one, encompassing everything)
 	virtual ISPNodePtr getRoot() const = 0;
 };
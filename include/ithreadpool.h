@@ -0,0 +1,250 @@
+#pragma once
+
+#include "imodule.h"
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+
+namespace threading
+{
+
+enum class TaskPriority
+{
+    High,       // Work somebody is actively waiting for
+    Normal,     // Default priority
+    Low,        // Background work which is only processed if nothing else is queued
+};
+
+// Thrown by TaskFuture::get() if the task has been cancelled before it was run
+class TaskCancelledException :
+    public std::runtime_error
+{
+public:
+    TaskCancelledException() :
+        std::runtime_error("Task has been cancelled")
+    {}
+};
+
+/**
+ * Handle to a task scheduled on the thread pool.
+ */
+class ITask
+{
+public:
+    virtual ~ITask() {}
+
+    // True if the task has been run (successfully or not) or has been cancelled
+    virtual bool isFinished() const = 0;
+
+    // True if the task has been cancelled before it could be run
+    virtual bool isCancelled() const = 0;
+
+    // Requests the task to be cancelled. A task which has not been started yet
+    // will not be run at all, running tasks can check IThreadPool::isCancellationRequested()
+    // to stop early. Returns true if the task has been prevented from running.
+    virtual bool cancel() = 0;
+
+    // Blocks until the task is finished. If no worker has picked up the task yet,
+    // it is executed by the calling thread, such that waiting tasks cannot starve
+    // the pool. Rethrows any exception which escaped the task function.
+    virtual void wait() = 0;
+};
+typedef std::shared_ptr<ITask> ITaskPtr;
+
+/**
+ * Shared pool of worker threads executing tasks in the background.
+ *
+ * Every worker has its own queue, tasks scheduled from within a running task
+ * are put into the queue of the current worker. Idle workers are taking tasks
+ * from the shared queues first, then they're stealing from the other workers.
+ * Tasks of low priority are only processed if nothing else is left to do.
+ *
+ * Long-running background operations should prefer the pool over spawning
+ * threads on their own, to not oversubscribe the available cores.
+ */
+class IThreadPool :
+    public RegisterableModule
+{
+public:
+    using TaskFunction = std::function<void()>;
+    using IndexFunction = std::function<void(std::size_t)>;
+
+    virtual ~IThreadPool() {}
+
+    // Returns the number of worker threads in this pool
+    virtual std::size_t getNumWorkers() const = 0;
+
+    // Schedules the given function for execution, returning the handle to wait for it
+    virtual ITaskPtr schedule(const TaskFunction& function, TaskPriority priority = TaskPriority::Normal) = 0;
+
+    // Returns true if the task executed by the calling thread has been cancelled.
+    // Returns false if the calling thread is not executing any task.
+    virtual bool isCancellationRequested() const = 0;
+
+    /**
+     * Invokes the function for every index in the range [begin, end), distributing
+     * the work across the pool. The calling thread is processing indices too, the call
+     * returns when all indices have been processed. The grain size is the number of
+     * consecutive indices processed at once, a value of 0 chooses it automatically.
+     * If the function throws, the remaining indices are skipped and the exception is
+     * rethrown to the caller.
+     */
+    virtual void parallelFor(std::size_t begin, std::size_t end, const IndexFunction& function,
+        std::size_t grainSize = 0) = 0;
+};
+
+/**
+ * Result of a task scheduled through runAsync(), similar to std::shared_future.
+ */
+template<typename ReturnType>
+class TaskFuture
+{
+private:
+    ITaskPtr _task;
+    std::shared_ptr<std::optional<ReturnType>> _result;
+
+public:
+    TaskFuture()
+    {}
+
+    TaskFuture(const ITaskPtr& task, const std::shared_ptr<std::optional<ReturnType>>& result) :
+        _task(task),
+        _result(result)
+    {}
+
+    // True if this future refers to a task
+    bool valid() const
+    {
+        return static_cast<bool>(_task);
+    }
+
+    bool isReady() const
+    {
+        return _task->isFinished();
+    }
+
+    void wait() const
+    {
+        _task->wait();
+    }
+
+    // Waits for the task and returns its result
+    const ReturnType& get() const
+    {
+        _task->wait();
+
+        if (!_result->has_value())
+        {
+            throw TaskCancelledException();
+        }
+
+        return **_result;
+    }
+
+    bool cancel()
+    {
+        return _task->cancel();
+    }
+
+    const ITaskPtr& getTask() const
+    {
+        return _task;
+    }
+};
+
+template<>
+class TaskFuture<void>
+{
+private:
+    ITaskPtr _task;
+
+public:
+    TaskFuture()
+    {}
+
+    TaskFuture(const ITaskPtr& task) :
+        _task(task)
+    {}
+
+    bool valid() const
+    {
+        return static_cast<bool>(_task);
+    }
+
+    bool isReady() const
+    {
+        return _task->isFinished();
+    }
+
+    void wait() const
+    {
+        _task->wait();
+    }
+
+    void get() const
+    {
+        _task->wait();
+
+        if (_task->isCancelled())
+        {
+            throw TaskCancelledException();
+        }
+    }
+
+    bool cancel()
+    {
+        return _task->cancel();
+    }
+
+    const ITaskPtr& getTask() const
+    {
+        return _task;
+    }
+};
+
+}
+
+const char* const MODULE_THREADPOOL("ThreadPool");
+
+inline threading::IThreadPool& GlobalThreadPool()
+{
+    static module::InstanceReference<threading::IThreadPool> _reference(MODULE_THREADPOOL);
+    return _reference;
+}
+
+namespace threading
+{
+
+/**
+ * Schedules the given function on the shared thread pool,
+ * the returned future provides access to its return value.
+ */
+template<typename Function>
+TaskFuture<std::invoke_result_t<Function&>> runAsync(Function function, TaskPriority priority = TaskPriority::Normal)
+{
+    using ReturnType = std::invoke_result_t<Function&>;
+
+    // std::function needs a copyable target, this allows for move-only lambdas
+    auto sharedFunction = std::make_shared<Function>(std::move(function));
+
+    if constexpr (std::is_void_v<ReturnType>)
+    {
+        return TaskFuture<void>(GlobalThreadPool().schedule([sharedFunction]() { (*sharedFunction)(); }, priority));
+    }
+    else
+    {
+        auto result = std::make_shared<std::optional<ReturnType>>();
+
+        auto task = GlobalThreadPool().schedule([result, sharedFunction]()
+        {
+            result->emplace((*sharedFunction)());
+        }, priority);
+
+        return TaskFuture<ReturnType>(task, result);
+    }
+}
+
+}
@@ -6,6 +6,7 @@
 #include "imodule.h"
 #include "imap.h"
 #include <cstddef>
+#include <iosfwd>
 #include <memory>
 #include <sigc++/signal.h>
 
@@ -18,6 +19,28 @@ class IUndoMemento
 {
 public:
     virtual ~IUndoMemento() {}
+
+    // The approximate number of bytes held by this memento, used to keep the undo
+    // history within its memory budget. Data shared with other mementos is not included.
+    virtual std::size_t getMemoryUsage() const
+    {
+        return 0;
+    }
+
+    /**
+     * Mementos holding plain values can move them out of memory while they are
+     * sitting deep in the undo history. saveData() writes the values to the given
+     * stream and releases them, loadData() reads them back before the memento
+     * is imported again. Mementos referencing live objects (like scene nodes)
+     * can't do this and return false.
+     */
+    virtual bool saveData(std::ostream& stream)
+    {
+        return false;
+    }
+
+    virtual void loadData(std::istream& stream)
+    {}
 };
 typedef std::shared_ptr<IUndoMemento> IUndoMementoPtr;
 
@@ -69,8 +92,9 @@ public:
     using Ptr = std::shared_ptr<IUndoSystem>;
 
 	// Undoable objects need to call this to get hold of a StateSaver instance
-	// which will take care of exporting and saving the state.
-    virtual IUndoStateSaver* getStateSaver(IUndoable& undoable) = 0;
+	// which will take care of exporting and saving the state. Undoables belonging
+	// to a scene node pass it along (nullptr otherwise), see signal_nodeChanged().
+    virtual IUndoStateSaver* getStateSaver(IUndoable& undoable, scene::INode* node) = 0;
 	virtual void releaseStateSaver(IUndoable& undoable) = 0;
 
 	virtual void start() = 0;
@@ -86,6 +110,15 @@ public:
 	// it immediately from the stack, therefore it never existed.
 	virtual void cancel() = 0;
 
+    struct MemoryUsage
+    {
+        std::size_t inMemory = 0;   // bytes held in RAM, compressed operations included
+        std::size_t onDisk = 0;     // bytes moved to the temporary file
+    };
+
+    // Returns the (approximate) amount of memory taken by the undo and redo history
+    virtual MemoryUsage getMemoryUsage() const = 0;
+
     enum class EventType
     {
         OperationRecorded,
@@ -99,6 +132,17 @@ public:
      * as arguments. Except for AllOperationsCleared, which will have an empty name argument.
      */
     virtual sigc::signal<void(EventType, const std::string&)>& signal_undoEvent() = 0;
+
+    /**
+     * Emitted when an undoable submits its state to the operation being recorded,
+     * undone or redone, passing the scene node the undoable has been connected for.
+     * The argument is nullptr if the undoable doesn't belong to a node. The node
+     * pointer is only guaranteed to be valid during the signal emission.
+     *
+     * This can be used to find the parts of the scene that have been changed
+     * since a certain point in time.
+     */
+    virtual sigc::signal<void(scene::INode*)>& signal_nodeChanged() = 0;
 };
 
 class IUndoSystemFactory :
@@ -24,6 +24,7 @@ struct StandardPosition
         OrthoViewPosition = 40,
         ShaderClipboard = 50,
         MapEditStopwatch = 60,
+        UndoMemory = 70,
         Back = 9000,
     };
 };
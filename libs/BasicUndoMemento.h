@@ -1,6 +1,8 @@
 #pragma once
 
 #include "iundo.h"
+#include "UndoMementoData.h"
+#include "UndoMementoArena.h"
 
 namespace undo
 {
@@ -23,6 +25,36 @@ public:
 	{
 		return _data;
 	}
+
+	std::size_t getMemoryUsage() const override
+	{
+		return sizeof(*this) + getHeapMemoryUsage(_data);
+	}
+
+	// Only strings (like entity key values) can be moved out of memory,
+	// other types are either tiny or referencing scene objects
+	bool saveData(std::ostream& stream) override
+	{
+		if constexpr (std::is_same_v<Copyable, std::string>)
+		{
+			// Nothing to gain for short strings stored inline
+			if (getHeapMemoryUsage(_data) == 0) return false;
+
+			writeString(stream, _data);
+			releaseMemory(_data);
+			return true;
+		}
+
+		return false;
+	}
+
+	void loadData(std::istream& stream) override
+	{
+		if constexpr (std::is_same_v<Copyable, std::string>)
+		{
+			readString(stream, _data);
+		}
+	}
 };
 
 } // namespace
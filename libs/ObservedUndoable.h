@@ -35,9 +35,9 @@ public:
 		_debugName(debugName)
 	{}
 
-	void connectUndoSystem(IUndoSystem& undoSystem)
+	void connectUndoSystem(IUndoSystem& undoSystem, scene::INode* node)
 	{
-		_undoStateSaver = undoSystem.getStateSaver(*this);
+		_undoStateSaver = undoSystem.getStateSaver(*this, node);
 	}
 
     void disconnectUndoSystem(IUndoSystem& undoSystem)
@@ -69,7 +69,7 @@ public:
 
 	IUndoMementoPtr exportState() const override
 	{
-		return IUndoMementoPtr(new BasicUndoMemento<Copyable>(_object));
+		return allocateMemento<BasicUndoMemento<Copyable>>(_object);
 	}
 
 	void importState(const IUndoMementoPtr& state) override
@@ -4,6 +4,8 @@
 #include "iimage.h"
 #include "BasicTexture2D.h"
 #include <memory>
+#include <vector>
+#include <algorithm>
 #include "util/Noncopyable.h"
 #include "debugging/gl.h"
 
@@ -73,10 +75,25 @@ public:
             format = GL_RG8;
         }
 
-        // Download image and set up mipmaps and filtering
-        glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
-        gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGBA, static_cast<GLint>(getWidth()),
-                          static_cast<GLint>(getHeight()), GL_RGBA, GL_UNSIGNED_BYTE, getPixels());
+        // Upload the full-size level only and let the driver calculate the mipmap
+        // chain. Non-power-of-two images are uploaded as they are, there's no need
+        // to rescale them on the CPU first.
+        auto maxTextureSize = getMaxTextureSize();
+
+        if (_width > maxTextureSize || _height > maxTextureSize)
+        {
+            auto reduced = getReducedPixels(maxTextureSize);
+
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, static_cast<GLsizei>(reduced.width),
+                static_cast<GLsizei>(reduced.height), 0, GL_RGBA, GL_UNSIGNED_BYTE, reduced.pixels.data());
+        }
+        else
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, static_cast<GLsizei>(_width),
+                static_cast<GLsizei>(_height), 0, GL_RGBA, GL_UNSIGNED_BYTE, getPixels());
+        }
+
+        glGenerateMipmap(GL_TEXTURE_2D);
 
         // Un-bind the texture
 		glBindTexture(GL_TEXTURE_2D, 0);
@@ -95,6 +112,62 @@ public:
 	{
 		return false; // not compressed
 	}
+
+private:
+    struct ReducedPixels
+    {
+        std::size_t width;
+        std::size_t height;
+        std::vector<RGBAPixel> pixels;
+    };
+
+    static std::size_t getMaxTextureSize()
+    {
+        GLint maxTextureSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
+        return maxTextureSize > 0 ? static_cast<std::size_t>(maxTextureSize) : 1024;
+    }
+
+    // Halves the image dimensions using a box filter until both fit the given size
+    ReducedPixels getReducedPixels(std::size_t maxSize) const
+    {
+        ReducedPixels result{ _width, _height, std::vector<RGBAPixel>(pixels, pixels + _width * _height) };
+
+        while (result.width > maxSize || result.height > maxSize)
+        {
+            auto width = std::max<std::size_t>(result.width / 2, 1);
+            auto height = std::max<std::size_t>(result.height / 2, 1);
+
+            // Odd or single-pixel dimensions are clamped to the last row or column
+            auto stepX = result.width > 1 ? 1 : 0;
+            auto stepY = result.height > 1 ? result.width : 0;
+
+            std::vector<RGBAPixel> reduced(width * height);
+
+            for (std::size_t y = 0; y < height; ++y)
+            {
+                const auto* row = result.pixels.data() + y * 2 * result.width;
+                auto* out = reduced.data() + y * width;
+
+                for (std::size_t x = 0; x < width; ++x)
+                {
+                    const auto* p = row + x * 2;
+
+                    out[x].red = static_cast<uint8_t>((p[0].red + p[stepX].red + p[stepY].red + p[stepX + stepY].red + 2) >> 2);
+                    out[x].green = static_cast<uint8_t>((p[0].green + p[stepX].green + p[stepY].green + p[stepX + stepY].green + 2) >> 2);
+                    out[x].blue = static_cast<uint8_t>((p[0].blue + p[stepX].blue + p[stepY].blue + p[stepX + stepY].blue + 2) >> 2);
+                    out[x].alpha = static_cast<uint8_t>((p[0].alpha + p[stepX].alpha + p[stepY].alpha + p[stepX + stepY].alpha + 2) >> 2);
+                }
+            }
+
+            result.width = width;
+            result.height = height;
+            result.pixels = std::move(reduced);
+        }
+
+        return result;
+    }
 };
 typedef std::shared_ptr<RGBAImage> RGBAImagePtr;
 
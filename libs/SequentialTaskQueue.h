@@ -3,14 +3,15 @@
 #include <mutex>
 #include <list>
 #include <functional>
-#include <future>
+
+#include "ithreadpool.h"
 
 namespace util
 {
 
 /**
  * Queueing helper, allowing to run queued tasks one after the other,
- * each of which will be run asynchronously (by means of std::async).
+ * each of which will be run asynchronously on the shared thread pool.
  * No task will be started before a previous one is completed.
  *
  * Destroying this object will remove all unstarted tasks from the queue,
@@ -23,8 +24,8 @@ private:
     std::list<std::function<void()>> _queue;
 
     mutable std::recursive_mutex _currentLock;
-    std::future<void> _current;
-    std::future<void> _finished;
+    threading::TaskFuture<void> _current;
+    threading::TaskFuture<void> _finished;
 
 public:
     ~SequentialTaskQueue()
@@ -62,15 +63,39 @@ public:
     {
         clearPendingTasks();
 
-        _current = std::future<void>();
-        _finished = std::future<void>();
+        threading::TaskFuture<void> current;
+        threading::TaskFuture<void> finished;
+
+        {
+            std::lock_guard<std::recursive_mutex> lock(_currentLock);
+            current = std::move(_current);
+            finished = std::move(_finished);
+        }
+
+        // Wait outside the lock, the running task needs it to finish
+        waitFor(current);
+        waitFor(finished);
     }
 
 private:
     bool isIdle() const
     {
         std::lock_guard<std::recursive_mutex> lock(_currentLock);
-        return !_current.valid() || _current.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        return !_current.valid() || _current.isReady();
+    }
+
+    static void waitFor(const threading::TaskFuture<void>& task)
+    {
+        if (!task.valid()) return;
+
+        try
+        {
+            task.wait();
+        }
+        catch (...)
+        {
+            // Exceptions of the task are not of interest here
+        }
     }
 
     std::function<void()> dequeueOne()
@@ -100,7 +125,7 @@ private:
 
         // Wrap the given task in our own lambda to start the next task right afterwards
         std::lock_guard<std::recursive_mutex> lock(_currentLock);
-        _current = std::async(std::launch::async, [this, task]()
+        _current = threading::runAsync([this, task]()
         {
             task();
 
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include "util/Noncopyable.h"
+
+namespace undo
+{
+
+/**
+ * Bump allocator for the mementos recorded by a single undo operation.
+ * Memory is handed out from blocks and never freed individually, all
+ * blocks are released at once when the arena is destroyed. Most operations
+ * only record a few mementos, the first block is small and the following
+ * ones double in size up to a maximum.
+ *
+ * The arena is reference counted: the operation holds one reference and
+ * every allocation another one, which is returned when the memento's
+ * shared_ptr control block is deallocated. It is therefore safe to hold
+ * on to a memento after its operation has been dropped.
+ *
+ * Allocations are not thread-safe, an arena must only be used by the thread
+ * recording the operation.
+ */
+class MementoArena final :
+    public util::Noncopyable
+{
+private:
+    static constexpr std::size_t InitialBlockSize = 512;
+    static constexpr std::size_t MaxBlockSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> _blocks;
+
+    char* _current;
+    std::size_t _remaining;
+    std::size_t _capacity;
+    std::size_t _used;
+    std::size_t _nextBlockSize;
+
+    std::atomic<std::size_t> _refCount;
+
+    // The number of arenas alive in this module
+    static inline std::atomic<std::size_t> _numInstances{ 0 };
+
+    MementoArena() :
+        _current(nullptr),
+        _remaining(0),
+        _capacity(0),
+        _used(0),
+        _nextBlockSize(InitialBlockSize),
+        _refCount(1)
+    {
+        _numInstances.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~MementoArena()
+    {
+        _numInstances.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+public:
+    struct Releaser
+    {
+        void operator()(MementoArena* arena) const
+        {
+            arena->releaseReference();
+        }
+    };
+
+    using Ptr = std::unique_ptr<MementoArena, Releaser>;
+
+    // Creates a new arena, the returned pointer is holding the first reference
+    static Ptr Create()
+    {
+        return Ptr(new MementoArena);
+    }
+
+    void addReference()
+    {
+        _refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void releaseReference()
+    {
+        if (_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete this;
+        }
+    }
+
+    void* allocate(std::size_t size, std::size_t alignment)
+    {
+        auto padding = (alignment - reinterpret_cast<std::uintptr_t>(_current) % alignment) % alignment;
+
+        if (_current == nullptr || padding + size > _remaining)
+        {
+            // Allocations not fitting into a regular block get a block of their own
+            auto blockSize = std::max(_nextBlockSize, size + alignment);
+            _nextBlockSize = std::min(_nextBlockSize * 2, MaxBlockSize);
+
+            _blocks.emplace_back(new char[blockSize]);
+            _current = _blocks.back().get();
+            _remaining = blockSize;
+            _capacity += blockSize;
+
+            padding = (alignment - reinterpret_cast<std::uintptr_t>(_current) % alignment) % alignment;
+        }
+
+        auto result = _current + padding;
+
+        _current += padding + size;
+        _remaining -= padding + size;
+        _used += padding + size;
+
+        return result;
+    }
+
+    // The number of references held by the operation and the allocations
+    std::size_t getReferenceCount() const
+    {
+        return _refCount.load(std::memory_order_relaxed);
+    }
+
+    // The number of arenas that have not been released yet, for diagnostics
+    static std::size_t GetNumInstances()
+    {
+        return _numInstances.load(std::memory_order_relaxed);
+    }
+
+    // The number of bytes allocated for this arena's blocks
+    std::size_t getCapacity() const
+    {
+        return _capacity;
+    }
+
+    // The number of bytes in the blocks which haven't been handed out, including the ones
+    // left at the end of previous blocks when an allocation didn't fit anymore
+    std::size_t getUnusedCapacity() const
+    {
+        return _capacity - _used;
+    }
+};
+
+// Standard allocator handing out memory from a MementoArena. Every allocation
+// holds a reference to the arena, deallocation just gives it back.
+template<typename T>
+class ArenaAllocator
+{
+private:
+    MementoArena* _arena;
+
+    template<typename U> friend class ArenaAllocator;
+
+public:
+    using value_type = T;
+
+    ArenaAllocator(MementoArena& arena) :
+        _arena(&arena)
+    {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) :
+        _arena(other._arena)
+    {}
+
+    T* allocate(std::size_t n)
+    {
+        auto memory = _arena->allocate(n * sizeof(T), alignof(T));
+        _arena->addReference();
+
+        return static_cast<T*>(memory);
+    }
+
+    void deallocate(T*, std::size_t)
+    {
+        _arena->releaseReference();
+    }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const
+    {
+        return _arena == other._arena;
+    }
+
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const
+    {
+        return _arena != other._arena;
+    }
+};
+
+namespace detail
+{
+    inline MementoArena*& activeArena()
+    {
+        thread_local MementoArena* arena = nullptr;
+        return arena;
+    }
+}
+
+/**
+ * Makes the given arena the one used by allocateMemento() on this thread,
+ * the undo system is activating the arena of an operation while it's
+ * recording the state of an undoable.
+ */
+class ScopedMementoArena final :
+    public util::Noncopyable
+{
+private:
+    MementoArena* _previous;
+
+public:
+    ScopedMementoArena(MementoArena& arena) :
+        _previous(detail::activeArena())
+    {
+        detail::activeArena() = &arena;
+    }
+
+    ~ScopedMementoArena()
+    {
+        detail::activeArena() = _previous;
+    }
+};
+
+/**
+ * Creates a memento of the given type, to be used by IUndoable::exportState().
+ * The memento and its control block are allocated from the arena of the operation
+ * being recorded, or on the heap if there is none.
+ *
+ * Don't use this for mementos the undoable keeps a weak reference to: the weak
+ * reference would keep the whole arena alive.
+ */
+template<typename MementoType, typename... Args>
+inline std::shared_ptr<MementoType> allocateMemento(Args&&... args)
+{
+    if (auto arena = detail::activeArena(); arena != nullptr)
+    {
+        return std::allocate_shared<MementoType>(ArenaAllocator<MementoType>(*arena), std::forward<Args>(args)...);
+    }
+
+    return std::make_shared<MementoType>(std::forward<Args>(args)...);
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <list>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace undo
+{
+
+/**
+ * Helpers for mementos implementing IUndoMemento::saveData() and loadData().
+ * The data never leaves the running process, so all values are written in
+ * native byte order without any versioning.
+ */
+template<typename ValueType>
+inline void writeValue(std::ostream& stream, const ValueType& value)
+{
+    static_assert(std::is_arithmetic_v<ValueType>, "Only arithmetic types can be written directly");
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(ValueType));
+}
+
+template<typename ValueType>
+inline void readValue(std::istream& stream, ValueType& value)
+{
+    static_assert(std::is_arithmetic_v<ValueType>, "Only arithmetic types can be read directly");
+    stream.read(reinterpret_cast<char*>(&value), sizeof(ValueType));
+}
+
+inline void writeString(std::ostream& stream, const std::string& value)
+{
+    writeValue(stream, static_cast<std::uint64_t>(value.size()));
+    stream.write(value.data(), value.size());
+}
+
+inline void readString(std::istream& stream, std::string& value)
+{
+    std::uint64_t length = 0;
+    readValue(stream, length);
+
+    value.resize(static_cast<std::size_t>(length));
+    stream.read(value.data(), value.size());
+}
+
+// Releases the memory held by the given string or vector, clear() alone is keeping its capacity
+template<typename Container>
+inline void releaseMemory(Container& container)
+{
+    Container().swap(container);
+}
+
+// The number of bytes allocated on the heap by the given value, 0 for anything unknown
+template<typename ValueType>
+inline std::size_t getHeapMemoryUsage(const ValueType&)
+{
+    return 0;
+}
+
+// The number of bytes allocated on the heap by the given string
+inline std::size_t getHeapMemoryUsage(const std::string& value)
+{
+    // Short strings are stored inline, the exact limit depends on the library
+    return value.capacity() > 15 ? value.capacity() + 1 : 0;
+}
+
+template<typename ValueType>
+inline std::size_t getHeapMemoryUsage(const std::vector<ValueType>& values)
+{
+    return values.capacity() * sizeof(ValueType);
+}
+
+template<typename ValueType>
+inline std::size_t getHeapMemoryUsage(const std::list<ValueType>& values)
+{
+    // Every list element is allocated separately, along with its two links
+    return values.size() * (sizeof(ValueType) + 2 * sizeof(void*));
+}
+
+}
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <iterator>
 #include <memory>
+#include <string_view>
 #include <vector>
 #include <algorithm>
 
@@ -737,6 +739,69 @@ struct SyntaxParserTraits<const std::string>
     }
 };
 
+// Specialisation on const std::string_view inputs, like memory-mapped files
+template<>
+struct SyntaxParserTraits<const std::string_view>
+{
+    struct ViewIteratorAdapter
+    {
+        const char* wrapped;
+        const char* end;
+
+        ViewIteratorAdapter(const char* iter, const char* end_) :
+            wrapped(iter),
+            end(end_)
+        {}
+
+        ViewIteratorAdapter& operator++()
+        {
+            ++wrapped;
+            return *this;
+        }
+
+        ViewIteratorAdapter operator++(int) noexcept
+        {
+            ViewIteratorAdapter temp = *this;
+            ++(*this);
+            return temp;
+        }
+
+        char operator*() const
+        {
+            return *wrapped;
+        }
+
+        char peek() const
+        {
+            if (wrapped == end) return '\0';
+
+            return wrapped + 1 != end ? wrapped[1] : '\0';
+        }
+
+        bool operator==(const ViewIteratorAdapter& other) const
+        {
+            return wrapped == other.wrapped;
+        }
+
+        bool operator!=(const ViewIteratorAdapter& other) const
+        {
+            return !(operator==(other));
+        }
+    };
+
+    typedef ViewIteratorAdapter Iterator;
+
+    static Iterator GetStartIterator(const std::string_view& str)
+    {
+        return ViewIteratorAdapter(str.data(), str.data() + str.size());
+    }
+
+    static Iterator GetEndIterator(const std::string_view& str)
+    {
+        return ViewIteratorAdapter(str.data() + str.size(), str.data() + str.size());
+    }
+};
+
 // Specialisation on std::istream inputs
 template<>
 struct SyntaxParserTraits<std::istream>
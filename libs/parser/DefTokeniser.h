@@ -2,10 +2,12 @@
 
 #include "ParseException.h"
 
+#include <algorithm>
 #include <iterator>
 #include <iostream>
 #include <ios>
 #include <string>
+#include <string_view>
 #include "string/tokeniser.h"
 
 namespace parser
@@ -359,6 +361,10 @@ constexpr const char* const WHITESPACE = " \t\n\v\r";
  */
 class DefTokeniser
 {
+private:
+    // Storage for the default nextTokenView() implementation
+    std::string _lastToken;
+
 public:
     /**
 	 * Destructor
@@ -386,6 +392,20 @@ public:
      */
      virtual std::string nextToken() = 0;
 
+    /**
+     * Return the next token in the sequence as read-only view, consuming it.
+     *
+     * The view is only guaranteed to be valid until the next call to any of
+     * this tokeniser's methods. Tokenisers working on an in-memory buffer
+     * return views into that buffer without copying the characters, the
+     * default implementation stores the result of nextToken().
+     */
+    virtual std::string_view nextTokenView()
+    {
+        _lastToken = nextToken();
+        return _lastToken;
+    }
+
     /**
      * Assert that the next token in the sequence must be equal to the provided
      * value. A ParseException is thrown if the assert fails.
@@ -610,4 +630,401 @@ public:
 	}
 };
 
+/**
+ * Specialisation of DefTokeniser working on a contiguous character buffer,
+ * like a memory-mapped file or the full contents of a file read from a PK4.
+ * The buffer must stay alive during the lifetime of this tokeniser.
+ *
+ * Tokens are returned as views into the buffer by nextTokenView(), without
+ * allocating any memory. Only quoted strings containing escape sequences or
+ * backslash continuations are assembled in an internal scratch string.
+ * It produces the same token sequence as the DefTokeniserFunc.
+ */
+template<>
+class BasicDefTokeniser<std::string_view> :
+    public DefTokeniser
+{
+private:
+    const char* _begin;
+    mutable const char* _cur;
+    const char* _end;
+
+    // End of the most recently consumed token
+    const char* _consumed;
+
+    bool _isDelim[256];
+    bool _isKeptDelim[256];
+
+    // The token fetched by hasMoreTokens() or peek(), not yet consumed
+    mutable std::string_view _next;
+    mutable bool _nextFetched;
+    mutable bool _hasNext;
+
+    // Storage for tokens which are not contiguous in the buffer
+    mutable std::string _scratch;
+
+public:
+    /**
+     * Construct a DefTokeniser on top of the given character buffer.
+     *
+     * @param str
+     * The buffer to tokenise. The view's target memory must remain valid.
+     *
+     * @param delims
+     * The list of characters to use as delimiters.
+     *
+     * @param keptDelims
+     * String of characters to treat as delimiters but return as tokens in their
+     * own right.
+     */
+    BasicDefTokeniser(std::string_view str,
+                      const char* delims = WHITESPACE,
+                      const char* keptDelims = "{}()") :
+        _begin(str.data()),
+        _cur(str.data()),
+        _end(str.data() + str.size()),
+        _consumed(str.data()),
+        _nextFetched(false),
+        _hasNext(false)
+    {
+        std::fill(std::begin(_isDelim), std::end(_isDelim), false);
+        std::fill(std::begin(_isKeptDelim), std::end(_isKeptDelim), false);
+
+        for (const char* c = delims; *c != 0; ++c)
+        {
+            _isDelim[static_cast<unsigned char>(*c)] = true;
+        }
+
+        for (const char* c = keptDelims; *c != 0; ++c)
+        {
+            _isKeptDelim[static_cast<unsigned char>(*c)] = true;
+        }
+    }
+
+    bool hasMoreTokens() const override
+    {
+        ensureNextFetched();
+        return _hasNext;
+    }
+
+    std::string nextToken() override
+    {
+        return std::string(nextTokenView());
+    }
+
+    std::string_view nextTokenView() override
+    {
+        if (!hasMoreTokens())
+        {
+            throw ParseException("DefTokeniser: no more tokens");
+        }
+
+        _nextFetched = false;
+        _consumed = _cur;
+        return _next;
+    }
+
+    std::string peek() const override
+    {
+        if (!hasMoreTokens())
+        {
+            throw ParseException("DefTokeniser: no more tokens");
+        }
+
+        return std::string(_next);
+    }
+
+    void assertNextToken(const std::string& val) override
+    {
+        auto tok = nextTokenView();
+
+        if (tok != val)
+        {
+            throw ParseException("DefTokeniser: Assertion failed: Required \""
+                + val + "\", found \"" + std::string(tok) + "\"");
+        }
+    }
+
+    void skipTokens(unsigned int n) override
+    {
+        for (unsigned int i = 0; i < n; i++)
+        {
+            nextTokenView();
+        }
+    }
+
+    /**
+     * Returns the offset of the first character following the most recently
+     * consumed token, relative to the start of the buffer.
+     */
+    std::size_t getPosition() const
+    {
+        return static_cast<std::size_t>(_consumed - _begin);
+    }
+
+private:
+    bool isDelim(char c) const
+    {
+        return _isDelim[static_cast<unsigned char>(c)];
+    }
+
+    bool isKeptDelim(char c) const
+    {
+        return _isKeptDelim[static_cast<unsigned char>(c)];
+    }
+
+    void ensureNextFetched() const
+    {
+        if (!_nextFetched)
+        {
+            _hasNext = fetchToken(_next);
+            _nextFetched = true;
+        }
+    }
+
+    // Advances over a comment, with _cur pointing at the character after the
+    // introducing slash. Returns false if the slash is not starting a comment.
+    bool skipComment() const
+    {
+        if (*_cur == '/')
+        {
+            // Line comment, ends after the first line break character
+            while (++_cur != _end)
+            {
+                if (*_cur == '\r' || *_cur == '\n')
+                {
+                    ++_cur;
+                    break;
+                }
+            }
+            return true;
+        }
+
+        if (*_cur == '*')
+        {
+            // Delimited comment, ends after the "*/" sequence
+            ++_cur;
+
+            while (_cur != _end)
+            {
+                if (*_cur++ == '*')
+                {
+                    while (_cur != _end && *_cur == '*') ++_cur;
+
+                    if (_cur != _end && *_cur == '/')
+                    {
+                        ++_cur;
+                        break;
+                    }
+                }
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    bool fetchToken(std::string_view& token) const
+    {
+        while (_cur != _end)
+        {
+            char c = *_cur;
+
+            if (isDelim(c))
+            {
+                ++_cur;
+                continue;
+            }
+
+            if (isKeptDelim(c))
+            {
+                token = std::string_view(_cur++, 1);
+                return true;
+            }
+
+            if (c == '"')
+            {
+                return fetchQuotedToken(token);
+            }
+
+            if (c == '/')
+            {
+                // A trailing slash at the very end is swallowed, like the DefTokeniserFunc does
+                if (++_cur == _end) return false;
+
+                if (skipComment()) continue;
+
+                // Not a comment, the slash is the start of a regular token
+                return fetchUnquotedToken(_cur - 1, token);
+            }
+
+            return fetchUnquotedToken(_cur, token);
+        }
+
+        return false;
+    }
+
+    // Reads a regular token starting at the given position (_cur is at or after start)
+    bool fetchUnquotedToken(const char* start, std::string_view& token) const
+    {
+        while (_cur != _end)
+        {
+            char c = *_cur;
+
+            if (isDelim(c) || isKeptDelim(c) || c == '"')
+            {
+                break;
+            }
+
+            if (c == '/')
+            {
+                const char* slash = _cur;
+
+                if (++_cur == _end)
+                {
+                    // The slash at the end of the buffer doesn't end up in the token
+                    token = std::string_view(start, slash - start);
+                    return true;
+                }
+
+                if (skipComment())
+                {
+                    // A comment ends the current token
+                    token = std::string_view(start, slash - start);
+                    return true;
+                }
+
+                continue;
+            }
+
+            ++_cur;
+        }
+
+        token = std::string_view(start, _cur - start);
+        return !token.empty();
+    }
+
+    enum class Continuation
+    {
+        None,       // the quoted string is complete
+        Continued,  // a backslash and another opening quote follow
+        EndOfInput, // a backslash has been found, but the buffer ends
+    };
+
+    // Reads a quoted string including escape sequences and backslash continuations,
+    // _cur is pointing at the opening quote
+    bool fetchQuotedToken(std::string_view& token) const
+    {
+        const char* start = ++_cur;
+
+        // Fast path: a plain quoted string without any backslashes
+        while (_cur != _end && *_cur != '"' && *_cur != '\\') ++_cur;
+
+        if (_cur == _end)
+        {
+            // Unterminated quote, return what we have
+            token = std::string_view(start, _cur - start);
+            return !token.empty();
+        }
+
+        if (*_cur == '"')
+        {
+            token = std::string_view(start, _cur - start);
+            ++_cur;
+
+            auto continuation = checkForContinuation();
+
+            if (continuation == Continuation::None) return true;
+            if (continuation == Continuation::EndOfInput) return !token.empty();
+
+            // Continued, the next quoted string is appended in the slow path
+            _scratch.assign(token);
+        }
+        else
+        {
+            // Slow path, assemble the token in the scratch string
+            _scratch.assign(start, _cur - start);
+        }
+
+        while (true)
+        {
+            bool closingQuoteFound = false;
+
+            while (_cur != _end)
+            {
+                char c = *_cur++;
+
+                if (c == '"')
+                {
+                    closingQuoteFound = true;
+                    break;
+                }
+
+                if (c == '\\')
+                {
+                    if (_cur == _end) break;
+
+                    switch (char escaped = *_cur++)
+                    {
+                    case 'n': _scratch += '\n'; break;
+                    case 't': _scratch += '\t'; break;
+                    case '"': _scratch += '"'; break;
+                    default:
+                        _scratch += '\\';
+                        _scratch += escaped;
+                    }
+                    continue;
+                }
+
+                _scratch += c;
+            }
+
+            token = _scratch;
+
+            if (!closingQuoteFound)
+            {
+                // Ran out of characters inside the quotes
+                return !token.empty();
+            }
+
+            switch (checkForContinuation())
+            {
+            case Continuation::None: return true;
+            case Continuation::EndOfInput: return !token.empty();
+            case Continuation::Continued: continue;
+            }
+        }
+    }
+
+    // Called after a closing quote. Checks for a backslash indicating that the quoted
+    // string is continued with the next quoted string, like in "abc" \ "def".
+    // If the string is continued, _cur points to the first character after the next opening quote.
+    Continuation checkForContinuation() const
+    {
+        while (_cur != _end && isDelim(*_cur)) ++_cur;
+
+        if (_cur == _end || *_cur != '\\')
+        {
+            return Continuation::None;
+        }
+
+        ++_cur;
+
+        while (_cur != _end && isDelim(*_cur)) ++_cur;
+
+        if (_cur == _end)
+        {
+            return Continuation::EndOfInput;
+        }
+
+        if (*_cur != '"')
+        {
+            throw ParseException("Could not find opening double quote after backslash.");
+        }
+
+        ++_cur;
+        return Continuation::Continued;
+    }
+};
+
 } // namespace parser
@@ -4,6 +4,8 @@
 #include "itextstream.h"
 #include "idecltypes.h"
 #include "debugging/ScopedDebugTimer.h"
+#include "os/path.h"
+#include "stream/TextFileContents.h"
 #include "parser/ParseException.h"
 #include "parser/ThreadedDefLoader.h"
 
@@ -26,7 +28,7 @@ private:
 
 protected:
     // Construct a parser traversing all files matching the given extension in the given VFS path
-    // Subclasses need to implement the parse(std::istream) overload for this scenario
+    // Subclasses need to implement the parse(std::string_view) overload for this scenario
     ThreadedDeclParser(decl::Type declType, const std::string& baseDir, const std::string& extension, std::size_t depth = 1) :
         ThreadedDefLoader<ReturnType>(std::bind(&ThreadedDeclParser::doParse, this)),
         _baseDir(baseDir),
@@ -70,8 +72,8 @@ protected:
         }
     }
 
-    // Parse all decls found in the given stream, to be implemented by subclasses
-    virtual void parse(std::istream& stream, const vfs::FileInfo& fileInfo, const std::string& modDir) = 0;
+    // Parse all decls found in the given file contents, to be implemented by subclasses
+    virtual void parse(std::string_view contents, const vfs::FileInfo& fileInfo, const std::string& modDir) = 0;
 
     void processFiles()
     {
@@ -95,22 +97,48 @@ protected:
         // Dispatch the sorted list to the protected parse() method
         for (const auto& fileInfo : _incomingFiles)
         {
-            auto file = GlobalFileSystem().openTextFile(fileInfo.fullPath());
+            processFile(fileInfo);
+        }
+    }
 
-            if (!file) continue;
+    // Loads the given file and passes its contents to parse(),
+    // returns false if the file could not be opened or parsed
+    virtual bool processFile(const vfs::FileInfo& fileInfo)
+    {
+        auto file = GlobalFileSystem().openTextFile(fileInfo.fullPath());
 
-            try
-            {
-                // Parse entity defs from the file
-                std::istream stream(&file->getInputStream());
-                parse(stream, fileInfo, file->getModName());
-            }
-            catch (ParseException& e)
+        if (!file) return false;
+
+        try
+        {
+            // Parse entity defs from the file contents, mapping physical files into memory
+            auto contents = loadFileContents(*file, fileInfo);
+            parse(contents->get(), fileInfo, file->getModName());
+            return true;
+        }
+        catch (ParseException& e)
+        {
+            rError() << "[DeclParser] Failed to parse " << fileInfo.fullPath()
+                << " (" << e.what() << ")" << std::endl;
+            return false;
+        }
+    }
+
+private:
+    static std::unique_ptr<stream::TextFileContents> loadFileContents(ArchiveTextFile& file, const vfs::FileInfo& fileInfo)
+    {
+        if (fileInfo.getIsPhysicalFile())
+        {
+            auto mapped = std::make_unique<stream::TextFileContents>(
+                os::standardPathWithSlash(fileInfo.getArchivePath()) + fileInfo.fullPath());
+
+            if (!mapped->failed())
             {
-                rError() << "[DeclParser] Failed to parse " << fileInfo.fullPath()
-                    << " (" << e.what() << ")" << std::endl;
+                return mapped;
             }
         }
+
+        return std::make_unique<stream::TextFileContents>(file.getInputStream());
     }
 };
 
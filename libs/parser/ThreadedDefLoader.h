@@ -1,16 +1,19 @@
 #pragma once
 
-#include <future>
 #include <functional>
 #include <algorithm>
+#include <mutex>
 #include <sigc++/signal.h>
 #include <vector>
 
+#include "ithreadpool.h"
+
 namespace parser
 {
 
 /**
- * Helper class used to asynchronically parse/load def files in a separate thread.
+ * Helper class used to asynchronically parse/load def files on the shared thread pool.
+ * Modules using this class need to list MODULE_THREADPOOL in their dependencies.
  *
  * The worker thread itself is ensured to be called in a thread-safe 
  * way (to prevent the worker from being invoked twice). Subsequent calls to 
@@ -31,8 +34,8 @@ private:
     LoadFunction _loadFunc;
     FinishedSignal _finishedSignal;
 
-    std::shared_future<ReturnType> _result;
-    std::shared_future<void> _finisher;
+    threading::TaskFuture<ReturnType> _result;
+    threading::TaskFuture<void> _finisher;
     std::mutex _mutex;
 
     bool _loadingStarted;
@@ -95,8 +98,8 @@ public:
                 _finisher.get();
             }
 
-            _result = std::shared_future<ReturnType>();
-            _finisher = std::shared_future<void>();
+            _result = threading::TaskFuture<ReturnType>();
+            _finisher = threading::TaskFuture<void>();
 
             _loadingStarted = false;
         }
@@ -111,16 +114,16 @@ private:
     struct FinishSignalEmitter
     {
         FinishedSignal& _signal;
-        std::shared_future<void>& _targetFuture;
+        threading::TaskFuture<void>& _targetFuture;
 
-        FinishSignalEmitter(FinishedSignal& signal, std::shared_future<void>& targetFuture) :
+        FinishSignalEmitter(FinishedSignal& signal, threading::TaskFuture<void>& targetFuture) :
             _signal(signal),
             _targetFuture(targetFuture)
         {}
 
         ~FinishSignalEmitter()
         {
-            _targetFuture = std::async(std::launch::async, std::bind(&FinishedSignal::emit, _signal));
+            _targetFuture = threading::runAsync(std::bind(&FinishedSignal::emit, _signal));
         }
     };
 
@@ -131,7 +134,7 @@ private:
         if (!_loadingStarted)
         {
             _loadingStarted = true;
-            _result = std::async(std::launch::async, [&]()
+            _result = threading::runAsync([&]()
             {
                 // When going out of scope, this instance invokes the finished signal in a separate thread
                 FinishSignalEmitter finisher(_finishedSignal, _finisher);
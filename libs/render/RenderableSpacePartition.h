@@ -15,8 +15,10 @@ namespace render
  * greebo: This is a renderable helper object which can be used
  * to render any space partition system implementing the ISPacepartitionSystem interface.
  *
- * Instantiate such a class and pass the Shader and the SpacePartition system to the
- * setShader() and setSpacePartition() methods to enable rendering.
+ * Instantiate such a class and pass the Shader and a function returning the SpacePartition
+ * system to the setShader() and setSpacePartition() methods to enable rendering. The space
+ * partition is requested anew every frame, since the scenegraph replaces it when a map
+ * is loaded or the space partition type is changed.
  *
  * This object can be directly attached to the GlobalRenderSystem().
  */
@@ -27,8 +29,12 @@ private:
 	// The shader we're using
 	ShaderPtr _shader;
 
-	// The space partition to render
-	scene::ISpacePartitionSystemPtr _spacePartition;
+public:
+	using SpacePartitionGetter = std::function<scene::ISpacePartitionSystemPtr()>;
+
+private:
+	// Returns the space partition to render
+	SpacePartitionGetter _getSpacePartition;
 
     std::vector<AABB> _spacePartitionNodes;
     std::vector<Vector4> _nodeColours;
@@ -39,14 +45,16 @@ public:
         _renderableBoxes(_spacePartitionNodes, _nodeColours)
     {}
 
-	void setSpacePartition(const scene::ISpacePartitionSystemPtr& spacePartition)
+	void setSpacePartition(const SpacePartitionGetter& getSpacePartition)
 	{
-		_spacePartition = spacePartition;
+		_getSpacePartition = getSpacePartition;
 	}
 
     void onPreRender(const VolumeTest& volume) override
     {
-        if (!_spacePartition)
+        auto spacePartition = _getSpacePartition ? _getSpacePartition() : scene::ISpacePartitionSystemPtr();
+
+        if (!spacePartition)
         {
             _renderableBoxes.clear();
             return;
@@ -56,7 +64,7 @@ public:
         _spacePartitionNodes.clear();
         _nodeColours.clear();
 
-        accumulateBoundingBoxes(_spacePartition->getRoot());
+        accumulateBoundingBoxes(spacePartition->getRoot());
 
         // Update the renderable every frame
         _renderableBoxes.queueUpdate();
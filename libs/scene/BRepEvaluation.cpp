@@ -0,0 +1,69 @@
+#include "BRepEvaluation.h"
+
+#include "ibrush.h"
+#include "ithreadpool.h"
+
+namespace scene
+{
+
+namespace
+{
+    // Number of brushes processed by a worker at once, a B-rep takes a few microseconds
+    constexpr std::size_t BREP_EVALUATION_CHUNK_SIZE = 32;
+}
+
+void BRepEvaluationBatch::add(IBrush& brush)
+{
+    if (brush.needsBRepEvaluation())
+    {
+        _brushes.push_back(&brush);
+    }
+}
+
+void BRepEvaluationBatch::addNode(const scene::INodePtr& node)
+{
+    if (auto brush = Node_getIBrush(node); brush)
+    {
+        add(*brush);
+    }
+}
+
+void BRepEvaluationBatch::addSubgraph(const scene::INodePtr& root)
+{
+    addNode(root);
+
+    // foreachNode is visiting the children of the children too
+    root->foreachNode([&](const scene::INodePtr& child)
+    {
+        addNode(child);
+        return true;
+    });
+}
+
+std::size_t BRepEvaluationBatch::size() const
+{
+    return _brushes.size();
+}
+
+void BRepEvaluationBatch::evaluate()
+{
+    std::vector<IBrush*> brushes;
+    brushes.swap(_brushes);
+
+    if (brushes.size() < 2 * BREP_EVALUATION_CHUNK_SIZE)
+    {
+        for (auto* brush : brushes)
+        {
+            brush->evaluateBRep();
+        }
+
+        return;
+    }
+
+    GlobalThreadPool().parallelFor(0, brushes.size(), [&](std::size_t i)
+    {
+        brushes[i]->evaluateBRep();
+    }, BREP_EVALUATION_CHUNK_SIZE);
+}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include "inode.h"
+
+class IBrush;
+
+namespace scene
+{
+
+/**
+ * \brief
+ * Collects brushes with outdated windings and rebuilds their B-reps on the
+ * thread pool, instead of having each of them evaluated lazily one after the
+ * other on the calling thread.
+ *
+ * Rebuilding a B-rep only touches the brush itself, its faces and the brush
+ * node observing it, so different brushes can be processed concurrently. The
+ * caller is blocked until all brushes are done, nobody else gets to see a
+ * partially rebuilt brush. Bounds change notifications are not emitted by the
+ * rebuild, they have been sent when the face planes were changed.
+ */
+class BRepEvaluationBatch
+{
+private:
+    std::vector<IBrush*> _brushes;
+
+public:
+    // Adds the brush if its B-rep needs to be rebuilt. A brush must not be added twice.
+    void add(IBrush& brush);
+
+    // Adds the brush of the given node, other node types are ignored
+    void addNode(const scene::INodePtr& node);
+
+    // Adds all brushes in the subgraph below (and including) the given node
+    void addSubgraph(const scene::INodePtr& root);
+
+    // The number of brushes waiting to be evaluated
+    std::size_t size() const;
+
+    // Rebuilds all collected B-reps and clears the batch. Small batches are processed
+    // on the calling thread, the overhead of distributing them isn't worth it.
+    void evaluate();
+};
+
+}
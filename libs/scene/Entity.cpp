@@ -9,6 +9,7 @@ Entity::Entity(const scene::EntityClass::Ptr& eclass) :
 	_eclass(eclass),
 	_undo(_keyValues, std::bind(&Entity::importState, this, std::placeholders::_1),
         std::function<void()>(), "EntityKeyValues"),
+	_undoNode(nullptr),
 	_observerMutex(false),
 	_isContainer(!eclass->isFixedSize()),
 	_attachments(eclass->getDeclName())
@@ -21,6 +22,7 @@ Entity::Entity(const Entity& other) :
 	_eclass(other.getEntityClass()),
 	_undo(_keyValues, std::bind(&Entity::importState, this, std::placeholders::_1),
         std::function<void()>(), "EntityKeyValues"),
+	_undoNode(nullptr),
 	_observerMutex(false),
 	_isContainer(other._isContainer),
 	_attachments(other._attachments)
@@ -110,19 +112,22 @@ void Entity::detachObserver(Observer* observer)
 	}
 }
 
-void Entity::connectUndoSystem(IUndoSystem& undoSystem)
+void Entity::connectUndoSystem(IUndoSystem& undoSystem, scene::INode& node)
 {
+	_undoNode = &node;
+
 	for (const auto& keyValue : _keyValues)
 	{
-		keyValue.second->connectUndoSystem(undoSystem);
+		keyValue.second->connectUndoSystem(undoSystem, _undoNode);
 	}
 
-    _undo.connectUndoSystem(undoSystem);
+    _undo.connectUndoSystem(undoSystem, _undoNode);
 }
 
 void Entity::disconnectUndoSystem(IUndoSystem& undoSystem)
 {
 	_undo.disconnectUndoSystem(undoSystem);
+	_undoNode = nullptr;
 
 	for (const auto& keyValue : _keyValues)
 	{
@@ -278,7 +283,7 @@ void Entity::insert(const std::string& key, const KeyValuePtr& keyValue)
 
 	if (_undo.isConnected())
 	{
-        pair.second->connectUndoSystem(_undo.getUndoSystem());
+        pair.second->connectUndoSystem(_undo.getUndoSystem(), _undoNode);
 	}
 }
 
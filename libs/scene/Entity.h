@@ -68,6 +68,9 @@ private:
 
 	undo::ObservedUndoable<KeyValues> _undo;
 
+	// The node passed to connectUndoSystem(), the key values inserted later on belong to it as well
+	scene::INode* _undoNode;
+
 	bool _observerMutex;
 
 	bool _isContainer;
@@ -99,7 +102,8 @@ public:
     /// Detach an Entity::Observer from this Entity.
     void detachObserver(Observer* observer);
 
-    void connectUndoSystem(IUndoSystem& undoSystem);
+    // Connects the spawnargs to the given undo system, their changes are reported for the given node
+    void connectUndoSystem(IUndoSystem& undoSystem, scene::INode& node);
     void disconnectUndoSystem(IUndoSystem& undoSystem);
 
     /// Return the entity class object for this entity.
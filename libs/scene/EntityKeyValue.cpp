@@ -17,9 +17,9 @@ EntityKeyValue::~EntityKeyValue()
 	assert(_observers.empty());
 }
 
-void EntityKeyValue::connectUndoSystem(IUndoSystem& undoSystem)
+void EntityKeyValue::connectUndoSystem(IUndoSystem& undoSystem, scene::INode* node)
 {
-    _undo.connectUndoSystem(undoSystem);
+    _undo.connectUndoSystem(undoSystem, node);
 }
 
 void EntityKeyValue::disconnectUndoSystem(IUndoSystem& undoSystem)
@@ -36,7 +36,7 @@ public:
 
     ~EntityKeyValue();
 
-    void connectUndoSystem(IUndoSystem& undoSystem);
+    void connectUndoSystem(IUndoSystem& undoSystem, scene::INode* node);
     void disconnectUndoSystem(IUndoSystem& undoSystem);
 
     /// Attaches a callback to get notified about the key change.
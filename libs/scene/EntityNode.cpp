@@ -340,7 +340,7 @@ void EntityNode::onInsertIntoScene(scene::IMapRootNode& root)
 {
     GlobalCounters().getCounter(counterEntities).increment();
 
-	_spawnArgs.connectUndoSystem(root.getUndoSystem());
+	_spawnArgs.connectUndoSystem(root.getUndoSystem(), *this);
 	_modelKey.connectUndoSystem(root.getUndoSystem());
 
     attachToRenderSystem();
@@ -166,7 +166,7 @@ void ModelKey::skinChanged(const std::string& value)
 
 void ModelKey::connectUndoSystem(IUndoSystem& undoSystem)
 {
-	_undo.connectUndoSystem(undoSystem);
+	_undo.connectUndoSystem(undoSystem, &_parentNode);
 }
 
 void ModelKey::disconnectUndoSystem(IUndoSystem& undoSystem)
@@ -150,7 +150,7 @@ bool SelectableNode::isSelected() const
 
 IUndoMementoPtr SelectableNode::exportState() const
 {
-	return IUndoMementoPtr(new undo::BasicUndoMemento<GroupIds>(_groups));
+	return undo::allocateMemento<undo::BasicUndoMemento<GroupIds>>(_groups);
 }
 
 void SelectableNode::importState(const IUndoMementoPtr& state)
@@ -235,7 +235,7 @@ void SelectableNode::onSelectionStatusChange(bool changeGroupStatus)
 
 void SelectableNode::connectUndoSystem(IUndoSystem& undoSystem)
 {
-    _undoStateSaver = undoSystem.getStateSaver(*this);
+    _undoStateSaver = undoSystem.getStateSaver(*this, this);
 }
 
 void SelectableNode::disconnectUndoSystem(IUndoSystem& undoSystem)
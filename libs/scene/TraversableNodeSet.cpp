@@ -173,7 +173,7 @@ bool TraversableNodeSet::empty() const
 
 void TraversableNodeSet::connectUndoSystem(IUndoSystem& undoSystem)
 {
-	_undoStateSaver = undoSystem.getStateSaver(*this);
+	_undoStateSaver = undoSystem.getStateSaver(*this, &_owner);
 }
 
 void TraversableNodeSet::disconnectUndoSystem(IUndoSystem& undoSystem)
@@ -193,7 +193,7 @@ void TraversableNodeSet::undoSave()
 IUndoMementoPtr TraversableNodeSet::exportState() const
 {
 	// Copy the current list of children and return the UndoMemento
-	return IUndoMementoPtr(new UndoListMemento(_children));
+	return undo::allocateMemento<UndoListMemento>(_children);
 }
 
 void TraversableNodeSet::importState(const IUndoMementoPtr& state)
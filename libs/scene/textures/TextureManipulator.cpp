@@ -1,6 +1,7 @@
 #include "TextureManipulator.h"
 
 #include <stdlib.h>
+#include <vector>
 #include "itextstream.h"
 #include "registry/registry.h"
 #include "math/Vector3.h"
@@ -8,8 +9,8 @@
 
 namespace
 {
-    static byte *row1 = NULL, *row2 = NULL;
-    static std::size_t rowsize = 0;
+    // Line buffers used by resampleTexture, images can be resampled on several threads at once
+    thread_local std::vector<byte> row1Buffer, row2Buffer;
 
     const std::size_t MAX_TEXTURE_QUALITY = 3;
 }
@@ -282,17 +283,14 @@ R_ResampleTexture
 void TextureManipulator::resampleTexture(const void *indata, std::size_t inwidth, std::size_t inheight,
                                          void *outdata,  std::size_t outwidth, std::size_t outheight, int bytesperpixel)
 {
-    if (rowsize < outwidth * bytesperpixel) {
-        if (row1)
-            free(row1);
-        if (row2)
-            free(row2);
-
-        rowsize = outwidth * bytesperpixel;
-        row1 = (byte *)malloc(rowsize);
-        row2 = (byte *)malloc(rowsize);
+    if (row1Buffer.size() < outwidth * bytesperpixel) {
+        row1Buffer.resize(outwidth * bytesperpixel);
+        row2Buffer.resize(outwidth * bytesperpixel);
     }
 
+    byte* row1 = row1Buffer.data();
+    byte* row2 = row2Buffer.data();
+
     if (bytesperpixel == 4) {
         std::size_t i, yi, oldy, f, fstep, lerp, endy = (inheight-1), inwidth4 = inwidth*4, outwidth4 = outwidth*4;
         long j;
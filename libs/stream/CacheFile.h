@@ -0,0 +1,353 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ifilesystem.h"
+#include "itextstream.h"
+#include "os/fs.h"
+#include "os/dir.h"
+#include "os/path.h"
+#include "util/Noncopyable.h"
+
+namespace stream
+{
+
+/**
+ * Size and modification time of a physical file, used to detect
+ * whether cached information about the file is still up to date.
+ */
+struct FileStamp
+{
+    std::uint64_t size = 0;
+    std::int64_t modificationTime = 0;
+
+    // Returns the stamp of the given file, or an invalid stamp if the file doesn't exist
+    static FileStamp ofFile(const std::string& path)
+    {
+        FileStamp stamp;
+
+        try
+        {
+            stamp.size = static_cast<std::uint64_t>(fs::file_size(path));
+            stamp.modificationTime = static_cast<std::int64_t>(fs::last_write_time(path).time_since_epoch().count());
+        }
+        catch (const fs::filesystem_error&)
+        {
+            return FileStamp();
+        }
+
+        return stamp;
+    }
+
+    // Returns the stamp of the given VFS file. Loose files carry their own stamp,
+    // packed files share the one of their PK4.
+    static FileStamp ofVfsFile(const std::string& vfsPath)
+    {
+        auto fileInfo = GlobalFileSystem().getFileInfo(vfsPath);
+
+        if (fileInfo.isEmpty())
+        {
+            return FileStamp();
+        }
+
+        auto archivePath = fileInfo.getArchivePath();
+
+        return ofFile(fileInfo.getIsPhysicalFile() ?
+            os::standardPathWithSlash(archivePath) + fileInfo.fullPath() : archivePath);
+    }
+
+    bool isValid() const
+    {
+        return modificationTime != 0;
+    }
+
+    bool operator==(const FileStamp& other) const
+    {
+        return size == other.size && modificationTime == other.modificationTime;
+    }
+
+    bool operator!=(const FileStamp& other) const
+    {
+        return !operator==(other);
+    }
+};
+
+// 64-bit FNV-1a hash, used for the cache file names
+inline std::uint64_t hashString(const std::string& value)
+{
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+
+    for (auto c : value)
+    {
+        hash = (hash ^ static_cast<std::uint8_t>(c)) * 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+// Thrown by the CacheFileReader if the file is truncated
+class CacheFileException :
+    public std::runtime_error
+{
+public:
+    CacheFileException(const std::string& message) :
+        std::runtime_error(message)
+    {}
+};
+
+/**
+ * Reads a binary cache file written by the CacheFileWriter. The file is only
+ * accepted if it starts with the expected identifier and format version.
+ * All values are stored in native byte order, cache files are not meant to be
+ * exchanged between machines.
+ */
+class CacheFileReader :
+    public util::Noncopyable
+{
+private:
+    std::ifstream _stream;
+    std::uint64_t _fileSize;
+    bool _valid;
+
+public:
+    CacheFileReader(const std::string& path, const std::string& identifier, std::uint32_t version) :
+        _stream(path, std::ios::binary),
+        _fileSize(0),
+        _valid(false)
+    {
+        if (!_stream.is_open()) return;
+
+        _stream.seekg(0, std::ios::end);
+        _fileSize = static_cast<std::uint64_t>(_stream.tellg());
+        _stream.seekg(0, std::ios::beg);
+
+        try
+        {
+            _valid = readString() == identifier && readUInt32() == version;
+        }
+        catch (const CacheFileException&)
+        {
+            _valid = false;
+        }
+    }
+
+    // True if the file exists and has the expected identifier and version
+    bool isValid() const
+    {
+        return _valid;
+    }
+
+    std::uint32_t readUInt32()
+    {
+        return readValue<std::uint32_t>();
+    }
+
+    std::uint64_t readUInt64()
+    {
+        return readValue<std::uint64_t>();
+    }
+
+    std::int64_t readInt64()
+    {
+        return readValue<std::int64_t>();
+    }
+
+    std::string readString()
+    {
+        auto length = readValue<std::uint32_t>();
+
+        // Don't try to allocate absurd amounts of memory for damaged files
+        if (length > _fileSize)
+        {
+            throw CacheFileException("Invalid string length in cache file");
+        }
+
+        std::string value(length, '\0');
+        _stream.read(value.data(), length);
+
+        if (!_stream)
+        {
+            throw CacheFileException("Unexpected end of cache file");
+        }
+
+        return value;
+    }
+
+    std::vector<std::uint8_t> readBytes()
+    {
+        auto length = readValue<std::uint64_t>();
+
+        if (length > _fileSize)
+        {
+            throw CacheFileException("Invalid data length in cache file");
+        }
+
+        std::vector<std::uint8_t> bytes(static_cast<std::size_t>(length));
+        _stream.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+
+        if (!_stream)
+        {
+            throw CacheFileException("Unexpected end of cache file");
+        }
+
+        return bytes;
+    }
+
+    FileStamp readFileStamp()
+    {
+        FileStamp stamp;
+        stamp.size = readUInt64();
+        stamp.modificationTime = readInt64();
+        return stamp;
+    }
+
+private:
+    template<typename ValueType>
+    ValueType readValue()
+    {
+        ValueType value;
+        _stream.read(reinterpret_cast<char*>(&value), sizeof(ValueType));
+
+        if (!_stream)
+        {
+            throw CacheFileException("Unexpected end of cache file");
+        }
+
+        return value;
+    }
+};
+
+/**
+ * Writes a binary cache file, starting with an identifier and a format version.
+ * The data is written to a temporary file first, which replaces the target
+ * file in commit(). The target is left untouched if commit() is not called.
+ * Every writer uses its own temporary file, several threads (or processes)
+ * can write the same target at once, the last commit() wins.
+ */
+class CacheFileWriter :
+    public util::Noncopyable
+{
+private:
+    std::string _path;
+    std::string _temporaryPath;
+    std::ofstream _stream;
+
+public:
+    CacheFileWriter(const std::string& path, const std::string& identifier, std::uint32_t version) :
+        _path(path),
+        _temporaryPath(GetTemporaryPath(path))
+    {
+        os::makeDirectory(fs::path(path).parent_path().string());
+
+        _stream.open(_temporaryPath, std::ios::binary | std::ios::trunc);
+
+        writeString(identifier);
+        writeUInt32(version);
+    }
+
+    ~CacheFileWriter()
+    {
+        if (_stream.is_open())
+        {
+            _stream.close();
+            removeTemporaryFile();
+        }
+    }
+
+    void writeUInt32(std::uint32_t value)
+    {
+        writeValue(value);
+    }
+
+    void writeUInt64(std::uint64_t value)
+    {
+        writeValue(value);
+    }
+
+    void writeInt64(std::int64_t value)
+    {
+        writeValue(value);
+    }
+
+    void writeString(const std::string& value)
+    {
+        writeValue(static_cast<std::uint32_t>(value.size()));
+        _stream.write(value.data(), value.size());
+    }
+
+    void writeBytes(const std::uint8_t* data, std::size_t length)
+    {
+        writeValue(static_cast<std::uint64_t>(length));
+        _stream.write(reinterpret_cast<const char*>(data), length);
+    }
+
+    void writeFileStamp(const FileStamp& stamp)
+    {
+        writeUInt64(stamp.size);
+        writeInt64(stamp.modificationTime);
+    }
+
+    // Moves the written file to the target path, returns false on failure
+    bool commit()
+    {
+        _stream.close();
+
+        if (_stream.fail())
+        {
+            rWarning() << "Failed to write cache file " << _temporaryPath << std::endl;
+            removeTemporaryFile();
+            return false;
+        }
+
+        try
+        {
+            fs::rename(_temporaryPath, _path);
+        }
+        catch (const fs::filesystem_error& ex)
+        {
+            rWarning() << "Failed to replace cache file " << _path << ": " << ex.what() << std::endl;
+            removeTemporaryFile();
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    static std::string GetTemporaryPath(const std::string& path)
+    {
+        static std::atomic<std::uint64_t> _counter(0);
+
+        // Thread and time make the name unique across processes, the counter within this one
+        auto threadHash = std::hash<std::thread::id>()(std::this_thread::get_id());
+        auto time = std::chrono::steady_clock::now().time_since_epoch().count();
+
+        return path + "." + std::to_string(threadHash ^ static_cast<std::size_t>(time)) +
+            "_" + std::to_string(++_counter) + ".tmp";
+    }
+
+    void removeTemporaryFile()
+    {
+        try
+        {
+            fs::remove(_temporaryPath);
+        }
+        catch (const fs::filesystem_error&)
+        {}
+    }
+
+    template<typename ValueType>
+    void writeValue(ValueType value)
+    {
+        _stream.write(reinterpret_cast<const char*>(&value), sizeof(ValueType));
+    }
+};
+
+}
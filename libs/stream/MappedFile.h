@@ -0,0 +1,117 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "util/Noncopyable.h"
+
+#ifdef WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace stream
+{
+
+/**
+ * Read-only memory mapping of a physical file. The contents are available
+ * through getContents() as long as this object is alive.
+ * Empty files and files that could not be mapped will report isOpen() == false.
+ */
+class MappedFile :
+    public util::Noncopyable
+{
+private:
+    const char* _data;
+    std::size_t _size;
+
+#ifdef WIN32
+    HANDLE _file;
+    HANDLE _mapping;
+#endif
+
+public:
+    MappedFile(const std::string& path) :
+        _data(nullptr),
+        _size(0)
+    {
+#ifdef WIN32
+        _mapping = nullptr;
+        _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+        if (_file == INVALID_HANDLE_VALUE) return;
+
+        LARGE_INTEGER size;
+
+        if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0) return;
+
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (_mapping == nullptr) return;
+
+        _data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+        _size = _data != nullptr ? static_cast<std::size_t>(size.QuadPart) : 0;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+
+        if (fd == -1) return;
+
+        struct stat st;
+
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void* address = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (address != MAP_FAILED)
+            {
+                _data = static_cast<const char*>(address);
+                _size = static_cast<std::size_t>(st.st_size);
+
+                // We're usually reading the whole file front to back
+                ::madvise(address, _size, MADV_SEQUENTIAL);
+            }
+        }
+
+        // The mapping stays valid after closing the descriptor
+        ::close(fd);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef WIN32
+        if (_data != nullptr) UnmapViewOfFile(_data);
+        if (_mapping != nullptr) CloseHandle(_mapping);
+        if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+#else
+        if (_data != nullptr)
+        {
+            ::munmap(const_cast<char*>(_data), _size);
+        }
+#endif
+    }
+
+    bool isOpen() const
+    {
+        return _data != nullptr;
+    }
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    std::string_view getContents() const
+    {
+        return std::string_view(_data, _size);
+    }
+};
+
+}
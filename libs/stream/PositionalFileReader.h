@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "idatastream.h"
+#include "util/Noncopyable.h"
+
+#ifdef WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace stream
+{
+
+/**
+ * Read-only handle to a physical file, reading data at explicit offsets
+ * (pread on POSIX systems, ReadFile with an OVERLAPPED offset on Windows).
+ * Since no file position is shared between the reads, any number of threads
+ * can read from the same handle at the same time without locking.
+ */
+class PositionalFileReader :
+    public util::Noncopyable
+{
+private:
+#ifdef WIN32
+    HANDLE _file;
+#else
+    int _file;
+#endif
+
+public:
+    PositionalFileReader(const std::string& path)
+    {
+#ifdef WIN32
+        _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+#else
+        _file = ::open(path.c_str(), O_RDONLY);
+#endif
+    }
+
+    ~PositionalFileReader()
+    {
+        if (!isOpen()) return;
+
+#ifdef WIN32
+        CloseHandle(_file);
+#else
+        ::close(_file);
+#endif
+    }
+
+    bool isOpen() const
+    {
+#ifdef WIN32
+        return _file != INVALID_HANDLE_VALUE;
+#else
+        return _file != -1;
+#endif
+    }
+
+    // Reads up to length bytes starting at the given offset, returns the number of bytes read
+    std::size_t readAt(std::size_t offset, void* buffer, std::size_t length) const
+    {
+        std::size_t totalRead = 0;
+
+        // The OS might return less than requested, keep reading until EOF or error
+        while (totalRead < length)
+        {
+            auto position = offset + totalRead;
+            auto target = static_cast<char*>(buffer) + totalRead;
+#ifdef WIN32
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = static_cast<DWORD>(position & 0xFFFFFFFF);
+            overlapped.OffsetHigh = static_cast<DWORD>(static_cast<std::uint64_t>(position) >> 32);
+
+            DWORD bytesRead = 0;
+            auto chunkSize = static_cast<DWORD>(std::min<std::size_t>(length - totalRead, 0x40000000));
+
+            if (!ReadFile(_file, target, chunkSize, &bytesRead, &overlapped) || bytesRead == 0)
+            {
+                break;
+            }
+#else
+            auto bytesRead = ::pread(_file, target, length - totalRead, static_cast<off_t>(position));
+
+            if (bytesRead <= 0)
+            {
+                break;
+            }
+#endif
+            totalRead += static_cast<std::size_t>(bytesRead);
+        }
+
+        return totalRead;
+    }
+};
+
+/**
+ * InputStream providing a range of a file through a shared PositionalFileReader.
+ * Data is fetched in blocks, to not issue a system call for every small read.
+ */
+class PositionalFileInputStream :
+    public InputStream
+{
+private:
+    static constexpr std::size_t BLOCK_SIZE = 16384;
+
+    std::shared_ptr<PositionalFileReader> _reader;
+
+    // File offset of the next byte to fetch into the buffer
+    std::size_t _position;
+
+    // Number of bytes of the range not fetched yet
+    std::size_t _remaining;
+
+    byte_type _buffer[BLOCK_SIZE];
+    std::size_t _bufferPos;
+    std::size_t _bufferEnd;
+
+public:
+    PositionalFileInputStream(const std::shared_ptr<PositionalFileReader>& reader, std::size_t offset, std::size_t size) :
+        _reader(reader),
+        _position(offset),
+        _remaining(size),
+        _bufferPos(0),
+        _bufferEnd(0)
+    {}
+
+    size_type read(byte_type* buffer, size_type length) override
+    {
+        size_type totalRead = 0;
+
+        while (totalRead < length)
+        {
+            if (_bufferPos == _bufferEnd && !fetchBlock())
+            {
+                break;
+            }
+
+            auto count = std::min(length - totalRead, _bufferEnd - _bufferPos);
+            std::copy(_buffer + _bufferPos, _buffer + _bufferPos + count, buffer + totalRead);
+
+            _bufferPos += count;
+            totalRead += count;
+        }
+
+        return totalRead;
+    }
+
+private:
+    bool fetchBlock()
+    {
+        if (_remaining == 0) return false;
+
+        auto bytesRead = _reader->readAt(_position, _buffer, std::min(_remaining, BLOCK_SIZE));
+
+        // Treat a short read as end of the range, the file might have been truncated
+        _remaining = bytesRead > 0 ? _remaining - bytesRead : 0;
+        _position += bytesRead;
+
+        _bufferPos = 0;
+        _bufferEnd = bytesRead;
+
+        return bytesRead > 0;
+    }
+};
+
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "itextstream.h"
+#include "MappedFile.h"
+
+namespace stream
+{
+
+/**
+ * Provides the complete contents of a text file as one contiguous
+ * character buffer, to be consumed by a BasicDefTokeniser<std::string_view>
+ * or a DefBlockSyntaxParser<const std::string_view>.
+ *
+ * Physical files are memory-mapped, other sources like files in PK4 archives
+ * are read into memory in one go. The characters are the same as the ones
+ * delivered by the file's TextInputStream: on Windows, where physical files are
+ * read in text mode, CRLF line endings of mapped files are converted to LF.
+ */
+class TextFileContents :
+    public util::Noncopyable
+{
+private:
+    std::unique_ptr<MappedFile> _mappedFile;
+    std::string _buffer;
+    std::string_view _contents;
+    bool _failed = false;
+
+public:
+    // Reads the remaining characters of the given text stream
+    explicit TextFileContents(TextInputStream& stream)
+    {
+        char block[16384];
+
+        for (std::size_t charsRead = stream.read(block, sizeof(block)); charsRead > 0;
+             charsRead = stream.read(block, sizeof(block)))
+        {
+            _buffer.append(block, charsRead);
+        }
+
+        _contents = _buffer;
+    }
+
+    // Reads the remaining characters of the given std::istream
+    explicit TextFileContents(std::istream& stream)
+    {
+        char block[16384];
+
+        while (stream.read(block, sizeof(block)) || stream.gcount() > 0)
+        {
+            _buffer.append(block, static_cast<std::size_t>(stream.gcount()));
+        }
+
+        _contents = _buffer;
+    }
+
+    // Maps the physical file at the given path. Use failed() to check
+    // whether this succeeded, empty files are never mapped.
+    explicit TextFileContents(const std::string& physicalPath) :
+        _mappedFile(new MappedFile(physicalPath))
+    {
+        if (!_mappedFile->isOpen())
+        {
+            _mappedFile.reset();
+            _failed = true;
+            return;
+        }
+
+        _contents = _mappedFile->getContents();
+
+#ifdef WIN32
+        // Emulate the text mode line ending conversion
+        if (_contents.find("\r\n") != std::string_view::npos)
+        {
+            _buffer.reserve(_contents.size());
+
+            for (std::size_t i = 0; i < _contents.size(); ++i)
+            {
+                if (_contents[i] != '\r' || i + 1 == _contents.size() || _contents[i + 1] != '\n')
+                {
+                    _buffer += _contents[i];
+                }
+            }
+
+            _contents = _buffer;
+            _mappedFile.reset();
+        }
+#endif
+    }
+
+    // True if the physical file could not be mapped
+    bool failed() const
+    {
+        return _failed;
+    }
+
+    // The file contents, valid during the lifetime of this object
+    std::string_view get() const
+    {
+        return _contents;
+    }
+};
+
+}
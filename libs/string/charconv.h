@@ -0,0 +1,122 @@
+#pragma once
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <ios>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+/**
+ * Locale-independent number conversion routines for the hot paths
+ * of the map parsers and writers, based on std::from_chars and std::to_chars.
+ *
+ * The results are identical to the ones of std::atof() and std::ostream::operator<<,
+ * which were used before. Where <charconv> is lacking floating point support,
+ * the C library is used as fallback.
+ */
+namespace string
+{
+
+namespace detail
+{
+    // Parses the given characters using std::strtod, which needs a null-terminated string
+    inline double strtodFallback(std::string_view str)
+    {
+        char buffer[64];
+
+        if (str.size() < sizeof(buffer))
+        {
+            str.copy(buffer, str.size());
+            buffer[str.size()] = '\0';
+            return std::strtod(buffer, nullptr);
+        }
+
+        return std::strtod(std::string(str).c_str(), nullptr);
+    }
+}
+
+/**
+ * Converts the given characters to a double. Returns the same value as
+ * std::atof() would, including 0.0 if the string is not a number.
+ */
+inline double to_double(std::string_view str)
+{
+#ifdef __cpp_lib_to_chars
+    double value = 0;
+    auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+
+    // Anything out of the ordinary like signs, hex numbers, trailing garbage
+    // or range errors is handed over to strtod to get the exact same behaviour
+    if (result.ec == std::errc() && result.ptr == str.data() + str.size())
+    {
+        return value;
+    }
+#endif
+
+    return detail::strtodFallback(str);
+}
+
+/**
+ * Converts the given characters to an integral value, returning the default value
+ * if the string doesn't start with a number.
+ */
+template<typename T>
+inline T to_integer(std::string_view str, T defaultVal = {})
+{
+    static_assert(std::is_integral_v<T>, "to_integer requires an integral type");
+
+    T value;
+    auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+
+    return result.ec == std::errc() ? value : defaultVal;
+}
+
+/**
+ * Writes the given double to the stream, producing the same characters as
+ * stream << value would. The formatting is done without involving the
+ * stream's locale facets, unless the stream is using any non-default
+ * formatting flags, in which case the regular operator<< is called.
+ */
+inline void write_double(std::ostream& stream, double value)
+{
+    constexpr auto nonDefaultFlags = std::ios_base::floatfield | std::ios_base::showpoint |
+        std::ios_base::showpos | std::ios_base::uppercase;
+
+    if ((stream.flags() & nonDefaultFlags) || stream.width() != 0)
+    {
+        stream << value;
+        return;
+    }
+
+    char buffer[64];
+
+    // The stream uses the printf("%.*g") format, precision 0 is treated as 1 by both
+    auto precision = stream.precision() >= 0 ? static_cast<int>(stream.precision()) : 6;
+
+#ifdef __cpp_lib_to_chars
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, precision);
+
+    if (result.ec == std::errc())
+    {
+        stream.write(buffer, result.ptr - buffer);
+        return;
+    }
+#else
+    auto length = std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+
+    if (length > 0 && static_cast<std::size_t>(length) < sizeof(buffer))
+    {
+        stream.write(buffer, length);
+        return;
+    }
+#endif
+
+    // Doesn't fit into the buffer (very high precision)
+    stream << value;
+}
+
+}
@@ -205,6 +205,7 @@ StringSet GuiManager::getDependencies() const
 	if (_dependencies.empty())
 	{
 		_dependencies.insert(MODULE_VIRTUALFILESYSTEM);
+		_dependencies.insert(MODULE_THREADPOOL);
 	}
 
 	return _dependencies;
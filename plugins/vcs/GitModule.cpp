@@ -7,6 +7,7 @@
 #include "ipreferencesystem.h"
 #include "ui/istatusbarmanager.h"
 #include "icommandsystem.h"
+#include "ithreadpool.h"
 #include <git2.h>
 #include "Repository.h"
 #include "Commit.h"
@@ -55,7 +56,7 @@ std::string GitModule::getName() const
 StringSet GitModule::getDependencies() const
 {
     static StringSet _dependencies{ MODULE_MAINFRAME, MODULE_STATUSBARMANAGER,
-        MODULE_PREFERENCESYSTEM, MODULE_MAP, MODULE_VERSION_CONTROL_MANAGER };
+        MODULE_PREFERENCESYSTEM, MODULE_MAP, MODULE_VERSION_CONTROL_MANAGER, MODULE_THREADPOOL };
     return _dependencies;
 }
 
@@ -243,7 +243,8 @@ void VcsStatus::startFetchTask()
     }
 
     auto repository = _repository->clone();
-    _repositoryTask = std::async(std::launch::async, std::bind(&VcsStatus::performFetch, this, repository));
+    _repositoryTask = threading::runAsync(std::bind(&VcsStatus::performFetch, this, repository),
+        threading::TaskPriority::Low);
 }
 
 void VcsStatus::onIntervalReached(wxTimerEvent& ev)
@@ -280,8 +281,15 @@ void VcsStatus::updateMapFileStatus()
 
     if (_repository)
     {
+        // Don't start another check while the previous one is still running
+        if (_mapFileTask.valid() && !_mapFileTask.isReady())
+        {
+            return;
+        }
+
         auto repository = _repository->clone();
-        _mapFileTask = std::async(std::launch::async, std::bind(&VcsStatus::performMapFileStatusCheck, this, repository));
+        _mapFileTask = threading::runAsync(std::bind(&VcsStatus::performMapFileStatusCheck, this, repository),
+            threading::TaskPriority::Low);
     }
     else
     {
@@ -4,10 +4,10 @@
 #include <wx/stattext.h>
 #include <wx/timer.h>
 #include <mutex>
-#include <future>
 #include <sigc++/trackable.h>
 
 #include "imap.h"
+#include "ithreadpool.h"
 #include "../Algorithm.h"
 #include "../Repository.h"
 #include "wxutil/XmlResourceBasedWidget.h"
@@ -31,8 +31,8 @@ private:
     wxTimer _statusTimer;
     std::mutex _taskLock;
     bool _taskInProgress;
-    std::future<void> _repositoryTask;
-    std::future<void> _mapFileTask;
+    threading::TaskFuture<void> _repositoryTask;
+    threading::TaskFuture<void> _mapFileTask;
 
     std::shared_ptr<git::Repository> _repository;
 
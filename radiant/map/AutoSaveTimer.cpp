@@ -4,6 +4,9 @@
 #include "iautosaver.h"
 #include "registry/registry.h"
 #include "i18n.h"
+#include "messages/MapOperationMessage.h"
+#include "ui/UserInterfaceModule.h"
+#include <fmt/format.h>
 
 namespace map
 {
@@ -24,6 +27,9 @@ AutoSaveTimer::~AutoSaveTimer()
     _enabled = false;
     stopTimer();
 
+    // Don't leave a worker behind which might still report its progress to us
+    GlobalAutoSaver().finishPendingSave();
+
     // Destroy the timer
     _timer.reset();
 }
@@ -48,6 +54,10 @@ void AutoSaveTimer::initialise()
         sigc::mem_fun(this, &AutoSaveTimer::registryKeyChanged)
     );
 
+    GlobalAutoSaver().signal_saveProgress().connect(
+        sigc::mem_fun(this, &AutoSaveTimer::onSaveProgress)
+    );
+
     // Refresh all values from the registry right now (this might also start the timer)
     registryKeyChanged();
 }
@@ -95,4 +105,17 @@ void AutoSaveTimer::onIntervalReached(wxTimerEvent& ev)
     }
 }
 
+void AutoSaveTimer::onSaveProgress(float fraction)
+{
+    auto text = fraction < 1.0f ?
+        fmt::format(_("Writing autosave... {0:d}%"), static_cast<int>(fraction * 100)) :
+        std::string(_("Autosave written"));
+
+    // The message bus must be used from the main thread only
+    ui::GetUserInterfaceModule().dispatch([text]()
+    {
+        OperationMessage::Send(text);
+    });
+}
+
 }
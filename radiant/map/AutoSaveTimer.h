@@ -38,6 +38,9 @@ public:
 private:
     void registryKeyChanged();
     void onIntervalReached(wxTimerEvent& ev);
+
+    // Invoked by the autosaver while writing the files, possibly from a worker thread
+    void onSaveProgress(float fraction);
 };
 
 }
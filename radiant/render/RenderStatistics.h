@@ -2,6 +2,7 @@
 
 #include <wx/stopwatch.h>
 #include "string/string.h"
+#include "ishaders.h"
 
 namespace render
 {
@@ -27,7 +28,23 @@ public:
         return " | f/e: " + std::to_string(_feTime) + " ms"
              + " | b/e: " + std::to_string(beTime) + " ms"
              + " | tot: " + std::to_string(totTime) + " ms"
-             + " | fps: " + (totTime > 0 ? std::to_string(1000 / totTime) : "-");
+             + " | fps: " + (totTime > 0 ? std::to_string(1000 / totTime) : "-")
+             + " | tex: " + getTextureMemoryString();
+    }
+
+    /// Return the texture memory in use, along with the budget if there is one
+    static std::string getTextureMemoryString()
+    {
+        auto stats = GlobalMaterialManager().getTextureStreamingStatistics();
+
+        auto result = std::to_string(stats.textureMemory >> 20);
+
+        if (stats.textureMemoryBudget > 0)
+        {
+            result += "/" + std::to_string(stats.textureMemoryBudget >> 20);
+        }
+
+        return result + " MB";
     }
 
     /// Mark the front-end render stage as completed, storing the time internally
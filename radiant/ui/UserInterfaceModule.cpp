@@ -18,6 +18,7 @@
 #include "ui/imainframe.h"
 #include "ishaders.h"
 #include "ieditstopwatch.h"
+#include "iautosaver.h"
 #include "icounter.h"
 #include "icameraview.h"
 
@@ -132,6 +133,7 @@ StringSet UserInterfaceModule::getDependencies() const
         MODULE_EDITING_STOPWATCH,
         MODULE_COUNTER,
         MODULE_CLIPPER,
+        MODULE_AUTOSAVER,
     };
 
 	return _dependencies;
@@ -231,6 +233,7 @@ void UserInterfaceModule::initialiseModule(const IApplicationContext& ctx)
 	_editStopwatchStatus.reset(new statusbar::EditingStopwatchStatus);
     _commandStatus.reset(new statusbar::CommandStatus);
     _mapStatisticsStatus.reset(new statusbar::MapStatistics);
+    _undoMemoryStatus.reset(new statusbar::UndoMemoryStatus);
 	_manipulatorToggle.reset(new ManipulatorToggle);
     _textureToolModeToggles.reset(new TexToolModeToggles);
 	_selectionModeToggle.reset(new SelectionModeToggle);
@@ -340,6 +343,7 @@ void UserInterfaceModule::shutdownModule()
 	_autoSaveRequestHandler.reset();
 	_shaderClipboardStatus.reset();
     _mapStatisticsStatus.reset();
+    _undoMemoryStatus.reset();
 	_editStopwatchStatus.reset();
 	_commandStatus.reset();
 	_manipulatorToggle.reset();
@@ -18,6 +18,7 @@
 #include "statusbar/ShaderClipboardStatus.h"
 #include "statusbar/EditingStopwatchStatus.h"
 #include "statusbar/CommandStatus.h"
+#include "statusbar/UndoMemoryStatus.h"
 #include "statusbar/MapStatistics.h"
 #include "messages/CommandExecutionFailed.h"
 #include "messages/TextureChanged.h"
@@ -55,6 +56,7 @@ private:
 	std::unique_ptr<statusbar::EditingStopwatchStatus> _editStopwatchStatus;
 	std::unique_ptr<statusbar::CommandStatus> _commandStatus;
 	std::unique_ptr<statusbar::MapStatistics> _mapStatisticsStatus;
+	std::unique_ptr<statusbar::UndoMemoryStatus> _undoMemoryStatus;
 	std::unique_ptr<ManipulatorToggle> _manipulatorToggle;
 	std::unique_ptr<SelectionModeToggle> _selectionModeToggle;
 	std::unique_ptr<TexToolModeToggles> _textureToolModeToggles;
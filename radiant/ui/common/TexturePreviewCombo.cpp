@@ -23,7 +23,8 @@ TexturePreviewCombo::TexturePreviewCombo(wxWindow* parent) :
     _glWidget(new wxutil::GLWidget(this, std::bind(&TexturePreviewCombo::_onRender, this), "TexturePreviewCombo")),
     _texName(""),
 	_infoTable(nullptr),
-	_contextMenu(new wxutil::PopupMenu)
+	_contextMenu(new wxutil::PopupMenu),
+    _thumbnailPending(false)
 {
     _glWidget->SetMinSize(wxSize(128, 128));
 
@@ -45,6 +46,11 @@ TexturePreviewCombo::TexturePreviewCombo(wxWindow* parent) :
     loadLightTexturePrefixes();
 }
 
+TexturePreviewCombo::~TexturePreviewCombo()
+{
+    GlobalMaterialManager().releaseThumbnailView(this);
+}
+
 void TexturePreviewCombo::ClearPreview()
 {
     SetPreviewDeclName({});
@@ -159,55 +165,44 @@ bool TexturePreviewCombo::_onRender()
     // If no texture is loaded, leave window blank
 	if (!_texName.empty())
 	{
+        // This view isn't using the render system's frames, upload the finished thumbnails on our own
+        GlobalMaterialManager().beginThumbnailFrame(this);
+        _thumbnailPending = GlobalMaterialManager().processTextureUploads();
+
 		// Get a reference to the selected shader
 		auto shader = GlobalMaterialManager().getMaterial(_texName);
 
-        // This is an "ordinary" texture, take the editor image
-        auto tex = shader->getEditorImage();
+        // This is an "ordinary" texture, take the thumbnail of the editor image
+        auto thumbnail = GlobalMaterialManager().getMaterialThumbnail(_texName, this);
 
-        // If this is a light, take #the first layer texture, but prefer the editor image if we got one
-        if (isLightTexture() && !tex)
+        if (thumbnail.textureNum != 0)
         {
-            if (auto first = shader->firstLayer(); first)
+            drawPreviewQuad(thumbnail.textureNum, thumbnail.imageWidth, thumbnail.imageHeight,
+                thumbnail.s0, thumbnail.t0, thumbnail.s1, thumbnail.t1);
+        }
+        else if (thumbnail.failed)
+        {
+            auto tex = shader->getEditorImage();
+
+            // If this is a light, take #the first layer texture, but prefer the editor image if we got one
+            if (isLightTexture() && !tex)
+            {
+                if (auto first = shader->firstLayer(); first)
+                {
+                    tex = shader->firstLayer()->getTexture();
+                }
+            }
+
+            if (tex)
             {
-                tex = shader->firstLayer()->getTexture();
+                drawPreviewQuad(tex->getGLTexNum(), tex->getWidth(), tex->getHeight(), 0, 0, 1, 1);
             }
         }
 
-		if (tex)
-		{
-			glBindTexture(GL_TEXTURE_2D, tex->getGLTexNum());
-
-			// Calculate the correct aspect ratio for preview
-			auto aspect = static_cast<float>(tex->getWidth()) / tex->getHeight();
-			float hfWidth, hfHeight;
-
-			if (aspect > 1.0f)
-			{
-				hfWidth = 0.5f * req.GetWidth();
-				hfHeight = 0.5f * req.GetHeight() / aspect;
-			}
-			else
-			{
-				hfHeight = 0.5f * req.GetWidth();
-				hfWidth = 0.5f * req.GetHeight() * aspect;
-			}
-
-			// Draw a quad to put the texture on
-			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-			glColor3f(1, 1, 1);
-
-			glBegin(GL_QUADS);
-			glTexCoord2i(0, 1);
-			glVertex2f(0.5f*req.GetWidth() - hfWidth, 0.5f*req.GetHeight() - hfHeight);
-			glTexCoord2i(1, 1);
-			glVertex2f(0.5f*req.GetWidth() + hfWidth, 0.5f*req.GetHeight() - hfHeight);
-			glTexCoord2i(1, 0);
-			glVertex2f(0.5f*req.GetWidth() + hfWidth, 0.5f*req.GetHeight() + hfHeight);
-			glTexCoord2i(0, 0);
-			glVertex2f(0.5f*req.GetWidth() - hfWidth, 0.5f*req.GetHeight() + hfHeight);
-			glEnd();
-		}
+        if (_thumbnailPending)
+        {
+            requestIdleCallback();
+        }
 	}
 
 	glPopAttrib();
@@ -215,6 +210,54 @@ bool TexturePreviewCombo::_onRender()
 	return true;
 }
 
+void TexturePreviewCombo::drawPreviewQuad(GLuint textureNum, std::size_t imageWidth, std::size_t imageHeight,
+    float s0, float t0, float s1, float t1)
+{
+    if (imageWidth == 0 || imageHeight == 0) return;
+
+	auto req = _glWidget->GetClientSize();
+
+	glBindTexture(GL_TEXTURE_2D, textureNum);
+
+	// Calculate the correct aspect ratio for preview
+	auto aspect = static_cast<float>(imageWidth) / imageHeight;
+	float hfWidth, hfHeight;
+
+	if (aspect > 1.0f)
+	{
+		hfWidth = 0.5f * req.GetWidth();
+		hfHeight = 0.5f * req.GetHeight() / aspect;
+	}
+	else
+	{
+		hfHeight = 0.5f * req.GetWidth();
+		hfWidth = 0.5f * req.GetHeight() * aspect;
+	}
+
+	// Draw a quad to put the texture on
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	glColor3f(1, 1, 1);
+
+	glBegin(GL_QUADS);
+	glTexCoord2f(s0, t1);
+	glVertex2f(0.5f*req.GetWidth() - hfWidth, 0.5f*req.GetHeight() - hfHeight);
+	glTexCoord2f(s1, t1);
+	glVertex2f(0.5f*req.GetWidth() + hfWidth, 0.5f*req.GetHeight() - hfHeight);
+	glTexCoord2f(s1, t0);
+	glVertex2f(0.5f*req.GetWidth() + hfWidth, 0.5f*req.GetHeight() + hfHeight);
+	glTexCoord2f(s0, t0);
+	glVertex2f(0.5f*req.GetWidth() - hfWidth, 0.5f*req.GetHeight() + hfHeight);
+	glEnd();
+}
+
+void TexturePreviewCombo::onIdle()
+{
+    if (_thumbnailPending)
+    {
+        _glWidget->Refresh(false);
+    }
+}
+
 void TexturePreviewCombo::loadLightTexturePrefixes()
 {
     _lightTexturePrefixes = game::current::getLightTexturePrefixes();
@@ -2,6 +2,7 @@
 
 #include <string>
 #include "wxutil/menu/PopupMenu.h"
+#include "wxutil/event/SingleIdleCallback.h"
 #include <wx/panel.h>
 
 #include "ui/ideclpreview.h"
@@ -23,7 +24,8 @@ namespace ui
  */
 class TexturePreviewCombo :
 	public wxPanel,
-    public IDeclarationPreview
+    public IDeclarationPreview,
+    protected wxutil::SingleIdleCallback
 {
 	// The OpenGL preview widget
 	wxutil::GLWidget* _glWidget;
@@ -39,11 +41,15 @@ class TexturePreviewCombo :
 
     std::vector<std::string> _lightTexturePrefixes;
 
+    // True while the thumbnail is still being generated
+    bool _thumbnailPending;
+
 public:
 
 	/** Constructor creates widgets.
 	 */
 	TexturePreviewCombo(wxWindow* parent);
+    ~TexturePreviewCombo() override;
 
     wxWindow* GetPreviewWidget() override
     {
@@ -66,6 +72,13 @@ private:
 	// render callback
 	bool _onRender();
 
+    // Draws the texture into a centered quad, keeping the aspect ratio of the image
+    void drawPreviewQuad(GLuint textureNum, std::size_t imageWidth, std::size_t imageHeight,
+        float s0, float t0, float s1, float t1);
+
+    // Redraws the preview until the thumbnail has been uploaded
+    void onIdle() override;
+
 	// Refresh info table utility function
 	void refreshInfoTable();
 
@@ -245,7 +245,7 @@ void StatusBarManager::rebuildStatusBar()
         // A few default elements don't need to use 1 as proportion
         auto proportion = i->first == StandardPosition::MapStatistics || i->first == StandardPosition::GridSize ||
             i->first == StandardPosition::MapEditStopwatch || i->first == StandardPosition::OrthoViewPosition ||
-            i->first == StandardPosition::Commands ? 0 : 1;
+            i->first == StandardPosition::Commands || i->first == StandardPosition::UndoMemory ? 0 : 1;
 
 		_statusBar->GetSizer()->Add(i->second->toplevel, proportion, flags, spacing);
 
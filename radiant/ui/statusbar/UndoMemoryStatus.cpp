@@ -0,0 +1,82 @@
+#include "UndoMemoryStatus.h"
+
+#include "i18n.h"
+#include "iundo.h"
+#include "iradiant.h"
+#include "ui/istatusbarmanager.h"
+#include "string/format.h"
+#include <fmt/format.h>
+
+namespace ui
+{
+
+namespace statusbar
+{
+
+namespace
+{
+    const char* const STATUS_BAR_ELEMENT = "UndoMemory";
+}
+
+UndoMemoryStatus::UndoMemoryStatus()
+{
+    _mapOperationListener = GlobalRadiantCore().getMessageBus().addListener(
+        radiant::IMessage::MapOperationFinished,
+        radiant::TypeListener<map::OperationMessage>(
+            sigc::mem_fun(this, &UndoMemoryStatus::onOperationFinished)));
+
+    _mapEventConn = GlobalMapModule().signal_mapEvent().connect(
+        sigc::mem_fun(this, &UndoMemoryStatus::onMapEvent)
+    );
+
+    GlobalStatusBarManager().addTextElement(STATUS_BAR_ELEMENT, "", StandardPosition::UndoMemory,
+        _("Memory used by the undo history\n(Amount moved to a temporary file shown in parentheses)"));
+
+    requestIdleCallback();
+}
+
+UndoMemoryStatus::~UndoMemoryStatus()
+{
+    _mapEventConn.disconnect();
+    GlobalRadiantCore().getMessageBus().removeListener(_mapOperationListener);
+}
+
+void UndoMemoryStatus::onOperationFinished(map::OperationMessage& message)
+{
+    requestIdleCallback();
+}
+
+void UndoMemoryStatus::onMapEvent(IMap::MapEvent ev)
+{
+    if (ev == IMap::MapLoaded || ev == IMap::MapUnloaded)
+    {
+        requestIdleCallback();
+    }
+}
+
+void UndoMemoryStatus::onIdle()
+{
+    IUndoSystem::MemoryUsage usage;
+
+    try
+    {
+        usage = GlobalMapModule().getUndoSystem().getMemoryUsage();
+    }
+    catch (const std::runtime_error&)
+    {
+        // No map loaded, leave the usage at zero
+    }
+
+    auto text = fmt::format(_("Undo: {0}"), string::getFormattedByteSize(usage.inMemory));
+
+    if (usage.onDisk > 0)
+    {
+        text += fmt::format(" ({0})", string::getFormattedByteSize(usage.onDisk));
+    }
+
+    GlobalStatusBarManager().setText(STATUS_BAR_ELEMENT, text);
+}
+
+}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <sigc++/connection.h>
+#include "imap.h"
+#include "wxutil/event/SingleIdleCallback.h"
+#include "messages/MapOperationMessage.h"
+
+namespace ui
+{
+
+namespace statusbar
+{
+
+// Status bar element showing the memory taken by the undo history of the current map
+class UndoMemoryStatus final :
+    private wxutil::SingleIdleCallback
+{
+private:
+    std::size_t _mapOperationListener;
+    sigc::connection _mapEventConn;
+
+public:
+    UndoMemoryStatus();
+
+    ~UndoMemoryStatus();
+
+protected:
+    void onIdle() override;
+
+private:
+    void onOperationFinished(map::OperationMessage& message);
+    void onMapEvent(IMap::MapEvent ev);
+};
+
+}
+
+}
@@ -9,6 +9,7 @@
 #include "ifavourites.h"
 #include "ishaderclipboard.h"
 #include "icommandsystem.h"
+#include "ishaders.h"
 
 #include "wxutil/menu/IconTextMenuItem.h"
 #include "wxutil/GLWidget.h"
@@ -49,6 +50,32 @@ namespace
 
     constexpr int VIEWPORT_BORDER = 12;
     constexpr int TILE_BORDER = 2;
+
+    // Layout size of tiles whose thumbnail hasn't been generated yet
+    constexpr int PLACEHOLDER_IMAGE_SIZE = 128;
+
+    // Returns the dimensions of the material's editor image. As long as the thumbnail
+    // isn't ready, a placeholder size is returned. Failed thumbnails fall back to the
+    // editor image itself (which will be the shader-not-found image in most cases).
+    Vector2i getMaterialImageSize(const MaterialPtr& material, const MaterialThumbnail& thumbnail)
+    {
+        if (thumbnail.failed)
+        {
+            auto texture = material->getEditorImage();
+
+            if (texture)
+            {
+                return Vector2i(static_cast<int>(texture->getWidth()), static_cast<int>(texture->getHeight()));
+            }
+        }
+
+        if (thumbnail.imageWidth == 0 || thumbnail.imageHeight == 0)
+        {
+            return Vector2i(PLACEHOLDER_IMAGE_SIZE, PLACEHOLDER_IMAGE_SIZE);
+        }
+
+        return Vector2i(static_cast<int>(thumbnail.imageWidth), static_cast<int>(thumbnail.imageHeight));
+    }
 }
 
 class TextureThumbnailBrowser::TextureTile
@@ -60,21 +87,44 @@ public:
     Vector2i position;
     MaterialPtr material;
 
+    // The image size the layout has been calculated with
+    Vector2i imageSize;
+
     TextureTile(TextureThumbnailBrowser& owner) :
         _owner(owner)
     {}
 
     void render(bool drawName)
     {
-        TexturePtr texture = material->getEditorImage();
-        if (!texture) return;
-
         // Is this texture visible?
         if ((position.y() - size.y() - FONT_HEIGHT() < _owner.getOriginY()) &&
             (position.y() > _owner.getOriginY() - _owner.getViewportHeight()))
         {
+            // Only the visible tiles request their thumbnail, to keep it in the atlas
+            auto thumbnail = GlobalMaterialManager().getMaterialThumbnail(material->getName(), &_owner);
+
+            // Re-arrange the tiles once the actual image size is known
+            if (getMaterialImageSize(material, thumbnail) != imageSize)
+            {
+                _owner.queueUpdate();
+            }
+
             drawBorder();
-            drawTextureQuad(texture->getGLTexNum());
+
+            if (thumbnail.textureNum != 0)
+            {
+                drawTextureQuad(thumbnail.textureNum, thumbnail.s0, thumbnail.t0, thumbnail.s1, thumbnail.t1);
+            }
+            else if (thumbnail.failed)
+            {
+                auto texture = material->getEditorImage();
+
+                if (texture)
+                {
+                    drawTextureQuad(texture->getGLTexNum(), 0, 0, 1, 1);
+                }
+            }
+
             if (drawName)
                 drawTextureName();
         }
@@ -153,20 +203,20 @@ private:
         }
     }
 
-    void drawTextureQuad(GLuint num)
+    void drawTextureQuad(GLuint num, float s0, float t0, float s1, float t1)
     {
         glBindTexture(GL_TEXTURE_2D, num);
         debug::assertNoGlErrors();
         glColor3f(1, 1, 1);
 
         glBegin(GL_QUADS);
-        glTexCoord2i(0, 0);
+        glTexCoord2f(s0, t0);
         glVertex2i(position.x(), position.y() - FONT_HEIGHT());
-        glTexCoord2i(1, 0);
+        glTexCoord2f(s1, t0);
         glVertex2i(position.x() + size.x(), position.y() - FONT_HEIGHT());
-        glTexCoord2i(1, 1);
+        glTexCoord2f(s1, t1);
         glVertex2i(position.x() + size.x(), position.y() - FONT_HEIGHT() - size.y());
-        glTexCoord2i(0, 1);
+        glTexCoord2f(s0, t1);
         glVertex2i(position.x(), position.y() - FONT_HEIGHT() - size.y());
         glEnd();
     }
@@ -217,7 +267,8 @@ TextureThumbnailBrowser::TextureThumbnailBrowser(wxWindow* parent, bool showTool
     _useUniformScale(registry::getValue<bool>(RKEY_TEXTURE_USE_UNIFORM_SCALE)),
     _uniformTextureSize(registry::getValue<int>(RKEY_TEXTURE_UNIFORM_SIZE)),
     _maxNameLength(registry::getValue<int>(RKEY_TEXTURE_MAX_NAME_LENGTH)),
-    _updateNeeded(true)
+    _updateNeeded(true),
+    _texturesPending(false)
 {
     observeKey(RKEY_TEXTURE_UNIFORM_SIZE);
     observeKey(RKEY_TEXTURE_USE_UNIFORM_SCALE);
@@ -330,6 +381,11 @@ TextureThumbnailBrowser::TextureThumbnailBrowser(wxWindow* parent, bool showTool
     updateScroll();
 }
 
+TextureThumbnailBrowser::~TextureThumbnailBrowser()
+{
+    GlobalMaterialManager().releaseThumbnailView(this);
+}
+
 void TextureThumbnailBrowser::loadScaleFromRegistry()
 {
     int index = registry::getValue<int>(RKEY_TEXTURE_SCALE);
@@ -420,14 +476,14 @@ void TextureThumbnailBrowser::keyChanged()
 }
 
 // Return the display width of a texture in the texture browser
-int TextureThumbnailBrowser::getTextureWidth(const Texture& tex) const
+int TextureThumbnailBrowser::getTextureWidth(const Vector2i& imageSize) const
 {
     if (!_useUniformScale)
     {
         // Don't use uniform scale
-        return static_cast<int>(tex.getWidth() * (static_cast<float>(_textureScale) / 100));
+        return static_cast<int>(imageSize.x() * (static_cast<float>(_textureScale) / 100));
     }
-    else if (tex.getWidth() >= tex.getHeight())
+    else if (imageSize.x() >= imageSize.y())
     {
         // Texture is square, or wider than it is tall
         return _uniformTextureSize;
@@ -436,19 +492,19 @@ int TextureThumbnailBrowser::getTextureWidth(const Texture& tex) const
     {
         // Otherwise, preserve the texture's aspect ratio
         return static_cast<int>(_uniformTextureSize *
-            (static_cast<float>(tex.getWidth()) / tex.getHeight())
+            (static_cast<float>(imageSize.x()) / imageSize.y())
         );
     }
 }
 
-int TextureThumbnailBrowser::getTextureHeight(const Texture& tex) const
+int TextureThumbnailBrowser::getTextureHeight(const Vector2i& imageSize) const
 {
     if (!_useUniformScale)
     {
         // Don't use uniform scale
-        return static_cast<int>(tex.getHeight() * (static_cast<float>(_textureScale) / 100));
+        return static_cast<int>(imageSize.y() * (static_cast<float>(_textureScale) / 100));
     }
-    else if (tex.getHeight() >= tex.getWidth())
+    else if (imageSize.y() >= imageSize.x())
     {
         // Texture is square, or taller than it is wide
         return _uniformTextureSize;
@@ -458,7 +514,7 @@ int TextureThumbnailBrowser::getTextureHeight(const Texture& tex) const
         // Otherwise, preserve the texture's aspect ratio
         return static_cast<int>(
             _uniformTextureSize
-            * (static_cast<float>(tex.getHeight()) / tex.getWidth())
+            * (static_cast<float>(imageSize.y()) / imageSize.x())
         );
     }
 }
@@ -519,12 +575,12 @@ TextureThumbnailBrowser::CurrentPosition::CurrentPosition()
 : origin(VIEWPORT_BORDER, -VIEWPORT_BORDER), rowAdvance(0)
 { }
 
-Vector2i TextureThumbnailBrowser::getNextPositionForTexture(const Texture& tex)
+Vector2i TextureThumbnailBrowser::getNextPositionForTexture(const Vector2i& imageSize)
 {
     auto& currentPos = *_currentPopulationPosition;
 
-    int nWidth = getTextureWidth(tex);
-    int nHeight = getTextureHeight(tex);
+    int nWidth = getTextureWidth(imageSize);
+    int nHeight = getTextureHeight(imageSize);
 
     // Wrap to the next row if there is not enough horizontal space for this
     // texture
@@ -606,11 +662,15 @@ void TextureThumbnailBrowser::createTileForMaterial(const MaterialPtr& material)
 
     tile.material = material;
 
-    Texture& texture = *tile.material->getEditorImage();
+    // The layout is based on the thumbnail, the full-size editor image is not loaded.
+    // Thumbnails are only generated for the visible tiles, the others are using
+    // the placeholder size until they're drawn for the first time.
+    auto thumbnail = GlobalMaterialManager().findMaterialThumbnail(material->getName());
+    tile.imageSize = getMaterialImageSize(material, thumbnail);
 
-    tile.position = getNextPositionForTexture(texture);
-    tile.size.x() = getTextureWidth(texture);
-    tile.size.y() = getTextureHeight(texture);
+    tile.position = getNextPositionForTexture(tile.imageSize);
+    tile.size.x() = getTextureWidth(tile.imageSize);
+    tile.size.y() = getTextureHeight(tile.imageSize);
 
     _entireSpaceHeight = std::max(
         _entireSpaceHeight,
@@ -952,6 +1012,10 @@ void TextureThumbnailBrowser::onIdle()
         refreshTiles();
         queueDraw();
     }
+    else if (_texturesPending)
+    {
+        queueDraw();
+    }
 }
 
 bool TextureThumbnailBrowser::onRender()
@@ -963,10 +1027,20 @@ bool TextureThumbnailBrowser::onRender()
 
 	debug::assertNoGlErrors();
 
+    // This view isn't using the render system's frames, so upload the
+    // textures which finished loading in the meantime on our own
+    GlobalMaterialManager().beginThumbnailFrame(this);
+    _texturesPending = GlobalMaterialManager().processTextureUploads();
+
     draw();
 
     debug::assertNoGlErrors();
 
+    if (_texturesPending)
+    {
+        requestIdleCallback();
+    }
+
     return true;
 }
 
@@ -102,6 +102,9 @@ class TextureThumbnailBrowser :
     // renderable items will be updated next round
     bool _updateNeeded;
 
+    // true while the material manager is still loading textures in the background
+    bool _texturesPending;
+
     // Data structure keeping track of the virtual position for the next texture to
     // be drawn in. Only the getNextPositionForTexture() method should access the values
     // in this structure.
@@ -117,6 +120,7 @@ class TextureThumbnailBrowser :
 
 public:
     TextureThumbnailBrowser(wxWindow* parent, bool showToolbar = true);
+    ~TextureThumbnailBrowser() override;
 
     // Schedules an update of the renderable items
     void queueUpdate();
@@ -160,13 +164,13 @@ private:
     // Repopulates the texture tiles
     void refreshTiles();
 
-    // Return the display width/height of a texture in the texture browser
-    int getTextureWidth(const Texture& tex) const;
-    int getTextureHeight(const Texture& tex) const;
+    // Return the display width/height of an image of the given size in the texture browser
+    int getTextureWidth(const Vector2i& imageSize) const;
+    int getTextureHeight(const Vector2i& imageSize) const;
 
-    // Get a new position for the given texture, and advance the CurrentPosition
+    // Get a new position for an image of the given size, and advance the CurrentPosition
     // state object.
-    Vector2i getNextPositionForTexture(const Texture& texture);
+    Vector2i getNextPositionForTexture(const Vector2i& imageSize);
 
     bool checkSeekInMediaBrowser(); // sensitivity check
     void onSeekInMediaBrowser();
@@ -10,6 +10,7 @@
 #include "Face.h"
 #include "FixedWinding.h"
 #include "math/Ray.h"
+#include "UndoMementoArena.h"
 
 #include <functional>
 
@@ -140,7 +141,7 @@ void Brush::connectUndoSystem(IUndoSystem& undoSystem)
 {
     assert(_undoStateSaver == nullptr);
 
-	_undoStateSaver = undoSystem.getStateSaver(*this);
+	_undoStateSaver = undoSystem.getStateSaver(*this, &_owner);
 
     forEachFace([&](Face& face) { face.connectUndoSystem(undoSystem); });
 }
@@ -237,6 +238,11 @@ void Brush::evaluateBRep() const {
     }
 }
 
+bool Brush::needsBRepEvaluation() const
+{
+    return m_planeChanged;
+}
+
 void Brush::transformChanged() {
     m_transformChanged = true;
     onFacePlaneChanged();
@@ -321,7 +327,17 @@ void Brush::undoSave()
 
 IUndoMementoPtr Brush::exportState() const
 {
-    return IUndoMementoPtr(new BrushUndoMemento(m_faces, _detailFlag));
+    auto faces = _lastSavedFaces.lock();
+
+    // Only copy the face list if faces have been added or removed since the last export.
+    // Not using make_shared, the memory would be kept alive by the weak reference.
+    if (!faces || *faces != m_faces)
+    {
+        faces.reset(new Faces(m_faces));
+        _lastSavedFaces = faces;
+    }
+
+    return undo::allocateMemento<BrushUndoMemento>(faces, _detailFlag);
 }
 
 void Brush::importState(const IUndoMementoPtr& state)
@@ -331,7 +347,8 @@ void Brush::importState(const IUndoMementoPtr& state)
 	BrushUndoMemento& memento = *std::static_pointer_cast<BrushUndoMemento>(state);
 
 	_detailFlag = memento._detailFlag;
-    appendFaces(memento._faces);
+    appendFaces(*memento._faces);
+    _lastSavedFaces = memento._faces;
 
     onFacePlaneChanged();
 
@@ -449,7 +466,10 @@ void Brush::onFaceShaderChanged()
     // therefore no call to onFacePlaneChanged() is necessary
 
     // Queue an UI update of the texture tools if any of them is listening
-	signal_faceShaderChanged().emit();
+    if (!scene::sceneNotificationsSuppressed())
+    {
+        signal_faceShaderChanged().emit();
+    }
 }
 
 void Brush::onFaceConnectivityChanged()
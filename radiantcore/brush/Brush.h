@@ -96,6 +96,9 @@ private:
 	Observers m_observers;
 	IUndoStateSaver* _undoStateSaver;
 
+	// The face list referenced by the most recent undo memento
+	mutable std::weak_ptr<const Faces> _lastSavedFaces;
+
 	// state
 	Faces m_faces;
 	// ----
@@ -142,18 +145,25 @@ private:
 
 public:
 	/// \brief The undo memento for a brush stores only the list of face references - the faces are not copied.
+	/// The list itself is immutable and shared by all mementos exported while the face set didn't change.
 	class BrushUndoMemento :
 		public IUndoMemento
 	{
 	public:
-		BrushUndoMemento(const Faces& faces, DetailFlag detailFlag) :
+		BrushUndoMemento(const std::shared_ptr<const Faces>& faces, DetailFlag detailFlag) :
 			_faces(faces),
 			_detailFlag(detailFlag)
 		{}
 
 		virtual ~BrushUndoMemento() {}
 
-		Faces _faces;
+		// The face list is shared, it's not counted here
+		std::size_t getMemoryUsage() const override
+		{
+			return sizeof(*this);
+		}
+
+		std::shared_ptr<const Faces> _faces;
 		DetailFlag _detailFlag;
 	};
 
@@ -216,6 +226,8 @@ public:
 
 	void evaluateBRep() const override;
 
+	bool needsBRepEvaluation() const override;
+
     void transformChanged();
     void evaluateTransform();
 
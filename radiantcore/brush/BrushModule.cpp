@@ -10,6 +10,7 @@
 #include "brush/BrushNode.h"
 #include "brush/BrushClipPlane.h"
 #include "brush/BrushVisit.h"
+#include "brush/PlaneKernel.h"
 #include "gamelib.h"
 #include "selectionlib.h"
 
@@ -58,6 +59,19 @@ void BrushModuleImpl::keyChanged()
 	_textureLockEnabled = registry::getValue<bool>(RKEY_ENABLE_TEXTURE_LOCK);
 }
 
+void BrushModuleImpl::planeKernelChanged()
+{
+	auto requested = getPlaneKernelForName(registry::getValue<std::string>(RKEY_BRUSH_PLANE_KERNEL));
+	auto kernel = setPlaneKernel(requested);
+
+	if (kernel != requested)
+	{
+		rWarning() << "Plane kernel " << getPlaneKernelName(requested) << " is not supported by this CPU" << std::endl;
+	}
+
+	rMessage() << "Using the " << getPlaneKernelName(kernel) << " plane kernel for brush windings" << std::endl;
+}
+
 bool BrushModuleImpl::textureLockEnabled() const {
 	return _textureLockEnabled;
 }
@@ -121,6 +135,12 @@ void BrushModuleImpl::initialiseModule(const IApplicationContext& ctx) {
 		sigc::mem_fun(this, &BrushModuleImpl::keyChanged)
 	);
 
+	planeKernelChanged();
+
+	GlobalRegistry().signalForKey(RKEY_BRUSH_PLANE_KERNEL).connect(
+		sigc::mem_fun(this, &BrushModuleImpl::planeKernelChanged)
+	);
+
 	// add the preference settings
 	constructPreferences();
 
@@ -24,6 +24,7 @@ private:
 
 private:
 	void keyChanged();
+	void planeKernelChanged();
 
 	void registerBrushCommands();
 
@@ -14,21 +14,110 @@
 #include "Brush.h"
 #include "BrushNode.h"
 #include "BrushModule.h"
+#include "UndoMementoData.h"
 
-// The structure that is saved in the undostack
+namespace
+{
+    // Plane3::operator== is fuzzy, the saved state needs to restore the exact plane
+    bool planesAreIdentical(const Plane3& a, const Plane3& b)
+    {
+        return a.normal() == b.normal() && a.dist() == b.dist();
+    }
+}
+
+// The structure that is saved in the undostack. Plane and texture projection are small enough
+// to be copied, a reference to them would take about the same space. The material name
+// is immutable and shared with the state saved before, if it didn't change in between.
+// While the operation holding this state is compressed, all values are moved out of memory.
 class Face::SavedState final :
     public IUndoMemento
 {
 public:
-    FacePlane::SavedState _planeState;
-    TextureProjection _texdefState;
-    std::string _materialName;
-
-    SavedState(const Face& face) :
-        _planeState(face.getPlane()),
-        _texdefState(face.getProjection()),
-        _materialName(face.getShader())
+    struct Values
+    {
+        Plane3 plane;
+        TextureProjection texdef;
+    };
+
+    // Null while the data is saved to the compressed operation
+    std::unique_ptr<Values> _values;
+    std::shared_ptr<const std::string> _materialName;
+
+    SavedState(const Face& face, const std::shared_ptr<const std::string>& previousMaterialName) :
+        _values(new Values{ face.getPlane().getPlane(), face.getProjection() }),
+        _materialName(previousMaterialName && *previousMaterialName == face.getShader() ?
+            previousMaterialName : std::make_shared<const std::string>(face.getShader()))
     {}
+
+    // The material name is shared, it's not counted here
+    std::size_t getMemoryUsage() const override
+    {
+        return sizeof(*this) + (_values ? sizeof(Values) : 0);
+    }
+
+    bool saveData(std::ostream& stream) override
+    {
+        const auto& normal = _values->plane.normal();
+        auto texdef = _values->texdef.getMatrix();
+
+        undo::writeValue(stream, normal.x());
+        undo::writeValue(stream, normal.y());
+        undo::writeValue(stream, normal.z());
+        undo::writeValue(stream, _values->plane.dist());
+
+        // The last row of the texture matrix is always (0 0 1)
+        undo::writeValue(stream, texdef.xx());
+        undo::writeValue(stream, texdef.yx());
+        undo::writeValue(stream, texdef.zx());
+        undo::writeValue(stream, texdef.xy());
+        undo::writeValue(stream, texdef.yy());
+        undo::writeValue(stream, texdef.zy());
+
+        undo::writeString(stream, *_materialName);
+
+        _values.reset();
+        _materialName.reset();
+
+        return true;
+    }
+
+    void loadData(std::istream& stream) override
+    {
+        Vector3 normal;
+        double dist = 0;
+
+        undo::readValue(stream, normal.x());
+        undo::readValue(stream, normal.y());
+        undo::readValue(stream, normal.z());
+        undo::readValue(stream, dist);
+
+        auto texdef = Matrix3::getIdentity();
+
+        undo::readValue(stream, texdef.xx());
+        undo::readValue(stream, texdef.yx());
+        undo::readValue(stream, texdef.zx());
+        undo::readValue(stream, texdef.xy());
+        undo::readValue(stream, texdef.yy());
+        undo::readValue(stream, texdef.zy());
+
+        std::string materialName;
+        undo::readString(stream, materialName);
+
+        // Construct the projection from the matrix directly, setTransform() would reject degenerate ones
+        _values.reset(new Values{ Plane3(normal, dist), TextureProjection(TextureMatrix(texdef)) });
+        _materialName = std::make_shared<const std::string>(std::move(materialName));
+    }
+
+    bool isDataSaved() const
+    {
+        return !_values;
+    }
+
+    bool matches(const Face& face) const
+    {
+        return planesAreIdentical(_values->plane, face.getPlane().getPlane()) &&
+            _values->texdef == face.getProjection() && *_materialName == face.getShader();
+    }
 };
 
 Face::Face(Brush& owner) :
@@ -175,7 +264,7 @@ void Face::connectUndoSystem(IUndoSystem& undoSystem)
 
     updateRenderables();
 
-    _undoStateSaver = undoSystem.getStateSaver(*this);
+    _undoStateSaver = undoSystem.getStateSaver(*this, &_owner.getBrushNode());
 }
 
 void Face::disconnectUndoSystem(IUndoSystem& undoSystem)
@@ -201,7 +290,25 @@ void Face::undoSave()
 // undoable
 IUndoMementoPtr Face::exportState() const
 {
-    return std::make_shared<SavedState>(*this);
+    auto previous = _lastSavedState.lock();
+
+    // The data of the last memento has been moved to a compressed operation, it can't be shared anymore
+    if (previous && previous->isDataSaved())
+    {
+        previous.reset();
+    }
+
+    // Nothing changed since the last export, the same memento can be referenced twice
+    if (previous && previous->matches(*this))
+    {
+        return previous;
+    }
+
+    // Neither make_shared nor the operation's arena, the memory would be kept alive by the weak reference
+    std::shared_ptr<SavedState> state(new SavedState(*this, previous ? previous->_materialName : nullptr));
+
+    _lastSavedState = state;
+    return state;
 }
 
 void Face::importState(const IUndoMementoPtr& data)
@@ -210,9 +317,12 @@ void Face::importState(const IUndoMementoPtr& data)
 
     auto state = std::static_pointer_cast<SavedState>(data);
 
-    state->_planeState.exportState(getPlane());
-    setShader(state->_materialName);
-    _texdef = state->_texdefState;
+    getPlane().setPlane(state->_values->plane);
+    setShader(*state->_materialName);
+    _texdef = state->_values->texdef;
+
+    // The face is now matching the imported state, the next export can share its data
+    _lastSavedState = state;
 
     planeChanged();
     _owner.onFaceConnectivityChanged();
@@ -450,7 +560,10 @@ void Face::texdefChanged()
     updateRenderables();
 
     // Fire the signal to update the Texture Tools
-    signal_texdefChanged().emit();
+    if (!scene::sceneNotificationsSuppressed())
+    {
+        signal_texdefChanged().emit();
+    }
 }
 
 const TextureProjection& Face::getProjection() const
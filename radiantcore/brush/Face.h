@@ -55,6 +55,9 @@ private:
 
 	IUndoStateSaver* _undoStateSaver;
 
+    // The most recently exported undo state, unchanged parts are shared with the next one
+    mutable std::weak_ptr<SavedState> _lastSavedState;
+
 	// Cached visibility flag, queried during front end rendering
 	bool _faceIsVisible;
 
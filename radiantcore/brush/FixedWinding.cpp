@@ -2,6 +2,7 @@
 
 #include "Brush.h"
 #include "Winding.h"
+#include "PlaneKernel.h"
 #include "itextstream.h"
 
 namespace {
@@ -132,7 +133,24 @@ void FixedWinding::clip(const Plane3& plane, const Plane3& clipPlane, std::size_
 		return; // Degenerate winding, exit
 	}
 
-	PlaneClassification classification = Winding::classifyDistance(clipPlane.distanceToPoint(back().vertex), ON_EPSILON);
+	// Calculate all distances to the clip plane in one go
+	brush::WindingPoints points;
+	points.assign(begin(), end());
+
+	auto split = points.classify(clipPlane, ON_EPSILON);
+
+	// Nothing behind the plane, the winding is kept as it is
+	if (split.counts[ePlaneBack] == 0) {
+		clipped.insert(clipped.end(), begin(), end());
+		return;
+	}
+
+	// Everything behind the plane, nothing is left
+	if (split.counts[ePlaneFront] == 0 && split.counts[ePlaneOn] == 0) {
+		return;
+	}
+
+	PlaneClassification classification = Winding::classifyDistance(points.getDistance(size() - 1), ON_EPSILON);
 	PlaneClassification nextClassification;
 
 	// for each edge
@@ -140,7 +158,7 @@ void FixedWinding::clip(const Plane3& plane, const Plane3& clipPlane, std::size_
 		 next != size();
 		 i = next, ++next, classification = nextClassification)
 	{
-		nextClassification = Winding::classifyDistance(clipPlane.distanceToPoint((*this)[next].vertex), ON_EPSILON);
+		nextClassification = Winding::classifyDistance(points.getDistance(next), ON_EPSILON);
 		const FixedWindingVertex& vertex = (*this)[i];
 
 		// if first vertex of edge is ON
@@ -0,0 +1,263 @@
+#include "PlaneKernel.h"
+
+#include <atomic>
+#include "iclipper.h"
+#include "string/case_conv.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PLANE_KERNEL_X86_64
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC allows AVX intrinsics in any function, GCC and clang need them to be enabled per function.
+// FMA is deliberately not enabled, to keep the rounding the same as in the scalar code.
+#if defined(PLANE_KERNEL_X86_64) && (defined(__GNUC__) || defined(__clang__))
+#define PLANE_KERNEL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define PLANE_KERNEL_TARGET_AVX2
+#endif
+
+namespace brush
+{
+
+namespace
+{
+    std::atomic<PlaneKernel> _activeKernel(getFastestPlaneKernel());
+
+    // The scalar part, also used for the points left over by the SIMD loops
+    void classifyScalar(const double* x, const double* y, const double* z, std::size_t begin, std::size_t end,
+        const Plane3& plane, double epsilon, double* distances, BrushSplitType& split)
+    {
+        for (auto i = begin; i < end; ++i)
+        {
+            auto distance = x[i] * plane.normal().x() + y[i] * plane.normal().y() + z[i] * plane.normal().z() - plane.dist();
+            distances[i] = distance;
+
+            ++split.counts[distance > epsilon ? ePlaneFront : distance < -epsilon ? ePlaneBack : ePlaneOn];
+        }
+    }
+
+#ifdef PLANE_KERNEL_X86_64
+
+    // Number of bits set in a movemask result of up to four lanes
+    constexpr std::size_t BIT_COUNT[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+    bool cpuSupportsAVX2()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+
+        if (info[0] < 7) return false;
+
+        // The OS has to save the YMM registers on context switches
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+
+        if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        // Might be called during static initialisation, before libgcc did this itself
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    void classifySSE2(const double* x, const double* y, const double* z, std::size_t size,
+        const Plane3& plane, double epsilon, double* distances, BrushSplitType& split)
+    {
+        auto nx = _mm_set1_pd(plane.normal().x());
+        auto ny = _mm_set1_pd(plane.normal().y());
+        auto nz = _mm_set1_pd(plane.normal().z());
+        auto dist = _mm_set1_pd(plane.dist());
+        auto front = _mm_set1_pd(epsilon);
+        auto back = _mm_set1_pd(-epsilon);
+
+        std::size_t frontCount = 0;
+        std::size_t backCount = 0;
+        std::size_t i = 0;
+
+        for (; i + 2 <= size; i += 2)
+        {
+            auto distance = _mm_sub_pd(_mm_add_pd(_mm_add_pd(
+                _mm_mul_pd(_mm_loadu_pd(x + i), nx),
+                _mm_mul_pd(_mm_loadu_pd(y + i), ny)),
+                _mm_mul_pd(_mm_loadu_pd(z + i), nz)), dist);
+
+            _mm_storeu_pd(distances + i, distance);
+
+            frontCount += BIT_COUNT[_mm_movemask_pd(_mm_cmpgt_pd(distance, front))];
+            backCount += BIT_COUNT[_mm_movemask_pd(_mm_cmplt_pd(distance, back))];
+        }
+
+        split.counts[ePlaneFront] += frontCount;
+        split.counts[ePlaneBack] += backCount;
+        split.counts[ePlaneOn] += i - frontCount - backCount;
+
+        classifyScalar(x, y, z, i, size, plane, epsilon, distances, split);
+    }
+
+    PLANE_KERNEL_TARGET_AVX2 void classifyAVX2(const double* x, const double* y, const double* z, std::size_t size,
+        const Plane3& plane, double epsilon, double* distances, BrushSplitType& split)
+    {
+        auto nx = _mm256_set1_pd(plane.normal().x());
+        auto ny = _mm256_set1_pd(plane.normal().y());
+        auto nz = _mm256_set1_pd(plane.normal().z());
+        auto dist = _mm256_set1_pd(plane.dist());
+        auto front = _mm256_set1_pd(epsilon);
+        auto back = _mm256_set1_pd(-epsilon);
+
+        std::size_t frontCount = 0;
+        std::size_t backCount = 0;
+        std::size_t i = 0;
+
+        for (; i + 4 <= size; i += 4)
+        {
+            auto distance = _mm256_sub_pd(_mm256_add_pd(_mm256_add_pd(
+                _mm256_mul_pd(_mm256_loadu_pd(x + i), nx),
+                _mm256_mul_pd(_mm256_loadu_pd(y + i), ny)),
+                _mm256_mul_pd(_mm256_loadu_pd(z + i), nz)), dist);
+
+            _mm256_storeu_pd(distances + i, distance);
+
+            frontCount += BIT_COUNT[_mm256_movemask_pd(_mm256_cmp_pd(distance, front, _CMP_GT_OQ))];
+            backCount += BIT_COUNT[_mm256_movemask_pd(_mm256_cmp_pd(distance, back, _CMP_LT_OQ))];
+        }
+
+        // Avoid the penalty of switching back to the SSE code in the rest of the program
+        _mm256_zeroupper();
+
+        split.counts[ePlaneFront] += frontCount;
+        split.counts[ePlaneBack] += backCount;
+        split.counts[ePlaneOn] += i - frontCount - backCount;
+
+        classifyScalar(x, y, z, i, size, plane, epsilon, distances, split);
+    }
+
+#endif
+}
+
+bool isPlaneKernelSupported(PlaneKernel kernel)
+{
+    switch (kernel)
+    {
+    case PlaneKernel::Scalar:
+        return true;
+#ifdef PLANE_KERNEL_X86_64
+    case PlaneKernel::SSE2:
+        return true; // part of every x86-64 CPU
+    case PlaneKernel::AVX2:
+    {
+        static bool supported = cpuSupportsAVX2();
+        return supported;
+    }
+#endif
+    default:
+        return false;
+    }
+}
+
+PlaneKernel getFastestPlaneKernel()
+{
+    if (isPlaneKernelSupported(PlaneKernel::AVX2)) return PlaneKernel::AVX2;
+    if (isPlaneKernelSupported(PlaneKernel::SSE2)) return PlaneKernel::SSE2;
+
+    return PlaneKernel::Scalar;
+}
+
+PlaneKernel setPlaneKernel(PlaneKernel kernel)
+{
+    if (!isPlaneKernelSupported(kernel))
+    {
+        kernel = getFastestPlaneKernel();
+    }
+
+    _activeKernel = kernel;
+    return kernel;
+}
+
+PlaneKernel getPlaneKernel()
+{
+    return _activeKernel;
+}
+
+std::string getPlaneKernelName(PlaneKernel kernel)
+{
+    switch (kernel)
+    {
+    case PlaneKernel::SSE2: return "sse2";
+    case PlaneKernel::AVX2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+PlaneKernel getPlaneKernelForName(const std::string& name)
+{
+    auto lowerName = string::to_lower_copy(name);
+
+    if (lowerName == "scalar") return PlaneKernel::Scalar;
+    if (lowerName == "sse2") return PlaneKernel::SSE2;
+    if (lowerName == "avx2") return PlaneKernel::AVX2;
+
+    return getFastestPlaneKernel();
+}
+
+WindingPoints::WindingPoints() :
+    _size(0),
+    _x(_inline[0]),
+    _y(_inline[1]),
+    _z(_inline[2]),
+    _distances(_inline[3])
+{}
+
+void WindingPoints::resize(std::size_t size)
+{
+    _size = size;
+
+    if (size <= InlineCapacity)
+    {
+        _x = _inline[0];
+        _y = _inline[1];
+        _z = _inline[2];
+        _distances = _inline[3];
+        return;
+    }
+
+    // Large windings are rare, the arrays are moved to the heap
+    _overflow.resize(size * 4);
+
+    _x = _overflow.data();
+    _y = _x + size;
+    _z = _y + size;
+    _distances = _z + size;
+}
+
+BrushSplitType WindingPoints::classify(const Plane3& plane, double epsilon)
+{
+    BrushSplitType split;
+
+    switch (_activeKernel.load(std::memory_order_relaxed))
+    {
+#ifdef PLANE_KERNEL_X86_64
+    case PlaneKernel::AVX2:
+        classifyAVX2(_x, _y, _z, _size, plane, epsilon, _distances, split);
+        break;
+    case PlaneKernel::SSE2:
+        classifySSE2(_x, _y, _z, _size, plane, epsilon, _distances, split);
+        break;
+#endif
+    default:
+        classifyScalar(_x, _y, _z, 0, _size, plane, epsilon, _distances, split);
+        break;
+    }
+
+    return split;
+}
+
+}
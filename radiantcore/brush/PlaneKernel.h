@@ -0,0 +1,106 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ibrush.h"
+#include "math/Plane3.h"
+#include "FixedWinding.h"
+
+namespace brush
+{
+
+/**
+ * The implementations available to classify winding points against a plane.
+ * The SIMD kernels are compiled on x86-64 only, the active one is selected at
+ * runtime depending on what the CPU is supporting.
+ */
+enum class PlaneKernel
+{
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+// Returns true if the kernel can be used on this machine
+bool isPlaneKernelSupported(PlaneKernel kernel);
+
+// The fastest kernel supported by this machine
+PlaneKernel getFastestPlaneKernel();
+
+// Selects the kernel used by all subsequent classifications. Unsupported
+// kernels are replaced by the fastest supported one, which is returned.
+PlaneKernel setPlaneKernel(PlaneKernel kernel);
+
+// The kernel currently in use
+PlaneKernel getPlaneKernel();
+
+// Conversion from and to the values used in the registry, "auto" resolves to the fastest kernel
+std::string getPlaneKernelName(PlaneKernel kernel);
+PlaneKernel getPlaneKernelForName(const std::string& name);
+
+/**
+ * \brief
+ * The vertex positions of a winding in structure-of-arrays layout, as needed
+ * by the SIMD kernels, together with the distances of the last classification.
+ *
+ * Windings with up to MAX_POINTS_ON_WINDING points are stored inline without
+ * any heap allocation, this is meant to be used as local variable.
+ */
+class WindingPoints
+{
+private:
+    static constexpr std::size_t InlineCapacity = MAX_POINTS_ON_WINDING;
+
+    std::size_t _size;
+
+    double* _x;
+    double* _y;
+    double* _z;
+    double* _distances;
+
+    alignas(32) double _inline[4][InlineCapacity];
+    std::vector<double> _overflow;
+
+public:
+    WindingPoints();
+
+    WindingPoints(const WindingPoints& other) = delete;
+    WindingPoints& operator=(const WindingPoints& other) = delete;
+
+    // Copies the vertex positions of the given range of (Fixed)WindingVertex objects
+    template<typename Iterator>
+    void assign(Iterator begin, Iterator end)
+    {
+        resize(static_cast<std::size_t>(end - begin));
+
+        for (std::size_t i = 0; begin != end; ++begin, ++i)
+        {
+            _x[i] = begin->vertex.x();
+            _y[i] = begin->vertex.y();
+            _z[i] = begin->vertex.z();
+        }
+    }
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    // The signed distance of the given point, as calculated by the last call to classify()
+    double getDistance(std::size_t index) const
+    {
+        return _distances[index];
+    }
+
+    /**
+     * Calculates the distances of all points to the given plane and returns how
+     * many of them are in front of, behind or on the plane (within epsilon).
+     * The counts are indexed by PlaneClassification, the same as Winding::classifyDistance().
+     */
+    BrushSplitType classify(const Plane3& plane, double epsilon);
+
+private:
+    void resize(std::size_t size);
+};
+
+}
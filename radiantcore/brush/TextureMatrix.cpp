@@ -134,3 +134,15 @@ bool TextureMatrix::isSane() const
            !std::isnan(_coords[1][1]) && !std::isinf(_coords[1][1]) &&
            !std::isnan(_coords[1][2]) && !std::isinf(_coords[1][2]);
 }
+
+bool TextureMatrix::operator==(const TextureMatrix& other) const
+{
+    return _coords[0][0] == other._coords[0][0] && _coords[0][1] == other._coords[0][1] &&
+           _coords[0][2] == other._coords[0][2] && _coords[1][0] == other._coords[1][0] &&
+           _coords[1][1] == other._coords[1][1] && _coords[1][2] == other._coords[1][2];
+}
+
+bool TextureMatrix::operator!=(const TextureMatrix& other) const
+{
+    return !operator==(other);
+}
@@ -72,6 +72,10 @@ public:
     // Checks if any of the matrix components are NaN or INF (in which case the matrix is not sane)
     bool isSane() const;
 
+    // Exact component-wise comparison, no epsilon involved
+    bool operator==(const TextureMatrix& other) const;
+    bool operator!=(const TextureMatrix& other) const;
+
     friend std::ostream& operator<<(std::ostream& st, const TextureMatrix& texdef);
 };
 
@@ -49,6 +49,16 @@ TextureProjection& TextureProjection::operator=(const TextureProjection& other)
     return *this;
 }
 
+bool TextureProjection::operator==(const TextureProjection& other) const
+{
+    return _matrix == other._matrix;
+}
+
+bool TextureProjection::operator!=(const TextureProjection& other) const
+{
+    return !operator==(other);
+}
+
 void TextureProjection::setTransform(const Matrix3& transform)
 {
     // Check the matrix for validity
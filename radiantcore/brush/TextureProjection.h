@@ -35,6 +35,10 @@ public:
 
     TextureProjection& operator=(const TextureProjection& other);
 
+    // Exact comparison of the texture matrices
+    bool operator==(const TextureProjection& other) const;
+    bool operator!=(const TextureProjection& other) const;
+
     void setTransform(const Matrix3& transform);
 
     // Returns the Shift/Scale/Rotation values scaled to the given image dimensions
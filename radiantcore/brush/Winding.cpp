@@ -7,6 +7,7 @@
 #include "math/Plane3.h"
 #include "texturelib.h"
 #include "Brush.h"
+#include "PlaneKernel.h"
 
 namespace {
 	struct indexremap_t {
@@ -74,14 +75,10 @@ bool Winding::testPlane(const Plane3& plane, bool flipped) const
 
 BrushSplitType Winding::classifyPlane(const Plane3& plane) const
 {
-	BrushSplitType split;
+	brush::WindingPoints points;
+	points.assign(begin(), end());
 
-	for (const_iterator i = begin(); i != end(); ++i)
-	{
-		++split.counts[classifyDistance(plane.distanceToPoint(i->vertex), ON_EPSILON)];
-	}
-
-	return split;
+	return points.classify(plane, ON_EPSILON);
 }
 
 PlaneClassification Winding::classifyDistance(const double distance, const double epsilon)
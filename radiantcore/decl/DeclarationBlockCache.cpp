@@ -0,0 +1,144 @@
+#include "DeclarationBlockCache.h"
+
+#include "itextstream.h"
+
+namespace decl
+{
+
+namespace
+{
+    constexpr const char* const CACHE_IDENTIFIER = "DarkRadiant Declaration Block Cache";
+    constexpr std::uint32_t CACHE_VERSION = 1;
+}
+
+DeclarationBlockCache::DeclarationBlockCache() :
+    _changed(false)
+{}
+
+void DeclarationBlockCache::load(const std::string& cacheFilePath)
+{
+    _files.clear();
+    _changed = false;
+
+    stream::CacheFileReader reader(cacheFilePath, CACHE_IDENTIFIER, CACHE_VERSION);
+
+    if (!reader.isValid())
+    {
+        return;
+    }
+
+    try
+    {
+        auto numFiles = reader.readUInt32();
+
+        for (std::uint32_t i = 0; i < numFiles; ++i)
+        {
+            auto fullPath = reader.readString();
+            auto& file = _files[fullPath].file;
+
+            file.archivePath = reader.readString();
+            file.stamp = reader.readFileStamp();
+            file.modName = reader.readString();
+
+            auto numBlocks = reader.readUInt32();
+            file.blocks.reserve(numBlocks);
+
+            for (std::uint32_t b = 0; b < numBlocks; ++b)
+            {
+                Block block;
+
+                block.typeName = reader.readString();
+                block.name = reader.readString();
+                block.contents = reader.readString();
+
+                file.blocks.emplace_back(std::move(block));
+            }
+        }
+    }
+    catch (const stream::CacheFileException& ex)
+    {
+        rWarning() << "Discarding declaration cache " << cacheFilePath << ": " << ex.what() << std::endl;
+        _files.clear();
+    }
+}
+
+void DeclarationBlockCache::save(const std::string& cacheFilePath)
+{
+    // Forget about the files which have been removed from the VFS
+    for (auto i = _files.begin(); i != _files.end();)
+    {
+        if (!i->second.used)
+        {
+            i = _files.erase(i);
+            _changed = true;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    if (!_changed)
+    {
+        return;
+    }
+
+    stream::CacheFileWriter writer(cacheFilePath, CACHE_IDENTIFIER, CACHE_VERSION);
+
+    writer.writeUInt32(static_cast<std::uint32_t>(_files.size()));
+
+    for (const auto& [fullPath, cachedFile] : _files)
+    {
+        const auto& file = cachedFile.file;
+
+        writer.writeString(fullPath);
+        writer.writeString(file.archivePath);
+        writer.writeFileStamp(file.stamp);
+        writer.writeString(file.modName);
+        writer.writeUInt32(static_cast<std::uint32_t>(file.blocks.size()));
+
+        for (const auto& block : file.blocks)
+        {
+            writer.writeString(block.typeName);
+            writer.writeString(block.name);
+            writer.writeString(block.contents);
+        }
+    }
+
+    if (writer.commit())
+    {
+        _changed = false;
+    }
+}
+
+const DeclarationBlockCache::File* DeclarationBlockCache::find(const std::string& fullPath,
+    const std::string& archivePath, const stream::FileStamp& stamp)
+{
+    auto found = _files.find(fullPath);
+
+    if (found == _files.end() || !stamp.isValid() ||
+        found->second.file.stamp != stamp || found->second.file.archivePath != archivePath)
+    {
+        return nullptr;
+    }
+
+    found->second.used = true;
+    return &found->second.file;
+}
+
+void DeclarationBlockCache::store(const std::string& fullPath, File file)
+{
+    if (!file.stamp.isValid())
+    {
+        return;
+    }
+
+    auto& cachedFile = _files[fullPath];
+
+    cachedFile.file = std::move(file);
+    cachedFile.used = true;
+
+    _changed = true;
+}
+
+}
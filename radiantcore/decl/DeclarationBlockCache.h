@@ -0,0 +1,66 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "stream/CacheFile.h"
+
+namespace decl
+{
+
+/**
+ * Persistent cache of the raw declaration blocks found in the files of a decl
+ * folder, saving the syntax parsing of unchanged files at startup.
+ * Files are stamped with the size and modification time of the physical file
+ * they're stored in, which is the PK4 archive for packed files.
+ */
+class DeclarationBlockCache
+{
+public:
+    struct Block
+    {
+        std::string typeName;
+        std::string name;
+        std::string contents;
+    };
+
+    struct File
+    {
+        // The archive or folder the file has been loaded from
+        std::string archivePath;
+        stream::FileStamp stamp;
+        std::string modName;
+        std::vector<Block> blocks;
+    };
+
+private:
+    struct CachedFile
+    {
+        File file;
+
+        // Whether this file has been requested since the cache has been loaded
+        bool used = false;
+    };
+
+    std::map<std::string, CachedFile> _files;
+
+    bool _changed;
+
+public:
+    DeclarationBlockCache();
+
+    // Replaces the contents of this cache with the ones stored in the given file
+    void load(const std::string& cacheFilePath);
+
+    // Writes the cache to the given file, dropping all files which haven't been
+    // requested since loading the cache. Does nothing if nothing changed.
+    void save(const std::string& cacheFilePath);
+
+    // Returns the cached blocks of the given VFS file, or nullptr if the file is unknown,
+    // has been loaded from a different archive or if the stamp doesn't match
+    const File* find(const std::string& fullPath, const std::string& archivePath, const stream::FileStamp& stamp);
+
+    void store(const std::string& fullPath, File file);
+};
+
+}
@@ -1,8 +1,12 @@
 #include "DeclarationFolderParser.h"
 
 #include "DeclarationManager.h"
+#include "imodule.h"
 #include "parser/DefBlockSyntaxParser.h"
 #include "string/trim.h"
+#include "string/replace.h"
+#include "string/case_conv.h"
+#include "os/path.h"
 
 namespace decl
 {
@@ -25,6 +29,17 @@ namespace
 
         return syntax;
     }
+
+    // Each parser is using its own cache file, e.g. "decls_material_materials_mtr.cache"
+    std::string getCacheFilePath(Type declType, const std::string& baseDir, const std::string& extension)
+    {
+        auto fileName = string::to_lower_copy("decls_" + getTypeName(declType) + "_" + baseDir + "_" + extension);
+
+        string::replace_all(fileName, "/", "");
+
+        return module::GlobalModuleRegistry().getApplicationContext().getCacheDataPath() +
+            "startupcache/" + fileName + ".cache";
+    }
 }
 
 DeclarationFolderParser::DeclarationFolderParser(DeclarationManager& owner, Type declType,
@@ -33,13 +48,14 @@ DeclarationFolderParser::DeclarationFolderParser(DeclarationManager& owner, Type
     ThreadedDeclParser<void>(declType, baseDir, extension, 1),
     _owner(owner),
     _typeMapping(typeMapping),
-    _defaultDeclType(declType)
+    _defaultDeclType(declType),
+    _cacheFilePath(getCacheFilePath(declType, baseDir, extension))
 {}
 
-void DeclarationFolderParser::parse(std::istream& stream, const vfs::FileInfo& fileInfo, const std::string& modDir)
+void DeclarationFolderParser::parse(std::string_view contents, const vfs::FileInfo& fileInfo, const std::string& modDir)
 {
-    // Parse the incoming stream into syntax blocks
-    parser::DefBlockSyntaxParser<std::istream> parser(stream);
+    // Parse the incoming file contents into syntax blocks
+    parser::DefBlockSyntaxParser<const std::string_view> parser(contents);
 
     auto syntaxTree = parser.parse();
 
@@ -55,19 +71,91 @@ void DeclarationFolderParser::parse(std::istream& stream, const vfs::FileInfo& f
         // Convert the incoming block to a DeclarationBlockSource
         auto blockSyntax = createBlock(blockNode, fileInfo, modDir);
 
-        // Move the block in the correct bucket
-        auto declType = determineBlockType(blockSyntax);
-        auto& blockList = _parsedBlocks.try_emplace(declType).first->second;
-        blockList.emplace_back(std::move(blockSyntax));
+        _currentFile.blocks.push_back({ blockSyntax.typeName, blockSyntax.name, blockSyntax.contents });
+
+        addBlock(std::move(blockSyntax));
+    }
+
+    _currentFile.modName = modDir;
+}
+
+bool DeclarationFolderParser::processFile(const vfs::FileInfo& fileInfo)
+{
+    auto [archivePath, stamp] = getFileStamp(fileInfo);
+
+    // Unchanged files don't need to be loaded and parsed again
+    if (auto cachedFile = _cache.find(fileInfo.fullPath(), archivePath, stamp); cachedFile)
+    {
+        for (const auto& block : cachedFile->blocks)
+        {
+            DeclarationBlockSource blockSource;
+
+            blockSource.typeName = block.typeName;
+            blockSource.name = block.name;
+            blockSource.contents = block.contents;
+            blockSource.modName = cachedFile->modName;
+            blockSource.fileInfo = fileInfo;
+
+            addBlock(std::move(blockSource));
+        }
+
+        return true;
+    }
+
+    _currentFile = DeclarationBlockCache::File();
+
+    if (!ThreadedDeclParser::processFile(fileInfo))
+    {
+        return false;
     }
+
+    _currentFile.archivePath = archivePath;
+    _currentFile.stamp = stamp;
+    _cache.store(fileInfo.fullPath(), std::move(_currentFile));
+
+    return true;
+}
+
+void DeclarationFolderParser::onBeginParsing()
+{
+    _cache.load(_cacheFilePath);
+    _stamps.clear();
 }
 
 void DeclarationFolderParser::onFinishParsing()
 {
+    _cache.save(_cacheFilePath);
+
     // Submit all parsed declarations to the decl manager
     _owner.onParserFinished(_defaultDeclType, _parsedBlocks);
 }
 
+void DeclarationFolderParser::addBlock(DeclarationBlockSource&& block)
+{
+    // Move the block in the correct bucket
+    auto declType = determineBlockType(block);
+    auto& blockList = _parsedBlocks.try_emplace(declType).first->second;
+    blockList.emplace_back(std::move(block));
+}
+
+std::pair<std::string, stream::FileStamp> DeclarationFolderParser::getFileStamp(const vfs::FileInfo& fileInfo)
+{
+    auto archivePath = fileInfo.getArchivePath();
+
+    // Loose files carry their own stamp, packed files share the one of their PK4
+    auto physicalPath = fileInfo.getIsPhysicalFile() ?
+        os::standardPathWithSlash(archivePath) + fileInfo.fullPath() : archivePath;
+
+    auto existing = _stamps.find(physicalPath);
+
+    if (existing == _stamps.end())
+    {
+        existing = _stamps.emplace(physicalPath, stream::FileStamp::ofFile(physicalPath)).first;
+    }
+
+    return { archivePath, existing->second };
+}
+
 Type DeclarationFolderParser::determineBlockType(const DeclarationBlockSource& block)
 {
     if (block.typeName.empty())
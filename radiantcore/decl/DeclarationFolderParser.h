@@ -3,6 +3,7 @@
 #include <map>
 #include "ideclmanager.h"
 #include "DeclarationFile.h"
+#include "DeclarationBlockCache.h"
 
 #include "parser/ThreadedDeclParser.h"
 #include "string/string.h"
@@ -31,6 +32,16 @@ private:
     // The default type to assign to untyped blocks
     Type _defaultDeclType;
 
+    // Blocks of the previously parsed files, stored on disk between sessions
+    DeclarationBlockCache _cache;
+    std::string _cacheFilePath;
+
+    // Stamps of the archives and physical files encountered during this run
+    std::map<std::string, stream::FileStamp> _stamps;
+
+    // The blocks and mod name of the file currently being parsed, to fill the cache
+    DeclarationBlockCache::File _currentFile;
+
 public:
     DeclarationFolderParser(DeclarationManager& owner, Type declType,
         const std::string& baseDir, const std::string& extension,
@@ -43,11 +54,17 @@ public:
     }
 
 protected:
-    void parse(std::istream& stream, const vfs::FileInfo& fileInfo, const std::string& modDir) override;
+    void parse(std::string_view contents, const vfs::FileInfo& fileInfo, const std::string& modDir) override;
+    bool processFile(const vfs::FileInfo& fileInfo) override;
+    void onBeginParsing() override;
     void onFinishParsing() override;
 
 private:
     Type determineBlockType(const DeclarationBlockSource& block);
+    void addBlock(DeclarationBlockSource&& block);
+
+    // Returns the archive path and the stamp of the physical file the given file is stored in
+    std::pair<std::string, stream::FileStamp> getFileStamp(const vfs::FileInfo& fileInfo);
 };
 
 }
@@ -1,4 +1,3 @@
-#include <future>
 #include <fstream>
 
 #include "i18n.h"
@@ -276,12 +275,12 @@ void DeclarationManager::waitForTypedParsersToFinish()
         {
             // Add the task to the list, we need to wait for it when shutting down the module
             // Move the collected parsers to the async lambda and clear it there
-            _parserCleanupTasks.emplace_back(std::make_shared<std::shared_future<void>>(
-                std::async(std::launch::async, [parsers = std::move(parsersToFinish)]() mutable
+            _parserCleanupTasks.emplace_back(
+                threading::runAsync([parsers = std::move(parsersToFinish)]() mutable
                 {
                     // Without locking anything, just let all parsers finish their work
                     parsers.clear();
-                })));
+                }));
         }
     }
 
@@ -295,7 +294,7 @@ void DeclarationManager::waitForCleanupTasksToFinish()
     {
         // Find the next cleanup task, but don't remove it from the list
         // Other threads might check the same list and get the impression there's nothing to wait for
-        std::shared_ptr<std::shared_future<void>> task;
+        threading::TaskFuture<void> task;
 
         {
             // Pick the next task to wait for
@@ -305,18 +304,17 @@ void DeclarationManager::waitForCleanupTasksToFinish()
 
             for (const auto& candidate : _parserCleanupTasks)
             {
-                if (candidate && candidate->valid() &&
-                    candidate->wait_for(std::chrono::milliseconds(0)) != std::future_status::ready)
+                if (candidate.valid() && !candidate.isReady())
                 {
                     task = candidate;
                     break;
                 }
             }
 
-            if (!task) return;
+            if (!task.valid()) return;
         }
 
-        task->get(); // wait for this task, then enter the next round
+        task.get(); // wait for this task, then enter the next round
     }
 }
 
@@ -328,7 +326,7 @@ void DeclarationManager::waitForSignalInvokersToFinish()
         auto declLock = std::make_unique<std::lock_guard<std::recursive_mutex>>(_declarationAndCreatorLock);
 
         // No cleanup task found, check the tasks in the declaration structures
-        std::future<void> signalInvoker;
+        threading::TaskFuture<void> signalInvoker;
 
         for (auto& [_, decl] : _declarationsByType)
         {
@@ -773,7 +771,7 @@ void DeclarationManager::onParserFinished(Type parserType, ParseResult& parsedBl
             // Move the parser reference from the dictionary as capture to the lambda
             // Then let the unique_ptr in the lambda go out of scope to finish off the thread
             // Lambda is mutable to make the unique_ptr member non-const
-            decls->second.parserFinisher = std::async(std::launch::async, [p = std::move(decls->second.parser)]() mutable
+            decls->second.parserFinisher = threading::runAsync([p = std::move(decls->second.parser)]() mutable
             {
                 p.reset();
             });
@@ -783,7 +781,7 @@ void DeclarationManager::onParserFinished(Type parserType, ParseResult& parsedBl
         // In the regular threaded scenario, the signal should fire on a separate thread
         if (!_reparseInProgress)
         {
-            decls->second.signalInvoker = std::async(std::launch::async, [=]()
+            decls->second.signalInvoker = threading::runAsync([=]()
             {
                 emitDeclsReloadedSignal(parserType);
             });
@@ -960,6 +958,7 @@ StringSet DeclarationManager::getDependencies() const
     {
         MODULE_VIRTUALFILESYSTEM,
         MODULE_COMMANDSYSTEM,
+        MODULE_THREADPOOL,
     };
 
     return _dependencies;
@@ -994,6 +993,15 @@ void DeclarationManager::shutdownModule()
     waitForTypedParsersToFinish();
     waitForSignalInvokersToFinish();
 
+    // Let the tasks destroying the finished parsers complete
+    for (auto& [_, decl] : _declarationsByType)
+    {
+        if (decl.parserFinisher.valid())
+        {
+            decl.parserFinisher.get();
+        }
+    }
+
     // All parsers and tasks have finished, clear all structures, no need to lock anything
     _parserCleanupTasks.clear();
     _registeredFolders.clear();
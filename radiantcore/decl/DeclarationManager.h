@@ -2,6 +2,7 @@
 
 #include "ideclmanager.h"
 #include "icommandsystem.h"
+#include "ithreadpool.h"
 #include <map>
 #include <vector>
 #include <memory>
@@ -46,8 +47,8 @@ private:
         // If not empty, holds the running parser
         std::unique_ptr<DeclarationFolderParser> parser;
 
-        std::future<void> parserFinisher;
-        std::future<void> signalInvoker;
+        threading::TaskFuture<void> parserFinisher;
+        threading::TaskFuture<void> signalInvoker;
     };
 
     // One entry for each decl
@@ -74,7 +75,7 @@ private:
     sigc::connection _vfsInitialisedConn;
 
     // Access allowed if the _declarationAndCreatorLock is owned
-    std::vector<std::shared_ptr<std::shared_future<void>>> _parserCleanupTasks;
+    std::vector<threading::TaskFuture<void>> _parserCleanupTasks;
 
 public:
     void registerDeclType(const std::string& typeName, const IDeclarationCreator::Ptr& parser) override;
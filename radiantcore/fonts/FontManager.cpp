@@ -29,6 +29,7 @@ StringSet FontManager::getDependencies() const
         MODULE_XMLREGISTRY,
         MODULE_GAMEMANAGER,
         MODULE_SHADERSYSTEM,
+        MODULE_THREADPOOL,
     };
 
 	return _dependencies;
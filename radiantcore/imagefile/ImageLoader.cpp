@@ -7,6 +7,7 @@
 
 #include "ifilesystem.h"
 #include "igame.h"
+#include "ithreadpool.h"
 
 #include "string/case_conv.h"
 
@@ -21,6 +22,21 @@ namespace
 {
     // Registry key holding texture types
     const char* const GKEY_IMAGE_TYPES = "/filetypes/texture//extension";
+
+    // Invokes the load function for every path, the files are decoded on the thread pool
+    std::vector<ImagePtr> loadConcurrently(const std::vector<std::string>& paths,
+        const std::function<ImagePtr(const std::string&)>& load)
+    {
+        std::vector<ImagePtr> images(paths.size());
+
+        // Decoding a single image is expensive enough to distribute them one by one
+        GlobalThreadPool().parallelFor(0, paths.size(), [&](std::size_t index)
+        {
+            images[index] = load(paths[index]);
+        }, 1);
+
+        return images;
+    }
 }
 
 void ImageLoader::addLoaderToMap(const ImageTypeLoader::Ptr& loader)
@@ -93,6 +109,31 @@ ImagePtr ImageLoader::imageFromVFS(const std::string& rawName) const
 	return ImagePtr();
 }
 
+std::string ImageLoader::findImageInVFS(const std::string& rawName) const
+{
+    auto name = os::standardPath(rawName).substr(0, rawName.rfind("."));
+
+    for (const auto& extension : _extensions)
+    {
+        auto loaderIter = _loadersByExtension.find(extension);
+
+        if (loaderIter == _loadersByExtension.end())
+        {
+            continue;
+        }
+
+        // Same lookup order as in imageFromVFS
+        auto fullName = loaderIter->second->getPrefix() + name + "." + extension;
+
+        if (GlobalFileSystem().getFileCount(fullName) > 0)
+        {
+            return fullName;
+        }
+    }
+
+    return std::string();
+}
+
 ImagePtr ImageLoader::imageFromFile(const std::string& filename) const
 {
     ImagePtr image;
@@ -121,6 +162,16 @@ ImagePtr ImageLoader::imageFromFile(const std::string& filename) const
     return image;
 }
 
+std::vector<ImagePtr> ImageLoader::imagesFromVFS(const std::vector<std::string>& vfsPaths) const
+{
+    return loadConcurrently(vfsPaths, [this](const std::string& path) { return imageFromVFS(path); });
+}
+
+std::vector<ImagePtr> ImageLoader::imagesFromFiles(const std::vector<std::string>& filenames) const
+{
+    return loadConcurrently(filenames, [this](const std::string& path) { return imageFromFile(path); });
+}
+
 std::string ImageLoader::getName() const
 {
     static std::string _name(MODULE_IMAGELOADER);
@@ -134,6 +185,7 @@ StringSet ImageLoader::getDependencies() const
     if (_dependencies.empty())
     {
         _dependencies.insert(MODULE_GAMEMANAGER);
+        _dependencies.insert(MODULE_THREADPOOL);
     }
 
     return _dependencies;
@@ -30,7 +30,10 @@ public:
 
     // ImageLoader implementation
     ImagePtr imageFromVFS(const std::string& vfsPath) const override;
+    std::string findImageInVFS(const std::string& vfsPath) const override;
 	ImagePtr imageFromFile(const std::string& filename) const override;
+    std::vector<ImagePtr> imagesFromVFS(const std::vector<std::string>& vfsPaths) const override;
+    std::vector<ImagePtr> imagesFromFiles(const std::vector<std::string>& filenames) const override;
 
     // RegisterableModule implementation
     std::string getName() const override;
@@ -213,19 +213,18 @@ static void jpeg_buffer_src(j_decompress_ptr cinfo, void* buffer, int bufsize)
 
 // =============================================================================
 
-static char errormsg[JMSG_LENGTH_MAX];
-
 typedef struct my_jpeg_error_mgr
 {
     struct jpeg_error_mgr pub;  // "public" fields
     jmp_buf setjmp_buffer;      // for return to caller
+    char errormsg[JMSG_LENGTH_MAX]; // per decoder, images are decoded concurrently
 } bt_jpeg_error_mgr;
 
 static void my_jpeg_error_exit(j_common_ptr cinfo)
 {
     my_jpeg_error_mgr* myerr = (bt_jpeg_error_mgr*)cinfo->err;
 
-    (*cinfo->err->format_message) (cinfo, errormsg);
+    (*cinfo->err->format_message) (cinfo, myerr->errormsg);
 
     longjmp(myerr->setjmp_buffer, 1);
 }
@@ -326,7 +325,7 @@ static image::RGBAImagePtr LoadJPGBuff_(const void* src_buffer, int src_size)
 
     if (setjmp(jerr.setjmp_buffer)) //< TODO: use c++ exceptions instead of setjmp/longjmp to handle errors
     {
-        rError() << "WARNING: JPEG library error: " << errormsg << "\n";
+        rError() << "WARNING: JPEG library error: " << jerr.errormsg << "\n";
         jpeg_destroy_decompress(&cinfo);
         return {};
     }
@@ -334,12 +333,46 @@ static image::RGBAImagePtr LoadJPGBuff_(const void* src_buffer, int src_size)
     jpeg_create_decompress(&cinfo);
     jpeg_buffer_src(&cinfo, const_cast<void*>(src_buffer), src_size);
     jpeg_read_header(&cinfo, TRUE);
-    jpeg_start_decompress(&cinfo);
 
-    int row_stride = cinfo.output_width * cinfo.output_components;
+#ifdef JCS_EXTENSIONS
+    // libjpeg-turbo is able to write opaque RGBA pixels directly,
+    // such that the scanlines can be decoded into the image
+    if (cinfo.out_color_space == JCS_RGB)
+    {
+        cinfo.out_color_space = JCS_EXT_RGBA;
+    }
+#endif
+
+    jpeg_start_decompress(&cinfo);
 
     image::RGBAImagePtr image(new image::RGBAImage(cinfo.output_width, cinfo.output_height));
 
+#ifdef JCS_EXTENSIONS
+    if (cinfo.out_color_space == JCS_EXT_RGBA)
+    {
+        // Allocated from the JPEG pool, which is released on errors too
+        JSAMPARRAY rows = (JSAMPARRAY)(*cinfo.mem->alloc_small)((j_common_ptr)&cinfo, JPOOL_IMAGE,
+            cinfo.output_height * sizeof(JSAMPROW));
+
+        for (JDIMENSION row = 0; row < cinfo.output_height; ++row)
+        {
+            rows[row] = image->getPixels() + row * cinfo.output_width * 4;
+        }
+
+        while (cinfo.output_scanline < cinfo.output_height)
+        {
+            jpeg_read_scanlines(&cinfo, rows + cinfo.output_scanline, cinfo.output_height - cinfo.output_scanline);
+        }
+
+        jpeg_finish_decompress(&cinfo);
+        jpeg_destroy_decompress(&cinfo);
+
+        return image;
+    }
+#endif
+
+    int row_stride = cinfo.output_width * cinfo.output_components;
+
     JSAMPARRAY buffer = (*cinfo.mem->alloc_sarray) ((j_common_ptr)&cinfo, JPOOL_IMAGE, row_stride, 1);
 
     while (cinfo.output_scanline < cinfo.output_height)
@@ -25,10 +25,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "iarchive.h"
 #include "idatastream.h"
 #include "itextstream.h"
+#include "ithreadpool.h"
 
 typedef unsigned char byte;
 
 #include <stdlib.h>
+#include <algorithm>
 
 #include "stream/ScopedArchiveBuffer.h"
 #include "stream/PointerInputStream.h"
@@ -38,236 +40,157 @@ typedef unsigned char byte;
 namespace image
 {
 
-// represents x,y origin of tga image being decoded
-class Flip00 {}; // no flip
-class Flip01 {}; // vertical flip only
-class Flip10 {}; // horizontal flip only
-class Flip11 {}; // both
+namespace
+{
+
+// Images with at least this many pixels are decoded by multiple threads
+constexpr std::size_t PARALLEL_DECODE_MIN_PIXELS = 256 * 256;
 
-template<typename PixelDecoder>
-void image_decode(stream::PointerInputStream& istream, PixelDecoder& decode, RGBAImage& image, const Flip00&)
+// Location of the first pixel in the TGA data
+struct TargaOrientation
 {
-  RGBAPixel* end = image.pixels + (image.getHeight() * image.getWidth());
-  for(RGBAPixel* row = end; row != image.pixels; row -= image.getWidth())
-  {
-    for(RGBAPixel* pixel = row - image.getWidth(); pixel != row; ++pixel)
-    {
-      decode(istream, *pixel);
-    }
-  }
-}
+  bool rightToLeft;
+  bool topToBottom;
+};
 
-template<typename PixelDecoder>
-void image_decode(stream::PointerInputStream& istream, PixelDecoder& decode, RGBAImage& image, const Flip01&)
+// Converts a single grayscale, BGR or BGRA pixel to RGBA
+template<std::size_t BytesPerPixel>
+inline void targa_decode_pixel(const byte* source, RGBAPixel& pixel)
 {
-  RGBAPixel* end = image.pixels + (image.getHeight() * image.getWidth());
-  for(RGBAPixel* row = image.pixels; row != end; row += image.getWidth())
+  if constexpr (BytesPerPixel == 1)
   {
-    for(RGBAPixel* pixel = row; pixel != row + image.getWidth(); ++pixel)
-    {
-      decode(istream, *pixel);
-    }
+    pixel.red = pixel.green = pixel.blue = source[0];
+    pixel.alpha = 0xff;
+  }
+  else
+  {
+    pixel.red = source[2];
+    pixel.green = source[1];
+    pixel.blue = source[0];
+    pixel.alpha = BytesPerPixel == 4 ? source[3] : 0xff;
   }
 }
 
-template<typename PixelDecoder>
-void image_decode(stream::PointerInputStream& istream, PixelDecoder& decode, RGBAImage& image, const Flip10&)
+// Converts a run of pixels, the loop has no dependencies between
+// iterations such that the compiler can vectorise the swizzle
+template<std::size_t BytesPerPixel>
+inline void targa_decode_row(const byte* source, RGBAPixel* row, std::size_t width)
 {
-  RGBAPixel* end = image.pixels + (image.getHeight() * image.getWidth());
-  for(RGBAPixel* row = end; row != image.pixels; row -= image.getWidth())
+  for (std::size_t x = 0; x < width; ++x)
   {
-    for(RGBAPixel* pixel = row; pixel != row - image.getWidth();)
-    {
-      decode(istream, *--pixel);
-    }
+    targa_decode_pixel<BytesPerPixel>(source + x * BytesPerPixel, row[x]);
   }
 }
 
-template<typename PixelDecoder>
-void image_decode(stream::PointerInputStream& istream, PixelDecoder& decode, RGBAImage& image, const Flip11&)
+// Invokes the function for every index in [0, numRows), using the thread pool for large images
+template<typename Function>
+void targa_foreach_row(const RGBAImage& image, std::size_t numRows, const Function& function)
 {
-  RGBAPixel* end = image.pixels + (image.getHeight() * image.getWidth());
-  for(RGBAPixel* row = image.pixels; row != end; row += image.getWidth())
+  if (image.getWidth() * image.getHeight() < PARALLEL_DECODE_MIN_PIXELS)
   {
-    for(RGBAPixel* pixel = row + image.getWidth(); pixel != row;)
+    for (std::size_t y = 0; y < numRows; ++y)
     {
-      decode(istream, *--pixel);
+      function(y);
     }
+    return;
   }
-}
 
-inline void istream_read_gray(stream::PointerInputStream& istream, RGBAPixel& pixel)
-{
-  istream.read(&pixel.blue, 1);
-  pixel.red = pixel.green = pixel.blue;
-  pixel.alpha = 0xff;
+  GlobalThreadPool().parallelFor(0, numRows, function);
 }
 
-inline void istream_read_rgb(stream::PointerInputStream& istream, RGBAPixel& pixel)
+// The rows of uncompressed images are independent, they're decoded straight to their target location
+template<std::size_t BytesPerPixel>
+void targa_decode_uncompressed(const byte* data, RGBAImage& image, const TargaOrientation& orientation)
 {
-  istream.read(&pixel.blue, 1);
-  istream.read(&pixel.green, 1);
-  istream.read(&pixel.red, 1);
-  pixel.alpha = 0xff;
-}
+  auto width = image.getWidth();
+  auto height = image.getHeight();
 
-inline void istream_read_rgba(stream::PointerInputStream& istream, RGBAPixel& pixel)
-{
-  istream.read(&pixel.blue, 1);
-  istream.read(&pixel.green, 1);
-  istream.read(&pixel.red, 1);
-  istream.read(&pixel.alpha, 1);
-}
-
-class TargaDecodeGrayPixel
-{
-public:
-  void operator()(stream::PointerInputStream& istream, RGBAPixel& pixel)
+  targa_foreach_row(image, height, [&](std::size_t y)
   {
-    istream_read_gray(istream, pixel);
-  }
-};
+    auto row = image.pixels + (orientation.topToBottom ? y : height - 1 - y) * width;
 
-template<typename Flip>
-void targa_decode_grayscale(stream::PointerInputStream& istream, RGBAImage& image, const Flip& flip)
-{
-  TargaDecodeGrayPixel decode;
-  image_decode(istream, decode, image, flip);
+    targa_decode_row<BytesPerPixel>(data + y * width * BytesPerPixel, row, width);
+
+    if (orientation.rightToLeft)
+    {
+      std::reverse(row, row + width);
+    }
+  });
 }
 
-class TargaDecodeRGBPixel
+// Moves the rows of an image decoded in file order to their target location
+void targa_apply_orientation(RGBAImage& image, const TargaOrientation& orientation)
 {
-public:
-  void operator()(stream::PointerInputStream& istream, RGBAPixel& pixel)
+  auto width = image.getWidth();
+  auto height = image.getHeight();
+
+  if (!orientation.topToBottom)
   {
-    istream_read_rgb(istream, pixel);
+    targa_foreach_row(image, height / 2, [&](std::size_t y)
+    {
+      auto row = image.pixels + y * width;
+      std::swap_ranges(row, row + width, image.pixels + (height - 1 - y) * width);
+    });
   }
-};
 
-template<typename Flip>
-void targa_decode_rgb(stream::PointerInputStream& istream, RGBAImage& image, const Flip& flip)
-{
-  TargaDecodeRGBPixel decode;
-  image_decode(istream, decode, image, flip);
-}
-
-class TargaDecodeRGBAPixel
-{
-public:
-  void operator()(stream::PointerInputStream& istream, RGBAPixel& pixel)
+  if (orientation.rightToLeft)
   {
-    istream_read_rgba(istream, pixel);
+    targa_foreach_row(image, height, [&](std::size_t y)
+    {
+      auto row = image.pixels + y * width;
+      std::reverse(row, row + width);
+    });
   }
-};
-
-template<typename Flip>
-void targa_decode_rgba(stream::PointerInputStream& istream, RGBAImage& image, const Flip& flip)
-{
-  TargaDecodeRGBAPixel decode;
-  image_decode(istream, decode, image, flip);
-}
-
-typedef byte TargaPacket;
-typedef byte TargaPacketSize;
-
-inline void targa_packet_read_istream(TargaPacket& packet, stream::PointerInputStream& istream)
-{
-  istream.read(&packet, 1);
 }
 
-inline bool targa_packet_is_rle(const TargaPacket& packet)
+// RLE packets may span multiple rows, so the image is decoded serially in file order,
+// whole packets at a time. Returns false if the data ends prematurely.
+template<std::size_t BytesPerPixel>
+bool targa_decode_rle(const byte* data, const byte* end, RGBAImage& image, const TargaOrientation& orientation)
 {
-  return (packet & 0x80) != 0;
-}
-
-inline TargaPacketSize targa_packet_size(const TargaPacket& packet)
-{
-  return 1 + (packet & 0x7f);
-}
+  RGBAPixel* pixel = image.pixels;
+  RGBAPixel* last = image.pixels + image.getWidth() * image.getHeight();
 
-
-class TargaDecodeRGBPixelRLE
-{
-  TargaPacketSize m_packetSize;
-  RGBAPixel m_pixel;
-  TargaPacket m_packet;
-public:
-  TargaDecodeRGBPixelRLE() : m_packetSize(0)
-  {
-  }
-  void operator()(stream::PointerInputStream& istream, RGBAPixel& pixel)
+  while (pixel != last)
   {
-    if(m_packetSize == 0)
-    {
-      targa_packet_read_istream(m_packet, istream);
-      m_packetSize = targa_packet_size(m_packet);
-
-      if(targa_packet_is_rle(m_packet))
-      {
-        istream_read_rgb(istream, m_pixel);
-      }
-    }
-
-    if(targa_packet_is_rle(m_packet))
+    if (data == end)
     {
-      pixel = m_pixel;
-    }
-    else
-    {
-      istream_read_rgb(istream, pixel);
+      return false;
     }
 
-    --m_packetSize;
-  }
-};
-
-template<typename Flip>
-void targa_decode_rle_rgb(stream::PointerInputStream& istream, RGBAImage& image, const Flip& flip)
-{
-	TargaDecodeRGBPixelRLE decode;
-  image_decode(istream, decode, image, flip);
-}
+    auto packet = *data++;
+    std::size_t packetSize = std::min<std::size_t>(1 + (packet & 0x7f), last - pixel);
 
-class TargaDecodeRGBAPixelRLE
-{
-  TargaPacketSize m_packetSize;
-  RGBAPixel m_pixel;
-  TargaPacket m_packet;
-public:
-  TargaDecodeRGBAPixelRLE() : m_packetSize(0)
-  {
-  }
-  void operator()(stream::PointerInputStream& istream, RGBAPixel& pixel)
-  {
-    if(m_packetSize == 0)
+    if ((packet & 0x80) != 0)
     {
-      targa_packet_read_istream(m_packet, istream);
-      m_packetSize = targa_packet_size(m_packet);
-
-      if(targa_packet_is_rle(m_packet))
+      if (static_cast<std::size_t>(end - data) < BytesPerPixel)
       {
-        istream_read_rgba(istream, m_pixel);
+        return false;
       }
-    }
 
-    if(targa_packet_is_rle(m_packet))
-    {
-      pixel = m_pixel;
+      RGBAPixel value;
+      targa_decode_pixel<BytesPerPixel>(data, value);
+      data += BytesPerPixel;
+
+      pixel = std::fill_n(pixel, packetSize, value);
     }
     else
     {
-      istream_read_rgba(istream, pixel);
-    }
+      if (static_cast<std::size_t>(end - data) < packetSize * BytesPerPixel)
+      {
+        return false;
+      }
 
-    --m_packetSize;
+      targa_decode_row<BytesPerPixel>(data, pixel, packetSize);
+      data += packetSize * BytesPerPixel;
+      pixel += packetSize;
+    }
   }
-};
 
-template<typename Flip>
-void targa_decode_rle_rgba(stream::PointerInputStream& istream, RGBAImage& image, const Flip& flip)
-{
-	TargaDecodeRGBAPixelRLE decode;
-  image_decode(istream, decode, image, flip);
+  targa_apply_orientation(image, orientation);
+  return true;
+}
+
 }
 
 struct TargaHeader
@@ -301,61 +224,56 @@ inline void targa_header_read_istream(TargaHeader& targa_header, stream::Pointer
     istream.seek(targa_header.id_length);	// skip TARGA image comment
 }
 
-template<typename Type>
-class ScopeDelete
-{
-  Type* m_value;
-  ScopeDelete(const ScopeDelete&);
-  ScopeDelete& operator=(const ScopeDelete&);
-public:
-  ScopeDelete(Type* value) : m_value(value)
-  {
-  }
-  ~ScopeDelete()
-  {
-    delete m_value;
-  }
-  Type* get_pointer() const
-  {
-    return m_value;
-  }
-};
-
-template<typename Flip>
-RGBAImagePtr Targa_decodeImageData(const TargaHeader& targa_header, stream::PointerInputStream& istream, const Flip& flip)
+RGBAImagePtr Targa_decodeImageData(const TargaHeader& targa_header, const byte* data, const byte* end, const TargaOrientation& orientation)
 {
   auto image = std::make_shared<RGBAImage>(targa_header.width, targa_header.height);
 
   if (targa_header.image_type == 2 || targa_header.image_type == 3)
   {
+    std::size_t dataSize = image->getWidth() * image->getHeight() * (targa_header.pixel_size / 8);
+
+    if (static_cast<std::size_t>(end - data) < dataSize)
+    {
+      rError() << "LoadTGA: image data is truncated\n";
+      return RGBAImagePtr();
+    }
+
     switch (targa_header.pixel_size)
     {
     case 8:
-      targa_decode_grayscale(istream, *image, flip);
+      targa_decode_uncompressed<1>(data, *image, orientation);
       break;
     case 24:
-      targa_decode_rgb(istream, *image, flip);
+      targa_decode_uncompressed<3>(data, *image, orientation);
       break;
     case 32:
-      targa_decode_rgba(istream, *image, flip);
+      targa_decode_uncompressed<4>(data, *image, orientation);
       break;
     default:
-      rError() << "LoadTGA: illegal pixel_size '" << targa_header.pixel_size << "'\n";
+      rError() << "LoadTGA: illegal pixel_size '" << static_cast<int>(targa_header.pixel_size) << "'\n";
       return RGBAImagePtr();
     }
   }
   else if (targa_header.image_type == 10)
   {
+    bool complete = false;
+
     switch (targa_header.pixel_size)
     {
     case 24:
-      targa_decode_rle_rgb(istream, *image, flip);
+      complete = targa_decode_rle<3>(data, end, *image, orientation);
       break;
     case 32:
-      targa_decode_rle_rgba(istream, *image, flip);
+      complete = targa_decode_rle<4>(data, end, *image, orientation);
       break;
     default:
-      rError() << "LoadTGA: illegal pixel_size '" << targa_header.pixel_size << "'\n";
+      rError() << "LoadTGA: illegal pixel_size '" << static_cast<int>(targa_header.pixel_size) << "'\n";
+      return RGBAImagePtr();
+    }
+
+    if (!complete)
+    {
+      rError() << "LoadTGA: RLE data is truncated\n";
       return RGBAImagePtr();
     }
   }
@@ -366,8 +284,17 @@ RGBAImagePtr Targa_decodeImageData(const TargaHeader& targa_header, stream::Poin
 const unsigned int TGA_FLIP_HORIZONTAL = 0x10;
 const unsigned int TGA_FLIP_VERTICAL = 0x20;
 
-RGBAImagePtr LoadTGABuff(const byte* buffer)
+// Size of the fixed part of the header
+const std::size_t TGA_HEADER_SIZE = 18;
+
+RGBAImagePtr LoadTGABuff(const byte* buffer, std::size_t length)
 {
+  if (length < TGA_HEADER_SIZE)
+  {
+    rError() << "LoadTGA: file is too small\n";
+    return RGBAImagePtr();
+  }
+
 	stream::PointerInputStream istream(buffer);
   TargaHeader targa_header;
 
@@ -393,37 +320,26 @@ RGBAImagePtr LoadTGABuff(const byte* buffer)
     return RGBAImagePtr();
   }
 
-  if ((targa_header.attributes & (TGA_FLIP_HORIZONTAL|TGA_FLIP_VERTICAL)) == 0)
-  {
-    return Targa_decodeImageData(targa_header, istream, Flip00());
-  }
-
-  if((targa_header.attributes & TGA_FLIP_HORIZONTAL) == 0 &&
-	 (targa_header.attributes & TGA_FLIP_VERTICAL) != 0)
-  {
-    return Targa_decodeImageData(targa_header, istream, Flip01());
-  }
+  const byte* end = buffer + length;
+  const byte* data = istream.get();
 
-  if ((targa_header.attributes & TGA_FLIP_HORIZONTAL) != 0 &&
-	  (targa_header.attributes & TGA_FLIP_VERTICAL) == 0)
+  if (data > end)
   {
-    return Targa_decodeImageData(targa_header, istream, Flip10());
+    rError() << "LoadTGA: image data is truncated\n";
+    return RGBAImagePtr();
   }
 
-  if ((targa_header.attributes & TGA_FLIP_HORIZONTAL) != 0 &&
-	  (targa_header.attributes & TGA_FLIP_VERTICAL) != 0)
-  {
-    return Targa_decodeImageData(targa_header, istream, Flip11());
-  }
+  TargaOrientation orientation;
+  orientation.rightToLeft = (targa_header.attributes & TGA_FLIP_HORIZONTAL) != 0;
+  orientation.topToBottom = (targa_header.attributes & TGA_FLIP_VERTICAL) != 0;
 
-  // unreachable
-  return RGBAImagePtr();
+  return Targa_decodeImageData(targa_header, data, end, orientation);
 }
 
 ImagePtr TGALoader::load(ArchiveFile& file) const
 {
     archive::ScopedArchiveBuffer buffer(file);
-    return LoadTGABuff(buffer.buffer);
+    return LoadTGABuff(buffer.buffer, buffer.length);
 }
 
 ImageTypeLoader::Extensions TGALoader::getExtensions() const
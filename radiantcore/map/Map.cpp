@@ -20,6 +20,7 @@
 #include "igame.h"
 #include "imru.h"
 #include "imapformat.h"
+#include "ithreadpool.h"
 
 #include "registry/registry.h"
 #include "entitylib.h"
@@ -1514,7 +1515,8 @@ StringSet Map::getDependencies() const
         MODULE_MAPINFOFILEMANAGER,
         MODULE_FILETYPES,
         MODULE_MAPRESOURCEMANAGER,
-        MODULE_COMMANDSYSTEM
+        MODULE_COMMANDSYSTEM,
+        MODULE_THREADPOOL
     };
 
     return _dependencies;
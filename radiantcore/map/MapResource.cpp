@@ -440,6 +440,30 @@ void MapResource::saveFile(const MapFormat& format, const scene::IMapRootNodePtr
 
 	rMessage() << "success" << std::endl;
 
+	saveToStream(format, root, traverse, outFileStream, auxFileStream.get());
+
+	// Check for any stream failures now that we're done writing
+	if (outFileStream.fail())
+	{
+		throw OperationException(fmt::format(_("Failure writing to file {0}"), outFile.string()));
+	}
+
+	if (auxFileStream && auxFileStream->fail())
+	{
+		throw OperationException(fmt::format(_("Failure writing to file {0}"), auxFile.string()));
+	}
+}
+
+void MapResource::saveToStream(const MapFormat& format, const scene::IMapRootNodePtr& root,
+	const GraphTraversalFunc& traverse, std::ostream& mapStream, std::ostream* auxStream)
+{
+	auto mapWriter = format.getMapWriter();
+	saveToStream(format, *mapWriter, root, traverse, mapStream, auxStream);
+}
+
+void MapResource::saveToStream(const MapFormat& format, IMapWriter& mapWriter, const scene::IMapRootNodePtr& root,
+	const GraphTraversalFunc& traverse, std::ostream& mapStream, std::ostream* auxStream)
+{
 	// Check the total count of nodes to traverse
 	NodeCounter counter;
 	traverse(root, counter);
@@ -449,15 +473,14 @@ void MapResource::saveFile(const MapFormat& format, const scene::IMapRootNodePtr
 	// and the destructor will clean it up afterwards. That way
 	// we ensure a nice and tidy scene when exceptions are thrown.
 	MapExporterPtr exporter;
-	auto mapWriter = format.getMapWriter();
 
-	if (format.allowInfoFileCreation())
+	if (auxStream != nullptr && format.allowInfoFileCreation())
 	{
-		exporter.reset(new MapExporter(*mapWriter, root, outFileStream, *auxFileStream, counter.getCount()));
+		exporter.reset(new MapExporter(mapWriter, root, mapStream, *auxStream, counter.getCount()));
 	}
 	else
 	{
-		exporter.reset(new MapExporter(*mapWriter, root, outFileStream, counter.getCount())); // no aux stream
+		exporter.reset(new MapExporter(mapWriter, root, mapStream, counter.getCount())); // no aux stream
 	}
 
 	try
@@ -470,17 +493,6 @@ void MapResource::saveFile(const MapFormat& format, const scene::IMapRootNodePtr
 	{
 		throw OperationException(_("Map writing cancelled"));
 	}
-
-	// Check for any stream failures now that we're done writing
-	if (outFileStream.fail())
-	{
-		throw OperationException(fmt::format(_("Failure writing to file {0}"), outFile.string()));
-	}
-
-	if (auxFileStream && auxFileStream->fail())
-	{
-		throw OperationException(fmt::format(_("Failure writing to file {0}"), auxFile.string()));
-	}
 }
 
 } // namespace map
@@ -66,6 +66,16 @@ public:
 	static void saveFile(const MapFormat& format, const scene::IMapRootNodePtr& root,
 						 const GraphTraversalFunc& traverse, const std::string& filename);
 
+	// Exports the map contents to the given stream using the given MapFormat export module.
+	// The info file is written to the auxiliary stream if it is not null and the format supports it.
+	// Throws an OperationException if the export has been cancelled
+	static void saveToStream(const MapFormat& format, const scene::IMapRootNodePtr& root,
+						 const GraphTraversalFunc& traverse, std::ostream& mapStream, std::ostream* auxStream);
+
+	// Same as above, writing the map using the given writer instead of the format's default one
+	static void saveToStream(const MapFormat& format, IMapWriter& mapWriter, const scene::IMapRootNodePtr& root,
+						 const GraphTraversalFunc& traverse, std::ostream& mapStream, std::ostream* auxStream);
+
 protected:
     // Implementation-specific method to open the stream of the primary .map or .mapx file
     // May return an empty reference, may throw OperationException on failure
@@ -99,7 +99,7 @@ void Doom3AasFile::parseFromTokens(parser::DefTokeniser& tok)
 {
     while (tok.hasMoreTokens())
     {
-        std::string token = tok.nextToken();
+        auto token = tok.nextTokenView();
 
         if (token == "settings")
         {
@@ -247,7 +247,7 @@ void Doom3AasFile::parseFromTokens(parser::DefTokeniser& tok)
                 /*std::size_t reachCount = */string::convert<std::size_t>(tok.nextToken());
                 tok.assertNextToken("{");
 
-                while (tok.nextToken() != "}")
+                while (tok.nextTokenView() != "}")
                 {
                     // do nothing
                 }
@@ -259,17 +259,17 @@ void Doom3AasFile::parseFromTokens(parser::DefTokeniser& tok)
         }
         else if (token == "nodes" || token == "portals" || token == "portalIndex" || token == "clusters")
         {
-            tok.nextToken(); // integer
+            tok.skipTokens(1); // integer
             tok.assertNextToken("{");
 
-            while (tok.nextToken() != "}")
+            while (tok.nextTokenView() != "}")
             {
                 // do nothing
             }
         }
         else
         {
-            throw parser::ParseException("Unknown token: " + token);
+            throw parser::ParseException("Unknown token: " + std::string(token));
         }
     }
 
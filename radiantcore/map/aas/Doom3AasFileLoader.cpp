@@ -4,6 +4,7 @@
 
 #include "parser/DefTokeniser.h"
 #include "string/convert.h"
+#include "stream/TextFileContents.h"
 #include "Doom3AasFile.h"
 #include "module/StaticModule.h"
 
@@ -53,9 +54,11 @@ IAasFilePtr Doom3AasFileLoader::loadFromStream(std::istream& stream)
     Doom3AasFilePtr aasFile = std::make_shared<Doom3AasFile>();
 
     // We assume that the stream is rewound to the beginning
+    stream::TextFileContents contents(stream);
 
-    // Instantiate a tokeniser to read the version tag
-	parser::BasicDefTokeniser<std::istream> tok(stream);
+    // Instantiate a tokeniser working on the in-memory contents, using
+    // the same kept delimiters as the std::istream tokeniser
+	parser::BasicDefTokeniser<std::string_view> tok(contents.get(), parser::WHITESPACE, "{}(),");
 
     try
 	{
@@ -14,8 +14,11 @@
 #include "string/string.h"
 
 #include "scene/ChildPrimitives.h"
+#include "scene/BRepEvaluation.h"
 #include "messages/MapFileOperation.h"
 
+#include <algorithm>
+
 namespace map
 {
 
@@ -57,6 +60,9 @@ MapExporter::MapExporter(IMapWriter& writer, const scene::IMapRootNodePtr& root,
 
 MapExporter::~MapExporter()
 {
+	// Make sure no worker is accessing the scene anymore (in case the export got aborted)
+	_parallelWriter.reset();
+
 	// Close any info file stream
 	_infoFileExporter.reset();
 
@@ -98,7 +104,13 @@ void MapExporter::exportMap(const scene::INodePtr& root, const GraphTraversalFun
 			throw std::logic_error("Map node is not a scene::IMapRootNode");
 		}
 
-		_writer.beginWriteMap(mapRoot, _mapStream);
+		if (registry::getValue<bool>(RKEY_MAP_PARALLEL_SAVING))
+		{
+			// Will be empty if the writer doesn't support it
+			_parallelWriter = ParallelEntityWriter::Create(_writer);
+		}
+
+		getNodeWriter().beginWriteMap(mapRoot, _mapStream);
 
 		if (_infoFileExporter)
 		{
@@ -122,7 +134,8 @@ void MapExporter::exportMap(const scene::INodePtr& root, const GraphTraversalFun
 			throw std::logic_error("Map node is not a scene::IMapRootNode");
 		}
 
-		_writer.endWriteMap(mapRoot, _mapStream);
+		// The parallel writer is writing all the entities to the stream at this point
+		getNodeWriter().endWriteMap(mapRoot, _mapStream);
 
 		if (_infoFileExporter)
 		{
@@ -134,6 +147,8 @@ void MapExporter::exportMap(const scene::INodePtr& root, const GraphTraversalFun
 		rError() << "Failure exporting a node (pre): " << ex.what() << std::endl;
 	}
 
+	_parallelWriter.reset();
+
 	// finishScene() is handled through the destructor
 }
 
@@ -148,7 +163,7 @@ bool MapExporter::pre(const scene::INodePtr& node)
 			// Progress dialog handling
 			onNodeProgress();
 
-			_writer.beginWriteEntity(entity, _mapStream);
+			getNodeWriter().beginWriteEntity(entity, _mapStream);
 
 			if (_infoFileExporter) _infoFileExporter->visitEntity(node, _entityNum);
 
@@ -162,7 +177,7 @@ bool MapExporter::pre(const scene::INodePtr& node)
 			// Progress dialog handling
 			onNodeProgress();
 
-			_writer.beginWriteBrush(brush, _mapStream);
+			getNodeWriter().beginWriteBrush(brush, _mapStream);
 
 			if (_infoFileExporter) _infoFileExporter->visitPrimitive(node, _entityNum, _primitiveNum);
 
@@ -176,7 +191,7 @@ bool MapExporter::pre(const scene::INodePtr& node)
 			// Progress dialog handling
 			onNodeProgress();
 
-			_writer.beginWritePatch(patch, _mapStream);
+			getNodeWriter().beginWritePatch(patch, _mapStream);
 
 			if (_infoFileExporter) _infoFileExporter->visitPrimitive(node, _entityNum, _primitiveNum);
 
@@ -199,7 +214,7 @@ void MapExporter::post(const scene::INodePtr& node)
 
 		if (entity)
 		{
-			_writer.endWriteEntity(entity, _mapStream);
+			getNodeWriter().endWriteEntity(entity, _mapStream);
 
 			_entityNum++;
 			return;
@@ -209,7 +224,7 @@ void MapExporter::post(const scene::INodePtr& node)
 
 		if (brush && brush->getIBrush().hasContributingFaces())
 		{
-			_writer.endWriteBrush(brush, _mapStream);
+			getNodeWriter().endWriteBrush(brush, _mapStream);
 			_primitiveNum++;
 			return;
 		}
@@ -218,7 +233,7 @@ void MapExporter::post(const scene::INodePtr& node)
 
 		if (patch)
 		{
-			_writer.endWritePatch(patch, _mapStream);
+			getNodeWriter().endWritePatch(patch, _mapStream);
 			_primitiveNum++;
 			return;
 		}
@@ -250,6 +265,11 @@ void MapExporter::onNodeProgress()
 	}
 }
 
+IMapWriter& MapExporter::getNodeWriter()
+{
+	return _parallelWriter ? *_parallelWriter : _writer;
+}
+
 void MapExporter::enableProgressMessages()
 {
     _sendProgressMessages = true;
@@ -298,17 +318,10 @@ void MapExporter::finishScene()
 
 void MapExporter::recalculateBrushWindings()
 {
-	_root->foreachNode([] (const scene::INodePtr& child)->bool
-	{
-		auto* brush = Node_getIBrush(child);
-
-		if (brush != nullptr)
-		{
-			brush->evaluateBRep();
-		}
-
-		return true;
-	});
+	// Only the brushes with outdated windings are collected, they're rebuilt in parallel
+	scene::BRepEvaluationBatch batch;
+	batch.addSubgraph(_root);
+	batch.evaluate();
 }
 
 } // namespace
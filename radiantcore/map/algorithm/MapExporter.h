@@ -8,6 +8,7 @@
 
 #include "../infofile/InfoFileExporter.h"
 #include "EventRateLimiter.h"
+#include "ParallelEntityWriter.h"
 
 #include <sigc++/signal.h>
 
@@ -33,6 +34,9 @@ private:
 	// For writing nodes to the stream
 	IMapWriter& _writer;
 
+	// Wraps the writer while exporting, if entities are serialised on multiple threads
+	std::shared_ptr<ParallelEntityWriter> _parallelWriter;
+
 	// The stream we're writing to
 	std::ostream& _mapStream;
 
@@ -86,6 +90,9 @@ private:
 
 	void onNodeProgress();
 
+	// The writer receiving the nodes during traversal
+	IMapWriter& getNodeWriter();
+
 	// Is called before exporting the scene to prepare func_* groups.
 	void prepareScene();
 
@@ -0,0 +1,305 @@
+#include "ParallelEntityWriter.h"
+
+#include "itextstream.h"
+#include "ithreadpool.h"
+#include <algorithm>
+
+namespace map
+{
+
+struct ParallelEntityWriter::WriteCall
+{
+	enum class Type
+	{
+		BeginEntity,
+		EndEntity,
+		BeginBrush,
+		EndBrush,
+		BeginPatch,
+		EndPatch,
+	};
+
+	Type type;
+
+	// Only the pointer matching the call type is set
+	EntityNodePtr entity;
+	IBrushNodePtr brush;
+	IPatchNodePtr patch;
+
+	bool isBeginCall() const
+	{
+		return type == Type::BeginEntity || type == Type::BeginBrush || type == Type::BeginPatch;
+	}
+};
+
+struct ParallelEntityWriter::Block
+{
+	// The writer used to replay the calls of this block
+	IMapWriterPtr writer;
+
+	std::vector<WriteCall> calls;
+
+	// The map text produced by the worker
+	std::string output;
+
+	// Writer failures, reported when the output is written to the map stream
+	std::vector<std::string> errors;
+
+	// Set by the worker once it's done with this block (guarded by the lock)
+	bool done = false;
+};
+
+ParallelEntityWriter::ParallelEntityWriter(IMapWriter& writer) :
+	_writer(writer),
+	_entityCount(0),
+	_entityDepth(0),
+	_nextBlock(0),
+	_recordingFinished(false),
+	_cancelled(false)
+{}
+
+ParallelEntityWriter::~ParallelEntityWriter()
+{
+	// Also reached when the traversal has been aborted with an exception
+	stopWorkers();
+}
+
+std::shared_ptr<ParallelEntityWriter> ParallelEntityWriter::Create(IMapWriter& writer)
+{
+	if (GlobalThreadPool().getNumWorkers() < 2 || !writer.createEntityWriter(0))
+	{
+		return std::shared_ptr<ParallelEntityWriter>();
+	}
+
+	return std::shared_ptr<ParallelEntityWriter>(new ParallelEntityWriter(writer));
+}
+
+void ParallelEntityWriter::beginWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream)
+{
+	// The buffers need the same precision and flags as the map stream
+	_streamFormat.copyfmt(stream);
+
+	_writer.beginWriteMap(root, stream);
+}
+
+void ParallelEntityWriter::endWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream)
+{
+	// Primitives following the last entity end up in a block of their own
+	if (_currentBlock)
+	{
+		submitCurrentBlock();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_recordingFinished = true;
+	}
+
+	_blocksChanged.notify_all();
+
+	// Help with the remaining blocks, the pool might be busy with other tasks
+	processBlocks();
+
+	for (std::size_t i = 0; i < _blocks.size(); ++i)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_lock);
+			_blocksChanged.wait(lock, [&]() { return _blocks[i]->done; });
+		}
+
+		const auto& block = *_blocks[i];
+
+		for (const auto& error : block.errors)
+		{
+			rError() << error << std::endl;
+		}
+
+		stream.write(block.output.data(), static_cast<std::streamsize>(block.output.size()));
+
+		// Free the memory, the workers don't touch finished blocks anymore
+		_blocks[i].reset();
+	}
+
+	stopWorkers();
+
+	_writer.endWriteMap(root, stream);
+}
+
+void ParallelEntityWriter::beginWriteEntity(const EntityNodePtr& entity, std::ostream& stream)
+{
+	getCurrentBlock().calls.push_back(WriteCall{ WriteCall::Type::BeginEntity, entity, {}, {} });
+
+	++_entityCount;
+	++_entityDepth;
+}
+
+void ParallelEntityWriter::endWriteEntity(const EntityNodePtr& entity, std::ostream& stream)
+{
+	getCurrentBlock().calls.push_back(WriteCall{ WriteCall::Type::EndEntity, entity, {}, {} });
+
+	if (_entityDepth > 0 && --_entityDepth == 0)
+	{
+		// The writer state is reset at the end of each top-level entity,
+		// the next block can be written independently
+		submitCurrentBlock();
+	}
+}
+
+void ParallelEntityWriter::beginWriteBrush(const IBrushNodePtr& brush, std::ostream& stream)
+{
+	getCurrentBlock().calls.push_back(WriteCall{ WriteCall::Type::BeginBrush, {}, brush, {} });
+}
+
+void ParallelEntityWriter::endWriteBrush(const IBrushNodePtr& brush, std::ostream& stream)
+{
+	getCurrentBlock().calls.push_back(WriteCall{ WriteCall::Type::EndBrush, {}, brush, {} });
+}
+
+void ParallelEntityWriter::beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream)
+{
+	getCurrentBlock().calls.push_back(WriteCall{ WriteCall::Type::BeginPatch, {}, {}, patch });
+}
+
+void ParallelEntityWriter::endWritePatch(const IPatchNodePtr& patch, std::ostream& stream)
+{
+	getCurrentBlock().calls.push_back(WriteCall{ WriteCall::Type::EndPatch, {}, {}, patch });
+}
+
+ParallelEntityWriter::Block& ParallelEntityWriter::getCurrentBlock()
+{
+	if (!_currentBlock)
+	{
+		_currentBlock.reset(new Block);
+
+		// Blocks are starting at the beginning of the map or after a top-level entity,
+		// which is the state the entity writers are set up to be in
+		_currentBlock->writer = _writer.createEntityWriter(_entityCount);
+	}
+
+	return *_currentBlock;
+}
+
+void ParallelEntityWriter::submitCurrentBlock()
+{
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_blocks.emplace_back(std::move(_currentBlock));
+	}
+
+	_blocksChanged.notify_all();
+
+	if (_workers.empty())
+	{
+		startWorkers();
+	}
+}
+
+void ParallelEntityWriter::startWorkers()
+{
+	for (std::size_t i = 0; i < GlobalThreadPool().getNumWorkers(); ++i)
+	{
+		_workers.emplace_back(GlobalThreadPool().schedule([this]() { processBlocks(); }));
+	}
+}
+
+void ParallelEntityWriter::stopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_cancelled = true;
+	}
+
+	_blocksChanged.notify_all();
+
+	for (const auto& worker : _workers)
+	{
+		// Workers which didn't start yet are not needed anymore
+		worker->cancel();
+		worker->wait();
+	}
+
+	_workers.clear();
+}
+
+void ParallelEntityWriter::processBlocks()
+{
+	while (true)
+	{
+		Block* block = nullptr;
+
+		{
+			std::unique_lock<std::mutex> lock(_lock);
+
+			_blocksChanged.wait(lock, [&]()
+			{
+				return _cancelled || _recordingFinished || _nextBlock < _blocks.size();
+			});
+
+			if (_cancelled || _nextBlock == _blocks.size())
+			{
+				return; // cancelled or no more blocks to come
+			}
+
+			block = _blocks[_nextBlock++].get();
+		}
+
+		writeBlock(*block);
+
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			block->done = true;
+		}
+
+		_blocksChanged.notify_all();
+	}
+}
+
+void ParallelEntityWriter::writeBlock(Block& block)
+{
+	std::ostringstream stream;
+	stream.copyfmt(_streamFormat);
+
+	auto& writer = *block.writer;
+
+	for (const auto& call : block.calls)
+	{
+		try
+		{
+			switch (call.type)
+			{
+			case WriteCall::Type::BeginEntity:
+				writer.beginWriteEntity(call.entity, stream);
+				break;
+			case WriteCall::Type::EndEntity:
+				writer.endWriteEntity(call.entity, stream);
+				break;
+			case WriteCall::Type::BeginBrush:
+				writer.beginWriteBrush(call.brush, stream);
+				break;
+			case WriteCall::Type::EndBrush:
+				writer.endWriteBrush(call.brush, stream);
+				break;
+			case WriteCall::Type::BeginPatch:
+				writer.beginWritePatch(call.patch, stream);
+				break;
+			case WriteCall::Type::EndPatch:
+				writer.endWritePatch(call.patch, stream);
+				break;
+			}
+		}
+		catch (IMapWriter::FailureException& ex)
+		{
+			// Same message as the MapExporter is using
+			block.errors.emplace_back(std::string("Failure exporting a node (") +
+				(call.isBeginCall() ? "pre" : "post") + "): " + ex.what());
+		}
+	}
+
+	block.output = stream.str();
+
+	// The nodes are not needed anymore
+	block.calls.clear();
+	block.writer.reset();
+}
+
+} // namespace
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "imapformat.h"
+#include "ithreadpool.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace map
+{
+
+/**
+ * IMapWriter adaptor used by the MapExporter to serialise the entities
+ * of a map on the shared thread pool.
+ *
+ * The begin/end calls of the entities and primitives are recorded in blocks,
+ * each block holding a top-level entity including its primitives. Every block
+ * is replayed on a separate writer acquired through IMapWriter::createEntityWriter(),
+ * writing to its own buffer. In endWriteMap() the buffers are written to
+ * the map stream in traversal order, followed by the wrapped writer's footer.
+ * The output is the same as if the wrapped writer had been used directly.
+ *
+ * Workers are started as soon as the first block is complete, so the
+ * serialisation runs in parallel to the remaining scene traversal.
+ */
+class ParallelEntityWriter :
+	public IMapWriter
+{
+private:
+	struct WriteCall;
+	struct Block;
+
+	// The writer we're wrapping
+	IMapWriter& _writer;
+
+	// Holds the formatting settings of the map stream
+	std::ostringstream _streamFormat;
+
+	// The block which is currently recorded (not visible to the workers yet)
+	std::unique_ptr<Block> _currentBlock;
+
+	// The number of begun entities, and the current nesting level
+	std::size_t _entityCount;
+	std::size_t _entityDepth;
+
+	// The completed blocks, in traversal order
+	std::vector<std::unique_ptr<Block>> _blocks;
+	std::size_t _nextBlock;
+	bool _recordingFinished;
+	bool _cancelled;
+
+	// Guards the block list and the flags above
+	std::mutex _lock;
+	std::condition_variable _blocksChanged;
+
+	std::vector<threading::ITaskPtr> _workers;
+
+	ParallelEntityWriter(IMapWriter& writer);
+
+public:
+	~ParallelEntityWriter();
+
+	// Returns a new instance wrapping the given writer, or an empty
+	// pointer if the writer doesn't support per-entity writers
+	static std::shared_ptr<ParallelEntityWriter> Create(IMapWriter& writer);
+
+	void beginWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream) override;
+	void endWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream) override;
+
+	// Entity export methods
+	void beginWriteEntity(const EntityNodePtr& entity, std::ostream& stream) override;
+	void endWriteEntity(const EntityNodePtr& entity, std::ostream& stream) override;
+
+	// Brush export methods
+	void beginWriteBrush(const IBrushNodePtr& brush, std::ostream& stream) override;
+	void endWriteBrush(const IBrushNodePtr& brush, std::ostream& stream) override;
+
+	// Patch export methods
+	void beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override;
+	void endWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override;
+
+private:
+	// Returns the block currently recorded, starting a new one if necessary
+	Block& getCurrentBlock();
+
+	// Hands the current block over to the workers
+	void submitCurrentBlock();
+
+	void startWorkers();
+	void stopWorkers();
+	void processBlocks();
+
+	// Replays the recorded calls of the given block into its buffer
+	void writeBlock(Block& block);
+};
+
+} // namespace
@@ -9,9 +9,10 @@
 #include "iregistry.h"
 #include "igame.h"
 #include "ipreferencesystem.h"
-#include "icommandsystem.h"
+#include "imapformat.h"
 
 #include "registry/registry.h"
+#include "scene/Traverse.h"
 
 #include "os/file.h"
 #include "os/path.h"
@@ -23,8 +24,11 @@
 #include "module/StaticModule.h"
 #include "messages/NotificationMessage.h"
 #include "messages/AutomaticMapSaveRequest.h"
+#include "../MapResource.h"
 
 #include <fmt/format.h>
+#include <set>
+#include <sstream>
 
 namespace map
 {
@@ -34,6 +38,14 @@ namespace
 	// Registry key names
 	const char* GKEY_MAP_EXTENSION = "/mapFormat/fileExtension";
 
+	// Only the most recent operation names are recorded in the journal
+	constexpr std::size_t MAX_RECORDED_OPERATIONS = 100;
+
+	fs::path getInfoFilename(const std::string& mapFilename)
+	{
+		return fs::path(mapFilename).replace_extension(game::current::getInfoFileExtension());
+	}
+
 	std::string constructSnapshotName(const fs::path& snapshotPath, const std::string& mapName, int num)
 	{
 		std::string mapExt = game::current::getValue<std::string>(GKEY_MAP_EXTENSION);
@@ -53,12 +65,14 @@ namespace
 
 AutoMapSaver::AutoMapSaver() :
 	_snapshotsEnabled(false),
+	_journalEnabled(false),
     _savedChangeCount(0)
 {}
 
 void AutoMapSaver::registryKeyChanged()
 {
 	_snapshotsEnabled = registry::getValue<bool>(RKEY_AUTOSAVE_SNAPSHOTS_ENABLED);
+	_journalEnabled = registry::getValue<bool>(RKEY_AUTOSAVE_JOURNAL_ENABLED);
 }
 
 void AutoMapSaver::clearChanges()
@@ -107,7 +121,7 @@ void AutoMapSaver::saveSnapshot()
 		rMessage() << "Autosaving snapshot to " << filename << std::endl;
 
 		// Dump to map to the next available filename
-        GlobalCommandSystem().executeCommand("SaveAutomaticBackup", filename);
+		saveInBackground(filename);
 
 		handleSnapshotSizeLimit(existingSnapshots, snapshotPath, mapName);
 	}
@@ -117,6 +131,128 @@ void AutoMapSaver::saveSnapshot()
 	}
 }
 
+bool AutoMapSaver::exportToMemory(const std::string& filename, std::string& mapText,
+	std::string& infoText, bool& writeInfoFile)
+{
+	auto format = GlobalMapFormatManager().getMapFormatForFilename(filename);
+
+	if (!format)
+	{
+		rError() << "Autosave failed, no map format available for " << filename << std::endl;
+		return false;
+	}
+
+	// Capture the map and info file contents, this is the only part that has
+	// to be done before the user can continue to edit the scene
+	std::ostringstream mapStream;
+	std::ostringstream infoStream;
+
+	try
+	{
+		auto mapWriter = _mapTextCache.createWriter(*format);
+		MapResource::saveToStream(*format, *mapWriter, GlobalSceneGraph().root(), scene::traverse, mapStream, &infoStream);
+	}
+	catch (const IMapResource::OperationException& ex)
+	{
+		radiant::NotificationMessage::SendError(ex.what());
+		return false;
+	}
+
+	mapText = mapStream.str();
+	infoText = infoStream.str();
+	writeInfoFile = format->allowInfoFileCreation();
+
+	return true;
+}
+
+void AutoMapSaver::saveInBackground(const std::string& filename)
+{
+	std::string mapText;
+	std::string infoText;
+	bool writeInfoFile;
+
+	if (!exportToMemory(filename, mapText, infoText, writeInfoFile))
+	{
+		return;
+	}
+
+	fs::path mapFile = filename;
+	auto infoFile = getInfoFilename(filename);
+
+	_pendingSave = threading::runAsync(
+		[this, mapFile, infoFile, writeInfoFile, mapText = std::move(mapText), infoText = std::move(infoText)]()
+	{
+		AutosaveJournal::WriteFiles(mapFile, infoFile, writeInfoFile, mapText, infoText,
+			[this](float fraction) { _sigSaveProgress.emit(fraction); });
+
+		_sigSaveProgress.emit(1.0f);
+
+		rMessage() << "Autosave written to " << mapFile.string() << std::endl;
+	}, threading::TaskPriority::Low);
+}
+
+void AutoMapSaver::saveCheckpointInBackground(const std::string& filename)
+{
+	std::string mapText;
+	std::string infoText;
+	bool writeInfoFile;
+
+	if (!exportToMemory(filename, mapText, infoText, writeInfoFile))
+	{
+		return;
+	}
+
+	fs::path mapFile = filename;
+	auto infoFile = getInfoFilename(filename);
+
+	_pendingSave = threading::runAsync(
+		[this, mapFile, infoFile, writeInfoFile, useJournal = _journalEnabled,
+		 operations = std::move(_recordedOperations), mapText = std::move(mapText), infoText = std::move(infoText)]()
+	{
+		_journal.checkpoint(mapFile, infoFile, writeInfoFile, mapText, infoText, useJournal, operations,
+			[this](float fraction) { _sigSaveProgress.emit(fraction); });
+
+		_sigSaveProgress.emit(1.0f);
+	}, threading::TaskPriority::Low);
+
+	_recordedOperations.clear();
+}
+
+bool AutoMapSaver::pendingSaveFinished() const
+{
+	return !_pendingSave.valid() || _pendingSave.isReady();
+}
+
+void AutoMapSaver::finishPendingSave()
+{
+	if (!_pendingSave.valid())
+	{
+		return;
+	}
+
+	// The result is only reported once
+	auto pendingSave = std::move(_pendingSave);
+
+	try
+	{
+		// Blocks until the worker is done, re-throws any exception it encountered
+		pendingSave.get();
+	}
+	catch (const std::runtime_error& ex)
+	{
+		rError() << "Autosave failed: " << ex.what() << std::endl;
+		radiant::NotificationMessage::SendError(fmt::format(_("Autosave failed:\n{0}"), ex.what()));
+
+		// Don't append to a journal that might be damaged
+		_journal.reset();
+	}
+}
+
+sigc::signal<void(float)>& AutoMapSaver::signal_saveProgress()
+{
+	return _sigSaveProgress;
+}
+
 void AutoMapSaver::handleSnapshotSizeLimit(const std::map<int, std::string>& existingSnapshots,
 	const fs::path& snapshotPath, const std::string& mapName)
 {
@@ -196,6 +332,16 @@ void AutoMapSaver::collectExistingSnapshots(std::map<int, std::string>& existing
 
 bool AutoMapSaver::runAutosaveCheck()
 {
+    // Don't start over while the previous save is still being written
+    if (!pendingSaveFinished())
+    {
+        rMessage() << "Auto save skipped: the previous save is still in progress" << std::endl;
+        return false;
+    }
+
+    // Report the outcome of the previous save
+    finishPendingSave();
+
     // Check, if changes have been made since the last autosave
     if (!GlobalSceneGraph().root() || _savedChangeCount == GlobalSceneGraph().root()->getUndoChangeTracker().getCurrentChangeCount())
     {
@@ -216,6 +362,9 @@ bool AutoMapSaver::runAutosaveCheck()
 
 void AutoMapSaver::performAutosave()
 {
+    // Only one save can be in progress at a time
+    finishPendingSave();
+
     // Remember the change tracking counter
     _savedChangeCount = GlobalSceneGraph().root()->getUndoChangeTracker().getCurrentChangeCount();
 
@@ -230,41 +379,85 @@ void AutoMapSaver::performAutosave()
         {
             rError() << "AutoSaver::saveSnapshot: " << f.what() << std::endl;
         }
+
+        // Snapshots are full copies, the operations are not recorded anywhere
+        _recordedOperations.clear();
     }
     else
     {
+        auto filename = getAutosaveFilename();
+
         if (GlobalMapModule().isUnnamed())
         {
-            // Get the maps path (within the mod path)
-            auto autoSaveFilename = GlobalGameManager().getMapPath();
-
             // Try to create the map folder, in case there doesn't exist one
-            os::makeDirectory(autoSaveFilename);
-
-            // Append the "autosave.map" to the filename
-            autoSaveFilename += "autosave.";
-            autoSaveFilename += game::current::getValue<std::string>(GKEY_MAP_EXTENSION);
+            os::makeDirectory(GlobalGameManager().getMapPath());
 
-            rMessage() << "Autosaving unnamed map to " << autoSaveFilename << std::endl;
-
-            // Invoke the save call
-            GlobalCommandSystem().executeCommand("SaveAutomaticBackup", autoSaveFilename);
+            rMessage() << "Autosaving unnamed map to " << filename << std::endl;
         }
         else
         {
-            // Construct the new filename (e.g. "test_autosave.map")
-            auto filename = GlobalMapModule().getMapName();
-            auto extension = os::getExtension(filename);
+            rMessage() << "Autosaving map to " << filename << std::endl;
+        }
 
-            // Cut off the extension
-            filename = filename.substr(0, filename.rfind('.'));
-            filename += "_autosave";
-            filename += "." + extension;
+        saveCheckpointInBackground(filename);
+    }
+}
 
-            rMessage() << "Autosaving map to " << filename << std::endl;
+std::string AutoMapSaver::getAutosaveFilename()
+{
+    if (GlobalMapModule().isUnnamed())
+    {
+        // Get the maps path (within the mod path)
+        auto autoSaveFilename = GlobalGameManager().getMapPath();
+
+        // Append the "autosave.map" to the filename
+        autoSaveFilename += "autosave.";
+        autoSaveFilename += game::current::getValue<std::string>(GKEY_MAP_EXTENSION);
+
+        return autoSaveFilename;
+    }
+
+    // Construct the new filename (e.g. "test_autosave.map")
+    auto filename = GlobalMapModule().getMapName();
+
+    if (!fs::path(filename).is_absolute())
+    {
+        filename = GlobalFileSystem().findFile(filename) + filename;
+    }
 
-            // Invoke the save call
-            GlobalCommandSystem().executeCommand("SaveAutomaticBackup", filename);
+    auto extension = os::getExtension(filename);
+
+    // Cut off the extension
+    filename = filename.substr(0, filename.rfind('.'));
+    filename += "_autosave";
+    filename += "." + extension;
+
+    return filename;
+}
+
+void AutoMapSaver::replayJournals()
+{
+    // The autosave of the map about to be loaded, and the loaded file itself
+    // in case it's an autosave the user wants to recover
+    std::set<std::string> filenames{ getAutosaveFilename() };
+
+    if (!GlobalMapModule().isUnnamed())
+    {
+        filenames.insert(GlobalMapModule().getMapName());
+    }
+
+    for (const auto& filename : filenames)
+    {
+        try
+        {
+            if (AutosaveJournal::Replay(filename, getInfoFilename(filename)))
+            {
+                rMessage() << "Autosave " << filename << " has been restored from its journal" << std::endl;
+            }
+        }
+        catch (const std::runtime_error& ex)
+        {
+            rError() << "Failed to replay the autosave journal of " << filename << ": " << ex.what() << std::endl;
         }
     }
 }
@@ -275,6 +468,8 @@ void AutoMapSaver::constructPreferences()
 	IPreferencePage& page = GlobalPreferenceSystem().getPage(_("Autosave"));
 
 	page.appendCheckBox(_("Save Snapshots"), RKEY_AUTOSAVE_SNAPSHOTS_ENABLED);
+	page.appendCheckBox(_("Only save the changes since the last Autosave (not applicable to Snapshots)"),
+		RKEY_AUTOSAVE_JOURNAL_ENABLED);
 	page.appendEntry(_("Snapshot Folder (absolute, or relative to Map Folder)"), RKEY_AUTOSAVE_SNAPSHOTS_FOLDER);
 	page.appendEntry(_("Max total Snapshot size per Map (MB)"), RKEY_AUTOSAVE_MAX_SNAPSHOT_FOLDER_SIZE);
 }
@@ -286,16 +481,59 @@ void AutoMapSaver::onMapEvent(IMap::MapEvent ev)
 	switch (ev)
 	{
 	case IMap::MapLoading:
+		clearChanges();
+
+		// A different map gets a new journal, restore what has been left behind
+		finishPendingSave();
+		_journal.reset();
+		_recordedOperations.clear();
+
+		replayJournals();
+		break;
 	case IMap::MapLoaded:
+		clearChanges();
+
+		_undoEventConnection.disconnect();
+		_undoEventConnection = GlobalSceneGraph().root()->getUndoSystem().signal_undoEvent().connect(
+			sigc::mem_fun(*this, &AutoMapSaver::onUndoEvent)
+		);
+
+		_mapTextCache.connectUndoSystem(GlobalSceneGraph().root()->getUndoSystem());
+		break;
 	case IMap::MapUnloading:
 	case IMap::MapUnloaded:
 		clearChanges();
+		_undoEventConnection.disconnect();
+		_mapTextCache.disconnectUndoSystem();
 		break;
     default:
         break;
 	};
 }
 
+void AutoMapSaver::onUndoEvent(IUndoSystem::EventType type, const std::string& operationName)
+{
+	switch (type)
+	{
+	case IUndoSystem::EventType::OperationRecorded:
+		_recordedOperations.push_back(operationName);
+		break;
+	case IUndoSystem::EventType::OperationUndone:
+		_recordedOperations.push_back(fmt::format(_("Undo: {0}"), operationName));
+		break;
+	case IUndoSystem::EventType::OperationRedone:
+		_recordedOperations.push_back(fmt::format(_("Redo: {0}"), operationName));
+		break;
+	default:
+		return;
+	}
+
+	if (_recordedOperations.size() > MAX_RECORDED_OPERATIONS)
+	{
+		_recordedOperations.erase(_recordedOperations.begin());
+	}
+}
+
 std::string AutoMapSaver::getName() const
 {
 	static std::string _name(MODULE_AUTOSAVER);
@@ -311,6 +549,7 @@ StringSet AutoMapSaver::getDependencies() const
 		_dependencies.insert(MODULE_MAP);
 		_dependencies.insert(MODULE_PREFERENCESYSTEM);
 		_dependencies.insert(MODULE_XMLREGISTRY);
+		_dependencies.insert(MODULE_THREADPOOL);
 	}
 
 	return _dependencies;
@@ -321,6 +560,9 @@ void AutoMapSaver::initialiseModule(const IApplicationContext& ctx)
 	_signalConnections.push_back(GlobalRegistry().signalForKey(RKEY_AUTOSAVE_SNAPSHOTS_ENABLED).connect(
 		sigc::mem_fun(this, &AutoMapSaver::registryKeyChanged)
 	));
+	_signalConnections.push_back(GlobalRegistry().signalForKey(RKEY_AUTOSAVE_JOURNAL_ENABLED).connect(
+		sigc::mem_fun(this, &AutoMapSaver::registryKeyChanged)
+	));
 
 	// Get notified when the map is loaded afresh
 	_signalConnections.push_back(GlobalMapModule().signal_mapEvent().connect(
@@ -339,6 +581,9 @@ void AutoMapSaver::initialiseModule(const IApplicationContext& ctx)
 
 void AutoMapSaver::shutdownModule()
 {
+	// Don't leave the snapshot files unfinished
+	finishPendingSave();
+
 	// Unsubscribe from all connections
 	for (sigc::connection& connection : _signalConnections)
 	{
@@ -346,6 +591,8 @@ void AutoMapSaver::shutdownModule()
 	}
 
 	_signalConnections.clear();
+	_undoEventConnection.disconnect();
+	_mapTextCache.disconnectUndoSystem();
 }
 
 module::StaticModuleRegistration<AutoMapSaver> staticAutoSaverModule;
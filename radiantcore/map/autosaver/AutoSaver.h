@@ -4,6 +4,10 @@
 
 #include "imap.h"
 #include "iautosaver.h"
+#include "iundo.h"
+#include "ithreadpool.h"
+#include "AutosaveJournal.h"
+#include "MapTextCache.h"
 
 #include <vector>
 #include <sigc++/connection.h>
@@ -22,10 +26,28 @@ private:
 	// TRUE, if the autosaver generates snapshots
 	bool _snapshotsEnabled;
 
+	// TRUE, if only the changes are written to the autosave journal
+	bool _journalEnabled;
+
 	std::size_t _savedChangeCount;
 
 	std::vector<sigc::connection> _signalConnections;
 
+	// The snapshot currently written to disk on a worker thread
+	threading::TaskFuture<void> _pendingSave;
+
+	sigc::signal<void(float)> _sigSaveProgress;
+
+	// Accessed by the worker thread while a save is pending
+	AutosaveJournal _journal;
+
+	// The undo operations performed since the last automatic save
+	std::vector<std::string> _recordedOperations;
+	sigc::connection _undoEventConnection;
+
+	// Only the nodes changed since the last automatic save are exported again
+	MapTextCache _mapTextCache;
+
 public:
 	// Constructor
 	AutoMapSaver();
@@ -45,16 +67,41 @@ public:
 
     void performAutosave() override;
 
+    void finishPendingSave() override;
+
+    sigc::signal<void(float)>& signal_saveProgress() override;
+
 private:
 	void constructPreferences();
 
 	void registryKeyChanged();
 
 	void onMapEvent(IMap::MapEvent ev);
+	void onUndoEvent(IUndoSystem::EventType type, const std::string& operationName);
+
+	// Returns the file name used for autosaves when not saving snapshots
+	std::string getAutosaveFilename();
+
+	// Restores the autosave files from their journals, if there are any left behind
+	void replayJournals();
 
 	// Saves a snapshot of the currently active map (only named maps)
 	void saveSnapshot();
 
+	// Exports the map to memory, re-using the text of the unchanged nodes. Returns false on failure.
+	bool exportToMemory(const std::string& filename, std::string& mapText,
+		std::string& infoText, bool& writeInfoFile);
+
+	// Exports the map to memory and writes it to the given file in the background
+	void saveInBackground(const std::string& filename);
+
+	// Exports the map to memory and writes the changes to the autosave journal
+	// (or a full copy) in the background
+	void saveCheckpointInBackground(const std::string& filename);
+
+	// True if the background save is done or there is none
+	bool pendingSaveFinished() const;
+
 	void collectExistingSnapshots(std::map<int, std::string>& existingSnapshots,
 		const fs::path& snapshotPath, const std::string& mapName);
 
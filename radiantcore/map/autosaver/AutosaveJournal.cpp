@@ -0,0 +1,813 @@
+#include "AutosaveJournal.h"
+
+#include "i18n.h"
+#include "itextstream.h"
+#include "math/Hash.h"
+#include "string/charconv.h"
+#include "stream/TemporaryOutputStream.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string_view>
+#include <utility>
+#include <fmt/format.h>
+
+namespace map
+{
+
+namespace
+{
+    constexpr const char* const JOURNAL_HEADER = "DarkRadiant autosave journal 1";
+    constexpr const char* const JOURNAL_EXTENSION = ".journal";
+
+    // The journal is compacted into a full copy after this many checkpoints,
+    // or when it is growing larger than the map file divided by this number
+    constexpr std::size_t MAX_CHECKPOINTS = 64;
+    constexpr std::size_t MAX_JOURNAL_SIZE_DIVISOR = 2;
+
+    // Number of bytes written between two progress updates
+    constexpr std::size_t WRITE_CHUNK_SIZE = 1024 * 1024;
+
+    // A chunk boundary is placed where the rolling hash has these bits cleared,
+    // which results in an average chunk size of 2 KB, within the given limits
+    constexpr std::uint64_t CHUNK_BOUNDARY_MASK = 0x7FFull << 53;
+    constexpr std::size_t MIN_CHUNK_SIZE = 512;
+    constexpr std::size_t MAX_CHUNK_SIZE = 16384;
+
+    // Random values for the gear hash, generated using splitmix64
+    constexpr std::array<std::uint64_t, 256> generateGearTable()
+    {
+        std::array<std::uint64_t, 256> table{};
+        std::uint64_t state = 0;
+
+        for (std::size_t i = 0; i < table.size(); ++i)
+        {
+            state += 0x9e3779b97f4a7c15ull;
+
+            auto value = state;
+            value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+            value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+            table[i] = value ^ (value >> 31);
+        }
+
+        return table;
+    }
+
+    constexpr auto GEAR_TABLE = generateGearTable();
+
+    // The comments written by the map writers in front of each entity and primitive
+    constexpr std::string_view ENTITY_COMMENT = "// entity ";
+    constexpr std::string_view PRIMITIVE_COMMENTS[] = { "// primitive ", "// brush " };
+
+    // Returns the number comment the given line is starting with, or an empty view
+    std::string_view getNumberComment(std::string_view line)
+    {
+        if (line.substr(0, ENTITY_COMMENT.size()) == ENTITY_COMMENT)
+        {
+            return ENTITY_COMMENT;
+        }
+
+        for (auto comment : PRIMITIVE_COMMENTS)
+        {
+            if (line.substr(0, comment.size()) == comment)
+            {
+                return comment;
+            }
+        }
+
+        return std::string_view();
+    }
+
+    // Invokes the given functor for each line of the text, including the line break
+    template<typename Functor>
+    void forEachLine(const std::string& text, const Functor& functor)
+    {
+        std::size_t pos = 0;
+
+        while (pos < text.size())
+        {
+            auto lineEnd = text.find('\n', pos);
+            lineEnd = lineEnd == std::string::npos ? text.size() : lineEnd + 1;
+
+            if (!functor(std::string_view(text.data() + pos, lineEnd - pos)))
+            {
+                return;
+            }
+
+            pos = lineEnd;
+        }
+    }
+
+    // Removes the numbers from the entity and primitive comments, "// entity 12" becomes "// entity ".
+    // Returns false if the numbers are not in the order restoreNumberComments() generates them.
+    bool stripNumberComments(const std::string& text, std::string& result)
+    {
+        result.clear();
+        result.reserve(text.size());
+
+        std::size_t entityNum = 0;
+        std::size_t primitiveNum = 0;
+        bool success = true;
+
+        forEachLine(text, [&](std::string_view line)
+        {
+            auto comment = getNumberComment(line);
+
+            if (comment.empty())
+            {
+                result.append(line);
+                return true;
+            }
+
+            auto isEntity = comment == ENTITY_COMMENT;
+            auto& number = isEntity ? entityNum : primitiveNum;
+
+            char buffer[24];
+            auto end = std::to_chars(buffer, buffer + sizeof(buffer) - 1, number).ptr;
+            *end++ = '\n';
+
+            if (line.substr(comment.size()) != std::string_view(buffer, end - buffer))
+            {
+                success = false;
+                return false;
+            }
+
+            result.append(comment);
+            result += '\n';
+
+            ++number;
+
+            if (isEntity)
+            {
+                primitiveNum = 0;
+            }
+
+            return true;
+        });
+
+        return success;
+    }
+
+    // Re-generates the numbers removed by stripNumberComments()
+    std::string restoreNumberComments(const std::string& text)
+    {
+        std::string result;
+        result.reserve(text.size() + text.size() / 32);
+
+        std::size_t entityNum = 0;
+        std::size_t primitiveNum = 0;
+
+        forEachLine(text, [&](std::string_view line)
+        {
+            auto comment = getNumberComment(line);
+
+            if (comment.empty() || line.size() != comment.size() + 1)
+            {
+                result.append(line);
+                return true;
+            }
+
+            auto isEntity = comment == ENTITY_COMMENT;
+            auto& number = isEntity ? entityNum : primitiveNum;
+
+            result.append(comment);
+            result.append(std::to_string(number++));
+            result += '\n';
+
+            if (isEntity)
+            {
+                primitiveNum = 0;
+            }
+
+            return true;
+        });
+
+        return result;
+    }
+
+    std::string getContentHash(const std::string& text)
+    {
+        math::Hash hash;
+        hash.addString(text);
+        return hash;
+    }
+
+    // Loads the file in text mode, the same way it has been written
+    std::string loadTextFile(const fs::path& path)
+    {
+        std::ifstream stream(path);
+        std::stringstream contents;
+        contents << stream.rdbuf();
+        return contents.str();
+    }
+
+    std::string loadBinaryFile(const fs::path& path)
+    {
+        std::ifstream stream(path, std::ios::binary);
+        std::stringstream contents;
+        contents << stream.rdbuf();
+        return contents.str();
+    }
+
+    // Returns the first word of the line and the remainder
+    std::pair<std::string_view, std::string_view> splitKeyword(std::string_view line)
+    {
+        auto space = line.find(' ');
+
+        if (space == std::string_view::npos)
+        {
+            return std::make_pair(line, std::string_view());
+        }
+
+        return std::make_pair(line.substr(0, space), line.substr(space + 1));
+    }
+
+    // Sequential reader for the journal contents
+    class JournalReader
+    {
+    private:
+        std::string_view _text;
+        std::size_t _pos;
+
+    public:
+        JournalReader(std::string_view text) :
+            _text(text),
+            _pos(0)
+        {}
+
+        // Reads the next line, excluding the line break. Returns false
+        // at the end of the journal or if the line is incomplete.
+        bool readLine(std::string_view& line)
+        {
+            auto end = _text.find('\n', _pos);
+
+            if (end == std::string_view::npos)
+            {
+                return false;
+            }
+
+            line = _text.substr(_pos, end - _pos);
+            _pos = end + 1;
+            return true;
+        }
+
+        // Reads a block of the given length, which is followed by a line break
+        bool readBlock(std::size_t length, std::string_view& block)
+        {
+            if (_text.size() - _pos <= length || _text[_pos + length] != '\n')
+            {
+                return false;
+            }
+
+            block = _text.substr(_pos, length);
+            _pos += length + 1;
+            return true;
+        }
+    };
+
+    // Reads the instructions up to the "end" line, building the new text out of the previous one
+    bool readDifference(JournalReader& reader, const std::string& previous, std::string& result)
+    {
+        constexpr auto invalid = std::numeric_limits<std::size_t>::max();
+
+        result.clear();
+        std::string_view line;
+
+        while (reader.readLine(line))
+        {
+            auto [keyword, args] = splitKeyword(line);
+
+            if (keyword == "end")
+            {
+                return true;
+            }
+
+            if (keyword == "copy")
+            {
+                auto [offsetArg, lengthArg] = splitKeyword(args);
+                auto offset = string::to_integer<std::size_t>(offsetArg, invalid);
+                auto length = string::to_integer<std::size_t>(lengthArg, invalid);
+
+                if (offset > previous.size() || length > previous.size() - offset)
+                {
+                    return false;
+                }
+
+                result.append(previous, offset, length);
+            }
+            else if (keyword == "insert")
+            {
+                auto length = string::to_integer<std::size_t>(args, invalid);
+                std::string_view block;
+
+                if (length == invalid || !reader.readBlock(length, block))
+                {
+                    return false;
+                }
+
+                result.append(block);
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    // Applies the complete checkpoints to the given (number-stripped) texts,
+    // returns the number of applied checkpoints
+    std::size_t applyCheckpoints(JournalReader& reader, std::string& mapText, std::string& infoText, bool hasInfo)
+    {
+        std::size_t applied = 0;
+        std::string_view line;
+
+        std::string newMapText;
+        std::string newInfoText;
+
+        while (reader.readLine(line) && splitKeyword(line).first == "checkpoint")
+        {
+            bool mapChanged = false;
+            bool infoChanged = false;
+            bool committed = false;
+
+            while (!committed && reader.readLine(line))
+            {
+                auto [keyword, args] = splitKeyword(line);
+
+                if (keyword == "operation")
+                {
+                    std::string_view name;
+
+                    if (!reader.readBlock(string::to_integer<std::size_t>(args), name))
+                    {
+                        return applied;
+                    }
+                }
+                else if (keyword == "map")
+                {
+                    if (!readDifference(reader, mapText, newMapText))
+                    {
+                        return applied;
+                    }
+
+                    mapChanged = true;
+                }
+                else if (keyword == "info" && hasInfo)
+                {
+                    if (!readDifference(reader, infoText, newInfoText))
+                    {
+                        return applied;
+                    }
+
+                    infoChanged = true;
+                }
+                else if (keyword == "commit")
+                {
+                    committed = true;
+                }
+                else
+                {
+                    return applied;
+                }
+            }
+
+            // An incomplete checkpoint at the end is left out
+            if (!committed)
+            {
+                break;
+            }
+
+            if (mapChanged)
+            {
+                mapText.swap(newMapText);
+            }
+
+            if (infoChanged)
+            {
+                infoText.swap(newInfoText);
+            }
+
+            ++applied;
+        }
+
+        return applied;
+    }
+}
+
+AutosaveJournal::AutosaveJournal() :
+    _writeInfoFile(false),
+    _baseSize(0),
+    _journalSize(0),
+    _checkpointCount(0),
+    _valid(false)
+{}
+
+void AutosaveJournal::reset()
+{
+    _valid = false;
+
+    _mapChunks = ChunkedText();
+    _infoChunks = ChunkedText();
+}
+
+void AutosaveJournal::checkpoint(const fs::path& mapFile, const fs::path& infoFile, bool writeInfoFile,
+    const std::string& mapText, const std::string& infoText, bool useJournal,
+    const std::vector<std::string>& operations, const ProgressCallback& progress)
+{
+    auto journalFile = GetJournalPath(mapFile);
+
+    std::string strippedMapText;
+    std::string strippedInfoText;
+
+    // The numbers of the entities and primitives need to be restored on replay
+    if (useJournal && (!stripNumberComments(mapText, strippedMapText) ||
+        (writeInfoFile && !stripNumberComments(infoText, strippedInfoText))))
+    {
+        rWarning() << "The map format is not suitable for the autosave journal, writing a full copy" << std::endl;
+        useJournal = false;
+    }
+
+    auto needsFullCopy = !useJournal || !_valid ||
+        mapFile != _mapFile || infoFile != _infoFile || writeInfoFile != _writeInfoFile ||
+        _checkpointCount >= MAX_CHECKPOINTS ||
+        _journalSize > _baseSize / MAX_JOURNAL_SIZE_DIVISOR ||
+        !fs::exists(journalFile);
+
+    // Only valid again if everything went fine
+    _valid = false;
+
+    if (!needsFullCopy)
+    {
+        if (appendCheckpoint(journalFile, strippedMapText, strippedInfoText, operations))
+        {
+            rMessage() << "Autosave journal checkpoint " << _checkpointCount << " written to " <<
+                journalFile.string() << std::endl;
+        }
+
+        _valid = true;
+        return;
+    }
+
+    WriteFiles(mapFile, infoFile, writeInfoFile, mapText, infoText, progress);
+
+    if (!useJournal)
+    {
+        // A journal left behind is not matching the new files anymore
+        if (fs::exists(journalFile))
+        {
+            fs::remove(journalFile);
+        }
+
+        return;
+    }
+
+    startJournal(journalFile, mapText, infoText, writeInfoFile);
+
+    _mapFile = mapFile;
+    _infoFile = infoFile;
+    _writeInfoFile = writeInfoFile;
+
+    _mapChunks = SplitIntoChunks(std::move(strippedMapText));
+    _infoChunks = SplitIntoChunks(std::move(strippedInfoText));
+
+    _baseSize = mapText.size();
+    _checkpointCount = 0;
+
+    _valid = true;
+}
+
+fs::path AutosaveJournal::GetJournalPath(const fs::path& mapFile)
+{
+    return fs::path(mapFile).replace_extension(JOURNAL_EXTENSION);
+}
+
+bool AutosaveJournal::Replay(const fs::path& mapFile, const fs::path& infoFile)
+{
+    auto journalFile = GetJournalPath(mapFile);
+
+    if (!fs::exists(journalFile))
+    {
+        return false;
+    }
+
+    auto journal = loadBinaryFile(journalFile);
+    auto mapText = fs::exists(mapFile) ? loadTextFile(mapFile) : std::string();
+
+    JournalReader reader(journal);
+    std::string_view header;
+    std::string_view baseMap;
+    std::string_view baseInfo;
+
+    // The journal is only applicable to the files it has been started with
+    bool isMatching = reader.readLine(header) && header == JOURNAL_HEADER &&
+        reader.readLine(baseMap) && reader.readLine(baseInfo) &&
+        baseMap == "basemap " + getContentHash(mapText);
+
+    auto hasInfo = isMatching && baseInfo != "baseinfo -";
+    auto infoText = hasInfo && fs::exists(infoFile) ? loadTextFile(infoFile) : std::string();
+
+    if (hasInfo && baseInfo != "baseinfo " + getContentHash(infoText))
+    {
+        isMatching = false;
+    }
+
+    std::string strippedMapText;
+    std::string strippedInfoText;
+
+    if (!isMatching || !stripNumberComments(mapText, strippedMapText) ||
+        (hasInfo && !stripNumberComments(infoText, strippedInfoText)))
+    {
+        rWarning() << "The autosave journal " << journalFile.string() <<
+            " doesn't match the file " << mapFile.string() << ", discarding it" << std::endl;
+
+        fs::remove(journalFile);
+        return false;
+    }
+
+    auto applied = applyCheckpoints(reader, strippedMapText, strippedInfoText, hasInfo);
+
+    if (applied > 0)
+    {
+        WriteFiles(mapFile, infoFile, hasInfo, restoreNumberComments(strippedMapText),
+            restoreNumberComments(strippedInfoText), ProgressCallback());
+
+        rMessage() << "Restored " << mapFile.string() << " from " << applied <<
+            " autosave journal checkpoints" << std::endl;
+    }
+
+    // The files are up to date now
+    fs::remove(journalFile);
+
+    return applied > 0;
+}
+
+void AutosaveJournal::WriteFiles(const fs::path& mapFile, const fs::path& infoFile, bool writeInfoFile,
+    const std::string& mapText, const std::string& infoText, const ProgressCallback& progress)
+{
+    std::size_t totalSize = mapText.size() + (writeInfoFile ? infoText.size() : 0);
+    std::size_t bytesWritten = 0;
+
+    auto writeText = [&](std::ostream& stream, const std::string& text, const fs::path& path)
+    {
+        for (std::size_t offset = 0; offset < text.size(); offset += WRITE_CHUNK_SIZE)
+        {
+            auto length = std::min(WRITE_CHUNK_SIZE, text.size() - offset);
+            stream.write(text.data() + offset, static_cast<std::streamsize>(length));
+
+            bytesWritten += length;
+
+            // 1.0 is reserved for the point where all files are in place
+            if (progress && bytesWritten < totalSize)
+            {
+                progress(static_cast<float>(bytesWritten) / totalSize);
+            }
+        }
+
+        stream.flush();
+
+        if (stream.fail())
+        {
+            throw std::runtime_error(fmt::format(_("Failure writing to file {0}"), path.string()));
+        }
+    };
+
+    // Write temporary files first, to not leave a half-written file behind on failure
+    stream::TemporaryOutputStream mapOutput(mapFile);
+    writeText(mapOutput.getStream(), mapText, mapFile);
+
+    if (writeInfoFile)
+    {
+        stream::TemporaryOutputStream infoOutput(infoFile);
+        writeText(infoOutput.getStream(), infoText, infoFile);
+
+        mapOutput.closeAndReplaceTargetFile();
+        infoOutput.closeAndReplaceTargetFile();
+    }
+    else
+    {
+        mapOutput.closeAndReplaceTargetFile();
+    }
+}
+
+void AutosaveJournal::startJournal(const fs::path& journalFile, const std::string& mapText,
+    const std::string& infoText, bool writeInfoFile)
+{
+    std::ostringstream header;
+
+    header << JOURNAL_HEADER << "\n";
+    header << "basemap " << getContentHash(mapText) << "\n";
+    header << "baseinfo " << (writeInfoFile ? getContentHash(infoText) : "-") << "\n";
+
+    auto text = header.str();
+
+    std::ofstream stream(journalFile, std::ios::binary | std::ios::trunc);
+    stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+    stream.flush();
+
+    if (stream.fail())
+    {
+        throw std::runtime_error(fmt::format(_("Failure writing to file {0}"), journalFile.string()));
+    }
+
+    _journalSize = text.size();
+}
+
+bool AutosaveJournal::appendCheckpoint(const fs::path& journalFile, const std::string& mapText,
+    const std::string& infoText, const std::vector<std::string>& operations)
+{
+    auto mapChunks = SplitIntoChunks(mapText);
+    auto infoChunks = SplitIntoChunks(infoText);
+
+    std::ostringstream record;
+    record << "checkpoint " << (_checkpointCount + 1) << "\n";
+
+    for (const auto& name : operations)
+    {
+        record << "operation " << name.size() << "\n" << name << "\n";
+    }
+
+    auto mapChanged = WriteDifference(record, "map", _mapChunks, mapChunks);
+    auto infoChanged = _writeInfoFile && WriteDifference(record, "info", _infoChunks, infoChunks);
+
+    if (!mapChanged && !infoChanged)
+    {
+        return false;
+    }
+
+    record << "commit\n";
+
+    auto text = record.str();
+
+    std::ofstream stream(journalFile, std::ios::binary | std::ios::app);
+    stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+    stream.flush();
+
+    if (stream.fail())
+    {
+        throw std::runtime_error(fmt::format(_("Failure writing to file {0}"), journalFile.string()));
+    }
+
+    _mapChunks = std::move(mapChunks);
+    _infoChunks = std::move(infoChunks);
+
+    _journalSize += text.size();
+    ++_checkpointCount;
+
+    return true;
+}
+
+AutosaveJournal::ChunkedText AutosaveJournal::SplitIntoChunks(std::string text)
+{
+    ChunkedText result;
+    result.chunks.reserve(text.size() / 2048 + 1);
+
+    auto addChunk = [&](std::size_t offset, std::size_t length)
+    {
+        auto hash = std::hash<std::string_view>()(std::string_view(text.data() + offset, length));
+
+        result.chunkIndex.emplace(hash, result.chunks.size());
+        result.chunks.push_back(Chunk{ offset, length, hash });
+    };
+
+    // Gear hash, depending on the last 64 bytes only, so the boundaries
+    // are in sync again shortly after a modified region
+    std::uint64_t rollingHash = 0;
+    std::size_t start = 0;
+
+    for (std::size_t i = 0; i < text.size(); ++i)
+    {
+        rollingHash = (rollingHash << 1) + GEAR_TABLE[static_cast<unsigned char>(text[i])];
+
+        auto length = i + 1 - start;
+
+        if ((length >= MIN_CHUNK_SIZE && (rollingHash & CHUNK_BOUNDARY_MASK) == 0) || length >= MAX_CHUNK_SIZE)
+        {
+            addChunk(start, length);
+            start = i + 1;
+        }
+    }
+
+    if (start < text.size())
+    {
+        addChunk(start, text.size() - start);
+    }
+
+    result.text = std::move(text);
+
+    return result;
+}
+
+bool AutosaveJournal::WriteDifference(std::ostream& stream, const char* section,
+    const ChunkedText& previous, const ChunkedText& current)
+{
+    struct Edit
+    {
+        bool copy; // copy from the previous text, or insert from the current one
+        std::size_t offset;
+        std::size_t length;
+    };
+
+    std::vector<Edit> edits;
+
+    // Chunks with equal hashes are compared byte by byte, a hash collision
+    // must not result in a copy of the wrong text
+    auto chunksAreEqual = [&](const Chunk& a, const Chunk& b)
+    {
+        return a.hash == b.hash && a.length == b.length &&
+            std::memcmp(previous.text.data() + a.offset, current.text.data() + b.offset, a.length) == 0;
+    };
+
+    const auto noChunk = previous.chunks.size();
+    auto nextChunk = noChunk;
+
+    for (const auto& chunk : current.chunks)
+    {
+        auto match = noChunk;
+
+        // Prefer extending the current copy range, look up the chunk otherwise
+        if (nextChunk != noChunk && chunksAreEqual(previous.chunks[nextChunk], chunk))
+        {
+            match = nextChunk;
+        }
+        else
+        {
+            auto candidates = previous.chunkIndex.equal_range(chunk.hash);
+
+            for (auto i = candidates.first; i != candidates.second; ++i)
+            {
+                if (chunksAreEqual(previous.chunks[i->second], chunk))
+                {
+                    match = i->second;
+                    break;
+                }
+            }
+        }
+
+        if (match != noChunk)
+        {
+            const auto& source = previous.chunks[match];
+
+            if (!edits.empty() && edits.back().copy && edits.back().offset + edits.back().length == source.offset)
+            {
+                edits.back().length += source.length;
+            }
+            else
+            {
+                edits.push_back(Edit{ true, source.offset, source.length });
+            }
+
+            nextChunk = match + 1 < noChunk ? match + 1 : noChunk;
+        }
+        else
+        {
+            // The current chunks are consecutive, the insertions can always be merged
+            if (!edits.empty() && !edits.back().copy)
+            {
+                edits.back().length += chunk.length;
+            }
+            else
+            {
+                edits.push_back(Edit{ false, chunk.offset, chunk.length });
+            }
+
+            nextChunk = noChunk;
+        }
+    }
+
+    // Nothing to write if the whole text is the same
+    if (current.text.size() == previous.text.size() &&
+        (edits.empty() || (edits.size() == 1 && edits.front().copy && edits.front().offset == 0)))
+    {
+        return false;
+    }
+
+    stream << section << "\n";
+
+    for (const auto& edit : edits)
+    {
+        if (edit.copy)
+        {
+            stream << "copy " << edit.offset << " " << edit.length << "\n";
+        }
+        else
+        {
+            stream << "insert " << edit.length << "\n";
+            stream.write(current.text.data() + edit.offset, static_cast<std::streamsize>(edit.length));
+            stream << "\n";
+        }
+    }
+
+    stream << "end\n";
+
+    return true;
+}
+
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "os/fs.h"
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace map
+{
+
+/**
+ * Append-only change journal written by the AutoMapSaver, to avoid
+ * rewriting the whole map file on every automatic save.
+ *
+ * The first checkpoint writes a full copy of the map and info file (the base),
+ * every following checkpoint appends the differences to the previous checkpoint
+ * to the journal file next to the map: the byte ranges which can be copied over
+ * from the previous version and the text of the regions that have changed.
+ * These regions are found by splitting the text into content-defined chunks,
+ * such that an edit only affects the chunks of the touched nodes. The entity
+ * and primitive number comments written by the map writers are stripped before
+ * comparing the text and re-generated on replay, otherwise removing a node
+ * would alter the text of everything following it.
+ *
+ * After a certain number of checkpoints, or when the journal grows too large,
+ * it is compacted into a new full copy.
+ *
+ * Replay() merges the last complete checkpoint of a journal into its base files.
+ */
+class AutosaveJournal
+{
+public:
+    using ProgressCallback = std::function<void(float)>;
+
+private:
+    // A content-defined chunk of the text written by the previous checkpoint
+    struct Chunk
+    {
+        std::size_t offset;
+        std::size_t length;
+        std::size_t hash;
+    };
+
+    // A (number-stripped) text and its chunks, with a lookup table hash => chunk index.
+    // The text is kept to verify chunks with matching hashes byte by byte.
+    struct ChunkedText
+    {
+        std::string text;
+        std::vector<Chunk> chunks;
+        std::unordered_multimap<std::size_t, std::size_t> chunkIndex;
+    };
+
+    fs::path _mapFile;
+    fs::path _infoFile;
+    bool _writeInfoFile;
+
+    ChunkedText _mapChunks;
+    ChunkedText _infoChunks;
+
+    std::size_t _baseSize;
+    std::size_t _journalSize;
+    std::size_t _checkpointCount;
+
+    // False if the next checkpoint has to write a full copy
+    bool _valid;
+
+public:
+    AutosaveJournal();
+
+    // Discards the recorded state, the next checkpoint will write a full copy
+    void reset();
+
+    /**
+     * Writes the given map and info file contents, either as full copy to the given
+     * paths or as checkpoint appended to the journal belonging to the map file.
+     * Only full copies are written if useJournal is false, removing any journal
+     * left behind. The names of the undo operations leading to this checkpoint
+     * are recorded in the journal, for informational purposes.
+     *
+     * This is called on a worker thread, one checkpoint at a time.
+     * Throws std::runtime_error on write failures.
+     */
+    void checkpoint(const fs::path& mapFile, const fs::path& infoFile, bool writeInfoFile,
+        const std::string& mapText, const std::string& infoText, bool useJournal,
+        const std::vector<std::string>& operations, const ProgressCallback& progress);
+
+    // Returns the path of the journal belonging to the given map file
+    static fs::path GetJournalPath(const fs::path& mapFile);
+
+    /**
+     * Applies the journal belonging to the given map file (if there is one)
+     * and writes the resulting map and info files. The journal is removed afterwards.
+     * Returns true if the files have been restored from the journal.
+     * Throws std::runtime_error on write failures.
+     */
+    static bool Replay(const fs::path& mapFile, const fs::path& infoFile);
+
+    /**
+     * Writes the given texts to temporary files first, replacing the target
+     * files once complete. Reports the progress while writing, except for the
+     * final 1.0 which is up to the caller.
+     * Throws std::runtime_error on failure.
+     */
+    static void WriteFiles(const fs::path& mapFile, const fs::path& infoFile, bool writeInfoFile,
+        const std::string& mapText, const std::string& infoText, const ProgressCallback& progress);
+
+private:
+    // Writes the header of a new journal belonging to the given base files
+    void startJournal(const fs::path& journalFile, const std::string& mapText,
+        const std::string& infoText, bool writeInfoFile);
+
+    // Appends the changes to the previous checkpoint (the texts are number-stripped),
+    // returns false if there were no changes to write
+    bool appendCheckpoint(const fs::path& journalFile, const std::string& mapText,
+        const std::string& infoText, const std::vector<std::string>& operations);
+
+    static ChunkedText SplitIntoChunks(std::string text);
+
+    // Writes the instructions to build the current text out of the previous one,
+    // returns false (writing nothing) if the text is unchanged
+    static bool WriteDifference(std::ostream& stream, const char* section,
+        const ChunkedText& previous, const ChunkedText& current);
+};
+
+}
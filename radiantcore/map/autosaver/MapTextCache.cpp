@@ -0,0 +1,409 @@
+#include "MapTextCache.h"
+
+#include "ibrush.h"
+#include "ipatch.h"
+#include "scene/EntityNode.h"
+
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+namespace map
+{
+
+namespace
+{
+	// The number comments written by the map writers in front of each entity and primitive
+	constexpr std::string_view ENTITY_COMMENTS[] = { "// entity " };
+	constexpr std::string_view PRIMITIVE_COMMENTS[] = { "// primitive ", "// brush " };
+
+	// Changes the number in the comment the text is starting with, returns false
+	// if the text doesn't start with one of the given comments and the old number
+	template<std::size_t NumComments>
+	bool renumber(std::string& text, std::size_t& textNumber, std::size_t number,
+		const std::string_view (&comments)[NumComments])
+	{
+		if (textNumber == number)
+		{
+			return true;
+		}
+
+		for (auto comment : comments)
+		{
+			auto oldLine = std::string(comment) + std::to_string(textNumber) + "\n";
+
+			if (text.compare(0, oldLine.size(), oldLine) == 0)
+			{
+				text.replace(0, oldLine.size(), std::string(comment) + std::to_string(number) + "\n");
+				textNumber = number;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void writeText(std::ostream& stream, const std::string& text)
+	{
+		stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+	}
+}
+
+/**
+ * IMapWriter adaptor writing the unchanged nodes from the cache. Changed nodes
+ * are written to their own buffer using writers acquired through createEntityWriter(),
+ * the buffer is stored in the cache and copied to the map stream.
+ */
+class MapTextCache::Writer :
+	public IMapWriter
+{
+private:
+	MapTextCache& _cache;
+
+	// The writer we're wrapping
+	IMapWriterPtr _writer;
+
+	// Holds the formatting settings of the map stream
+	std::ostringstream _streamFormat;
+
+	struct EntityState
+	{
+		// The writer used for this entity, empty if its text is taken from the cache
+		IMapWriterPtr writer;
+
+		// True if the text of the entity has changed, its primitives are written again
+		bool changed;
+	};
+
+	std::vector<EntityState> _entities;
+
+	// The numbers of the next entity and primitive, counted like the writers do
+	std::size_t _entityCount;
+	std::size_t _primitiveCount;
+
+	// The primitive currently written, if it is not taken from the cache
+	IMapWriterPtr _primitiveWriter;
+	std::ostringstream _primitiveOutput;
+	std::size_t _primitiveNumber;
+
+public:
+	Writer(MapTextCache& cache, const IMapWriterPtr& writer) :
+		_cache(cache),
+		_writer(writer),
+		_entityCount(0),
+		_primitiveCount(0),
+		_primitiveNumber(0)
+	{}
+
+	void beginWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream) override
+	{
+		// The buffers need the same precision and flags as the map stream
+		_streamFormat.copyfmt(stream);
+
+		_cache.beginExport();
+		_writer->beginWriteMap(root, stream);
+	}
+
+	void endWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream) override
+	{
+		_cache.finishExport();
+		_writer->endWriteMap(root, stream);
+	}
+
+	void beginWriteEntity(const EntityNodePtr& entity, std::ostream& stream) override
+	{
+		auto number = _entityCount++;
+		auto cached = _cache.find(entity);
+
+		if (cached && !_cache.hasChanged(entity.get()) &&
+			renumber(cached->text, cached->number, number, ENTITY_COMMENTS))
+		{
+			cached->visited = true;
+			writeText(stream, cached->text);
+
+			_entities.push_back(EntityState{ IMapWriterPtr(), false });
+			return;
+		}
+
+		_entities.push_back(EntityState{ _writer->createEntityWriter(number), true });
+
+		auto text = write(entity, stream, [&](std::ostream& output)
+		{
+			_entities.back().writer->beginWriteEntity(entity, output);
+		});
+
+		// The primitives can be taken from the cache if the entity text is the same as before
+		_entities.back().changed = !cached ||
+			!renumber(cached->text, cached->number, number, ENTITY_COMMENTS) || cached->text != text;
+
+		writeText(stream, _cache.store(entity, number, std::move(text)).text);
+	}
+
+	void endWriteEntity(const EntityNodePtr& entity, std::ostream& stream) override
+	{
+		if (_entities.empty())
+		{
+			return;
+		}
+
+		auto state = std::move(_entities.back());
+		_entities.pop_back();
+
+		// The writers are numbering the primitives of each entity from zero
+		_primitiveCount = 0;
+
+		auto cached = _cache.find(entity);
+
+		if (!state.writer)
+		{
+			writeText(stream, cached->endText);
+			return;
+		}
+
+		auto text = write(entity, stream, [&](std::ostream& output)
+		{
+			state.writer->endWriteEntity(entity, output);
+		});
+
+		if (cached)
+		{
+			cached->endText = text;
+		}
+
+		writeText(stream, text);
+	}
+
+	void beginWriteBrush(const IBrushNodePtr& brush, std::ostream& stream) override
+	{
+		beginWritePrimitive(std::dynamic_pointer_cast<scene::INode>(brush), stream,
+			[&](IMapWriter& writer, std::ostream& output) { writer.beginWriteBrush(brush, output); });
+	}
+
+	void endWriteBrush(const IBrushNodePtr& brush, std::ostream& stream) override
+	{
+		endWritePrimitive(std::dynamic_pointer_cast<scene::INode>(brush), stream,
+			[&](IMapWriter& writer, std::ostream& output) { writer.endWriteBrush(brush, output); });
+	}
+
+	void beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override
+	{
+		beginWritePrimitive(std::dynamic_pointer_cast<scene::INode>(patch), stream,
+			[&](IMapWriter& writer, std::ostream& output) { writer.beginWritePatch(patch, output); });
+	}
+
+	void endWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override
+	{
+		endWritePrimitive(std::dynamic_pointer_cast<scene::INode>(patch), stream,
+			[&](IMapWriter& writer, std::ostream& output) { writer.endWritePatch(patch, output); });
+	}
+
+private:
+	std::ostringstream createStream()
+	{
+		std::ostringstream stream;
+		stream.copyfmt(_streamFormat);
+		return stream;
+	}
+
+	// Writes the node using the given function, returning the text. On failure the
+	// partial text is written to the map stream and the node is removed from the cache.
+	template<typename WriteFunc>
+	std::string write(const scene::INodePtr& node, std::ostream& stream, const WriteFunc& writeFunc)
+	{
+		auto output = createStream();
+
+		try
+		{
+			writeFunc(output);
+		}
+		catch (IMapWriter::FailureException&)
+		{
+			_cache.forget(node.get());
+			writeText(stream, output.str());
+			throw;
+		}
+
+		return output.str();
+	}
+
+	template<typename WriteFunc>
+	void beginWritePrimitive(const scene::INodePtr& node, std::ostream& stream, const WriteFunc& writeFunc)
+	{
+		auto number = _primitiveCount++;
+		auto entityChanged = !_entities.empty() && _entities.back().changed;
+		auto cached = _cache.find(node);
+
+		// Brushes and patches are written completely in the begin call, the end call is skipped
+		if (cached && !entityChanged && !_cache.hasChanged(node.get()) &&
+			renumber(cached->text, cached->number, number, PRIMITIVE_COMMENTS))
+		{
+			cached->visited = true;
+			writeText(stream, cached->text);
+			return;
+		}
+
+		// A fresh writer starts numbering at zero, the comment is changed afterwards
+		_primitiveWriter = _writer->createEntityWriter(_entityCount);
+		_primitiveOutput = createStream();
+		_primitiveNumber = number;
+
+		try
+		{
+			writeFunc(*_primitiveWriter, _primitiveOutput);
+		}
+		catch (IMapWriter::FailureException&)
+		{
+			_primitiveWriter.reset();
+			_cache.forget(node.get());
+			writeText(stream, _primitiveOutput.str());
+			throw;
+		}
+	}
+
+	template<typename WriteFunc>
+	void endWritePrimitive(const scene::INodePtr& node, std::ostream& stream, const WriteFunc& writeFunc)
+	{
+		if (!_primitiveWriter)
+		{
+			return;
+		}
+
+		auto writer = std::move(_primitiveWriter);
+
+		auto text = write(node, stream, [&](std::ostream& output)
+		{
+			output << _primitiveOutput.str();
+			writeFunc(*writer, output);
+		});
+
+		auto& cached = _cache.store(node, 0, std::move(text));
+		renumber(cached.text, cached.number, _primitiveNumber, PRIMITIVE_COMMENTS);
+
+		writeText(stream, cached.text);
+	}
+};
+
+MapTextCache::MapTextCache()
+{}
+
+MapTextCache::~MapTextCache()
+{
+	disconnectUndoSystem();
+}
+
+void MapTextCache::connectUndoSystem(IUndoSystem& undoSystem)
+{
+	disconnectUndoSystem();
+
+	_nodeChangedConnection = undoSystem.signal_nodeChanged().connect(
+		sigc::mem_fun(*this, &MapTextCache::onNodeChanged)
+	);
+}
+
+void MapTextCache::disconnectUndoSystem()
+{
+	_nodeChangedConnection.disconnect();
+	clear();
+}
+
+void MapTextCache::clear()
+{
+	_nodes.clear();
+	_changedNodes.clear();
+}
+
+IMapWriterPtr MapTextCache::createWriter(const MapFormat& format)
+{
+	auto writer = format.getMapWriter();
+
+	if (!writer->createEntityWriter(0))
+	{
+		clear();
+		return writer;
+	}
+
+	if (format.getMapFormatName() != _formatName)
+	{
+		clear();
+		_formatName = format.getMapFormatName();
+	}
+
+	return std::make_shared<Writer>(*this, writer);
+}
+
+void MapTextCache::onNodeChanged(scene::INode* node)
+{
+	if (node == nullptr)
+	{
+		// No idea what has been changed, write everything again
+		clear();
+		return;
+	}
+
+	_changedNodes.insert(node);
+}
+
+MapTextCache::CachedNode* MapTextCache::find(const scene::INodePtr& node)
+{
+	auto found = _nodes.find(node.get());
+
+	if (found == _nodes.end() || found->second.node.lock() != node)
+	{
+		return nullptr;
+	}
+
+	return &found->second;
+}
+
+bool MapTextCache::hasChanged(const scene::INode* node) const
+{
+	return _changedNodes.count(node) > 0;
+}
+
+MapTextCache::CachedNode& MapTextCache::store(const scene::INodePtr& node, std::size_t number, std::string text)
+{
+	auto& cached = _nodes[node.get()];
+
+	cached.node = node;
+	cached.number = number;
+	cached.text = std::move(text);
+	cached.endText.clear();
+	cached.visited = true;
+
+	_changedNodes.erase(node.get());
+
+	return cached;
+}
+
+void MapTextCache::forget(const scene::INode* node)
+{
+	_nodes.erase(node);
+}
+
+void MapTextCache::beginExport()
+{
+	for (auto& [_, cached] : _nodes)
+	{
+		cached.visited = false;
+	}
+}
+
+void MapTextCache::finishExport()
+{
+	for (auto i = _nodes.begin(); i != _nodes.end();)
+	{
+		if (i->second.visited)
+		{
+			++i;
+		}
+		else
+		{
+			i = _nodes.erase(i);
+		}
+	}
+
+	// The changes of nodes that are no longer part of the map don't matter anymore
+	_changedNodes.clear();
+}
+
+} // namespace
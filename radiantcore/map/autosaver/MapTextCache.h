@@ -0,0 +1,106 @@
+#pragma once
+
+#include "imapformat.h"
+#include "iundo.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <sigc++/connection.h>
+
+namespace map
+{
+
+/**
+ * Keeps the map text written for each entity and primitive of the scene,
+ * such that the AutoMapSaver only needs to serialise the nodes which have
+ * been changed since its previous save.
+ *
+ * The changed nodes are collected through the undo system: every undoable
+ * submitting its state to an operation (including undo and redo) reports the
+ * node it belongs to. If a change can't be attributed to a node, everything
+ * is written again. Changes made outside of undo operations are not tracked,
+ * like the autosaver itself is only triggered by the undo change tracker.
+ *
+ * The texts are recorded by the writer returned from createWriter(), which
+ * produces the same output as the wrapped writer, taking the unchanged nodes
+ * from the cache. Their entity and primitive number comments are updated when
+ * a node has moved to a different position in the map. The primitives of an
+ * entity are written again if the entity's own text has changed, since child
+ * primitives are exported relative to the entity origin.
+ *
+ * Only writers supporting IMapWriter::createEntityWriter() are able to write
+ * single nodes, other formats are always written in full.
+ */
+class MapTextCache
+{
+private:
+	class Writer;
+
+	struct CachedNode
+	{
+		// To recognise a different node allocated at the same address
+		std::weak_ptr<scene::INode> node;
+
+		// The entity or primitive number the text has been written with
+		std::size_t number = 0;
+
+		// The text written for the node, and the closing text of entities
+		std::string text;
+		std::string endText;
+
+		// Set when the node is encountered during an export
+		bool visited = false;
+	};
+
+	std::unordered_map<const scene::INode*, CachedNode> _nodes;
+
+	// The nodes reported by the undo system since the last export
+	std::unordered_set<const scene::INode*> _changedNodes;
+
+	// The format the cached texts have been written in
+	std::string _formatName;
+
+	sigc::connection _nodeChangedConnection;
+
+public:
+	MapTextCache();
+	~MapTextCache();
+
+	// Starts tracking the changes recorded by the given undo system, clearing the cache
+	void connectUndoSystem(IUndoSystem& undoSystem);
+	void disconnectUndoSystem();
+
+	// Discards all texts, the next export writes every node
+	void clear();
+
+	/**
+	 * Returns a writer wrapping the one of the given format, to be passed to
+	 * the MapExporter. The cache is updated when the export is complete, the
+	 * returned writer must not be used after that. Returns the format's own
+	 * writer if it doesn't support writing single nodes.
+	 */
+	IMapWriterPtr createWriter(const MapFormat& format);
+
+private:
+	void onNodeChanged(scene::INode* node);
+
+	// Returns the cache entry of the given node, or nullptr if there is none
+	CachedNode* find(const scene::INodePtr& node);
+
+	bool hasChanged(const scene::INode* node) const;
+
+	// Stores the text written for the given node, marking it as unchanged
+	CachedNode& store(const scene::INodePtr& node, std::size_t number, std::string text);
+
+	// Removes the node from the cache, to write it again next time
+	void forget(const scene::INode* node);
+
+	void beginExport();
+
+	// Drops the nodes that are no longer part of the map
+	void finishExport();
+};
+
+} // namespace
@@ -2,6 +2,7 @@
 #include "parser/DefTokeniser.h"
 #include "Doom3MapReader.h"
 #include "Doom3MapWriter.h"
+#include "ithreadpool.h"
 
 #include "module/StaticModule.h"
 
@@ -21,6 +22,7 @@ StringSet Doom3MapFormat::getDependencies() const
     if (_dependencies.empty())
     {
         _dependencies.insert(MODULE_MAPFORMATMANAGER);
+        _dependencies.insert(MODULE_THREADPOOL);
     }
 
     return _dependencies;
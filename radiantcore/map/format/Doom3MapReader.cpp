@@ -3,13 +3,21 @@
 #include "itextstream.h"
 #include "ieclass.h"
 #include "igame.h"
+#include "ithreadpool.h"
 #include "scene/EntityNode.h"
 #include "string/string.h"
+#include "registry/registry.h"
+#include "stream/TextFileContents.h"
+#include "messages/TextureChanged.h"
 
 #include "Doom3MapFormat.h"
+#include "EntityChunkSplitter.h"
 
 #include "i18n.h"
 #include <fmt/format.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 #include "primitiveparsers/BrushDef.h"
 #include "primitiveparsers/BrushDef3.h"
@@ -24,20 +32,73 @@ Doom3MapReader::Doom3MapReader(IMapImportFilter& importFilter) :
 	_primitiveCount(0)
 {}
 
+namespace
+{
+	// Kept delimiters used for map files, same as the std::istream tokeniser default
+	constexpr const char* const MAP_KEPT_DELIMS = "{}(),";
+
+	std::size_t getNumLoaderThreads()
+	{
+		return GlobalThreadPool().getNumWorkers();
+	}
+}
+
+struct Doom3MapReader::ParsedEntityChunk
+{
+	// The key values encountered before the first primitive
+	EntityKeyValues keyValues;
+
+	// The primitive nodes, in file order
+	std::vector<scene::INodePtr> primitives;
+
+	// Set to true if this block couldn't be parsed on the worker
+	bool failed = false;
+
+	// Set by the worker once it's done with this block (guarded by the reader's mutex)
+	bool done = false;
+};
+
 void Doom3MapReader::readFromStream(std::istream& stream)
 {
 	// Call the virtual method to initialise the primitve parser map (if not done yet)
 	initPrimitiveParsers();
 
-	// The tokeniser used to split the stream into pieces
-	parser::BasicDefTokeniser<std::istream> tok(stream);
+	auto startPosition = stream.tellg();
+
+	// Tokenise the map text in memory, this is much faster than streaming it
+	stream::TextFileContents contents(stream);
+
+	if (registry::getValue<bool>(RKEY_MAP_PARALLEL_LOADING) && getNumLoaderThreads() > 1 &&
+		primitiveParsersCanRunOnWorkers())
+	{
+		readInParallel(contents.get(), stream, startPosition);
+		return;
+	}
+
+	// The tokeniser used to split the text into pieces
+	parser::BasicDefTokeniser<std::string_view> tok(contents.get(), parser::WHITESPACE, MAP_KEPT_DELIMS);
 
 	// Try to parse the map version (throws on failure)
 	parseMapVersion(tok);
 
+	parseEntities(tok, stream, startPosition);
+}
+
+void Doom3MapReader::parseEntities(parser::BasicDefTokeniser<std::string_view>& tok,
+	std::istream& stream, std::istream::pos_type textStart)
+{
+	// The import filter is reporting the progress using the stream position
+	bool streamIsSeekable = textStart != std::istream::pos_type(-1);
+
 	// Read each entity in the map, until EOF is reached
 	while (tok.hasMoreTokens())
 	{
+		if (streamIsSeekable)
+		{
+			stream.clear();
+			stream.seekg(textStart + static_cast<std::streamoff>(tok.getPosition()));
+		}
+
 		// Create an entity node by parsing from the stream. If there is an
 		// exception, display it and return
 		try
@@ -58,6 +119,181 @@ void Doom3MapReader::readFromStream(std::istream& stream)
 	// EOF reached, success
 }
 
+bool Doom3MapReader::primitiveParsersCanRunOnWorkers() const
+{
+	for (const auto& [keyword, parser] : _primitiveParsers)
+	{
+		if (!parser->canParseOnWorkerThread())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool Doom3MapReader::headerContainsVersionOnly(std::string_view header)
+{
+	parser::BasicDefTokeniser<std::string_view> tok(header, parser::WHITESPACE, MAP_KEPT_DELIMS);
+
+	// Try to parse the map version (throws on failure)
+	parseMapVersion(tok);
+
+	return !tok.hasMoreTokens();
+}
+
+void Doom3MapReader::readInParallel(std::string_view text, std::istream& stream, std::istream::pos_type textStart)
+{
+	EntityChunkSplitter splitter(text);
+
+	if (!splitter.split() || !headerContainsVersionOnly(text.substr(0, splitter.getHeaderLength())))
+	{
+		// Irregular file structure, let the regular parser deal with it (and report the errors)
+		rWarning() << "[mapdoom3] Cannot split map into entity blocks, parsing it in one piece." << std::endl;
+
+		parser::BasicDefTokeniser<std::string_view> tok(text, parser::WHITESPACE, MAP_KEPT_DELIMS);
+		parseMapVersion(tok);
+		parseEntities(tok, stream, textStart);
+		return;
+	}
+
+	const auto& chunks = splitter.getChunks();
+
+	std::vector<ParsedEntityChunk> results(chunks.size());
+
+	std::mutex resultLock;
+	std::condition_variable resultReady;
+	std::atomic<std::size_t> nextChunk(0);
+	std::atomic<bool> cancelled(false);
+
+	// Claims and parses the next chunk, returns false if there's nothing left to do
+	auto processNextChunk = [&]()
+	{
+		if (cancelled) return false;
+
+		auto index = nextChunk++;
+
+		if (index >= chunks.size()) return false;
+
+		auto& result = results[index];
+
+		// The nodes are constructed outside the scene, the notifications
+		// are sent once from the main thread after parsing
+		scene::ScopedSceneNotificationSuppressor suppressor;
+
+		try
+		{
+			parser::BasicDefTokeniser<std::string_view> tok(text.substr(chunks[index].offset, chunks[index].length),
+				parser::WHITESPACE, MAP_KEPT_DELIMS);
+
+			parseEntityChunk(tok, result);
+
+			// The block must have been consumed completely
+			result.failed = tok.hasMoreTokens();
+		}
+		catch (const std::exception&)
+		{
+			result.failed = true;
+		}
+
+		std::lock_guard<std::mutex> lock(resultLock);
+		result.done = true;
+		resultReady.notify_all();
+
+		return true;
+	};
+
+	std::vector<threading::ITaskPtr> workers;
+
+	// Cancels and joins the workers when leaving this scope, also in case of an exception
+	struct WorkerGuard
+	{
+		std::atomic<bool>& cancelled;
+		std::vector<threading::ITaskPtr>& workers;
+
+		~WorkerGuard()
+		{
+			cancelled = true;
+
+			for (const auto& worker : workers)
+			{
+				worker->cancel();
+				worker->wait();
+			}
+		}
+	} guard{ cancelled, workers };
+
+	auto numThreads = std::min(getNumLoaderThreads(), chunks.size());
+
+	for (std::size_t i = 0; i < numThreads; ++i)
+	{
+		workers.emplace_back(GlobalThreadPool().schedule([&]()
+		{
+			while (processNextChunk()) {}
+		}));
+	}
+
+	// The import filter is reporting the progress using the stream position
+	bool streamIsSeekable = textStart != std::istream::pos_type(-1);
+
+	for (std::size_t i = 0; i < chunks.size(); ++i)
+	{
+		// Help out with parsing while the chunk has not been picked up by any worker,
+		// the pool might be busy with other tasks
+		while (nextChunk <= i && processNextChunk()) {}
+
+		{
+			std::unique_lock<std::mutex> lock(resultLock);
+			resultReady.wait(lock, [&]() { return results[i].done; });
+		}
+
+		auto& result = results[i];
+
+		if (result.failed)
+		{
+			// Continue with the regular parser from this entity on,
+			// it produces the same nodes and error messages as a serial load would
+			cancelled = true;
+			notifyParsedPrimitives();
+
+			parser::BasicDefTokeniser<std::string_view> tok(text.substr(chunks[i].offset),
+				parser::WHITESPACE, MAP_KEPT_DELIMS);
+			parseEntities(tok, stream, streamIsSeekable ?
+				textStart + static_cast<std::streamoff>(chunks[i].offset) : textStart);
+			return;
+		}
+
+		if (streamIsSeekable)
+		{
+			stream.clear();
+			stream.seekg(textStart + static_cast<std::streamoff>(chunks[i].offset + chunks[i].length));
+		}
+
+		try
+		{
+			insertParsedEntity(result);
+		}
+		catch (FailureException& e)
+		{
+			std::string text = fmt::format(_("Failed parsing entity {0:d}:\n{1}"), _entityCount, e.what());
+
+			// Re-throw with more text
+			throw FailureException(text);
+		}
+
+		_entityCount++;
+	}
+
+	notifyParsedPrimitives();
+}
+
+void Doom3MapReader::notifyParsedPrimitives()
+{
+	// Send the notifications suppressed while constructing the primitives
+	SceneChangeNotify();
+	radiant::TextureChangedMessage::Send();
+}
+
 void Doom3MapReader::initPrimitiveParsers()
 {
 	if (_primitiveParsers.empty())
@@ -121,14 +357,14 @@ void Doom3MapReader::parsePrimitive(parser::DefTokeniser& tok, const scene::INod
 {
     _primitiveCount++;
 
-	std::string primitiveKeyword = tok.nextToken();
+	auto primitiveKeyword = tok.nextTokenView();
 
 	// Get a parser for this keyword
 	PrimitiveParsers::const_iterator p = _primitiveParsers.find(primitiveKeyword);
 
 	if (p == _primitiveParsers.end())
 	{
-		throw FailureException("Unknown primitive type: " + primitiveKeyword);
+		throw FailureException("Unknown primitive type: " + std::string(primitiveKeyword));
 	}
 
 	const PrimitiveParserPtr& parser = p->second;
@@ -257,4 +493,65 @@ void Doom3MapReader::parseEntity(parser::DefTokeniser& tok)
 	_importFilter.addEntity(entity);
 }
 
+void Doom3MapReader::parseEntityChunk(parser::DefTokeniser& tok, ParsedEntityChunk& chunk) const
+{
+	tok.assertNextToken("{");
+
+	for (std::string token = tok.nextToken(); token != "}"; token = tok.nextToken())
+	{
+		if (token == "{") // PRIMITIVE
+		{
+			auto p = _primitiveParsers.find(tok.nextTokenView());
+
+			if (p == _primitiveParsers.end())
+			{
+				throw FailureException("Unknown primitive type");
+			}
+
+			auto primitive = p->second->parse(tok);
+
+			if (!primitive)
+			{
+				throw FailureException("Primitive parse error");
+			}
+
+			chunk.primitives.push_back(primitive);
+		}
+		else // KEY
+		{
+			std::string value = tok.nextToken();
+
+			if (value == "{" || value == "}")
+			{
+				throw FailureException("Invalid key value");
+			}
+
+			// The serial parser creates the entity when the first primitive shows up,
+			// any key values after that point are not applied
+			if (chunk.primitives.empty())
+			{
+				chunk.keyValues.insert(EntityKeyValues::value_type(token, value));
+			}
+		}
+	}
+}
+
+void Doom3MapReader::insertParsedEntity(ParsedEntityChunk& chunk)
+{
+	auto entity = createEntity(chunk.keyValues);
+
+	_primitiveCount = 0;
+
+	for (const auto& primitive : chunk.primitives)
+	{
+		_primitiveCount++;
+		_importFilter.addPrimitiveToEntity(primitive, entity);
+	}
+
+	// The scene is holding the references now
+	chunk.primitives.clear();
+
+	_importFilter.addEntity(entity);
+}
+
 } // namespace map
@@ -24,9 +24,12 @@ protected:
 	std::size_t _primitiveCount;
 
 	// Our list of primitive parsers
-	typedef std::map<std::string, PrimitiveParserPtr> PrimitiveParsers;
+	typedef std::map<std::string, PrimitiveParserPtr, std::less<>> PrimitiveParsers;
 	PrimitiveParsers _primitiveParsers;
 
+	// The result of parsing a single entity block on a worker thread
+	struct ParsedEntityChunk;
+
 public:
 	Doom3MapReader(IMapImportFilter& importFilter);
 
@@ -34,6 +37,36 @@ public:
 	virtual void readFromStream(std::istream& stream);
 
 protected:
+	// Parses all entities until the tokeniser is exhausted, throws on failure.
+	// Before each entity the stream is positioned at the corresponding offset
+	// (relative to textStart), the import filter uses it to report the progress.
+	void parseEntities(parser::BasicDefTokeniser<std::string_view>& tok,
+		std::istream& stream, std::istream::pos_type textStart);
+
+	// Splits the map text at the entity boundaries and parses the entity blocks
+	// on several worker threads. The nodes are sent to the import filter in
+	// file order, on the calling thread.
+	void readInParallel(std::string_view text, std::istream& stream, std::istream::pos_type textStart);
+
+	// Returns true if all registered primitive parsers can be used on worker threads
+	bool primitiveParsersCanRunOnWorkers() const;
+
+	// Sends the scene and texture change notifications which have been suppressed
+	// while the primitives were parsed on the worker threads
+	void notifyParsedPrimitives();
+
+	// Parses the version tag in the given map header (throws on failure),
+	// returns false if there are any other tokens following it
+	bool headerContainsVersionOnly(std::string_view header);
+
+	// Parses the key values and primitives of a single entity block without
+	// creating the entity itself. This is called from worker threads,
+	// so it must not touch the import filter or any member state.
+	void parseEntityChunk(parser::DefTokeniser& tok, ParsedEntityChunk& chunk) const;
+
+	// Creates the entity of a pre-parsed chunk and sends it to the import filter
+	void insertParsedEntity(ParsedEntityChunk& chunk);
+
 	// Set up our set of primitive parsers
 	virtual void initPrimitiveParsers();
 
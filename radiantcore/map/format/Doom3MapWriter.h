@@ -37,8 +37,23 @@ public:
 	virtual void beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override;
 	virtual void endWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override;
 
+	virtual IMapWriterPtr createEntityWriter(std::size_t entityNumber) override;
+
 protected:
 	void writeEntityKeyValues(const EntityNodePtr& entity, std::ostream& stream);
+
+	// Creates a copy of the given writer (of this writer's type), with the counters
+	// set up as if it had just finished writing <entityNumber> entities
+	template<typename WriterType>
+	static IMapWriterPtr createEntityWriterCopy(const WriterType& writer, std::size_t entityNumber)
+	{
+		auto copy = std::make_shared<WriterType>(writer);
+
+		static_cast<Doom3MapWriter&>(*copy)._entityCount = entityNumber;
+		static_cast<Doom3MapWriter&>(*copy)._primitiveCount = 0;
+
+		return copy;
+	}
 };
 
 } // namespace
@@ -0,0 +1,217 @@
+#include "EntityChunkSplitter.h"
+
+namespace map
+{
+
+namespace
+{
+    inline bool isWhitespace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\r';
+    }
+}
+
+EntityChunkSplitter::EntityChunkSplitter(std::string_view text) :
+    _text(text),
+    _headerLength(0)
+{}
+
+bool EntityChunkSplitter::split()
+{
+    _chunks.clear();
+
+    std::size_t pos = 0;
+    const auto length = _text.length();
+
+    // Header: advance to the first opening brace
+    while (pos < length)
+    {
+        char c = _text[pos];
+
+        if (c == '{')
+        {
+            break;
+        }
+
+        if (c == '}')
+        {
+            return false;
+        }
+
+        if (c == '"')
+        {
+            if (!skipQuotedString(pos)) return false;
+            continue;
+        }
+
+        if (c == '/')
+        {
+            if (!skipComment(pos)) return false;
+            continue;
+        }
+
+        ++pos;
+    }
+
+    _headerLength = pos;
+
+    // Entity blocks, separated by nothing but whitespace and comments
+    while (pos < length)
+    {
+        if (_text[pos] != '{')
+        {
+            return false;
+        }
+
+        auto start = pos;
+
+        if (!skipBlock(pos))
+        {
+            return false;
+        }
+
+        _chunks.push_back(EntityChunk{ start, pos - start });
+
+        if (!skipWhitespaceAndComments(pos))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool EntityChunkSplitter::skipWhitespaceAndComments(std::size_t& pos) const
+{
+    const auto length = _text.length();
+
+    while (pos < length)
+    {
+        char c = _text[pos];
+
+        if (isWhitespace(c))
+        {
+            ++pos;
+            continue;
+        }
+
+        if (c == '/' && pos + 1 < length && (_text[pos + 1] == '/' || _text[pos + 1] == '*'))
+        {
+            if (!skipComment(pos)) return false;
+            continue;
+        }
+
+        break;
+    }
+
+    return true;
+}
+
+bool EntityChunkSplitter::skipBlock(std::size_t& pos) const
+{
+    const auto length = _text.length();
+    std::size_t depth = 0;
+
+    while (pos < length)
+    {
+        switch (_text[pos])
+        {
+        case '{':
+            ++depth;
+            ++pos;
+            break;
+
+        case '}':
+            ++pos;
+
+            if (--depth == 0)
+            {
+                return true;
+            }
+            break;
+
+        case '"':
+            if (!skipQuotedString(pos)) return false;
+            break;
+
+        case '/':
+            if (!skipComment(pos)) return false;
+            break;
+
+        default:
+            ++pos;
+        }
+    }
+
+    // Ran out of characters before the block was closed
+    return false;
+}
+
+bool EntityChunkSplitter::skipQuotedString(std::size_t& pos) const
+{
+    const auto length = _text.length();
+
+    // Skip the opening quote
+    ++pos;
+
+    while (pos < length)
+    {
+        char c = _text[pos++];
+
+        if (c == '"')
+        {
+            return true;
+        }
+
+        // Backslashes escape the next character, as in the DefTokeniser
+        if (c == '\\' && pos < length)
+        {
+            ++pos;
+        }
+    }
+
+    return false;
+}
+
+bool EntityChunkSplitter::skipComment(std::size_t& pos) const
+{
+    const auto length = _text.length();
+
+    if (pos + 1 >= length)
+    {
+        ++pos;
+        return true;
+    }
+
+    if (_text[pos + 1] == '/')
+    {
+        // Line comments end at the next line break
+        pos = _text.find_first_of("\r\n", pos + 2);
+
+        if (pos == std::string_view::npos)
+        {
+            pos = length;
+        }
+
+        return true;
+    }
+
+    if (_text[pos + 1] == '*')
+    {
+        auto end = _text.find("*/", pos + 2);
+
+        if (end == std::string_view::npos)
+        {
+            return false;
+        }
+
+        pos = end + 2;
+        return true;
+    }
+
+    // Not a comment, just a single slash
+    ++pos;
+    return true;
+}
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+namespace map
+{
+
+/**
+ * A contiguous section of the map text spanning exactly one top-level
+ * entity block, including the opening and closing braces.
+ */
+struct EntityChunk
+{
+    // Character offset of the opening brace within the map text
+    std::size_t offset;
+
+    // Number of characters, up to and including the closing brace
+    std::size_t length;
+};
+
+/**
+ * Splits the text of an idTech4 map file at its top-level entity
+ * boundaries without tokenising it.
+ *
+ * The scanner follows the same quoting and comment rules as the
+ * DefTokeniser, such that braces inside quoted strings or comments
+ * don't affect the block depth. Each chunk can then be tokenised
+ * independently and yields the same token sequence as the corresponding
+ * section of the full text.
+ */
+class EntityChunkSplitter
+{
+private:
+    std::string_view _text;
+
+    // Offset of the first entity block, everything before is the map header
+    std::size_t _headerLength;
+
+    std::vector<EntityChunk> _chunks;
+
+public:
+    EntityChunkSplitter(std::string_view text);
+
+    // Scans the whole text. Returns false if the text contains anything that
+    // cannot be split safely (unbalanced braces, unterminated quotes or comments,
+    // stray tokens between two entities), in which case the caller should
+    // fall back to parsing the map in one piece.
+    bool split();
+
+    // The length of the header (version tag) preceding the first entity
+    std::size_t getHeaderLength() const
+    {
+        return _headerLength;
+    }
+
+    const std::vector<EntityChunk>& getChunks() const
+    {
+        return _chunks;
+    }
+
+private:
+    // Advances over whitespace and comments outside of entity blocks. Returns false
+    // if a comment is unterminated
+    bool skipWhitespaceAndComments(std::size_t& pos) const;
+
+    // Advances to the character following the closing brace of the block
+    // starting at the given position. Returns false on unbalanced input.
+    bool skipBlock(std::size_t& pos) const;
+
+    // Called with pos pointing at an opening quote, advances past the closing quote
+    bool skipQuotedString(std::size_t& pos) const;
+
+    // Called with pos pointing at a forward slash, advances past the comment
+    // if there is one. Returns false if the comment is unterminated.
+    bool skipComment(std::size_t& pos) const;
+};
+
+}
@@ -2,6 +2,8 @@
 
 #include "itextstream.h"
 #include "igame.h"
+#include "i18n.h"
+#include "ipreferencesystem.h"
 #include "module/StaticModule.h"
 
 #include "debugging/debugging.h"
@@ -107,6 +109,19 @@ std::string MapFormatManager::getName() const
 	return _name;
 }
 
+StringSet MapFormatManager::getDependencies() const
+{
+	static StringSet _dependencies{ MODULE_PREFERENCESYSTEM };
+	return _dependencies;
+}
+
+void MapFormatManager::initialiseModule(const IApplicationContext& ctx)
+{
+	IPreferencePage& page = GlobalPreferenceSystem().getPage(preferences::FILES_PAGE);
+	page.appendCheckBox(_("Load map files using multiple threads"), RKEY_MAP_PARALLEL_LOADING);
+	page.appendCheckBox(_("Save map files using multiple threads"), RKEY_MAP_PARALLEL_SAVING);
+}
+
 // Creates the static module instance
 module::StaticModuleRegistration<MapFormatManager> staticMapFormatManagerModule;
 
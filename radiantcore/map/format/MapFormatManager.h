@@ -27,6 +27,8 @@ public:
 
 	// RegisterableModule implementation
 	std::string getName() const override;
+	StringSet getDependencies() const override;
+	void initialiseModule(const IApplicationContext& ctx) override;
 };
 
 }
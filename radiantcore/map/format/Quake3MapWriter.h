@@ -39,6 +39,13 @@ public:
 		// Export patchDef2 to stream (patchDef3 is not supported)
 		PatchDefExporter::exportQ3PatchDef2(stream, patch);
 	}
+
+	// The legacy brush syntax needs the editor image dimensions of every face,
+	// which are only accessible from the main thread, so no parallel export
+	virtual IMapWriterPtr createEntityWriter(std::size_t entityNumber) override
+	{
+		return IMapWriterPtr();
+	}
 };
 
 class Quake3AlternateMapWriter :
@@ -54,6 +61,13 @@ public:
         // Export brushDef definition to stream
         BrushDefExporter::exportBrush(stream, brush);
     }
+
+    // The exporters are resolving the texture prefix through the material manager,
+    // keep the export on the main thread
+    virtual IMapWriterPtr createEntityWriter(std::size_t entityNumber) override
+    {
+        return IMapWriterPtr();
+    }
 };
 
 } // namespace
@@ -2,6 +2,7 @@
 #include "Doom3MapFormat.h"
 #include "Quake4MapReader.h"
 #include "Quake4MapWriter.h"
+#include "ithreadpool.h"
 
 #include "module/StaticModule.h"
 
@@ -22,6 +23,7 @@ StringSet Quake4MapFormat::getDependencies() const
     if (_dependencies.empty())
     {
         _dependencies.insert(MODULE_MAPFORMATMANAGER);
+        _dependencies.insert(MODULE_THREADPOOL);
     }
 
     return _dependencies;
@@ -28,6 +28,11 @@ public:
 		// Export brushDef3 definition to stream, but without contents flags
 		BrushDef3Exporter::exportBrush(stream, brush, false);
 	}
+
+	virtual IMapWriterPtr createEntityWriter(std::size_t entityNumber) override
+	{
+		return createEntityWriterCopy(*this, entityNumber);
+	}
 };
 
 } // namespace
@@ -1,10 +1,7 @@
-// greebo: Specialise the float casting function
-#define SPECIALISE_STR_TO_FLOAT
-
 #include "BrushDef.h"
 
 #include "../Quake3Utils.h"
-#include "string/convert.h"
+#include "string/charconv.h"
 #include "imap.h"
 #include "ibrush.h"
 #include "parser/DefTokeniser.h"
@@ -56,7 +53,7 @@ scene::INodePtr BrushDefParser::parse(parser::DefTokeniser& tok) const
 	// Parse face tokens until a closing brace is encountered
 	while (1)
 	{
-		std::string token = tok.nextToken();
+		auto token = tok.nextTokenView();
 
 		// Token should be either a "(" (start of face) or "}" (end of brush)
 		if (token == "}")
@@ -66,25 +63,25 @@ scene::INodePtr BrushDefParser::parse(parser::DefTokeniser& tok) const
 		else if (token == "(") // FACE
 		{
 			// Parse three 3D points to construct a plane
-			double x = string::to_float(tok.nextToken());
-			double y = string::to_float(tok.nextToken());
-			double z = string::to_float(tok.nextToken());
+			double x = string::to_double(tok.nextTokenView());
+			double y = string::to_double(tok.nextTokenView());
+			double z = string::to_double(tok.nextTokenView());
 			Vector3 p1(x, y, z);
 
 			tok.assertNextToken(")");
 			tok.assertNextToken("(");
 
-			x = string::to_float(tok.nextToken());
-			y = string::to_float(tok.nextToken());
-			z = string::to_float(tok.nextToken());
+			x = string::to_double(tok.nextTokenView());
+			y = string::to_double(tok.nextTokenView());
+			z = string::to_double(tok.nextTokenView());
 			Vector3 p2(x, y, z);
 
 			tok.assertNextToken(")");
 			tok.assertNextToken("(");
 
-			x = string::to_float(tok.nextToken());
-			y = string::to_float(tok.nextToken());
-			z = string::to_float(tok.nextToken());
+			x = string::to_double(tok.nextTokenView());
+			y = string::to_double(tok.nextTokenView());
+			z = string::to_double(tok.nextTokenView());
 			Vector3 p3(x, y, z);
 
 			tok.assertNextToken(")");
@@ -97,15 +94,15 @@ scene::INodePtr BrushDefParser::parse(parser::DefTokeniser& tok) const
 			tok.assertNextToken("(");
 
 			tok.assertNextToken("(");
-			texdef.xx() = string::to_float(tok.nextToken());
-			texdef.yx() = string::to_float(tok.nextToken());
-			texdef.zx() = string::to_float(tok.nextToken());
+			texdef.xx() = string::to_double(tok.nextTokenView());
+			texdef.yx() = string::to_double(tok.nextTokenView());
+			texdef.zx() = string::to_double(tok.nextTokenView());
 			tok.assertNextToken(")");
 
 			tok.assertNextToken("(");
-			texdef.xy() = string::to_float(tok.nextToken());
-			texdef.yy() = string::to_float(tok.nextToken());
-			texdef.zy() = string::to_float(tok.nextToken());
+			texdef.xy() = string::to_double(tok.nextTokenView());
+			texdef.yy() = string::to_double(tok.nextTokenView());
+			texdef.zy() = string::to_double(tok.nextTokenView());
 			tok.assertNextToken(")");
 
 			tok.assertNextToken(")");
@@ -115,7 +112,7 @@ scene::INodePtr BrushDefParser::parse(parser::DefTokeniser& tok) const
 
 			// Parse Flags (usually each brush has all faces detail or all faces structural)
 			IBrush::DetailFlag flag = static_cast<IBrush::DetailFlag>(
-				string::convert<std::size_t>(tok.nextToken(), IBrush::Structural));
+				string::to_integer<std::size_t>(tok.nextTokenView(), IBrush::Structural));
 			brush.setDetailFlag(flag);
 
 			// Ignore the other two flags
@@ -175,7 +172,7 @@ scene::INodePtr LegacyBrushDefParser::parse(parser::DefTokeniser& tok) const
 	// Parse face tokens until a closing brace is encountered
 	while (1)
 	{
-		std::string token = tok.nextToken();
+		auto token = tok.nextTokenView();
 
 		// Token should be either a "(" (start of face) or "}" (end of brush)
 		if (token == "}")
@@ -185,25 +182,25 @@ scene::INodePtr LegacyBrushDefParser::parse(parser::DefTokeniser& tok) const
 		else if (token == "(") // FACE
 		{
 			// Parse three 3D points to construct a plane
-			double x = string::to_float(tok.nextToken());
-			double y = string::to_float(tok.nextToken());
-			double z = string::to_float(tok.nextToken());
+			double x = string::to_double(tok.nextTokenView());
+			double y = string::to_double(tok.nextTokenView());
+			double z = string::to_double(tok.nextTokenView());
 			Vector3 p1(x, y, z);
 
 			tok.assertNextToken(")");
 			tok.assertNextToken("(");
 
-			x = string::to_float(tok.nextToken());
-			y = string::to_float(tok.nextToken());
-			z = string::to_float(tok.nextToken());
+			x = string::to_double(tok.nextTokenView());
+			y = string::to_double(tok.nextTokenView());
+			z = string::to_double(tok.nextTokenView());
 			Vector3 p2(x, y, z);
 
 			tok.assertNextToken(")");
 			tok.assertNextToken("(");
 
-			x = string::to_float(tok.nextToken());
-			y = string::to_float(tok.nextToken());
-			z = string::to_float(tok.nextToken());
+			x = string::to_double(tok.nextTokenView());
+			y = string::to_double(tok.nextTokenView());
+			z = string::to_double(tok.nextTokenView());
 			Vector3 p3(x, y, z);
 
 			tok.assertNextToken(")");
@@ -217,13 +214,13 @@ scene::INodePtr LegacyBrushDefParser::parse(parser::DefTokeniser& tok) const
 			// Parse texdef (shift rotation scale)
             ShiftScaleRotation ssr;
 
-            ssr.shift[0] = string::to_float(tok.nextToken());
-            ssr.shift[1] = string::to_float(tok.nextToken());
+            ssr.shift[0] = string::to_double(tok.nextTokenView());
+            ssr.shift[1] = string::to_double(tok.nextTokenView());
 
-            ssr.rotate = string::to_float(tok.nextToken());
+            ssr.rotate = string::to_double(tok.nextTokenView());
 
-            ssr.scale[0] = string::to_float(tok.nextToken());
-            ssr.scale[1] = string::to_float(tok.nextToken());
+            ssr.scale[0] = string::to_double(tok.nextTokenView());
+            ssr.scale[1] = string::to_double(tok.nextTokenView());
 
             if (ssr.scale[0] == 0)
             {
@@ -239,7 +236,7 @@ scene::INodePtr LegacyBrushDefParser::parse(parser::DefTokeniser& tok) const
 
 			// Parse Flags (usually each brush has all faces detail or all faces structural)
 			auto flag = static_cast<IBrush::DetailFlag>(
-				string::convert<std::size_t>(tok.nextToken(), IBrush::Structural));
+				string::to_integer<std::size_t>(tok.nextTokenView(), IBrush::Structural));
 			brush.setDetailFlag(flag);
 
 			// Ignore the other two flags
@@ -261,6 +258,11 @@ scene::INodePtr LegacyBrushDefParser::parse(parser::DefTokeniser& tok) const
 	return node;
 }
 
+bool LegacyBrushDefParser::canParseOnWorkerThread() const
+{
+    return false;
+}
+
 Matrix3 LegacyBrushDefParser::calculateTextureMatrix(const std::string& shader, const Vector3& normal, const ShiftScaleRotation& ssr)
 {
 	float imageWidth = 128;
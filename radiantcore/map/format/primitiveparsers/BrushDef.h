@@ -26,6 +26,9 @@ public:
 
     scene::INodePtr parse(parser::DefTokeniser& tok) const;
 
+    // Needs the editor image dimensions to calculate the texture matrix
+    bool canParseOnWorkerThread() const override;
+
 private:
     static Matrix3 calculateTextureMatrix(const std::string& shader, const Vector3& normal, const ShiftScaleRotation& ssr);
 };
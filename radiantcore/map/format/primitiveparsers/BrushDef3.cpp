@@ -1,8 +1,5 @@
-// greebo: Specialise the float casting function
-#define SPECIALISE_STR_TO_FLOAT
-
 #include "BrushDef3.h"
-#include "string/convert.h"
+#include "string/charconv.h"
 #include "imap.h"
 #include "ibrush.h"
 #include "parser/DefTokeniser.h"
@@ -60,7 +57,7 @@ scene::INodePtr BrushDef3Parser::parse(parser::DefTokeniser& tok) const
 	// Parse face tokens until a closing brace is encountered
 	while (1)
 	{
-		std::string token = tok.nextToken();
+		auto token = tok.nextTokenView();
 
 		// Token should be either a "(" (start of face) or "}" (end of brush)
 		if (token == "}")
@@ -72,10 +69,10 @@ scene::INodePtr BrushDef3Parser::parse(parser::DefTokeniser& tok) const
 			// Construct a plane and parse its values
 			Plane3 plane;
 
-			plane.normal().x() = string::to_float(tok.nextToken());
-			plane.normal().y() = string::to_float(tok.nextToken());
-			plane.normal().z() = string::to_float(tok.nextToken());
-			plane.dist() = -string::to_float(tok.nextToken()); // negate d
+			plane.normal().x() = string::to_double(tok.nextTokenView());
+			plane.normal().y() = string::to_double(tok.nextTokenView());
+			plane.normal().z() = string::to_double(tok.nextTokenView());
+			plane.dist() = -string::to_double(tok.nextTokenView()); // negate d
 
 			tok.assertNextToken(")");
 
@@ -84,15 +81,15 @@ scene::INodePtr BrushDef3Parser::parse(parser::DefTokeniser& tok) const
 			tok.assertNextToken("(");
 
 			tok.assertNextToken("(");
-			texdef.xx() = string::to_float(tok.nextToken());
-			texdef.yx() = string::to_float(tok.nextToken());
-			texdef.zx() = string::to_float(tok.nextToken());
+			texdef.xx() = string::to_double(tok.nextTokenView());
+			texdef.yx() = string::to_double(tok.nextTokenView());
+			texdef.zx() = string::to_double(tok.nextTokenView());
 			tok.assertNextToken(")");
 
 			tok.assertNextToken("(");
-			texdef.xy() = string::to_float(tok.nextToken());
-			texdef.yy() = string::to_float(tok.nextToken());
-			texdef.zy() = string::to_float(tok.nextToken());
+			texdef.xy() = string::to_double(tok.nextTokenView());
+			texdef.yy() = string::to_double(tok.nextTokenView());
+			texdef.zy() = string::to_double(tok.nextTokenView());
 			tok.assertNextToken(")");
 
 			tok.assertNextToken(")");
@@ -102,7 +99,7 @@ scene::INodePtr BrushDef3Parser::parse(parser::DefTokeniser& tok) const
 
 			// Parse Flags (usually each brush has all faces detail or all faces structural)
 			IBrush::DetailFlag flag = static_cast<IBrush::DetailFlag>(
-				string::convert<std::size_t>(tok.nextToken(), IBrush::Structural));
+				string::to_integer<std::size_t>(tok.nextTokenView(), IBrush::Structural));
 			brush.setDetailFlag(flag);
 
 			// Ignore the other two flags
@@ -142,7 +139,7 @@ scene::INodePtr BrushDef3ParserQuake4::parse(parser::DefTokeniser& tok) const
 	// Parse face tokens until a closing brace is encountered
 	while (1)
 	{
-		std::string token = tok.nextToken();
+		auto token = tok.nextTokenView();
 
 		// Token should be either a "(" (start of face) or "}" (end of brush)
 		if (token == "}")
@@ -154,10 +151,10 @@ scene::INodePtr BrushDef3ParserQuake4::parse(parser::DefTokeniser& tok) const
 			// Construct a plane and parse its values
 			Plane3 plane;
 
-			plane.normal().x() = string::to_float(tok.nextToken());
-			plane.normal().y() = string::to_float(tok.nextToken());
-			plane.normal().z() = string::to_float(tok.nextToken());
-			plane.dist() = -string::to_float(tok.nextToken()); // negate d
+			plane.normal().x() = string::to_double(tok.nextTokenView());
+			plane.normal().y() = string::to_double(tok.nextTokenView());
+			plane.normal().z() = string::to_double(tok.nextTokenView());
+			plane.dist() = -string::to_double(tok.nextTokenView()); // negate d
 
 			tok.assertNextToken(")");
 
@@ -166,15 +163,15 @@ scene::INodePtr BrushDef3ParserQuake4::parse(parser::DefTokeniser& tok) const
 			tok.assertNextToken("(");
 
 			tok.assertNextToken("(");
-			texdef.xx() = string::to_float(tok.nextToken());
-			texdef.yx() = string::to_float(tok.nextToken());
-			texdef.zx() = string::to_float(tok.nextToken());
+			texdef.xx() = string::to_double(tok.nextTokenView());
+			texdef.yx() = string::to_double(tok.nextTokenView());
+			texdef.zx() = string::to_double(tok.nextTokenView());
 			tok.assertNextToken(")");
 
 			tok.assertNextToken("(");
-			texdef.xy() = string::to_float(tok.nextToken());
-			texdef.yy() = string::to_float(tok.nextToken());
-			texdef.zy() = string::to_float(tok.nextToken());
+			texdef.xy() = string::to_double(tok.nextTokenView());
+			texdef.yy() = string::to_double(tok.nextTokenView());
+			texdef.zy() = string::to_double(tok.nextTokenView());
 			tok.assertNextToken(")");
 
 			tok.assertNextToken(")");
@@ -1,9 +1,6 @@
-// greebo: Specialise the float casting function
-#define SPECIALISE_STR_TO_FLOAT
-
 #include "Patch.h"
 
-#include "string/convert.h"
+#include "string/charconv.h"
 #include "parser/DefTokeniser.h"
 
 namespace map
@@ -24,13 +21,13 @@ void PatchParser::parseMatrix(parser::DefTokeniser& tok, IPatch& patch) const
 			tok.assertNextToken("(");
 
 			// Parse vertex coordinates
-			patch.ctrlAt(r, c).vertex[0] = string::to_float(tok.nextToken());
-			patch.ctrlAt(r, c).vertex[1] = string::to_float(tok.nextToken());
-			patch.ctrlAt(r, c).vertex[2] = string::to_float(tok.nextToken());
+			patch.ctrlAt(r, c).vertex[0] = string::to_double(tok.nextTokenView());
+			patch.ctrlAt(r, c).vertex[1] = string::to_double(tok.nextTokenView());
+			patch.ctrlAt(r, c).vertex[2] = string::to_double(tok.nextTokenView());
 
 			// Parse texture coordinates
-			patch.ctrlAt(r, c).texcoord[0] = string::to_float(tok.nextToken());
-			patch.ctrlAt(r, c).texcoord[1] = string::to_float(tok.nextToken());
+			patch.ctrlAt(r, c).texcoord[0] = string::to_double(tok.nextTokenView());
+			patch.ctrlAt(r, c).texcoord[1] = string::to_double(tok.nextTokenView());
 
 			tok.assertNextToken(")");
 		}
@@ -1,12 +1,9 @@
-// greebo: Specialise the float casting function
-#define SPECIALISE_STR_TO_FLOAT
-
 #include "PatchDef2.h"
 
 #include "imap.h"
 #include "ipatch.h"
 #include "parser/DefTokeniser.h"
-#include "string/convert.h"
+#include "string/charconv.h"
 #include "shaderlib.h"
 
 namespace map
@@ -53,8 +50,8 @@ scene::INodePtr PatchDef2Parser::parse(parser::DefTokeniser& tok) const
 	tok.assertNextToken("(");
 
 	// parse matrix dimensions
-	std::size_t cols = string::convert<std::size_t>(tok.nextToken());
-	std::size_t rows = string::convert<std::size_t>(tok.nextToken());
+	std::size_t cols = string::to_integer<std::size_t>(tok.nextTokenView());
+	std::size_t rows = string::to_integer<std::size_t>(tok.nextTokenView());
 
 	patch.setDims(cols, rows);
 
@@ -1,12 +1,9 @@
-// greebo: Specialise the float casting function
-#define SPECIALISE_STR_TO_FLOAT
-
 #include "PatchDef3.h"
 
 #include "imap.h"
 #include "ipatch.h"
 #include "parser/DefTokeniser.h"
-#include "string/convert.h"
+#include "string/charconv.h"
 
 namespace map
 {
@@ -51,14 +48,14 @@ scene::INodePtr PatchDef3Parser::parse(parser::DefTokeniser& tok) const
 	// Parse parameters
 	tok.assertNextToken("(");
 
-	std::size_t cols = string::convert<std::size_t>(tok.nextToken());
-	std::size_t rows = string::convert<std::size_t>(tok.nextToken());
+	std::size_t cols = string::to_integer<std::size_t>(tok.nextTokenView());
+	std::size_t rows = string::to_integer<std::size_t>(tok.nextTokenView());
 
 	patch.setDims(cols, rows);
 
 	// Parse fixed tesselation
-	std::size_t subdivX = string::convert<std::size_t>(tok.nextToken());
-	std::size_t subdivY = string::convert<std::size_t>(tok.nextToken());
+	std::size_t subdivX = string::to_integer<std::size_t>(tok.nextTokenView());
+	std::size_t subdivY = string::to_integer<std::size_t>(tok.nextTokenView());
 
 	patch.setFixedSubdivisions(true, Subdivisions(subdivX, subdivY));
 
@@ -2,6 +2,7 @@
 
 #include <ostream>
 #include "math/FloatTools.h"
+#include "string/charconv.h"
 
 namespace map
 {
@@ -17,7 +18,7 @@ inline void writeDoubleSafe(const double d, std::ostream& os)
 		}
 		else
 		{
-			os << d;
+			string::write_double(os, d);
 		}
 	}
 	else
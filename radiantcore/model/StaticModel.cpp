@@ -46,11 +46,11 @@ StaticModel::StaticModel(const StaticModel& other) :
     }
 }
 
-void StaticModel::connectUndoSystem(IUndoSystem& undoSystem)
+void StaticModel::connectUndoSystem(IUndoSystem& undoSystem, scene::INode& node)
 {
     assert(_undoStateSaver == nullptr);
 
-    _undoStateSaver = undoSystem.getStateSaver(*this);
+    _undoStateSaver = undoSystem.getStateSaver(*this, &node);
 }
 
 void StaticModel::disconnectUndoSystem(IUndoSystem& undoSystem)
@@ -322,7 +322,7 @@ void StaticModel::undoSave()
 
 IUndoMementoPtr StaticModel::exportState() const
 {
-    return IUndoMementoPtr(new undo::BasicUndoMemento<Vector3>(_scale));
+    return undo::allocateMemento<undo::BasicUndoMemento<Vector3>>(_scale);
 }
 
 void StaticModel::importState(const IUndoMementoPtr& state)
@@ -113,7 +113,7 @@ public:
      */
     StaticModel(const StaticModel& other);
 
-    void connectUndoSystem(IUndoSystem& undoSystem);
+    void connectUndoSystem(IUndoSystem& undoSystem, scene::INode& node);
     void disconnectUndoSystem(IUndoSystem& undoSystem);
 
     void setRenderSystem(const RenderSystemPtr& renderSystem);
@@ -34,7 +34,7 @@ void StaticModelNode::createRenderableSurfaces()
 
 void StaticModelNode::onInsertIntoScene(scene::IMapRootNode& root)
 {
-    _model->connectUndoSystem(root.getUndoSystem());
+    _model->connectUndoSystem(root.getUndoSystem(), *this);
 
     ModelNodeBase::onInsertIntoScene(root);
 }
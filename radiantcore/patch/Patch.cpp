@@ -156,7 +156,7 @@ void Patch::connectUndoSystem(IUndoSystem& undoSystem)
     assert(!_undoStateSaver);
 
     // Acquire a new state saver
-    _undoStateSaver = undoSystem.getStateSaver(*this);
+    _undoStateSaver = undoSystem.getStateSaver(*this, &_node);
 }
 
 // Remove the attached instance and decrease the counters
@@ -380,10 +380,11 @@ void Patch::undoSave()
     }
 }
 
-// Save the current patch state into a new UndoMemento instance (allocated on heap) and return it to the undo observer
+// Save the current patch state into a new UndoMemento instance (allocated from the operation's arena) and return it to the undo observer
 IUndoMementoPtr Patch::exportState() const
 {
-    return IUndoMementoPtr(new SavedState(_width, _height, _ctrl, _patchDef3, _subDivisions.x(), _subDivisions.y(), _shader.getMaterialName()));
+    return undo::allocateMemento<SavedState>(_width, _height, _ctrl, _patchDef3,
+        static_cast<std::size_t>(_subDivisions.x()), static_cast<std::size_t>(_subDivisions.y()), _shader.getMaterialName());
 }
 
 // Revert the state of this patch to the one that has been saved in the UndoMemento
@@ -2568,7 +2569,10 @@ void Patch::textureChanged()
         (*i++)->onPatchTextureChanged();
     }
 
-    signal_patchTextureChanged().emit();
+    if (!scene::sceneNotificationsSuppressed())
+    {
+        signal_patchTextureChanged().emit();
+    }
 }
 
 void Patch::attachObserver(Observer* observer)
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "PatchControl.h"
+#include "UndoMementoData.h"
+#include "UndoMementoArena.h"
 
 /* greebo: This is a structure that is allocated on the heap and contains all the state
  * information of a patch. This information is used by the UndoSystem to save the current
@@ -36,4 +38,50 @@ public:
 		m_subdivisions_y(subdivisions_y),
         _materialName(materialName)
     {}
+
+    std::size_t getMemoryUsage() const override
+    {
+        return sizeof(*this) + undo::getHeapMemoryUsage(m_ctrl) + undo::getHeapMemoryUsage(_materialName);
+    }
+
+    // The control points are moved out of memory, the dimensions stay
+    bool saveData(std::ostream& stream) override
+    {
+        undo::writeValue(stream, static_cast<std::uint64_t>(m_ctrl.size()));
+
+        for (const auto& ctrl : m_ctrl)
+        {
+            undo::writeValue(stream, ctrl.vertex.x());
+            undo::writeValue(stream, ctrl.vertex.y());
+            undo::writeValue(stream, ctrl.vertex.z());
+            undo::writeValue(stream, ctrl.texcoord.x());
+            undo::writeValue(stream, ctrl.texcoord.y());
+        }
+
+        undo::writeString(stream, _materialName);
+
+        undo::releaseMemory(m_ctrl);
+        undo::releaseMemory(_materialName);
+
+        return true;
+    }
+
+    void loadData(std::istream& stream) override
+    {
+        std::uint64_t numControls = 0;
+        undo::readValue(stream, numControls);
+
+        m_ctrl.resize(static_cast<std::size_t>(numControls));
+
+        for (auto& ctrl : m_ctrl)
+        {
+            undo::readValue(stream, ctrl.vertex.x());
+            undo::readValue(stream, ctrl.vertex.y());
+            undo::readValue(stream, ctrl.vertex.z());
+            undo::readValue(stream, ctrl.texcoord.x());
+            undo::readValue(stream, ctrl.texcoord.y());
+        }
+
+        undo::readString(stream, _materialName);
+    }
 };
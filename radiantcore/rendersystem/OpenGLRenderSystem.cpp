@@ -6,6 +6,7 @@
 #include "iregistry.h"
 #include "icolourscheme.h"
 #include "ideclmanager.h"
+#include "iscenegraph.h"
 
 #include "module/StaticModule.h"
 #include "backend/GLProgramFactory.h"
@@ -185,6 +186,13 @@ void OpenGLRenderSystem::startFrame()
 {
     // Prepare the storage objects
     _geometryStore.onFrameStart();
+
+    // Upload the textures which finished loading in the background, and
+    // keep the views redrawing while there are more of them to come
+    if (GlobalMaterialManager().processTextureUploads())
+    {
+        GlobalSceneGraph().sceneChanged();
+    }
 }
 
 void OpenGLRenderSystem::endFrame()
@@ -383,6 +391,7 @@ StringSet OpenGLRenderSystem::getDependencies() const
         MODULE_SHADERSYSTEM,
         MODULE_XMLREGISTRY,
         MODULE_SHARED_GL_CONTEXT,
+        MODULE_SCENEGRAPH,
     };
 
     return _dependencies;
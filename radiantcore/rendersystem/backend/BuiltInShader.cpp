@@ -96,7 +96,7 @@ void BuiltInShader::construct()
             state.stage0 = nullptr;
 
             // Set the texture
-            pass.texture0 = editorTex ? editorTex->getGLTexNum() : 0;
+            pass.setTexture(0, editorTex);
 
             // Set the blend ADD function
             state.m_blend_src = GL_ONE;
@@ -113,7 +113,7 @@ void BuiltInShader::construct()
         }
         else
         {
-            pass.texture0 = editorTex ? editorTex->getGLTexNum() : 0;
+            pass.setTexture(0, editorTex);
 
             pass.setRenderFlag(RENDER_FILL);
             pass.setRenderFlag(RENDER_TEXTURE_2D);
@@ -52,16 +52,16 @@ InteractionPass::InteractionPass(OpenGLShader& owner, OpenGLRenderSystem& render
 
     for (auto&& stage : stages)
     {
-        auto texture = getTextureOrInteractionDefault(stage)->getGLTexNum();
-        _interactionStages.emplace_back(Stage{ std::move(stage), texture });
+        auto texture = getTextureOrInteractionDefault(stage);
+        _interactionStages.emplace_back(Stage{ std::move(stage), std::move(texture) });
     }
 
-    _defaultBumpTexture = getDefaultInteractionTexture(IShaderLayer::BUMP)->getGLTexNum();
-    _defaultDiffuseTexture = getDefaultInteractionTexture(IShaderLayer::DIFFUSE)->getGLTexNum();
-    _defaultSpecularTexture = getDefaultInteractionTexture(IShaderLayer::SPECULAR)->getGLTexNum();
+    _defaultBumpTexture = GlobalMaterialManager().getDefaultInteractionTexture(IShaderLayer::BUMP);
+    _defaultDiffuseTexture = GlobalMaterialManager().getDefaultInteractionTexture(IShaderLayer::DIFFUSE);
+    _defaultSpecularTexture = GlobalMaterialManager().getDefaultInteractionTexture(IShaderLayer::SPECULAR);
 }
 
-GLuint InteractionPass::getDefaultInteractionTextureBinding(IShaderLayer::Type type)
+const TexturePtr& InteractionPass::getDefaultInteractionTexture(IShaderLayer::Type type)
 {
     switch (type)
     {
@@ -16,19 +16,20 @@ class InteractionPass :
     public OpenGLShaderPass
 {
 public:
-    // An interaction stage prepared for rendering
+    // An interaction stage prepared for rendering. The GL number of the texture
+    // is looked up when binding it, since streamed textures can change it.
     struct Stage
     {
         IShaderLayer::Ptr stage;
-        GLuint texture;
+        TexturePtr texture;
     };
 
 private:
     std::vector<Stage> _interactionStages;
 
-    GLuint _defaultDiffuseTexture;
-    GLuint _defaultBumpTexture;
-    GLuint _defaultSpecularTexture;
+    TexturePtr _defaultDiffuseTexture;
+    TexturePtr _defaultBumpTexture;
+    TexturePtr _defaultSpecularTexture;
 
 public:
     InteractionPass(OpenGLShader& owner, OpenGLRenderSystem& renderSystem, std::vector<IShaderLayer::Ptr>& stages);
@@ -58,7 +59,7 @@ public:
         return _interactionStages;
     }
 
-    GLuint getDefaultInteractionTextureBinding(IShaderLayer::Type type);
+    const TexturePtr& getDefaultInteractionTexture(IShaderLayer::Type type);
 
     // Generates the state with all the required flags for drawing interaction passes
     static OpenGLState GenerateInteractionState(GLProgramFactory& programFactory);
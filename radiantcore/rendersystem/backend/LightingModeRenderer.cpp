@@ -436,7 +436,7 @@ void LightingModeRenderer::drawNonInteractionPasses(OpenGLState& current, Render
                 pass.applyState(current, globalFlagsMask);
 
                 // Bind textures
-                OpenGLState::SetTextureState(current.texture0, pass.state().texture0, GL_TEXTURE0, GL_TEXTURE_2D);
+                OpenGLState::SetTextureState(current.texture0, pass.state().getTextureNumber(0), GL_TEXTURE0, GL_TEXTURE_2D);
 
                 if (dynamic_cast<RegularStageProgram*>(current.glProgram))
                 {
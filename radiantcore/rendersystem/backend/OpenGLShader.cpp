@@ -478,9 +478,9 @@ void OpenGLShader::constructLightingPassesFromMaterial()
             auto& zPass = appendDepthFillPass();
 
             zPass.stage0 = diffuseForDepthFillPass;
-            zPass.texture0 = diffuseForDepthFillPass ?
-                getTextureOrInteractionDefault(diffuseForDepthFillPass)->getGLTexNum() :
-                getDefaultInteractionTexture(IShaderLayer::DIFFUSE)->getGLTexNum();
+            zPass.setTexture(0, diffuseForDepthFillPass ?
+                getTextureOrInteractionDefault(diffuseForDepthFillPass) :
+                getDefaultInteractionTexture(IShaderLayer::DIFFUSE));
             zPass.alphaThreshold = diffuseForDepthFillPass ? diffuseForDepthFillPass->getAlphaTest() : -1.0f;
         }
 
@@ -517,7 +517,7 @@ void OpenGLShader::constructEditorPreviewPassFromMaterial()
 
     // Render the editor texture in legacy mode
     auto editorTex = _material->getEditorImage();
-    previewPass.texture0 = editorTex ? editorTex->getGLTexNum() : 0;
+    previewPass.setTexture(0, editorTex);
 
     // If there's a diffuse stage's, link it to this shader pass to inherit
     // settings like scale and translate
@@ -587,12 +587,12 @@ void OpenGLShader::appendBlendLayer(const IShaderLayer::Ptr& layer)
 	state.stage0 = layer;
 
     // Set the texture
-    state.texture0 = layerTex->getGLTexNum();
+    state.setTexture(0, layerTex);
 
     // BlendLights need to load the fall off image into texture unit 1
     if (_material->isBlendLight())
     {
-        state.texture1 = _material->lightFalloffImage()->getGLTexNum();
+        state.setTexture(1, _material->lightFalloffImage());
         state.setRenderFlag(RENDER_CULLFACE);
     }
 
@@ -68,6 +68,11 @@ private:
 
 	std::string _name;
 
+    // The textures assigned to the units 0-2 through setTexture(). Their GL numbers
+    // are looked up each time the state is applied: a streamed texture is bound to a
+    // placeholder until it's uploaded, and can be evicted and reloaded later on.
+    TexturePtr _textures[3];
+
 public:
 	const std::string& getName() const
 	{
@@ -163,6 +168,8 @@ public:
      * \{
      */
 
+    // The numbers of textures assigned through setTexture() are only
+    // used for sorting the states, use getTextureNumber() for binding.
     GLuint texture0; // diffuse
     GLuint texture1; // bump
     GLuint texture2; // specular
@@ -240,6 +247,20 @@ public:
       ignoreStageColour(false)
     { }
 
+    // Assigns the texture to bind to the given unit (0-2)
+    void setTexture(std::size_t unit, const TexturePtr& texture)
+    {
+        getTextureField(unit) = texture ? texture->getGLTexNum() : 0;
+        _textures[unit] = texture;
+    }
+
+    // Returns the GL texture number to bind to the given unit (0-2)
+    GLuint getTextureNumber(std::size_t unit) const
+    {
+        return _textures[unit] ? _textures[unit]->getGLTexNum() :
+            unit == 0 ? texture0 : unit == 1 ? texture1 : texture2;
+    }
+
     // Determines the difference between this state and the target (current) state.
     // Issues the state calls required by this state and updates the target state
     // to reflect the changes.
@@ -518,6 +539,11 @@ private:
         glLoadMatrixd(tex);
     }
 
+    GLuint& getTextureField(std::size_t unit)
+    {
+        return unit == 0 ? texture0 : unit == 1 ? texture1 : texture2;
+    }
+
     void setTextureState(GLuint& current, const GLuint texture, GLenum textureMode)
     {
         if (texture == current) return;
@@ -551,24 +577,24 @@ private:
 
             if (GLEW_VERSION_1_3)
             {
-                SetTextureState(current.texture0, texture0, GL_TEXTURE0, textureMode);
+                SetTextureState(current.texture0, getTextureNumber(0), GL_TEXTURE0, textureMode);
                 setupTextureMatrix(GL_TEXTURE0, stage0);
 
-                SetTextureState(current.texture1, texture1, GL_TEXTURE1, textureMode);
+                SetTextureState(current.texture1, getTextureNumber(1), GL_TEXTURE1, textureMode);
                 setupTextureMatrix(GL_TEXTURE1, stage1);
 
-                SetTextureState(current.texture2, texture2, GL_TEXTURE2, textureMode);
+                SetTextureState(current.texture2, getTextureNumber(2), GL_TEXTURE2, textureMode);
                 setupTextureMatrix(GL_TEXTURE2, stage2);
 
-                SetTextureState(current.texture3, texture2, GL_TEXTURE2, textureMode);
-                SetTextureState(current.texture4, texture2, GL_TEXTURE2, textureMode);
+                SetTextureState(current.texture3, getTextureNumber(2), GL_TEXTURE2, textureMode);
+                SetTextureState(current.texture4, getTextureNumber(2), GL_TEXTURE2, textureMode);
 
                 glActiveTexture(GL_TEXTURE0);
                 glClientActiveTexture(GL_TEXTURE0);
             }
             else
             {
-                setTextureState(current.texture0, texture0, textureMode);
+                setTextureState(current.texture0, getTextureNumber(0), textureMode);
                 setupTextureMatrix(GL_TEXTURE0, stage0);
             }
 
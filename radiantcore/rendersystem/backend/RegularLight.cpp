@@ -261,9 +261,9 @@ void RegularLight::InteractionDrawCall::submit(const ObjectList& objects)
     }
 
     // Bind textures
-    OpenGLState::SetTextureState(_state.texture0, _diffuse->texture, GL_TEXTURE0, GL_TEXTURE_2D);
-    OpenGLState::SetTextureState(_state.texture1, _bump->texture, GL_TEXTURE1, GL_TEXTURE_2D);
-    OpenGLState::SetTextureState(_state.texture2, _specular->texture, GL_TEXTURE2, GL_TEXTURE_2D);
+    OpenGLState::SetTextureState(_state.texture0, _diffuse->texture->getGLTexNum(), GL_TEXTURE0, GL_TEXTURE_2D);
+    OpenGLState::SetTextureState(_state.texture1, _bump->texture->getGLTexNum(), GL_TEXTURE1, GL_TEXTURE_2D);
+    OpenGLState::SetTextureState(_state.texture2, _specular->texture->getGLTexNum(), GL_TEXTURE2, GL_TEXTURE_2D);
 
     // Enable alphatest if required
     if (_diffuse && _diffuse->stage && _diffuse->stage->hasAlphaTest())
@@ -429,7 +429,7 @@ void RegularLight::setupAlphaTest(OpenGLState& state, OpenGLShader* shader, Dept
         program.setAlphaTest(depthFillPass->getAlphaTestValue());
 
         // If there's a diffuse stage, apply the correct texture
-        OpenGLState::SetTextureState(state.texture0, depthFillPass->state().texture0, GL_TEXTURE0, GL_TEXTURE_2D);
+        OpenGLState::SetTextureState(state.texture0, depthFillPass->state().getTextureNumber(0), GL_TEXTURE0, GL_TEXTURE_2D);
 
         // Set evaluated stage texture transformation matrix to the GLSL uniform
         program.setDiffuseTextureTransform(depthFillPass->getDiffuseTextureTransform());
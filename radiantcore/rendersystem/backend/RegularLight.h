@@ -97,9 +97,9 @@ private:
         {
             clear();
 
-            _defaultBumpStage.texture = pass.getDefaultInteractionTextureBinding(IShaderLayer::BUMP);
-            _defaultDiffuseStage.texture = pass.getDefaultInteractionTextureBinding(IShaderLayer::DIFFUSE);
-            _defaultSpecularStage.texture = pass.getDefaultInteractionTextureBinding(IShaderLayer::SPECULAR);
+            _defaultBumpStage.texture = pass.getDefaultInteractionTexture(IShaderLayer::BUMP);
+            _defaultDiffuseStage.texture = pass.getDefaultInteractionTexture(IShaderLayer::DIFFUSE);
+            _defaultSpecularStage.texture = pass.getDefaultInteractionTexture(IShaderLayer::SPECULAR);
         }
 
         bool hasBump() const
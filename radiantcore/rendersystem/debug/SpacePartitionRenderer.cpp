@@ -68,7 +68,7 @@ void SpacePartitionRenderer::shutdownModule()
 
 void SpacePartitionRenderer::installRenderer()
 {
-	_renderableSP.setSpacePartition(GlobalSceneGraph().getSpacePartition());
+	_renderableSP.setSpacePartition([] { return GlobalSceneGraph().getSpacePartition(); });
 	_renderableSP.setRenderSystem(std::dynamic_pointer_cast<RenderSystem>(
 		module::GlobalModuleRegistry().getModule(MODULE_RENDERSYSTEM)));
 
@@ -78,7 +78,7 @@ void SpacePartitionRenderer::installRenderer()
 void SpacePartitionRenderer::uninstallRenderer()
 {
 	_renderableSP.setRenderSystem(RenderSystemPtr());
-	_renderableSP.setSpacePartition(scene::ISpacePartitionSystemPtr());
+	_renderableSP.setSpacePartition(RenderableSpacePartition::SpacePartitionGetter());
 
 	GlobalRenderSystem().detachRenderable(_renderableSP);
 }
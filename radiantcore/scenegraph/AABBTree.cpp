@@ -0,0 +1,468 @@
+#include "AABBTree.h"
+
+#include "inode.h"
+#include "ivolumetest.h"
+#include "SPNodeSnapshot.h"
+
+#include <algorithm>
+
+namespace scene
+{
+
+namespace
+{
+	// The amount the leaf bounds are enlarged in each direction
+	const double LEAF_BOUNDS_MARGIN = 8.0;
+
+	inline AABB getUnion(const AABB& a, const AABB& b)
+	{
+		auto aMin = a.origin - a.extents;
+		auto aMax = a.origin + a.extents;
+		auto bMin = b.origin - b.extents;
+		auto bMax = b.origin + b.extents;
+
+		return AABB::createFromMinMax(
+			Vector3(std::min(aMin.x(), bMin.x()), std::min(aMin.y(), bMin.y()), std::min(aMin.z(), bMin.z())),
+			Vector3(std::max(aMax.x(), bMax.x()), std::max(aMax.y(), bMax.y()), std::max(aMax.z(), bMax.z()))
+		);
+	}
+
+	// Proportional to the surface area of the box, used as cost function
+	inline double getArea(const AABB& aabb)
+	{
+		const auto& e = aabb.extents;
+		return e.x() * e.y() + e.y() * e.z() + e.z() * e.x();
+	}
+}
+
+AABBTree::AABBTree() :
+	_root(INVALID_NODE),
+	_freeList(INVALID_NODE)
+{}
+
+void AABBTree::link(const scene::INodePtr& sceneNode)
+{
+	// Make sure we don't do double-links
+	assert(_nodeMapping.find(sceneNode.get()) == nullptr);
+
+	addMember(sceneNode, sceneNode->worldAABB());
+}
+
+bool AABBTree::unlink(const scene::INodePtr& sceneNode)
+{
+	auto* entry = _nodeMapping.find(sceneNode.get());
+
+	if (entry == nullptr)
+	{
+		return false;
+	}
+
+	removeMember(sceneNode, *entry);
+	return true;
+}
+
+void AABBTree::relink(const std::vector<scene::INodePtr>& sceneNodes)
+{
+	// Evaluate all bounds before touching the tree, this might
+	// call back into the scenegraph's nodeBoundsChanged()
+	for (const auto& sceneNode : sceneNodes)
+	{
+		sceneNode->worldAABB();
+	}
+
+	for (const auto& sceneNode : sceneNodes)
+	{
+		AABB bounds = sceneNode->worldAABB();
+
+		auto* entry = _nodeMapping.find(sceneNode.get());
+
+		if (entry == nullptr) continue; // not linked
+
+		if (entry->spNode == INVALID_NODE ? !bounds.isValid() : bounds.isValid() &&
+			_nodes[entry->spNode].bounds.contains(bounds))
+		{
+			continue; // still fits
+		}
+
+		removeMember(sceneNode, *entry);
+		addMember(sceneNode, bounds);
+	}
+}
+
+ISPNodePtr AABBTree::getRoot() const
+{
+	auto snapshot = _root != INVALID_NODE ? createSnapshot(_root, ISPNodePtr()) :
+		std::make_shared<SPNodeSnapshot>(AABB(Vector3(0, 0, 0), Vector3(0, 0, 0)), ISPNodePtr());
+
+	// The unbounded members are attached to the root
+	std::static_pointer_cast<SPNodeSnapshot>(snapshot)->addMembers(_unboundedMembers);
+
+	return snapshot;
+}
+
+ISPNodePtr AABBTree::createSnapshot(std::uint32_t index, const ISPNodePtr& parent) const
+{
+	const auto& node = _nodes[index];
+
+	auto snapshot = std::make_shared<SPNodeSnapshot>(node.bounds, parent);
+
+	if (node.isLeaf())
+	{
+		snapshot->addMembers(ISPNode::MemberList{ node.member });
+	}
+	else
+	{
+		snapshot->addChild(createSnapshot(node.child1, snapshot));
+		snapshot->addChild(createSnapshot(node.child2, snapshot));
+	}
+
+	return snapshot;
+}
+
+bool AABBTree::foreachMemberInVolume(const VolumeTest& volume, const MemberVisitor& visitor) const
+{
+	for (const auto& member : _unboundedMembers)
+	{
+		if (!visitor(member))
+		{
+			return false;
+		}
+	}
+
+	if (_root == INVALID_NODE)
+	{
+		return true;
+	}
+
+	// The stack holds the nodes still to be visited, along with a flag
+	// telling whether the node is known to be completely inside the volume
+	std::vector<std::pair<std::uint32_t, bool>> stack;
+	stack.reserve(64);
+	stack.emplace_back(_root, false);
+
+	while (!stack.empty())
+	{
+		auto [index, inside] = stack.back();
+		stack.pop_back();
+
+		const auto& node = _nodes[index];
+
+		if (!inside)
+		{
+			auto intersection = volume.TestAABB(node.bounds);
+
+			if (intersection == VOLUME_OUTSIDE) continue;
+
+			// No need to test anything below a node which is completely inside
+			inside = intersection == VOLUME_INSIDE;
+		}
+
+		if (node.isLeaf())
+		{
+			if (!visitor(node.member))
+			{
+				return false;
+			}
+
+			continue;
+		}
+
+		stack.emplace_back(node.child2, inside);
+		stack.emplace_back(node.child1, inside);
+	}
+
+	return true; // traversal complete
+}
+
+void AABBTree::addMember(const scene::INodePtr& sceneNode, const AABB& bounds)
+{
+	if (!bounds.isValid())
+	{
+		_nodeMapping.insert(sceneNode.get(), INVALID_NODE, static_cast<std::uint32_t>(_unboundedMembers.size()));
+		_unboundedMembers.push_back(sceneNode);
+		return;
+	}
+
+	auto leaf = allocateNode();
+	auto& node = _nodes[leaf];
+
+	node.bounds = bounds;
+	node.bounds.extendBy(Vector3(LEAF_BOUNDS_MARGIN, LEAF_BOUNDS_MARGIN, LEAF_BOUNDS_MARGIN));
+	node.member = sceneNode;
+	node.height = 0;
+
+	insertLeaf(leaf);
+
+	_nodeMapping.insert(sceneNode.get(), leaf, 0);
+}
+
+void AABBTree::removeMember(const scene::INodePtr& sceneNode, const NodeLinkTable::Entry& entry)
+{
+	if (entry.spNode == INVALID_NODE)
+	{
+		// Fill the gap with the last unbounded member
+		auto slot = entry.slot;
+		assert(slot < _unboundedMembers.size() && _unboundedMembers[slot] == sceneNode);
+
+		if (slot + 1 < _unboundedMembers.size())
+		{
+			_unboundedMembers[slot] = std::move(_unboundedMembers.back());
+			_nodeMapping.find(_unboundedMembers[slot].get())->slot = slot;
+		}
+
+		_unboundedMembers.pop_back();
+	}
+	else
+	{
+		auto leaf = entry.spNode;
+		assert(_nodes[leaf].member == sceneNode);
+
+		removeLeaf(leaf);
+		freeNode(leaf);
+	}
+
+	// This is invalidating the entry reference
+	_nodeMapping.erase(sceneNode.get());
+}
+
+std::uint32_t AABBTree::allocateNode()
+{
+	std::uint32_t index;
+
+	if (_freeList != INVALID_NODE)
+	{
+		index = _freeList;
+		_freeList = _nodes[index].parent;
+	}
+	else
+	{
+		index = static_cast<std::uint32_t>(_nodes.size());
+		_nodes.emplace_back();
+	}
+
+	auto& node = _nodes[index];
+	node.parent = INVALID_NODE;
+	node.child1 = INVALID_NODE;
+	node.child2 = INVALID_NODE;
+	node.height = 0;
+
+	return index;
+}
+
+void AABBTree::freeNode(std::uint32_t index)
+{
+	auto& node = _nodes[index];
+
+	node.member.reset();
+	node.height = -1;
+	node.parent = _freeList;
+
+	_freeList = index;
+}
+
+void AABBTree::insertLeaf(std::uint32_t leaf)
+{
+	if (_root == INVALID_NODE)
+	{
+		_root = leaf;
+		_nodes[leaf].parent = INVALID_NODE;
+		return;
+	}
+
+	// Find the best sibling for the new leaf, going down the tree
+	AABB leafBounds = _nodes[leaf].bounds;
+	auto index = _root;
+
+	while (!_nodes[index].isLeaf())
+	{
+		const auto& node = _nodes[index];
+
+		auto area = getArea(node.bounds);
+		auto combinedArea = getArea(getUnion(node.bounds, leafBounds));
+
+		// Cost of creating a new parent for this node and the new leaf
+		auto cost = 2 * combinedArea;
+
+		// Minimum cost of pushing the leaf further down the tree
+		auto inheritanceCost = 2 * (combinedArea - area);
+
+		auto getDescentCost = [&](std::uint32_t child)
+		{
+			const auto& childNode = _nodes[child];
+			auto childCombinedArea = getArea(getUnion(childNode.bounds, leafBounds));
+
+			return childNode.isLeaf() ? childCombinedArea + inheritanceCost :
+				childCombinedArea - getArea(childNode.bounds) + inheritanceCost;
+		};
+
+		auto cost1 = getDescentCost(node.child1);
+		auto cost2 = getDescentCost(node.child2);
+
+		if (cost < cost1 && cost < cost2)
+		{
+			break;
+		}
+
+		index = cost1 < cost2 ? node.child1 : node.child2;
+	}
+
+	auto sibling = index;
+
+	// Create a new parent for the sibling and the leaf
+	auto oldParent = _nodes[sibling].parent;
+	auto newParent = allocateNode();
+
+	_nodes[newParent].parent = oldParent;
+	_nodes[newParent].bounds = getUnion(leafBounds, _nodes[sibling].bounds);
+	_nodes[newParent].height = _nodes[sibling].height + 1;
+	_nodes[newParent].child1 = sibling;
+	_nodes[newParent].child2 = leaf;
+
+	_nodes[sibling].parent = newParent;
+	_nodes[leaf].parent = newParent;
+
+	if (oldParent == INVALID_NODE)
+	{
+		_root = newParent;
+	}
+	else if (_nodes[oldParent].child1 == sibling)
+	{
+		_nodes[oldParent].child1 = newParent;
+	}
+	else
+	{
+		_nodes[oldParent].child2 = newParent;
+	}
+
+	refitAncestors(_nodes[leaf].parent);
+}
+
+void AABBTree::removeLeaf(std::uint32_t leaf)
+{
+	if (leaf == _root)
+	{
+		_root = INVALID_NODE;
+		return;
+	}
+
+	auto parent = _nodes[leaf].parent;
+	auto grandParent = _nodes[parent].parent;
+	auto sibling = _nodes[parent].child1 == leaf ? _nodes[parent].child2 : _nodes[parent].child1;
+
+	// The sibling takes the place of the parent
+	_nodes[sibling].parent = grandParent;
+	freeNode(parent);
+
+	if (grandParent == INVALID_NODE)
+	{
+		_root = sibling;
+		return;
+	}
+
+	if (_nodes[grandParent].child1 == parent)
+	{
+		_nodes[grandParent].child1 = sibling;
+	}
+	else
+	{
+		_nodes[grandParent].child2 = sibling;
+	}
+
+	refitAncestors(grandParent);
+}
+
+void AABBTree::refitAncestors(std::uint32_t index)
+{
+	while (index != INVALID_NODE)
+	{
+		index = balance(index);
+
+		auto& node = _nodes[index];
+		const auto& child1 = _nodes[node.child1];
+		const auto& child2 = _nodes[node.child2];
+
+		node.height = 1 + std::max(child1.height, child2.height);
+		node.bounds = getUnion(child1.bounds, child2.bounds);
+
+		index = node.parent;
+	}
+}
+
+std::uint32_t AABBTree::balance(std::uint32_t iA)
+{
+	auto& a = _nodes[iA];
+
+	if (a.isLeaf() || a.height < 2)
+	{
+		return iA;
+	}
+
+	auto iB = a.child1;
+	auto iC = a.child2;
+	auto& b = _nodes[iB];
+	auto& c = _nodes[iC];
+
+	auto heightDifference = c.height - b.height;
+
+	// Rotate the higher child up, it takes the place of A,
+	// A takes the place of its lower grandchild
+	if (heightDifference > 1 || heightDifference < -1)
+	{
+		bool rotateC = heightDifference > 1;
+
+		auto iUp = rotateC ? iC : iB;
+		auto& up = _nodes[iUp];
+		const auto& other = rotateC ? b : c;
+
+		auto iF = up.child1;
+		auto iG = up.child2;
+		auto& f = _nodes[iF];
+		auto& g = _nodes[iG];
+
+		// Swap A and the rising node
+		up.child1 = iA;
+		up.parent = a.parent;
+		a.parent = iUp;
+
+		if (up.parent == INVALID_NODE)
+		{
+			_root = iUp;
+		}
+		else if (_nodes[up.parent].child1 == iA)
+		{
+			_nodes[up.parent].child1 = iUp;
+		}
+		else
+		{
+			_nodes[up.parent].child2 = iUp;
+		}
+
+		// The higher grandchild stays below the rising node, the lower one goes to A
+		auto iHigh = f.height > g.height ? iF : iG;
+		auto iLow = f.height > g.height ? iG : iF;
+
+		up.child2 = iHigh;
+		_nodes[iLow].parent = iA;
+
+		if (rotateC)
+		{
+			a.child2 = iLow;
+		}
+		else
+		{
+			a.child1 = iLow;
+		}
+
+		a.bounds = getUnion(other.bounds, _nodes[iLow].bounds);
+		a.height = 1 + std::max(other.height, _nodes[iLow].height);
+
+		up.bounds = getUnion(a.bounds, _nodes[iHigh].bounds);
+		up.height = 1 + std::max(a.height, _nodes[iHigh].height);
+
+		return iUp;
+	}
+
+	return iA;
+}
+
+} // namespace scene
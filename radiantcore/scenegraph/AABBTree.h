@@ -0,0 +1,107 @@
+#pragma once
+
+#include "ispacepartition.h"
+#include "math/AABB.h"
+#include "NodeLinkTable.h"
+
+#include <cstdint>
+
+namespace scene
+{
+
+/**
+ * A dynamic bounding volume hierarchy, as alternative to the Octree.
+ *
+ * Every linked scene::INode is held by a leaf of a binary tree, each inner
+ * node of the tree encloses the bounds of its two children. Unlike the Octree,
+ * the tree adapts to the distribution of the nodes, such that large and
+ * sparse maps with dense clusters of detail don't end up with lots of nodes
+ * in a single octant.
+ *
+ * New leaves are inserted next to the sibling which causes the least increase
+ * of surface area of the tree (surface area heuristic), the tree is kept balanced
+ * by rotating the nodes on the path back to the root.
+ *
+ * The leaves are storing slightly enlarged bounds, such that small movements of
+ * a scene::INode don't require it to be re-inserted - relink() leaves it in place
+ * as long as the new bounds fit into the enlarged ones.
+ *
+ * Scene nodes without valid bounds are kept in a separate list and are visited
+ * by every traversal, like the members of the Octree's root node.
+ */
+class AABBTree :
+	public ISpacePartitionSystem
+{
+private:
+	static constexpr std::uint32_t INVALID_NODE = UINT32_MAX;
+
+	struct Node
+	{
+		// The enlarged bounds of the member for leaves, the union of the children otherwise
+		AABB bounds;
+
+		// The parent node, or the next unused node in the free list
+		std::uint32_t parent;
+
+		std::uint32_t child1;
+		std::uint32_t child2;
+
+		// 0 for leaves, -1 for unused nodes
+		std::int32_t height;
+
+		// The scene node held by a leaf
+		INodePtr member;
+
+		bool isLeaf() const
+		{
+			return child1 == INVALID_NODE;
+		}
+	};
+
+	std::vector<Node> _nodes;
+	std::uint32_t _root;
+	std::uint32_t _freeList;
+
+	// The scene nodes without valid bounds
+	ISPNode::MemberList _unboundedMembers;
+
+	// Maps scene nodes to leaves, or to slots in the unbounded member list
+	// (the latter having the node index set to INVALID_NODE)
+	NodeLinkTable _nodeMapping;
+
+public:
+	AABBTree();
+
+	void link(const scene::INodePtr& sceneNode) override;
+	bool unlink(const scene::INodePtr& sceneNode) override;
+	void relink(const std::vector<scene::INodePtr>& sceneNodes) override;
+
+	// Returns a copy of the current tree structure
+	ISPNodePtr getRoot() const override;
+
+	bool foreachMemberInVolume(const VolumeTest& volume, const MemberVisitor& visitor) const override;
+
+private:
+	// Adds the scene node to the tree or the unbounded members, using the given bounds
+	void addMember(const scene::INodePtr& sceneNode, const AABB& bounds);
+
+	// Removes the scene node from the tree or the unbounded members
+	void removeMember(const scene::INodePtr& sceneNode, const NodeLinkTable::Entry& entry);
+
+	std::uint32_t allocateNode();
+	void freeNode(std::uint32_t index);
+
+	void insertLeaf(std::uint32_t leaf);
+	void removeLeaf(std::uint32_t leaf);
+
+	// Recalculates the bounds and heights on the way from the given node up to the root
+	void refitAncestors(std::uint32_t index);
+
+	// Performs a rotation if the subtree at the given index is imbalanced,
+	// returns the index of the node taking its place
+	std::uint32_t balance(std::uint32_t index);
+
+	ISPNodePtr createSnapshot(std::uint32_t index, const ISPNodePtr& parent) const;
+};
+
+} // namespace scene
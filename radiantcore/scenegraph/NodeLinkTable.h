@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace scene
+{
+
+class INode;
+
+/**
+ * Lookup table used by the space partition to find the place
+ * a scene::INode is linked to: the index of the SP node and the
+ * slot in the member array of that SP node.
+ *
+ * This is an open-addressing hash table keyed by the INode pointer,
+ * using linear probing and backward-shift deletion (no tombstones),
+ * all entries are stored in a single contiguous array.
+ * Pointers to entries are invalidated by insert() and erase().
+ */
+class NodeLinkTable
+{
+public:
+	struct Entry
+	{
+		const INode* sceneNode;
+		std::uint32_t spNode;
+		std::uint32_t slot;
+	};
+
+private:
+	std::vector<Entry> _entries;
+	std::size_t _size;
+
+	// The table is enlarged before exceeding this load factor (as numerator / 8)
+	static constexpr std::size_t MAX_LOAD_EIGHTHS = 6;
+	static constexpr std::size_t MIN_CAPACITY = 256;
+
+public:
+	NodeLinkTable() :
+		_size(0)
+	{}
+
+	std::size_t size() const
+	{
+		return _size;
+	}
+
+	// Returns the entry of the given node, or nullptr if it's not in the table
+	Entry* find(const INode* sceneNode)
+	{
+		if (_entries.empty()) return nullptr;
+
+		for (auto i = getHomeIndex(sceneNode); ; i = (i + 1) & getMask())
+		{
+			auto& entry = _entries[i];
+
+			if (entry.sceneNode == sceneNode) return &entry;
+			if (entry.sceneNode == nullptr) return nullptr;
+		}
+	}
+
+	// Adds a new entry for the given node, which must not be in the table yet
+	Entry& insert(const INode* sceneNode, std::uint32_t spNode, std::uint32_t slot)
+	{
+		assert(sceneNode != nullptr && find(sceneNode) == nullptr);
+
+		if ((_size + 1) * 8 > _entries.size() * MAX_LOAD_EIGHTHS)
+		{
+			rehash(_entries.empty() ? MIN_CAPACITY : _entries.size() * 2);
+		}
+
+		++_size;
+		return insertUnique(Entry{ sceneNode, spNode, slot });
+	}
+
+	// Removes the entry of the given node, returns false if it's not in the table
+	bool erase(const INode* sceneNode)
+	{
+		auto* entry = find(sceneNode);
+
+		if (entry == nullptr) return false;
+
+		auto hole = static_cast<std::size_t>(entry - _entries.data());
+		entry->sceneNode = nullptr;
+		--_size;
+
+		// Move the following entries of the probe sequence up, as long as
+		// this doesn't place them in front of their home index
+		for (auto i = (hole + 1) & getMask(); _entries[i].sceneNode != nullptr; i = (i + 1) & getMask())
+		{
+			auto home = getHomeIndex(_entries[i].sceneNode);
+
+			// Distance of the hole and the current index to the entry's home, modulo capacity
+			if (((hole - home) & getMask()) < ((i - home) & getMask()))
+			{
+				_entries[hole] = _entries[i];
+				_entries[i].sceneNode = nullptr;
+				hole = i;
+			}
+		}
+
+		return true;
+	}
+
+	void clear()
+	{
+		_entries.clear();
+		_size = 0;
+	}
+
+private:
+	std::size_t getMask() const
+	{
+		return _entries.size() - 1;
+	}
+
+	std::size_t getHomeIndex(const INode* sceneNode) const
+	{
+		// Finaliser of MurmurHash3, the lower bits of heap addresses are all the same
+		auto hash = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(sceneNode));
+
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdull;
+		hash ^= hash >> 33;
+
+		return static_cast<std::size_t>(hash) & getMask();
+	}
+
+	Entry& insertUnique(const Entry& newEntry)
+	{
+		auto i = getHomeIndex(newEntry.sceneNode);
+
+		while (_entries[i].sceneNode != nullptr)
+		{
+			i = (i + 1) & getMask();
+		}
+
+		return _entries[i] = newEntry;
+	}
+
+	void rehash(std::size_t capacity)
+	{
+		std::vector<Entry> oldEntries(capacity, Entry{ nullptr, 0, 0 });
+		oldEntries.swap(_entries);
+
+		for (const auto& entry : oldEntries)
+		{
+			if (entry.sceneNode != nullptr)
+			{
+				insertUnique(entry);
+			}
+		}
+	}
+};
+
+} // namespace scene
@@ -1,8 +1,8 @@
 #include "Octree.h"
 
 #include "inode.h"
-
-#include "OctreeNode.h"
+#include "ivolumetest.h"
+#include "SPNodeSnapshot.h"
 
 namespace scene
 {
@@ -17,38 +17,30 @@ namespace
 
 Octree::Octree()
 {
-	_root = OctreeNodePtr(new OctreeNode(*this, START_AABB));
-}
-
-Octree::~Octree()
-{
-	_nodeMapping.clear();
-	_root = OctreeNodePtr();
+	_root = allocateNode(START_AABB, INVALID_OCTREE_NODE);
 }
 
 void Octree::link(const scene::INodePtr& sceneNode)
 {
 	// Make sure we don't do double-links
-	assert(_nodeMapping.find(sceneNode) == _nodeMapping.end());
+	assert(_nodeMapping.find(sceneNode.get()) == nullptr);
 
 	// Make sure the root node is large enough
-	ensureRootSize(sceneNode);
+	ensureRootSize(sceneNode->worldAABB());
 
 	// Root node size is adjusted, let's link the node into the smallest encompassing octant
-	_root->linkRecursively(sceneNode);
+	linkRecursively(_root, sceneNode);
 }
 
-void Octree::ensureRootSize(const scene::INodePtr& sceneNode)
+void Octree::ensureRootSize(const AABB& aabb)
 {
-	// Check if sceneNode exceeds the root node's bounds
-	const AABB& aabb = sceneNode->worldAABB();
-
 	if (!aabb.isValid()) return; // skip this for invalid bounds
 
-	while (!_root->getBounds().contains(aabb))
+	// Check if the bounds exceed the root node's bounds
+	while (!_nodes[_root].bounds.contains(aabb))
 	{
 		// The bounding box of this node exceed the root node's bounds, we need to extend the tree bounds
-		AABB newBounds = _root->getBounds();
+		AABB newBounds = _nodes[_root].bounds;
 		newBounds.extents *= 2;
 
 		// Don't go beyond the map limits
@@ -58,42 +50,45 @@ void Octree::ensureRootSize(const scene::INodePtr& sceneNode)
 		}
 
 		// Allocate a new root node and subdivide it once
-		OctreeNodePtr newRootPtr(new OctreeNode(*this, newBounds));
-
-		OctreeNode& newRoot = *newRootPtr;
-		OctreeNode& oldRoot = *_root;
+		auto newRoot = allocateNode(newBounds, INVALID_OCTREE_NODE);
+		auto oldRoot = _root;
 
 		// Re-link the members of the old root node
 		// Note: this might be inaccurate, as some members of the old root could be
 		// re-linked to some children of the new root. But we don't want to call
 		// link again, as this can lead to re-entering of the evaluateBounds() function
 		// in scene::Node in some cases.
-		oldRoot.relocateMembersTo(newRoot);
+		relocateMembers(oldRoot, newRoot);
 
 		// Now, subdivide the new root node, after we moved the members
-		newRoot.subdivide();
+		subdivide(newRoot);
 
 		// Check if the old root had children
-		if (!oldRoot.isLeaf())
+		if (!_nodes[oldRoot].isLeaf())
 		{
 			// Move the children of the old root into the new root
 			// Each octant of the old root will be added to one child of the new root
-			for (std::size_t i = 0; i < 8; ++i)
+			// The old root and its (now empty) children remain unused in the array
+			for (std::uint32_t i = 0; i < 8; ++i)
 			{
+				auto newChild = _nodes[newRoot].firstChild + i;
+
 				// Subdivide each of the new children
-				newRoot[i].subdivide();
+				subdivide(newChild);
 
 				// Find out which of the new subdivisions is matching the children of the old root
-				for (std::size_t j = 0; j < 8; ++j)
+				for (std::uint32_t j = 0; j < 8; ++j)
 				{
-					for (std::size_t old = 0; old < 8; ++old)
+					auto newNode = _nodes[newChild].firstChild + j;
+
+					for (std::uint32_t old = 0; old < 8; ++old)
 					{
-						OctreeNode& newNode = newRoot[i][j];
+						auto oldNode = _nodes[oldRoot].firstChild + old;
 
-						if (newNode.getBounds() == oldRoot[old].getBounds())
+						if (_nodes[newNode].bounds == _nodes[oldNode].bounds)
 						{
-							oldRoot[old].relocateMembersTo(newNode);
-							oldRoot[old].relocateChildrenTo(newNode);
+							relocateMembers(oldNode, newNode);
+							relocateChildren(oldNode, newNode);
 							break;
 						}
 					}
@@ -101,58 +96,351 @@ void Octree::ensureRootSize(const scene::INodePtr& sceneNode)
 			}
 		}
 
-		_root = newRootPtr;
+		_root = newRoot;
 	}
 }
 
 // Unlink this node from the SP tree
 bool Octree::unlink(const scene::INodePtr& sceneNode)
 {
-	NodeMapping::iterator found = _nodeMapping.find(sceneNode);
+	auto* entry = _nodeMapping.find(sceneNode.get());
+
+	if (entry == nullptr)
+	{
+		return false;
+	}
+
+	removeMember(sceneNode, *entry);
+	return true;
+}
+
+void Octree::relink(const std::vector<scene::INodePtr>& sceneNodes)
+{
+	// Evaluate all bounds before touching the tree, this might
+	// call back into the scenegraph's nodeBoundsChanged()
+	for (const auto& sceneNode : sceneNodes)
+	{
+		sceneNode->worldAABB();
+	}
+
+	for (const auto& sceneNode : sceneNodes)
+	{
+		relinkNode(sceneNode);
+	}
+}
+
+void Octree::relinkNode(const scene::INodePtr& sceneNode)
+{
+	AABB bounds = sceneNode->worldAABB();
+
+	auto* entry = _nodeMapping.find(sceneNode.get());
+
+	if (entry == nullptr)
+	{
+		return; // not linked
+	}
+
+	auto index = entry->spNode;
+
+	if (!bounds.isValid())
+	{
+		// Invalid bounds belong to the root
+		if (index == _root) return;
+
+		removeMember(sceneNode, *entry);
+		linkRecursively(_root, sceneNode);
+		return;
+	}
+
+	if (isBestFit(index, bounds))
+	{
+		return; // stays where it is
+	}
+
+	removeMember(sceneNode, *entry);
+
+	if (!_nodes[_root].bounds.contains(bounds))
+	{
+		ensureRootSize(bounds);
+		index = _root;
+	}
+
+	// Go up until we find a node large enough to hold the new bounds
+	while (index != _root && !_nodes[index].bounds.contains(bounds))
+	{
+		index = _nodes[index].parent;
+	}
+
+	linkRecursively(index, sceneNode);
+}
+
+bool Octree::isBestFit(std::uint32_t index, const AABB& aabb) const
+{
+	const auto& node = _nodes[index];
 
-	if (found != _nodeMapping.end())
+	if (!node.bounds.contains(aabb))
 	{
-		// Lookup successful, unlink the node (will fire notifyUnlink())
-		found->second->unlink(sceneNode);
+		// Doesn't fit, unless it's in the root node and larger than the map limits
+		return index == _root && node.bounds.extents.x() * 2 > MAX_WORLD_COORD;
+	}
+
+	if (node.isLeaf())
+	{
+		// A leaf might need to be subdivided, but members are only
+		// moved down when the next one is linked
 		return true;
 	}
 
-	return false;
+	for (std::uint32_t i = 0; i < 8; ++i)
+	{
+		if (_nodes[node.firstChild + i].bounds.contains(aabb))
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
 
-// Returns the root node of this SP tree
 ISPNodePtr Octree::getRoot() const
 {
-	return _root;
+	return createSnapshot(_root, ISPNodePtr());
 }
 
-void Octree::notifyLink(const scene::INodePtr& sceneNode, OctreeNode* node)
+ISPNodePtr Octree::createSnapshot(std::uint32_t index, const ISPNodePtr& parent) const
 {
-	std::pair<NodeMapping::iterator, bool> result =
-		_nodeMapping.insert(NodeMapping::value_type(sceneNode, node));
+	const auto& node = _nodes[index];
 
-	assert(result.second);
+	auto snapshot = std::make_shared<SPNodeSnapshot>(node.bounds, parent);
+	snapshot->addMembers(node.members);
+
+	if (!node.isLeaf())
+	{
+		for (auto i = node.firstChild; i < node.firstChild + 8; ++i)
+		{
+			snapshot->addChild(createSnapshot(i, snapshot));
+		}
+	}
+
+	return snapshot;
 }
 
-void Octree::notifyUnlink(const scene::INodePtr& sceneNode, OctreeNode* node)
+bool Octree::foreachMemberInVolume(const VolumeTest& volume, const MemberVisitor& visitor) const
 {
-	// Remove the node from the lookup table, if found
-	NodeMapping::iterator found = _nodeMapping.find(sceneNode);
+	// Depth-first traversal, the stack holds the octree nodes still to be visited
+	std::vector<std::uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(_root);
+
+	while (!stack.empty())
+	{
+		const auto& node = _nodes[stack.back()];
+		stack.pop_back();
+
+		// Visit all members, we're done as soon as the visitor returns false
+		for (const auto& member : node.members)
+		{
+			if (!visitor(member))
+			{
+				return false;
+			}
+		}
 
-	assert(found != _nodeMapping.end());
+		if (node.isLeaf()) continue;
 
-	_nodeMapping.erase(found);
+		// Push the children in reverse order, such that the first child is visited first
+		for (auto i = node.firstChild + 8; i-- > node.firstChild;)
+		{
+			if (volume.TestAABB(_nodes[i].bounds) != VOLUME_OUTSIDE)
+			{
+				stack.push_back(i);
+			}
+		}
+	}
+
+	return true; // traversal complete
 }
 
-#ifdef _DEBUG
-void Octree::notifyErase(OctreeNode* node)
+std::uint32_t Octree::allocateNode(const AABB& bounds, std::uint32_t parent)
 {
-	// Remove the node from the lookup table, if found
-	for (NodeMapping::iterator i = _nodeMapping.begin(); i != _nodeMapping.end(); ++i)
+	_nodes.emplace_back(bounds, parent);
+	return static_cast<std::uint32_t>(_nodes.size() - 1);
+}
+
+void Octree::subdivide(std::uint32_t index)
+{
+	assert(_nodes[index].isLeaf());
+
+	// Copy the bounds, allocating the children will invalidate any references
+	AABB bounds = _nodes[index].bounds;
+
+	// Each child node has half the extents of this node
+	Vector3 childExtents = bounds.extents * 0.5;
+
+	// Construct delta-vectors, pointing in each room direction
+	Vector3 x(childExtents.x(), 0, 0);
+	Vector3 y(0, childExtents.y(), 0);
+	Vector3 z(0, 0, childExtents.z());
+
+	Vector3 baseUpper = bounds.origin + z;
+	Vector3 baseLower = bounds.origin - z;
+
+	// Upper half of the cube
+	auto firstChild = allocateNode(AABB(baseUpper + x + y, childExtents), index);
+	allocateNode(AABB(baseUpper + x - y, childExtents), index);
+	allocateNode(AABB(baseUpper - x - y, childExtents), index);
+	allocateNode(AABB(baseUpper - x + y, childExtents), index);
+
+	// Lower half of the cube
+	allocateNode(AABB(baseLower + x + y, childExtents), index);
+	allocateNode(AABB(baseLower + x - y, childExtents), index);
+	allocateNode(AABB(baseLower - x - y, childExtents), index);
+	allocateNode(AABB(baseLower - x + y, childExtents), index);
+
+	_nodes[index].firstChild = firstChild;
+}
+
+void Octree::linkRecursively(std::uint32_t index, const scene::INodePtr& sceneNode)
+{
+	AABB bounds = sceneNode->worldAABB();
+
+	// If the AABB is not valid, just link it here
+	if (!bounds.isValid())
+	{
+		addMember(index, sceneNode);
+		return;
+	}
+
+	// Descend into the child which this object fits into, as long as there is one
+	while (!_nodes[index].isLeaf())
+	{
+		auto firstChild = _nodes[index].firstChild;
+		auto fittingChild = INVALID_OCTREE_NODE;
+
+		for (auto i = firstChild; i < firstChild + 8; ++i)
+		{
+			if (_nodes[i].bounds.contains(bounds))
+			{
+				fittingChild = i;
+				break;
+			}
+		}
+
+		if (fittingChild == INVALID_OCTREE_NODE)
+		{
+			break; // Node didn't fit into any of the children, link it here
+		}
+
+		index = fittingChild;
+	}
+
+	addMember(index, sceneNode);
+
+	// If this is a leaf, check if we exceeded the subdivision threshold and are large enough
+	if (_nodes[index].isLeaf() &&
+		_nodes[index].members.size() >= SUBDIVISION_THRESHOLD &&
+		_nodes[index].bounds.extents.x() > MIN_NODE_EXTENTS)
+	{
+		// This leaf has enough members to justify a further subdivision, create 8 child nodes
+		subdivide(index);
+
+		// To avoid concurrent nodeBoundsChanged() calls during this operation, evaluate all
+		// child bounds before trying to re-distribute them over the new childnodes.
+		// Do this in a copy of the members list, the member array might change during traversal.
+		{
+			ISPNode::MemberList temp = _nodes[index].members;
+
+			for (const auto& member : temp)
+			{
+				member->worldAABB();
+			}
+		}
+
+		// At this point, all child bounds are calculated, some children might have re-located
+		// themselves to a different node already, so it's possible that the number of members is
+		// below SUBDIVISION_THRESHOLD now. We cannot rely on this, so let's continue anyway.
+
+		// We cannot use the original member array in the loop below...
+		ISPNode::MemberList oldList;
+
+		// ... so move it out of the node
+		oldList.swap(_nodes[index].members);
+
+		// Cycle through all the members and distribute them over the children
+		for (const auto& member : oldList)
+		{
+			_nodeMapping.erase(member.get());
+
+			// Call ourselves. The fact that we have 8 children now ensures that we won't be
+			// going down the same code path here again
+			linkRecursively(index, member);
+		}
+	}
+}
+
+void Octree::addMember(std::uint32_t index, const scene::INodePtr& sceneNode)
+{
+	auto& members = _nodes[index].members;
+
+	_nodeMapping.insert(sceneNode.get(), index, static_cast<std::uint32_t>(members.size()));
+	members.push_back(sceneNode);
+}
+
+void Octree::removeMember(const scene::INodePtr& sceneNode, const NodeMapping::Entry& entry)
+{
+	auto& members = _nodes[entry.spNode].members;
+	auto slot = entry.slot;
+
+	assert(slot < members.size() && members[slot] == sceneNode);
+
+	// Fill the gap with the last member, there's no need to keep the order
+	if (slot + 1 < members.size())
+	{
+		members[slot] = std::move(members.back());
+		_nodeMapping.find(members[slot].get())->slot = slot;
+	}
+
+	members.pop_back();
+
+	// This is invalidating the entry reference
+	_nodeMapping.erase(sceneNode.get());
+}
+
+void Octree::relocateMembers(std::uint32_t source, std::uint32_t target)
+{
+	auto& sourceMembers = _nodes[source].members;
+	auto& targetMembers = _nodes[target].members;
+
+	for (auto& member : sourceMembers)
+	{
+		auto* entry = _nodeMapping.find(member.get());
+		assert(entry != nullptr);
+
+		entry->spNode = target;
+		entry->slot = static_cast<std::uint32_t>(targetMembers.size());
+
+		targetMembers.emplace_back(std::move(member));
+	}
+
+	sourceMembers.clear();
+}
+
+void Octree::relocateChildren(std::uint32_t source, std::uint32_t target)
+{
+	assert(_nodes[target].isLeaf());
+
+	auto firstChild = _nodes[source].firstChild;
+
+	_nodes[target].firstChild = firstChild;
+	_nodes[source].firstChild = INVALID_OCTREE_NODE;
+
+	if (firstChild == INVALID_OCTREE_NODE) return;
+
+	// Tell each child who their parent is
+	for (auto i = firstChild; i < firstChild + 8; ++i)
 	{
-		assert(i->second != node);
+		_nodes[i].parent = target;
 	}
 }
-#endif
 
 } // namespace scene
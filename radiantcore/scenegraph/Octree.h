@@ -2,14 +2,12 @@
 #define _OCTREE_H_
 
 #include "ispacepartition.h"
-#include <map>
+#include "OctreeNode.h"
+#include "NodeLinkTable.h"
 
 namespace scene
 {
 
-class OctreeNode;
-typedef std::shared_ptr<OctreeNode> OctreeNodePtr;
-
 /**
  * greebo: An Octree is a simple way to subdivide the entire space
  * used by a collectivity of nodes in a scene. This is achieved by using cubic
@@ -33,6 +31,10 @@ typedef std::shared_ptr<OctreeNode> OctreeNodePtr;
  * one OctreeNode, the scene::INode remains in the one parent node able to do so.
  * In the "worst" case this is the root node itself.
  *
+ * All OctreeNodes are stored in one contiguous array, such that traversing
+ * the tree doesn't need to chase pointers all over the heap. Nodes are never
+ * removed from that array, except for clearing the whole tree.
+ *
  * The Octree maintains a lookup table (NodeMapping) to implement a fast unlink()
  * algorithm. The scene::INodes don't know or care where they are linked to, so
  * it needs a fast lookup to avoid having to traverse the entire tree to find and
@@ -42,44 +44,68 @@ class Octree :
 	public ISpacePartitionSystem
 {
 private:
-	// The root node of this SP
-	OctreeNodePtr _root;
+	// All the nodes of this SP
+	std::vector<OctreeNode> _nodes;
 
-	// Maps scene nodes against octree nodes, for fast lookup during unlink
-	typedef std::map<INodePtr, OctreeNode*> NodeMapping;
+	// The index of the root node
+	std::uint32_t _root;
+
+	// Maps scene nodes against octree nodes and member slots, for fast lookup during unlink
+	typedef NodeLinkTable NodeMapping;
 	NodeMapping _nodeMapping;
 
 public:
 	Octree();
 
-	~Octree();
-
 	// Links this node into the SP tree.
-	void link(const scene::INodePtr& sceneNode);
+	void link(const scene::INodePtr& sceneNode) override;
 
 	// Unlink this node from the SP tree, returns true if found
-	bool unlink(const scene::INodePtr& sceneNode);
+	bool unlink(const scene::INodePtr& sceneNode) override;
 
-	// Returns the root node of this SP tree
-	ISPNodePtr getRoot() const;
+	// Re-links the given nodes, leaving those in place which didn't leave their octree node
+	void relink(const std::vector<scene::INodePtr>& sceneNodes) override;
 
-	// Callback used by the OctreeNodes to let the tree update its caching structures
-	void notifyLink(const scene::INodePtr& sceneNode, OctreeNode* node);
-	void notifyUnlink(const scene::INodePtr& sceneNode, OctreeNode* node);
+	// Returns a copy of the current tree structure
+	ISPNodePtr getRoot() const override;
 
-#ifdef _DEBUG
-	// In debug builds, this ensures that no octree node is deleted
-	// while it is still mapped in the NodeMapping table
-	void notifyErase(OctreeNode* node);
-#endif
+	bool foreachMemberInVolume(const VolumeTest& volume, const MemberVisitor& visitor) const override;
 
 private:
 	/**
 	 * This is called whenever a node is linked into the octree
 	 * and ensures that the topmost octree node (the root node) is
-	 * large enough to encompass the scenenode's bounds.
+	 * large enough to encompass the given bounds.
 	 */
-	void ensureRootSize(const scene::INodePtr& sceneNode);
+	void ensureRootSize(const AABB& aabb);
+
+	// Adds a new node to the array, returning its index
+	std::uint32_t allocateNode(const AABB& bounds, std::uint32_t parent);
+
+	// Subdivide the given octree node (adding 8 child nodes)
+	void subdivide(std::uint32_t index);
+
+	// Links the given scene object into the smallest octree node below the given one
+	void linkRecursively(std::uint32_t index, const scene::INodePtr& sceneNode);
+
+	// Re-links a single node, assuming its bounds have been evaluated already
+	void relinkNode(const scene::INodePtr& sceneNode);
+
+	void addMember(std::uint32_t index, const scene::INodePtr& sceneNode);
+
+	// Removes the scene node from its octree node and the lookup table
+	void removeMember(const scene::INodePtr& sceneNode, const NodeMapping::Entry& entry);
+
+	// Returns true if the given bounds fit into the octree node, but none of its children
+	bool isBestFit(std::uint32_t index, const AABB& aabb) const;
+
+	// Moves all the members of an octree node to another one
+	void relocateMembers(std::uint32_t source, std::uint32_t target);
+
+	// Moves the children of an octree node to another one, which must be a leaf
+	void relocateChildren(std::uint32_t source, std::uint32_t target);
+
+	ISPNodePtr createSnapshot(std::uint32_t index, const ISPNodePtr& parent) const;
 };
 
 } // namespace scene
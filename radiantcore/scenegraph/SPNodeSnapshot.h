@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ispacepartition.h"
+#include "math/AABB.h"
+
+namespace scene
+{
+
+/**
+ * Immutable copy of a space partition node, used by the space partition
+ * implementations to hand out their tree structure through getRoot().
+ * The actual trees are stored in flat arrays, which cannot be referenced
+ * through ISPNodePtrs.
+ */
+class SPNodeSnapshot :
+	public ISPNode
+{
+private:
+	ISPNodeWeakPtr _parent;
+	AABB _bounds;
+	NodeList _children;
+	MemberList _members;
+
+public:
+	SPNodeSnapshot(const AABB& bounds, const ISPNodePtr& parent) :
+		_parent(parent),
+		_bounds(bounds)
+	{}
+
+	ISPNodePtr getParent() const override
+	{
+		return _parent.lock();
+	}
+
+	const AABB& getBounds() const override
+	{
+		return _bounds;
+	}
+
+	const NodeList& getChildNodes() const override
+	{
+		return _children;
+	}
+
+	bool isLeaf() const override
+	{
+		return _children.empty();
+	}
+
+	const MemberList& getMembers() const override
+	{
+		return _members;
+	}
+
+	void addChild(const ISPNodePtr& child)
+	{
+		_children.push_back(child);
+	}
+
+	void addMembers(const MemberList& members)
+	{
+		_members.insert(_members.end(), members.begin(), members.end());
+	}
+};
+
+} // namespace scene
@@ -1,8 +1,13 @@
 #include "SceneGraph.h"
 
 #include "ivolumetest.h"
+#include "iregistry.h"
+#include "ithreadpool.h"
 #include "scene/InstanceWalkers.h"
+#include "scene/BRepEvaluation.h"
+#include "render/NopVolumeTest.h"
 #include "Octree.h"
+#include "AABBTree.h"
 #include "SceneGraphFactory.h"
 #include "util/ScopedBoolLock.h"
 #include "module/StaticModule.h"
@@ -10,11 +15,15 @@
 namespace scene
 {
 
+namespace
+{
+	const char* const SPACE_PARTITION_AABB_TREE = "aabbtree";
+}
+
 SceneGraph::SceneGraph() :
 	_spacePartition(new Octree),
-	_visitedSPNodes(0),
-	_skippedSPNodes(0),
-    _traversalOngoing(false)
+    _traversalOngoing(false),
+    _boundsChangeBatchActive(false)
 {}
 
 SceneGraph::~SceneGraph()
@@ -82,11 +91,21 @@ void SceneGraph::setRoot(const IMapRootNodePtr& newRoot)
 
 	_root = newRoot;
 
+	// Nodes collected for the old space partition are not of interest anymore
+	_pendingRelinks.clear();
+	_pendingRelinkSet.clear();
+
 	// Refresh the space partition class
-	_spacePartition = std::make_shared<Octree>();
+	_spacePartition = createSpacePartition();
 
 	if (_root)
 	{
+		// Build the windings of all brushes at once, instead of one by one
+		// when the space partition is asking for their bounds
+		BRepEvaluationBatch batch;
+		batch.addSubgraph(_root);
+		batch.evaluate();
+
 		// New root not NULL, "instantiate" the whole scene
 		GraphPtr self = shared_from_this();
 		InstanceSubgraphWalker instanceWalker(self);
@@ -189,6 +208,16 @@ void SceneGraph::nodeBoundsChanged(const INodePtr& node)
         return;
     }
 
+    if (_boundsChangeBatchActive)
+    {
+        // Collect each node only once, the relink will use its latest bounds
+        if (_pendingRelinkSet.insert(node.get()).second)
+        {
+            _pendingRelinks.push_back(node);
+        }
+        return;
+    }
+
 	if (_spacePartition->unlink(node))
 	{
 		// unlink returned true, so the given node was linked before => re-link it
@@ -196,6 +225,45 @@ void SceneGraph::nodeBoundsChanged(const INodePtr& node)
 	}
 }
 
+void SceneGraph::beginBoundsChangeBatch()
+{
+    _boundsChangeBatchActive = true;
+}
+
+void SceneGraph::endBoundsChangeBatch()
+{
+    _boundsChangeBatchActive = false;
+
+    flushPendingRelinks();
+}
+
+void SceneGraph::flushPendingRelinks()
+{
+    // Don't change the space partition while it's being traversed
+    if (_traversalOngoing) return;
+
+    // Relinking evaluates the node bounds, which might call nodeBoundsChanged()
+    // and add more nodes to the list, process them until nothing is left
+    while (!_pendingRelinks.empty())
+    {
+        std::vector<INodePtr> nodes;
+        nodes.swap(_pendingRelinks);
+        _pendingRelinkSet.clear();
+
+        // The moved brushes need new windings before their bounds can be determined
+        BRepEvaluationBatch batch;
+
+        for (const auto& node : nodes)
+        {
+            batch.addNode(node);
+        }
+
+        batch.evaluate();
+
+        _spacePartition->relink(nodes);
+    }
+}
+
 void SceneGraph::foreachNode(const INode::VisitorFunc& functor)
 {
 	if (!_root) return;
@@ -243,18 +311,26 @@ void SceneGraph::foreachNodeInVolume(const VolumeTest& volume, const INode::Visi
     // changes during traversal so let's call this now. If nothing got changed, this call is very cheap.
     if (_root != nullptr) _root->worldAABB();
 
+    // Bring the space partition up to date with the bounds changes collected so far
+    flushPendingRelinks();
+
     {
         // Buffer any calls that might happen in between
         util::ScopedBoolLock traversal(_traversalOngoing);
 
         // Descend the SpacePartition tree and call the walker for each (partially) visible member
-        ISPNodePtr root = _spacePartition->getRoot();
-
-        _visitedSPNodes = _skippedSPNodes = 0;
-
-        foreachNodeInVolume_r(*root, volume, functor, visitHidden);
-
-        _visitedSPNodes = _skippedSPNodes = 0;
+        if (visitHidden)
+        {
+            _spacePartition->foreachMemberInVolume(volume, functor);
+        }
+        else
+        {
+            _spacePartition->foreachMemberInVolume(volume, [&](const INodePtr& node)
+            {
+                // Skip hidden nodes, we're done as soon as the walker returns false
+                return !node->visible() || functor(node);
+            });
+        }
     }
 
     // Traversal finished, flush the action buffer
@@ -277,57 +353,45 @@ void SceneGraph::foreachVisibleNodeInVolume(const VolumeTest& volume, Walker& wa
 		false); // don't visit hidden
 }
 
-bool SceneGraph::foreachNodeInVolume_r(const ISPNode& node, const VolumeTest& volume,
-									   const INode::VisitorFunc& functor, bool visitHidden)
+ISpacePartitionSystemPtr SceneGraph::getSpacePartition()
 {
-	_visitedSPNodes++;
+    flushPendingRelinks();
 
-	// Visit all members
-	const ISPNode::MemberList& members = node.getMembers();
+	return _spacePartition;
+}
 
-	for (ISPNode::MemberList::const_iterator m = members.begin();
-		 m != members.end(); /* in-loop increment */)
+ISpacePartitionSystemPtr SceneGraph::createSpacePartition() const
+{
+	if (_spacePartitionType == SPACE_PARTITION_AABB_TREE)
 	{
-		// Skip hidden nodes, if specified
-		if (!visitHidden && !(*m)->visible())
-		{
-			++m;
-			continue;
-		}
-
-		// We're done, as soon as the walker returns FALSE
-		if (!functor(*m++))
-		{
-			return false;
-		}
+		return std::make_shared<AABBTree>();
 	}
 
-	// Now consider the children
-	const ISPNode::NodeList& children = node.getChildNodes();
+	return std::make_shared<Octree>();
+}
 
-	for (ISPNode::NodeList::const_iterator i = children.begin(); i != children.end(); ++i)
+void SceneGraph::setSpacePartitionType(const std::string& type)
+{
+	if (_spacePartitionType == type)
 	{
-		if (volume.TestAABB((*i)->getBounds()) == VOLUME_OUTSIDE)
-		{
-			// Skip this node, not visible
-			_skippedSPNodes++;
-			continue;
-		}
-
-		// Traverse all the children too, enter recursion
-		if (!foreachNodeInVolume_r(**i, volume, functor, visitHidden))
-		{
-			// The walker returned false somewhere in the recursion depths, propagate this message
-			return false;
-		}
+		return;
 	}
 
-	return true; // continue traversal
-}
+	_spacePartitionType = type;
 
-ISpacePartitionSystemPtr SceneGraph::getSpacePartition()
-{
-	return _spacePartition;
+	// Nodes can't be moved around while the space partition is being traversed
+	assert(!_traversalOngoing);
+
+	flushPendingRelinks();
+
+	auto oldSpacePartition = _spacePartition;
+	_spacePartition = createSpacePartition();
+
+	oldSpacePartition->foreachMemberInVolume(render::NopVolumeTest(), [&](const INodePtr& node)
+	{
+		_spacePartition->link(node);
+		return true;
+	});
 }
 
 void SceneGraph::flushActionBuffer()
@@ -359,6 +423,25 @@ std::string SceneGraphModule::getName() const
 	return _name;
 }
 
+StringSet SceneGraphModule::getDependencies() const
+{
+	return { MODULE_XMLREGISTRY, MODULE_THREADPOOL };
+}
+
+void SceneGraphModule::initialiseModule(const IApplicationContext& ctx)
+{
+	onSpacePartitionTypeChanged();
+
+	GlobalRegistry().signalForKey(RKEY_SPACE_PARTITION_TYPE).connect(
+		sigc::mem_fun(this, &SceneGraphModule::onSpacePartitionTypeChanged)
+	);
+}
+
+void SceneGraphModule::onSpacePartitionTypeChanged()
+{
+	setSpacePartitionType(GlobalRegistry().get(RKEY_SPACE_PARTITION_TYPE));
+}
+
 // Static module instances
 module::StaticModuleRegistration<SceneGraphModule> sceneGraphModule;
 module::StaticModuleRegistration<SceneGraphFactory> sceneGraphFactory;
@@ -2,6 +2,8 @@
 
 #include <map>
 #include <list>
+#include <unordered_set>
+#include <vector>
 #include <sigc++/signal.h>
 #include <sigc++/connection.h>
 
@@ -36,8 +38,8 @@ private:
 	// The space partitioning system
 	ISpacePartitionSystemPtr _spacePartition;
 
-	std::size_t _visitedSPNodes;
-	std::size_t _skippedSPNodes;
+	// The kind of space partition to create, see RKEY_SPACE_PARTITION_TYPE
+	std::string _spacePartitionType;
 
     // During partition traversal all link/unlink calls are buffered and
     // performed later on.
@@ -53,6 +55,11 @@ private:
 
     bool _traversalOngoing;
 
+    // While a bounds change batch is active, the changed nodes are collected here
+    bool _boundsChangeBatchActive;
+    std::vector<INodePtr> _pendingRelinks;
+    std::unordered_set<INode*> _pendingRelinkSet;
+
     sigc::connection _undoEventHandler;
 
 public:
@@ -85,6 +92,9 @@ public:
 
     void nodeBoundsChanged(const scene::INodePtr& node) override;
 
+    void beginBoundsChangeBatch() override;
+    void endBoundsChangeBatch() override;
+
 	// Walker variants
     void foreachNodeInVolume(const VolumeTest& volume, Walker& walker) override;
     void foreachVisibleNodeInVolume(const VolumeTest& volume, Walker& walker) override;
@@ -99,13 +109,19 @@ public:
 private:
 	void foreachNodeInVolume(const VolumeTest& volume, const INode::VisitorFunc& functor, bool visitHidden);
 
-	// Recursive method used to descend the SpacePartition tree, returns FALSE if the walker signaled stop
-	bool foreachNodeInVolume_r(const ISPNode& node, const VolumeTest& volume,
-							   const INode::VisitorFunc& functor, bool visitHidden);
-
     void flushActionBuffer();
 
+    // Relinks the nodes collected during the bounds change batch
+    void flushPendingRelinks();
+
+    // Creates an empty space partition of the currently configured type
+    ISpacePartitionSystemPtr createSpacePartition() const;
+
     void onUndoEvent(IUndoSystem::EventType type, const std::string& operationName);
+
+protected:
+    // Switches to the given space partition type, moving all linked nodes over to the new one
+    void setSpacePartitionType(const std::string& type);
 };
 typedef std::shared_ptr<SceneGraph> SceneGraphPtr;
 
@@ -117,6 +133,11 @@ class SceneGraphModule :
 public:
 	// RegisterableModule implementation
 	std::string getName() const;
+	StringSet getDependencies() const override;
+	void initialiseModule(const IApplicationContext& ctx) override;
+
+private:
+	void onSpacePartitionTypeChanged();
 };
 typedef std::shared_ptr<SceneGraphModule> SceneGraphModulePtr;
 
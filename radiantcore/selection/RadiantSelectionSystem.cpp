@@ -802,6 +802,10 @@ void RadiantSelectionSystem::onManipulationStart()
 {
 	// Save the pivot state now that the transformation is starting
 	_pivot.beginOperation();
+
+	// Don't relink every transformed node in the space partition on every mouse move,
+	// the scenegraph is doing that in one go before the next render pass
+	GlobalSceneGraph().beginBoundsChangeBatch();
 }
 
 void RadiantSelectionSystem::onManipulationChanged()
@@ -815,6 +819,9 @@ void RadiantSelectionSystem::onManipulationEnd()
 {
     GlobalSceneGraph().foreachNode(scene::freezeTransformableNode);
 
+    // Everything is in place, update the space partition
+    GlobalSceneGraph().endBoundsChangeBatch();
+
     _pivot.endOperation();
 
 	// The selection bounds have possibly changed
@@ -888,6 +895,8 @@ void RadiantSelectionSystem::onManipulationCancelled()
 
     _pivot.cancelOperation();
 
+    GlobalSceneGraph().endBoundsChangeBatch();
+
     pivotChanged();
 }
 
@@ -11,6 +11,8 @@
 
 #include "SceneManipulationPivot.h"
 
+#include <list>
+
 namespace selection
 {
 
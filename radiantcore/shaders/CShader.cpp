@@ -80,27 +80,32 @@ TexturePtr CShader::getEditorImage()
 {
     if (!_editorTexture)
     {
-        auto editorTex = _template->getEditorTexture();
+        // Pass the call to the GLTextureManager to realise this image
+        _editorTexture = GetTextureManager().getBinding(getEditorImageSource());
+    }
+
+    return _editorTexture;
+}
 
-        if (!editorTex)
+MapExpressionPtr CShader::getEditorImageSource()
+{
+    auto editorTex = _template->getEditorTexture();
+
+    if (!editorTex)
+    {
+        // If there is no editor expression defined, use the an image from a layer, but no Bump or speculars
+        for (const auto& layer : _template->getLayers())
         {
-            // If there is no editor expression defined, use the an image from a layer, but no Bump or speculars
-            for (const auto& layer : _template->getLayers())
+            if (layer->getType() != IShaderLayer::BUMP && layer->getType() != IShaderLayer::SPECULAR &&
+                std::dynamic_pointer_cast<MapExpression>(layer->getMapExpression()))
             {
-                if (layer->getType() != IShaderLayer::BUMP && layer->getType() != IShaderLayer::SPECULAR &&
-                    std::dynamic_pointer_cast<MapExpression>(layer->getMapExpression()))
-                {
-                    editorTex = std::static_pointer_cast<MapExpression>(layer->getMapExpression());
-                    break;
-                }
+                editorTex = std::static_pointer_cast<MapExpression>(layer->getMapExpression());
+                break;
             }
         }
-
-        // Pass the call to the GLTextureManager to realise this image
-        _editorTexture = GetTextureManager().getBinding(editorTex);
     }
 
-    return _editorTexture;
+    return editorTex;
 }
 
 IMapExpression::Ptr CShader::getEditorImageExpression()
@@ -118,7 +123,7 @@ void CShader::setEditorImageExpressionFromString(const std::string& editorImageP
 
 bool CShader::isEditorImageNoTex()
 {
-	return (getEditorImage() == GetTextureManager().getShaderNotFound());
+	return GetTextureManager().isShaderNotFound(getEditorImage());
 }
 
 IMapExpression::Ptr CShader::getLightFalloffExpression()
@@ -155,6 +155,10 @@ public:
     // Returns the current template (including any modifications) of this material
     const ShaderTemplate::Ptr& getTemplate();
 
+    // Returns the expression the editor image is generated from, which is the
+    // qer_editorimage or the first suitable stage. Might be empty.
+    MapExpressionPtr getEditorImageSource();
+
 private:
     void ensureTemplateCopy();
     void subscribeToTemplateChanges();
@@ -2,6 +2,7 @@
 
 #include "itextstream.h"
 #include "imodule.h"
+#include "ithreadpool.h"
 
 #include <iostream>
 
@@ -14,6 +15,7 @@
 #include "scene/textures/TextureManipulator.h"
 #include "string/predicate.h"
 #include "ShaderTemplate.h"
+#include "MaterialManager.h"
 
 /* CONSTANTS */
 namespace
@@ -38,6 +40,51 @@ namespace
     {
         return module::GlobalModuleRegistry().getApplicationContext().getBitmapsPath();
     }
+
+    // Mean of the two values, rounded half to even like lrint((a + b) * 0.5)
+    inline byte getRoundedMean(int a, int b)
+    {
+        int sum = a + b;
+        return static_cast<byte>((sum + ((sum >> 1) & 1)) >> 1);
+    }
+
+    // Invokes the function for every pixel of the input and the corresponding output pixel,
+    // the rows are distributed across the thread pool
+    template<typename PixelFunction>
+    void transformPixels(const Image& input, Image& output, const PixelFunction& function)
+    {
+        auto width = input.getWidth();
+
+        GlobalThreadPool().parallelFor(0, input.getHeight(), [&](std::size_t y)
+        {
+            const byte* in = input.getPixels() + y * width * 4;
+            byte* out = output.getPixels() + y * width * 4;
+
+            for (std::size_t x = 0; x < width; ++x, in += 4, out += 4)
+            {
+                function(in, out);
+            }
+        });
+    }
+
+    // Same as transformPixels, for two input images of the same size
+    template<typename PixelFunction>
+    void combinePixels(const Image& first, const Image& second, Image& output, const PixelFunction& function)
+    {
+        auto width = first.getWidth();
+
+        GlobalThreadPool().parallelFor(0, first.getHeight(), [&](std::size_t y)
+        {
+            const byte* one = first.getPixels() + y * width * 4;
+            const byte* two = second.getPixels() + y * width * 4;
+            byte* out = output.getPixels() + y * width * 4;
+
+            for (std::size_t x = 0; x < width; ++x, one += 4, two += 4, out += 4)
+            {
+                function(one, two, out);
+            }
+        });
+    }
 }
 
 namespace shaders
@@ -135,6 +182,35 @@ ImagePtr MapExpression::getResampled(const ImagePtr& input, std::size_t width, s
     }
 }
 
+ImagePtr MapExpression::getCachedImage(const MapExpression& expression)
+{
+    return GetShaderSystem()->getMapExpressionCache().get(expression.getIdentifier(), [&]()
+    {
+        return expression.createImage();
+    });
+}
+
+bool MapExpression::getCachedImages(const MapExpression& first, const MapExpression& second,
+    ImagePtr& firstImage, ImagePtr& secondImage)
+{
+    // The second operand is evaluated on the pool while this thread is working on the first
+    auto secondResult = threading::runAsync([&second]() { return getCachedImage(second); });
+
+    try
+    {
+        firstImage = getCachedImage(first);
+    }
+    catch (...)
+    {
+        secondResult.wait();
+        throw;
+    }
+
+    secondImage = secondResult.get();
+
+    return firstImage && secondImage;
+}
+
 HeightMapExpression::HeightMapExpression (DefTokeniser& token) {
     token.assertNextToken("(");
     heightMapExp = createForToken(token);
@@ -143,10 +219,10 @@ HeightMapExpression::HeightMapExpression (DefTokeniser& token) {
     token.assertNextToken(")");
 }
 
-ImagePtr HeightMapExpression::getImage() const
+ImagePtr HeightMapExpression::createImage() const
 {
     // Get the heightmap from the contained expression
-    ImagePtr heightMap = heightMapExp->getImage();
+    ImagePtr heightMap = getCachedImage(*heightMapExp);
 
     if (heightMap == NULL) return ImagePtr();
 
@@ -172,6 +248,11 @@ std::string HeightMapExpression::getExpressionString()
     return fmt::format("heightmap({0}, {1})", heightMapExp->getExpressionString(), scale);
 }
 
+void HeightMapExpression::foreachImage(const std::function<void(const std::string&)>& functor) const
+{
+    heightMapExp->foreachImage(functor);
+}
+
 AddNormalsExpression::AddNormalsExpression (DefTokeniser& token) {
     token.assertNextToken("(");
     mapExpOne = createForToken(token);
@@ -180,17 +261,12 @@ AddNormalsExpression::AddNormalsExpression (DefTokeniser& token) {
     token.assertNextToken(")");
 }
 
-ImagePtr AddNormalsExpression::getImage() const {
-    ImagePtr imgOne = mapExpOne->getImage();
-
-    if (imgOne == NULL) return ImagePtr();
-
-    std::size_t width = imgOne->getWidth();
-    std::size_t height = imgOne->getHeight();
-
-    ImagePtr imgTwo = mapExpTwo->getImage();
+ImagePtr AddNormalsExpression::createImage() const
+{
+    ImagePtr imgOne;
+    ImagePtr imgTwo;
 
-    if (imgTwo == NULL) return ImagePtr();
+    if (!getCachedImages(*mapExpOne, *mapExpTwo, imgOne, imgTwo)) return ImagePtr();
 
     // Don't process precompressed images
     if (imgOne->isPrecompressed() || imgTwo->isPrecompressed()) {
@@ -199,44 +275,19 @@ ImagePtr AddNormalsExpression::getImage() const {
     }
 
     // The image must match the dimensions of the first
-    imgTwo = getResampled(imgTwo, width, height);
-
-    ImagePtr result (new image::RGBAImage(width, height));
+    imgTwo = getResampled(imgTwo, imgOne->getWidth(), imgOne->getHeight());
 
-    byte* pixOne = imgOne->getPixels();
-    byte* pixTwo = imgTwo->getPixels();
-    byte* pixOut = result->getPixels();
+    auto result = std::make_shared<image::RGBAImage>(imgOne->getWidth(), imgOne->getHeight());
 
-    // iterate through the pixels
-    for( std::size_t y = 0; y < height; y++ )
+    // Take the mean value of the two vectors
+    combinePixels(*imgOne, *imgTwo, *result, [](const byte* one, const byte* two, byte* out)
     {
-        for( std::size_t x = 0; x < width; x++ )
-        {
-            // create the two vectors
-            Vector3 vectorOne(
-                static_cast<double>(pixOne[0]),
-                static_cast<double>(pixOne[1]),
-                static_cast<double>(pixOne[2])
-            );
-            Vector3 vectorTwo(
-                static_cast<double>(pixTwo[0]),
-                static_cast<double>(pixTwo[1]),
-                static_cast<double>(pixTwo[2])
-            );
-            // Take the mean value of the two vectors
-            Vector3 vectorOut = (vectorOne + vectorTwo) * 0.5;
-
-            pixOut[0] = static_cast<byte>(float_to_integer(vectorOut.x()));
-            pixOut[1] = static_cast<byte>(float_to_integer(vectorOut.y()));
-            pixOut[2] = static_cast<byte>(float_to_integer(vectorOut.z()));
-            pixOut[3] = 255;
-
-            // advance the pixel pointer
-            pixOne += 4;
-            pixTwo += 4;
-            pixOut += 4;
-        }
-    }
+        out[0] = getRoundedMean(one[0], two[0]);
+        out[1] = getRoundedMean(one[1], two[1]);
+        out[2] = getRoundedMean(one[2], two[2]);
+        out[3] = 255;
+    });
+
     return result;
 }
 
@@ -251,15 +302,21 @@ std::string AddNormalsExpression::getExpressionString()
     return fmt::format("addnormals({0}, {1})", mapExpOne->getExpressionString(), mapExpTwo->getExpressionString());
 }
 
+void AddNormalsExpression::foreachImage(const std::function<void(const std::string&)>& functor) const
+{
+    mapExpOne->foreachImage(functor);
+    mapExpTwo->foreachImage(functor);
+}
+
 SmoothNormalsExpression::SmoothNormalsExpression (DefTokeniser& token) {
     token.assertNextToken("(");
     mapExp = createForToken(token);
     token.assertNextToken(")");
 }
 
-ImagePtr SmoothNormalsExpression::getImage() const {
-
-    ImagePtr normalMap = mapExp->getImage();
+ImagePtr SmoothNormalsExpression::createImage() const
+{
+    ImagePtr normalMap = getCachedImage(*mapExp);
 
     if (normalMap == NULL) return ImagePtr();
 
@@ -272,58 +329,42 @@ ImagePtr SmoothNormalsExpression::getImage() const {
     std::size_t width = normalMap->getWidth();
     std::size_t height = normalMap->getHeight();
 
-    ImagePtr result (new image::RGBAImage(width, height));
+    auto result = std::make_shared<image::RGBAImage>(width, height);
 
     byte* in = normalMap->getPixels();
     byte* out = result->getPixels();
 
-    struct KernelElement {
-        // offset to the current pixel
-        int dx, dy;
-    };
-
-    // a 3x3 kernel with the surrounding pixels including the pixel itself
-    const int kernelSize = 9;
-    KernelElement kernel[kernelSize] = {
-        {-1, -1 },
-        { 0, -1 },
-        { 1, -1 },
-        { 1,  0 },
-        { 1,  1 },
-        { 0,  1 },
-        {-1,  1 },
-        {-1,  0 },
-        { 0,  0 }
-    };
-    const float perKernelSize = 1.0f/kernelSize;
-
-    // iterate through the pixels
-    for( std::size_t y = 0; y < height; y++) {
-        for( std::size_t x = 0; x < width; x++) {
-            //the new normal vector for this pixel
-            Vector3 smoothVector(0,0,0);
-
-            // calculate the average direction of the surrounding vectors
-            for (KernelElement* i = kernel; i != kernel + kernelSize; ++i) {
-                // temporary vector to represent one of the surrounding pixels
-                byte* pixel = getPixel(in, width, height, x + i->dx, y + i->dy);
-                Vector3 temp(pixel[0], pixel[1], pixel[2]);
-
-                smoothVector += temp;
-            }
+    // Average the normal vectors of the 3x3 neighbourhood, including the pixel itself,
+    // wrapping around at the image borders
+    const double perKernelSize = 1.0f / 9;
 
-            // Take the average normal vector as result
-            smoothVector *= perKernelSize;
+    GlobalThreadPool().parallelFor(0, height, [&](std::size_t y)
+    {
+        byte* outPixel = out + y * width * 4;
 
-            out[0] = static_cast<byte>(float_to_integer(smoothVector.x()));
-            out[1] = static_cast<byte>(float_to_integer(smoothVector.y()));
-            out[2] = static_cast<byte>(float_to_integer(smoothVector.z()));
-            out[3] = 255;
+        for (std::size_t x = 0; x < width; x++, outPixel += 4)
+        {
+            int sum[3] = { 0, 0, 0 };
+
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    byte* pixel = getPixel(in, width, height, x + dx, y + dy);
+
+                    sum[0] += pixel[0];
+                    sum[1] += pixel[1];
+                    sum[2] += pixel[2];
+                }
+            }
 
-            // advance the pixel pointer
-            out += 4;
+            outPixel[0] = static_cast<byte>(float_to_integer(sum[0] * perKernelSize));
+            outPixel[1] = static_cast<byte>(float_to_integer(sum[1] * perKernelSize));
+            outPixel[2] = static_cast<byte>(float_to_integer(sum[2] * perKernelSize));
+            outPixel[3] = 255;
         }
-    }
+    });
+
     return result;
 }
 
@@ -338,6 +379,11 @@ std::string SmoothNormalsExpression::getExpressionString()
     return fmt::format("smoothnormals({0})", mapExp->getExpressionString());
 }
 
+void SmoothNormalsExpression::foreachImage(const std::function<void(const std::string&)>& functor) const
+{
+    mapExp->foreachImage(functor);
+}
+
 AddExpression::AddExpression (DefTokeniser& token) {
     token.assertNextToken("(");
     mapExpOne = createForToken(token);
@@ -346,17 +392,12 @@ AddExpression::AddExpression (DefTokeniser& token) {
     token.assertNextToken(")");
 }
 
-ImagePtr AddExpression::getImage() const {
-    ImagePtr imgOne = mapExpOne->getImage();
-
-    if (imgOne == NULL) return ImagePtr();
-
-    std::size_t width = imgOne->getWidth();
-    std::size_t height = imgOne->getHeight();
-
-    ImagePtr imgTwo = mapExpTwo->getImage();
+ImagePtr AddExpression::createImage() const
+{
+    ImagePtr imgOne;
+    ImagePtr imgTwo;
 
-    if (imgTwo == NULL) return ImagePtr();
+    if (!getCachedImages(*mapExpOne, *mapExpTwo, imgOne, imgTwo)) return ImagePtr();
 
     // Don't process precompressed images
     if (imgOne->isPrecompressed() || imgTwo->isPrecompressed()) {
@@ -365,31 +406,19 @@ ImagePtr AddExpression::getImage() const {
     }
 
     // Resize the image to match the dimensions of the first
-    imgTwo = getResampled(imgTwo, width, height);
-
-    ImagePtr result (new image::RGBAImage(width, height));
+    imgTwo = getResampled(imgTwo, imgOne->getWidth(), imgOne->getHeight());
 
-    byte* pixOne = imgOne->getPixels();
-    byte* pixTwo = imgTwo->getPixels();
-    byte* pixOut = result->getPixels();
+    auto result = std::make_shared<image::RGBAImage>(imgOne->getWidth(), imgOne->getHeight());
 
-    // iterate through the pixels
-    for( std::size_t y = 0; y < height; y++)
+    // add the colors
+    combinePixels(*imgOne, *imgTwo, *result, [](const byte* one, const byte* two, byte* out)
     {
-        for( std::size_t x = 0; x < width; x++)
-        {
-            // add the colors
-            pixOut[0] = static_cast<byte>(float_to_integer((static_cast<float>(pixOne[0]) + pixTwo[0]) * 0.5f));
-            pixOut[1] = static_cast<byte>(float_to_integer((static_cast<float>(pixOne[1]) + pixTwo[1]) * 0.5f));
-            pixOut[2] = static_cast<byte>(float_to_integer((static_cast<float>(pixOne[2]) + pixTwo[2]) * 0.5f));
-            pixOut[3] = static_cast<byte>(float_to_integer((static_cast<float>(pixOne[3]) + pixTwo[3]) * 0.5f));
-
-            //advance the pixel pointer
-            pixOne += 4;
-            pixTwo += 4;
-            pixOut += 4;
-        }
-    }
+        out[0] = getRoundedMean(one[0], two[0]);
+        out[1] = getRoundedMean(one[1], two[1]);
+        out[2] = getRoundedMean(one[2], two[2]);
+        out[3] = getRoundedMean(one[3], two[3]);
+    });
+
     return result;
 }
 
@@ -405,6 +434,12 @@ std::string AddExpression::getExpressionString()
     return fmt::format("add({0}, {1})", mapExpOne->getExpressionString(), mapExpTwo->getExpressionString());
 }
 
+void AddExpression::foreachImage(const std::function<void(const std::string&)>& functor) const
+{
+    mapExpOne->foreachImage(functor);
+    mapExpTwo->foreachImage(functor);
+}
+
 ScaleExpression::ScaleExpression(DefTokeniser& token) :
     scaleGreen(0),
     scaleBlue(0),
@@ -429,9 +464,9 @@ ScaleExpression::ScaleExpression(DefTokeniser& token) :
     token.assertNextToken(")");
 }
 
-ImagePtr ScaleExpression::getImage() const
+ImagePtr ScaleExpression::createImage() const
 {
-    ImagePtr img = mapExp->getImage();
+    ImagePtr img = getCachedImage(*mapExp);
 
     if (img == NULL) return ImagePtr();
 
@@ -441,42 +476,25 @@ ImagePtr ScaleExpression::getImage() const
         return img;
     }
 
-    std::size_t width = img->getWidth();
-    std::size_t height = img->getHeight();
-
     if (scaleRed < 0 || scaleGreen < 0 || scaleBlue < 0 || scaleAlpha < 0) {
         rWarning() << "[shaders] ScaleExpression: Invalid scale values found." << std::endl;
         return img;
     }
 
-    ImagePtr result (new image::RGBAImage(width, height));
+    auto result = std::make_shared<image::RGBAImage>(img->getWidth(), img->getHeight());
 
-    byte* in = img->getPixels();
-    byte* out = result->getPixels();
+    const float scale[4] = { scaleRed, scaleGreen, scaleBlue, scaleAlpha };
 
-    // iterate through the pixels
-    for( std::size_t y = 0; y < height; ++y)
+    transformPixels(*img, *result, [&](const byte* in, byte* out)
     {
-        for( std::size_t x = 0; x < width; ++x)
+        for (int c = 0; c < 4; ++c)
         {
-            // prevent negative values and check for values >255
-            int red = float_to_integer(static_cast<float>(in[0]) * scaleRed);
-            out[0] = (red>255) ? 255 : static_cast<byte>(red);
-
-            int green = float_to_integer(static_cast<float>(in[1]) * scaleGreen);
-            out[1] = (green>255) ? 255 : static_cast<byte>(green);
-
-            int blue = float_to_integer(static_cast<float>(in[2]) * scaleBlue);
-            out[2] = (blue>255) ? 255 : static_cast<byte>(blue);
-
-            int alpha = float_to_integer(static_cast<float>(in[3]) * scaleAlpha);
-            out[3] = (alpha>255) ? 255 : static_cast<byte>(alpha);
-
-            // advance the pixel pointer
-            in += 4;
-            out += 4;
+            // prevent values >255, the scales are not negative
+            int value = float_to_integer(static_cast<float>(in[c]) * scale[c]);
+            out[c] = (value > 255) ? 255 : static_cast<byte>(value);
         }
-    }
+    });
+
     return result;
 }
 
@@ -495,14 +513,20 @@ std::string ScaleExpression::getExpressionString()
     return fmt::format("scale({0}, {1}{2}{3}{4})", mapExp->getExpressionString(), scaleRed, scaleGreenStr, scaleBlueStr, scaleAlphaStr);
 }
 
+void ScaleExpression::foreachImage(const std::function<void(const std::string&)>& functor) const
+{
+    mapExp->foreachImage(functor);
+}
+
 InvertAlphaExpression::InvertAlphaExpression (DefTokeniser& token) {
     token.assertNextToken("(");
     mapExp = createForToken(token);
     token.assertNextToken(")");
 }
 
-ImagePtr InvertAlphaExpression::getImage() const {
-    ImagePtr img = mapExp->getImage();
+ImagePtr InvertAlphaExpression::createImage() const
+{
+    ImagePtr img = getCachedImage(*mapExp);
 
     if (img == NULL) return ImagePtr();
 
@@ -512,29 +536,15 @@ ImagePtr InvertAlphaExpression::getImage() const {
         return img;
     }
 
-    std::size_t width = img->getWidth();
-    std::size_t height = img->getHeight();
-
-    ImagePtr result (new image::RGBAImage(width, height));
+    auto result = std::make_shared<image::RGBAImage>(img->getWidth(), img->getHeight());
 
-    byte* in = img->getPixels();
-    byte* out = result->getPixels();
-
-    // iterate through the pixels
-    for( std::size_t y = 0; y < height; ++y)
+    transformPixels(*img, *result, [](const byte* in, byte* out)
     {
-        for( std::size_t x = 0; x < width; ++x)
-        {
-            out[0] = in[0];
-            out[1] = in[1];
-            out[2] = in[2];
-            out[3] = 255 - in[3];
-
-            // advance the pixel pointer
-            in += 4;
-            out += 4;
-        }
-    }
+        out[0] = in[0];
+        out[1] = in[1];
+        out[2] = in[2];
+        out[3] = 255 - in[3];
+    });
 
     return result;
 }
@@ -550,14 +560,20 @@ std::string InvertAlphaExpression::getExpressionString()
     return fmt::format("invertAlpha({0})", mapExp->getExpressionString());
 }
 
+void InvertAlphaExpression::foreachImage(const std::function<void(const std::string&)>& functor) const
+{
+    mapExp->foreachImage(functor);
+}
+
 InvertColorExpression::InvertColorExpression (DefTokeniser& token) {
     token.assertNextToken("(");
     mapExp = createForToken(token);
     token.assertNextToken(")");
 }
 
-ImagePtr InvertColorExpression::getImage() const {
-    ImagePtr img = mapExp->getImage();
+ImagePtr InvertColorExpression::createImage() const
+{
+    ImagePtr img = getCachedImage(*mapExp);
 
     if (img == NULL) return ImagePtr();
 
@@ -567,27 +583,15 @@ ImagePtr InvertColorExpression::getImage() const {
         return img;
     }
 
-    std::size_t width = img->getWidth();
-    std::size_t height = img->getHeight();
-
-    ImagePtr result (new image::RGBAImage(width, height));
-
-    byte* in = img->getPixels();
-    byte* out = result->getPixels();
+    auto result = std::make_shared<image::RGBAImage>(img->getWidth(), img->getHeight());
 
-    // iterate through the pixels
-    for( std::size_t y = 0; y < height; y++) {
-        for( std::size_t x = 0; x < width; x++) {
-            out[0] = 255 - in[0];
-            out[1] = 255 - in[1];
-            out[2] = 255 - in[2];
-            out[3] = in[3];
-
-            // advance the pixel pointer
-            in += 4;
-            out += 4;
-        }
-    }
+    transformPixels(*img, *result, [](const byte* in, byte* out)
+    {
+        out[0] = 255 - in[0];
+        out[1] = 255 - in[1];
+        out[2] = 255 - in[2];
+        out[3] = in[3];
+    });
 
     return result;
 }
@@ -603,14 +607,20 @@ std::string InvertColorExpression::getExpressionString()
     return fmt::format("invertColor({0})", mapExp->getExpressionString());
 }
 
+void InvertColorExpression::foreachImage(const std::function<void(const std::string&)>& functor) const
+{
+    mapExp->foreachImage(functor);
+}
+
 MakeIntensityExpression::MakeIntensityExpression (DefTokeniser& token) {
     token.assertNextToken("(");
     mapExp = createForToken(token);
     token.assertNextToken(")");
 }
 
-ImagePtr MakeIntensityExpression::getImage() const {
-    ImagePtr img = mapExp->getImage();
+ImagePtr MakeIntensityExpression::createImage() const
+{
+    ImagePtr img = getCachedImage(*mapExp);
 
     if (img == NULL) return ImagePtr();
 
@@ -620,29 +630,15 @@ ImagePtr MakeIntensityExpression::getImage() const {
         return img;
     }
 
-    std::size_t width = img->getWidth();
-    std::size_t height = img->getHeight();
-
-    ImagePtr result (new image::RGBAImage(width, height));
+    auto result = std::make_shared<image::RGBAImage>(img->getWidth(), img->getHeight());
 
-    byte* in = img->getPixels();
-    byte* out = result->getPixels();
-
-    // iterate through the pixels
-    for( std::size_t y = 0; y < height; ++y)
+    transformPixels(*img, *result, [](const byte* in, byte* out)
     {
-        for( std::size_t x = 0; x < width; ++x)
-        {
-            out[0] = in[0];
-            out[1] = in[0];
-            out[2] = in[0];
-            out[3] = in[0];
-
-            // advance the pixel pointer
-            in += 4;
-            out += 4;
-        }
-    }
+        out[0] = in[0];
+        out[1] = in[0];
+        out[2] = in[0];
+        out[3] = in[0];
+    });
 
     return result;
 }
@@ -659,6 +655,11 @@ std::string MakeIntensityExpression::getExpressionString()
     return fmt::format("makeIntensity({0})", mapExp->getExpressionString());
 }
 
+void MakeIntensityExpression::foreachImage(const std::function<void(const std::string&)>& functor) const
+{
+    mapExp->foreachImage(functor);
+}
+
 MakeAlphaExpression::MakeAlphaExpression(DefTokeniser& token)
 {
     token.assertNextToken("(");
@@ -666,9 +667,9 @@ MakeAlphaExpression::MakeAlphaExpression(DefTokeniser& token)
     token.assertNextToken(")");
 }
 
-ImagePtr MakeAlphaExpression::getImage() const
+ImagePtr MakeAlphaExpression::createImage() const
 {
-    ImagePtr img = mapExp->getImage();
+    ImagePtr img = getCachedImage(*mapExp);
 
     if (img == NULL) return ImagePtr();
 
@@ -678,29 +679,15 @@ ImagePtr MakeAlphaExpression::getImage() const
         return img;
     }
 
-    std::size_t width = img->getWidth();
-    std::size_t height = img->getHeight();
+    auto result = std::make_shared<image::RGBAImage>(img->getWidth(), img->getHeight());
 
-    ImagePtr result (new image::RGBAImage(width, height));
-
-    byte* in = img->getPixels();
-    byte* out = result->getPixels();
-
-    // iterate through the pixels
-    for( std::size_t y = 0; y < height; y++)
+    transformPixels(*img, *result, [](const byte* in, byte* out)
     {
-        for( std::size_t x = 0; x < width; x++)
-        {
-            out[0] = 255;
-            out[1] = 255;
-            out[2] = 255;
-            out[3] = (in[0] + in[1] + in[2])/3;
-
-            // advance the pixel pointer
-            in += 4;
-            out += 4;
-        }
-    }
+        out[0] = 255;
+        out[1] = 255;
+        out[2] = 255;
+        out[3] = (in[0] + in[1] + in[2])/3;
+    });
 
     return result;
 }
@@ -717,6 +704,11 @@ std::string MakeAlphaExpression::getExpressionString()
     return fmt::format("makeAlpha({0})", mapExp->getExpressionString());
 }
 
+void MakeAlphaExpression::foreachImage(const std::function<void(const std::string&)>& functor) const
+{
+    mapExp->foreachImage(functor);
+}
+
 /* ImageExpression */
 
 ImageExpression::ImageExpression(const std::string& imgName) :
@@ -727,6 +719,11 @@ ImageExpression::ImageExpression(const std::string& imgName) :
 }
 
 ImagePtr ImageExpression::getImage() const
+{
+    return createImage();
+}
+
+ImagePtr ImageExpression::createImage() const
 {
     // Check for some image keywords and load the correct file
     if (_imgName == "_black") {
@@ -816,4 +813,9 @@ std::string ImageExpression::getExpressionString()
     return _imgName;
 }
 
+void ImageExpression::foreachImage(const std::function<void(const std::string&)>& functor) const
+{
+    functor(_imgName);
+}
+
 } // namespace shaders
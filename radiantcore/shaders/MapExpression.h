@@ -2,6 +2,7 @@
 
 #include <string>
 
+#include <functional>
 #include <memory>
 
 #include "ishaderexpression.h"
@@ -46,8 +47,15 @@ public:
             return TexturePtr();
     }
 
-    // Abstract method to be implemented
-    virtual ImagePtr getImage() const = 0;
+    // Returns the image generated by this expression. The results are memoised
+    // by their identifier, the returned image must not be modified.
+    virtual ImagePtr getImage() const
+    {
+        return getCachedImage(*this);
+    }
+
+    // Invokes the functor with the name of every image this expression is built from
+    virtual void foreachImage(const std::function<void(const std::string&)>& functor) const = 0;
 
 public: /* STATIC CONSTRUCTION METHODS */
 
@@ -70,6 +78,16 @@ protected:
 	 * @returns: the resampled image, this might as well be input.
 	 */
 	static ImagePtr getResampled(const ImagePtr& input, std::size_t width, std::size_t height);
+
+    // Evaluates the expression, to be implemented by subclasses
+    virtual ImagePtr createImage() const = 0;
+
+    // Returns the image of the given (sub-)expression through the MapExpressionCache
+    static ImagePtr getCachedImage(const MapExpression& expression);
+
+    // Evaluates both expressions in parallel, returns false if any of them failed
+    static bool getCachedImages(const MapExpression& first, const MapExpression& second,
+        ImagePtr& firstImage, ImagePtr& secondImage);
 };
 
 // the specific MapExpressions
@@ -80,9 +98,12 @@ class HeightMapExpression :
 	float scale;
 public:
 	HeightMapExpression(DefTokeniser& token);
-	ImagePtr getImage() const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
+    void foreachImage(const std::function<void(const std::string&)>& functor) const override;
+
+protected:
+    ImagePtr createImage() const override;
 };
 
 class AddNormalsExpression :
@@ -92,9 +113,12 @@ class AddNormalsExpression :
 	MapExpressionPtr mapExpTwo;
 public:
 	AddNormalsExpression(DefTokeniser& token);
-	ImagePtr getImage() const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
+    void foreachImage(const std::function<void(const std::string&)>& functor) const override;
+
+protected:
+    ImagePtr createImage() const override;
 };
 
 class SmoothNormalsExpression :
@@ -103,9 +127,12 @@ class SmoothNormalsExpression :
 	MapExpressionPtr mapExp;
 public:
 	SmoothNormalsExpression(DefTokeniser& token);
-	ImagePtr getImage() const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
+    void foreachImage(const std::function<void(const std::string&)>& functor) const override;
+
+protected:
+    ImagePtr createImage() const override;
 };
 
 class AddExpression : public MapExpression {
@@ -113,9 +140,12 @@ class AddExpression : public MapExpression {
 	MapExpressionPtr mapExpTwo;
 public:
 	AddExpression(DefTokeniser& token);
-	ImagePtr getImage() const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
+    void foreachImage(const std::function<void(const std::string&)>& functor) const override;
+
+protected:
+    ImagePtr createImage() const override;
 };
 
 class ScaleExpression :
@@ -128,9 +158,12 @@ class ScaleExpression :
 	float scaleAlpha;
 public:
 	ScaleExpression(DefTokeniser& token);
-	ImagePtr getImage() const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
+    void foreachImage(const std::function<void(const std::string&)>& functor) const override;
+
+protected:
+    ImagePtr createImage() const override;
 };
 
 class InvertAlphaExpression :
@@ -139,9 +172,12 @@ class InvertAlphaExpression :
 	MapExpressionPtr mapExp;
 public:
 	InvertAlphaExpression(DefTokeniser& token);
-	ImagePtr getImage() const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
+    void foreachImage(const std::function<void(const std::string&)>& functor) const override;
+
+protected:
+    ImagePtr createImage() const override;
 };
 
 class InvertColorExpression :
@@ -150,9 +186,12 @@ class InvertColorExpression :
 	MapExpressionPtr mapExp;
 public:
 	InvertColorExpression(DefTokeniser& token);
-	ImagePtr getImage() const;
-	std::string getIdentifier() const;
+	std::string getIdentifier() const override;
     std::string getExpressionString() override;
+    void foreachImage(const std::function<void(const std::string&)>& functor) const override;
+
+protected:
+    ImagePtr createImage() const override;
 };
 
 class MakeIntensityExpression :
@@ -161,9 +200,12 @@ class MakeIntensityExpression :
 	MapExpressionPtr mapExp;
 public:
 	MakeIntensityExpression(DefTokeniser& token);
-	ImagePtr getImage() const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
+    void foreachImage(const std::function<void(const std::string&)>& functor) const override;
+
+protected:
+    ImagePtr createImage() const override;
 };
 
 class MakeAlphaExpression :
@@ -172,9 +214,12 @@ class MakeAlphaExpression :
 	MapExpressionPtr mapExp;
 public:
 	MakeAlphaExpression(DefTokeniser& token);
-	ImagePtr getImage() const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
+    void foreachImage(const std::function<void(const std::string&)>& functor) const override;
+
+protected:
+    ImagePtr createImage() const override;
 };
 
 /**
@@ -192,9 +237,14 @@ private:
 public:
 	ImageExpression(const std::string& imgName);
 
+    // Standalone images are not memoised, they're only cached as part of other expressions
 	ImagePtr getImage() const override;
 	std::string getIdentifier() const override;
     std::string getExpressionString() override;
+    void foreachImage(const std::function<void(const std::string&)>& functor) const override;
+
+protected:
+    ImagePtr createImage() const override;
 };
 
 } // namespace shaders
@@ -0,0 +1,133 @@
+#include "MapExpressionCache.h"
+
+namespace shaders
+{
+
+namespace
+{
+    std::size_t getImageSize(const Image& image)
+    {
+        if (image.isPrecompressed())
+        {
+            // Block compressed formats are using one byte per pixel or less
+            return image.getWidth() * image.getHeight();
+        }
+
+        return image.getWidth() * image.getHeight() * 4;
+    }
+}
+
+MapExpressionCache::MapExpressionCache(std::size_t capacity) :
+    _size(0),
+    _capacity(capacity),
+    _generation(0)
+{}
+
+ImagePtr MapExpressionCache::get(const std::string& identifier, const CreateFunction& create)
+{
+    std::promise<ImagePtr> promise;
+    std::size_t generation;
+
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+
+        auto existing = _entries.find(identifier);
+
+        if (existing != _entries.end())
+        {
+            if (existing->second.ready)
+            {
+                _lru.splice(_lru.begin(), _lru, existing->second.lruPosition);
+                return existing->second.image.get();
+            }
+
+            // Somebody else is evaluating this expression, wait for the result outside the lock
+            auto pending = existing->second.image;
+            lock.unlock();
+
+            return pending.get();
+        }
+
+        _entries[identifier].image = promise.get_future().share();
+        generation = _generation;
+    }
+
+    ImagePtr image;
+
+    try
+    {
+        image = create();
+    }
+    catch (...)
+    {
+        store(identifier, ImagePtr(), generation);
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    store(identifier, image, generation);
+    promise.set_value(image);
+
+    return image;
+}
+
+void MapExpressionCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    // Threads waiting for pending entries are holding a copy of the future
+    _entries.clear();
+    _lru.clear();
+    _size = 0;
+
+    ++_generation;
+}
+
+std::size_t MapExpressionCache::getSize()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _size;
+}
+
+void MapExpressionCache::store(const std::string& identifier, const ImagePtr& image, std::size_t generation)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    // The entry belongs to a newer evaluation if the cache has been cleared in the meantime
+    auto entry = _entries.find(identifier);
+
+    if (entry == _entries.end() || generation != _generation)
+    {
+        return;
+    }
+
+    // Failed evaluations are not cached, they might succeed after the files have changed
+    if (!image)
+    {
+        _entries.erase(entry);
+        return;
+    }
+
+    entry->second.ready = true;
+    entry->second.size = getImageSize(*image);
+    entry->second.lruPosition = _lru.insert(_lru.begin(), identifier);
+
+    _size += entry->second.size;
+
+    evictLeastRecentlyUsed();
+}
+
+void MapExpressionCache::evictLeastRecentlyUsed()
+{
+    // Keep the most recently used entry, even if it exceeds the capacity on its own
+    while (_size > _capacity && _lru.size() > 1)
+    {
+        auto entry = _entries.find(_lru.back());
+
+        _size -= entry->second.size;
+        _entries.erase(entry);
+        _lru.pop_back();
+    }
+}
+
+}
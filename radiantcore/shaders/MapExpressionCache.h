@@ -0,0 +1,67 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "iimage.h"
+
+namespace shaders
+{
+
+/**
+ * \brief
+ * Memoises the images produced by map expressions, keyed by their identifier,
+ * such that materials sharing a sub-expression like heightmap(foo_local, 4)
+ * evaluate it only once.
+ *
+ * The cached images are treated as immutable. The least recently used ones
+ * are discarded once the total size exceeds the capacity. Concurrent requests
+ * for the same identifier wait for the first one to finish evaluating.
+ */
+class MapExpressionCache
+{
+public:
+    using CreateFunction = std::function<ImagePtr()>;
+
+private:
+    struct Entry
+    {
+        std::shared_future<ImagePtr> image;
+        std::size_t size = 0;
+        bool ready = false;
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    std::mutex _lock;
+    std::unordered_map<std::string, Entry> _entries;
+
+    // Identifiers of the ready entries, the most recently used one first
+    std::list<std::string> _lru;
+
+    std::size_t _size;
+    std::size_t _capacity;
+
+    // Incremented by clear(), evaluations started before are not stored
+    std::size_t _generation;
+
+public:
+    MapExpressionCache(std::size_t capacity);
+
+    // Returns the cached image for the given identifier, or evaluates and stores it
+    ImagePtr get(const std::string& identifier, const CreateFunction& create);
+
+    // Removes all entries, the ones currently being evaluated are not stored afterwards
+    void clear();
+
+    // Total size of the cached pixel data in bytes
+    std::size_t getSize();
+
+private:
+    void store(const std::string& identifier, const ImagePtr& image, std::size_t generation);
+    void evictLeastRecentlyUsed();
+};
+
+}
@@ -7,6 +7,7 @@
 
 #include "iregistry.h"
 #include "icommandsystem.h"
+#include "ithreadpool.h"
 #include "ifilesystem.h"
 #include "ifiletypes.h"
 #include "igame.h"
@@ -37,7 +38,14 @@ namespace
 namespace shaders
 {
 
+namespace
+{
+    // Memory used by the memoised map expression images
+    constexpr std::size_t MAP_EXPRESSION_CACHE_SIZE = 256 << 20;
+}
+
 MaterialManager::MaterialManager() :
+    _mapExpressionCache(MAP_EXPRESSION_CACHE_SIZE),
     _enableActiveUpdates(true)
 {}
 
@@ -46,6 +54,13 @@ void MaterialManager::construct()
     _library = std::make_shared<ShaderLibrary>();
     _textureManager = std::make_shared<GLTextureManager>();
 
+    // Images are loaded on worker threads, which are all using the manipulator
+    _textureManip = std::make_unique<TextureManipulator>();
+
+    _thumbnailCache = std::make_unique<ThumbnailCache>(
+        module::GlobalModuleRegistry().getApplicationContext().getCacheDataPath() + "thumbnails/"
+    );
+
     // Add necessary preference pages
     IPreferencePage& page = GlobalPreferenceSystem().getPage("Textures");
 
@@ -59,6 +74,16 @@ void MaterialManager::construct()
     page.appendSpinner(
         "Texture Gamma", TextureManipulator::RKEY_TEXTURES_GAMMA, 0.0f, 1.0f, 10
     );
+
+    // Background loading
+    page.appendCheckBox(_("Load textures in the background"), TextureStreamer::RKEY_TEXTURE_STREAMING);
+    page.appendSpinner(
+        _("Texture upload time per frame (msec)"), TextureStreamer::RKEY_UPLOAD_BUDGET, 1.0f, 100.0f, 0
+    );
+    page.appendCheckBox(_("Compress textures (reduces video memory)"), TextureStreamer::RKEY_TEXTURE_COMPRESSION);
+    page.appendSpinner(
+        _("Texture memory budget (MB, 0 = unlimited)"), TextureStreamer::RKEY_MEMORY_BUDGET, 0.0f, 65536.0f, 0
+    );
 }
 
 void MaterialManager::destroy()
@@ -69,6 +94,7 @@ void MaterialManager::destroy()
 
 void MaterialManager::freeShaders() {
     _library->clear();
+    _mapExpressionCache.clear();
     _textureManager->checkBindings();
     activeShadersChangedNotify();
 }
@@ -113,13 +139,64 @@ GLTextureManager& MaterialManager::getTextureManager()
 
 TextureManipulator& MaterialManager::getTextureManipulator()
 {
-    // Construct on demand
-    if (!_textureManip) {
-        _textureManip = std::make_unique<TextureManipulator>();
-    }
     return *_textureManip;
 }
 
+MapExpressionCache& MaterialManager::getMapExpressionCache()
+{
+    return _mapExpressionCache;
+}
+
+bool MaterialManager::processTextureUploads()
+{
+    auto texturesPending = _textureManager->processUploads();
+    auto thumbnailsPending = _thumbnailCache->processUploads();
+
+    return texturesPending || thumbnailsPending;
+}
+
+TextureStreamingStatistics MaterialManager::getTextureStreamingStatistics()
+{
+    return _textureManager->getStreamingStatistics();
+}
+
+MaterialThumbnail MaterialManager::getMaterialThumbnail(const std::string& materialName, const void* view)
+{
+    return _thumbnailCache->getThumbnail(_library->findShader(materialName)->getEditorImageSource(), view);
+}
+
+MaterialThumbnail MaterialManager::findMaterialThumbnail(const std::string& materialName)
+{
+    return _thumbnailCache->findThumbnail(_library->findShader(materialName)->getEditorImageSource());
+}
+
+void MaterialManager::beginThumbnailFrame(const void* view)
+{
+    _thumbnailCache->beginFrame(view);
+}
+
+void MaterialManager::releaseThumbnailView(const void* view)
+{
+    // Views might be destroyed after the module has been shut down
+    if (_thumbnailCache)
+    {
+        _thumbnailCache->releaseView(view);
+    }
+}
+
+void MaterialManager::printTextureStatistics()
+{
+    auto stats = getTextureStreamingStatistics();
+
+    rMessage() << "Uploaded textures: " << stats.uploadedTextures
+        << ", estimated memory: " << (stats.textureMemory >> 20) << " MB" << std::endl;
+    rMessage() << "Memory budget: " << (stats.textureMemoryBudget > 0 ?
+        std::to_string(stats.textureMemoryBudget >> 20) + " MB" : std::string("unlimited"))
+        << ", evicted textures: " << stats.evictedTextures << std::endl;
+    rMessage() << "Pending decodes: " << stats.pendingDecodes
+        << ", pending uploads: " << stats.pendingUploads << std::endl;
+}
+
 // Get default textures
 TexturePtr MaterialManager::getDefaultInteractionTexture(IShaderLayer::Type type)
 {
@@ -288,6 +365,10 @@ ITableDefinition::Ptr MaterialManager::getTable(const std::string& name)
 
 void MaterialManager::reloadImages()
 {
+    // The images might have changed on disk
+    _mapExpressionCache.clear();
+    _thumbnailCache->clear();
+
     _library->foreachShader([](const CShaderPtr& shader)
     {
         shader->refreshImageMaps();
@@ -311,6 +392,7 @@ StringSet MaterialManager::getDependencies() const
         MODULE_GAMEMANAGER,
         MODULE_FILETYPES,
         MODULE_PREFERENCESYSTEM,
+        MODULE_THREADPOOL,
     };
 
     return _dependencies;
@@ -345,6 +427,9 @@ void MaterialManager::initialiseModule(const IApplicationContext& ctx)
     GlobalCommandSystem().addCommand("ReloadImages", [this](const cmd::ArgumentList&) {
         reloadImages();
     });
+    GlobalCommandSystem().addCommand("PrintTextureStatistics", [this](const cmd::ArgumentList&) {
+        printTextureStatistics();
+    });
 }
 
 void MaterialManager::onMaterialDefsReloaded()
@@ -362,6 +447,9 @@ void MaterialManager::shutdownModule()
     rMessage() << "MaterialManager::shutdownModule called" << std::endl;
 
     destroy();
+    _textureManager->cancelStreaming();
+    _thumbnailCache.reset();
+    _mapExpressionCache.clear();
     _library->clear();
     _library.reset();
 }
@@ -7,6 +7,8 @@
 
 #include "ShaderLibrary.h"
 #include "textures/GLTextureManager.h"
+#include "MapExpressionCache.h"
+#include "textures/ThumbnailCache.h"
 
 namespace shaders
 {
@@ -24,6 +26,12 @@ class MaterialManager: public IMaterialManager
     // The singleton which manages resizing of textures
     std::unique_ptr<TextureManipulator> _textureManip;
 
+    // Memoised map expression results, shared by all materials
+    MapExpressionCache _mapExpressionCache;
+
+    // Downscaled editor images for the texture browsers
+    std::unique_ptr<ThumbnailCache> _thumbnailCache;
+
     // Active shaders list changed signal
     sigc::signal<void> _signalActiveShadersChanged;
 
@@ -76,6 +84,9 @@ public:
     /// Return the texture manipulator
     TextureManipulator& getTextureManipulator() override;
 
+    /// Return the cache of the evaluated map expressions
+    MapExpressionCache& getMapExpressionCache();
+
     // Get default textures for D,B,S layers
     TexturePtr getDefaultInteractionTexture(IShaderLayer::Type t) override;
 
@@ -93,6 +104,13 @@ public:
 
     void reloadImages() override;
 
+    bool processTextureUploads() override;
+    TextureStreamingStatistics getTextureStreamingStatistics() override;
+    MaterialThumbnail getMaterialThumbnail(const std::string& materialName, const void* view) override;
+    MaterialThumbnail findMaterialThumbnail(const std::string& materialName) override;
+    void beginThumbnailFrame(const void* view) override;
+    void releaseThumbnailView(const void* view) override;
+
 public:
     sigc::signal<void> signal_activeShadersChanged() const override;
 
@@ -111,6 +129,9 @@ private:
     void freeShaders();
 
     void onMaterialDefsReloaded();
+
+    // Command target writing the texture memory usage to the console
+    void printTextureStatistics();
 };
 
 typedef std::shared_ptr<MaterialManager> MaterialManagerPtr;
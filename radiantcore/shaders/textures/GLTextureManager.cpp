@@ -13,6 +13,8 @@ namespace shaders {
 
 void GLTextureManager::checkBindings()
 {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
     // Check the TextureMap for unique pointers and release them
     // as they aren't used by anyone else than this class.
     for (TextureMap::iterator i = _textures.begin();
@@ -43,6 +45,8 @@ TexturePtr GLTextureManager::getBinding(const NamedBindablePtr& bindable,
         return getShaderNotFound();
     }
 
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
     // Check if we already have the texture, otherwise construct it
     auto identifier = bindable->getIdentifier();
     auto existing = _textures.find(identifier);
@@ -52,6 +56,22 @@ TexturePtr GLTextureManager::getBinding(const NamedBindablePtr& bindable,
         return existing->second;
     }
 
+    // Images of map expressions can be loaded in the background, the texture
+    // is bound to a placeholder until then. The streamer is keeping track of
+    // their memory usage, so they're going through it in either case.
+    if (auto expression = std::dynamic_pointer_cast<MapExpression>(bindable); expression)
+    {
+        auto texture = _streamer.requestTexture(identifier, expression, role, getShaderNotFound());
+
+        if (!_streamer.isEnabled())
+        {
+            _streamer.finishLoading(texture);
+        }
+
+        _textures.emplace(identifier, texture);
+        return texture;
+    }
+
     // Create and insert texture object, if it is valid
     auto texture = bindable->bindTexture(identifier, role);
     if (texture)
@@ -66,6 +86,8 @@ TexturePtr GLTextureManager::getBinding(const NamedBindablePtr& bindable,
 
 TexturePtr GLTextureManager::getBinding(const std::string& fullPath)
 {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
     // check if the texture has to be loaded
     TextureMap::iterator i = _textures.find(fullPath);
 
@@ -97,12 +119,15 @@ void GLTextureManager::clearCacheForBindable(const NamedBindablePtr& bindable)
 {
     if (!bindable) return;
 
+    std::lock_guard<std::recursive_mutex> lock(_lock);
     _textures.erase(bindable->getIdentifier());
 }
 
 // Return the shader-not-found texture, loading if necessary
 TexturePtr GLTextureManager::getShaderNotFound()
 {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
     // Construct the texture if necessary
     if (!_shaderNotFound) {
         _shaderNotFound = loadStandardTexture(SHADER_NOT_FOUND);
@@ -112,6 +137,32 @@ TexturePtr GLTextureManager::getShaderNotFound()
     return _shaderNotFound;
 }
 
+bool GLTextureManager::isShaderNotFound(const TexturePtr& texture)
+{
+    if (texture == getShaderNotFound())
+    {
+        return true;
+    }
+
+    auto streamedTexture = std::dynamic_pointer_cast<StreamedTexture>(texture);
+    return streamedTexture && streamedTexture->hasFailed();
+}
+
+bool GLTextureManager::processUploads()
+{
+    return _streamer.processUploads();
+}
+
+TextureStreamingStatistics GLTextureManager::getStreamingStatistics()
+{
+    return _streamer.getStatistics();
+}
+
+void GLTextureManager::cancelStreaming()
+{
+    _streamer.cancelPendingDecodes();
+}
+
 TexturePtr GLTextureManager::loadStandardTexture(const std::string& filename)
 {
     // Create the texture path
@@ -3,14 +3,20 @@
 
 #include "ishaders.h"
 #include <map>
+#include <mutex>
 #include "../MapExpression.h"
 #include "texturelib.h"
+#include "TextureStreamer.h"
 
 namespace shaders
 {
 
 class GLTextureManager
 {
+	// Guards the texture map and the fallback texture, materials might
+	// be asking for their images from worker threads
+	std::recursive_mutex _lock;
+
 	// The mapping between texturekeys and Texture instances
 	typedef std::map<std::string, TexturePtr> TextureMap;
 	TextureMap _textures;
@@ -18,6 +24,9 @@ class GLTextureManager
 	// The fallback textures in case a texture is empty or broken
 	TexturePtr _shaderNotFound;
 
+	// Loads the images of map expressions in the background
+	TextureStreamer _streamer;
+
 private:
 
 	// Constructs the fallback textures like "Shader Image Missing"
@@ -47,6 +56,18 @@ public:
      */
 	TexturePtr getShaderNotFound();
 
+	// True if the given texture is the "shader not found" texture, or a
+	// streamed texture which failed to load (waits for it to be decoded)
+	bool isShaderNotFound(const TexturePtr& texture);
+
+	// Uploads the textures decoded in the background, see IMaterialManager
+	bool processUploads();
+
+	TextureStreamingStatistics getStreamingStatistics();
+
+	// Stops loading any textures in the background
+	void cancelStreaming();
+
 	/* greebo: This is some sort of "cleanup" call, which causes
 	 * the TextureManager to go through the list of textures and
 	 * remove the unused ones.
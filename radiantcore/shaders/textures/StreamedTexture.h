@@ -0,0 +1,234 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include "Texture.h"
+#include "iimage.h"
+#include "ithreadpool.h"
+#include "../MapExpression.h"
+
+namespace shaders
+{
+
+// Counters shared by the TextureStreamer and its textures, which might outlive the streamer
+struct StreamedTextureCounters
+{
+    std::atomic<std::size_t> uploadedTextures = 0;
+    std::atomic<std::size_t> textureMemory = 0;
+
+    // Time of the current frame in msec, stored in the textures when they are drawn
+    std::atomic<int64_t> frameTime = 0;
+};
+
+/**
+ * \brief
+ * Texture which is decoded on a worker thread and uploaded to OpenGL in a
+ * later frame by the TextureStreamer.
+ *
+ * Until the upload has happened, the GL number of a placeholder texture is
+ * returned. If the image couldn't be loaded, the fallback texture is used.
+ * Uploaded textures which haven't been drawn for a while can be evicted to
+ * stay within the memory budget, they are loaded again when drawn next time.
+ *
+ * Since the GL number changes over the lifetime of this texture, it must not
+ * be cached: the render passes are asking for it whenever they bind the
+ * texture, which is also what marks the texture as being in use.
+ * Querying the dimensions blocks until the image has been decoded, since
+ * texture projections depend on them.
+ */
+class StreamedTexture :
+    public Texture
+{
+public:
+    enum class State
+    {
+        Decoding,
+        Decoded,
+        Uploaded,
+        Failed,
+        Evicted,
+    };
+
+private:
+    std::string _name;
+    BindableTexture::Role _role;
+
+    MapExpressionPtr _expression;
+
+    TexturePtr _placeholder;
+    TexturePtr _fallback;
+
+    std::atomic<State> _state;
+
+    // The decoded image, released after upload
+    ImagePtr _image;
+
+    // The uploaded texture, only accessed by the thread owning the GL context
+    TexturePtr _texture;
+
+    threading::ITaskPtr _decodeTask;
+
+    std::size_t _width;
+    std::size_t _height;
+
+    std::size_t _memorySize;
+    std::shared_ptr<StreamedTextureCounters> _counters;
+
+    // Frame time this texture has last been bound in, and the time it has been evicted
+    mutable std::atomic<int64_t> _lastUsed;
+    int64_t _evictionTime;
+
+    // Set by the TextureStreamer once it's keeping track of this texture's residency
+    bool _tracked;
+
+public:
+    StreamedTexture(const std::string& name, BindableTexture::Role role, const MapExpressionPtr& expression,
+        const TexturePtr& placeholder, const TexturePtr& fallback,
+        const std::shared_ptr<StreamedTextureCounters>& counters) :
+        _name(name),
+        _role(role),
+        _expression(expression),
+        _placeholder(placeholder),
+        _fallback(fallback),
+        _state(State::Decoding),
+        _width(0),
+        _height(0),
+        _memorySize(0),
+        _counters(counters),
+        _lastUsed(counters->frameTime.load()),
+        _evictionTime(0),
+        _tracked(false)
+    {}
+
+    ~StreamedTexture() override
+    {
+        if (_state == State::Uploaded)
+        {
+            _counters->uploadedTextures--;
+            _counters->textureMemory -= _memorySize;
+        }
+    }
+
+    State getState() const
+    {
+        return _state;
+    }
+
+    // True if the image couldn't be loaded, waits for the decode to finish
+    bool hasFailed() const
+    {
+        waitForDecode();
+        return _state == State::Failed || _state == State::Decoding;
+    }
+
+    std::string getName() const override
+    {
+        return _name;
+    }
+
+    GLuint getGLTexNum() const override
+    {
+        _lastUsed.store(_counters->frameTime.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        switch (_state)
+        {
+        case State::Uploaded:
+            return _texture->getGLTexNum();
+        case State::Failed:
+            return _fallback ? _fallback->getGLTexNum() : 0;
+        default:
+            return _placeholder->getGLTexNum();
+        }
+    }
+
+    std::size_t getWidth() const override
+    {
+        return hasFailed() ? getFallbackWidth() : _width;
+    }
+
+    std::size_t getHeight() const override
+    {
+        return hasFailed() ? getFallbackHeight() : _height;
+    }
+
+private:
+    friend class TextureStreamer;
+
+    void waitForDecode() const
+    {
+        if (_state == State::Decoding && _decodeTask)
+        {
+            _decodeTask->wait();
+        }
+    }
+
+    std::size_t getFallbackWidth() const
+    {
+        return _fallback ? _fallback->getWidth() : INVALID_SIZE;
+    }
+
+    std::size_t getFallbackHeight() const
+    {
+        return _fallback ? _fallback->getHeight() : INVALID_SIZE;
+    }
+
+    // Called by the worker thread when the image has been loaded
+    void setDecodedImage(const ImagePtr& image)
+    {
+        if (!image)
+        {
+            _state = State::Failed;
+            return;
+        }
+
+        _image = image;
+        _width = image->getWidth();
+        _height = image->getHeight();
+        _state = State::Decoded;
+    }
+
+    int64_t getLastUsed() const
+    {
+        return _lastUsed.load(std::memory_order_relaxed);
+    }
+
+    // True if this texture has been evicted, but was drawn again afterwards
+    bool needsReload() const
+    {
+        return _state == State::Evicted && getLastUsed() > _evictionTime;
+    }
+
+    // Called by the thread owning the GL context
+    void upload(std::size_t memorySize)
+    {
+        _texture = _image->bindTexture(_name, _role);
+        _image.reset();
+
+        if (!_texture)
+        {
+            _state = State::Failed;
+            return;
+        }
+
+        _memorySize = memorySize;
+        _counters->uploadedTextures++;
+        _counters->textureMemory += _memorySize;
+
+        _state = State::Uploaded;
+    }
+
+    // Releases the GL texture, called by the thread owning the GL context
+    void evict()
+    {
+        _state = State::Evicted;
+        _evictionTime = getLastUsed();
+
+        _texture.reset();
+
+        _counters->uploadedTextures--;
+        _counters->textureMemory -= _memorySize;
+        _memorySize = 0;
+    }
+};
+
+}
@@ -0,0 +1,668 @@
+#include "TextureCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <iomanip>
+#include <sstream>
+#include "itextstream.h"
+#include "iimage.h"
+#include "BasicTexture2D.h"
+#include "../MapExpression.h"
+#include "os/fs.h"
+#include "debugging/gl.h"
+
+namespace shaders
+{
+
+namespace
+{
+    const char* const CACHE_IDENTIFIER = "DarkRadiant Compressed Texture";
+    const uint32_t CACHE_VERSION = 2;
+
+    // The cache folder is pruned to 3/4 of this size once it's exceeded
+    constexpr uint64_t MAX_CACHE_SIZE = uint64_t(2) << 30;
+
+    struct CacheFileInfo
+    {
+        fs::path path;
+        uint64_t size;
+        fs::file_time_type lastWriteTime;
+    };
+
+    // Returns all files in the given folder, including temporary files left behind
+    std::vector<CacheFileInfo> getCacheFiles(const std::string& folder)
+    {
+        std::vector<CacheFileInfo> files;
+
+        try
+        {
+            for (const auto& entry : fs::directory_iterator(folder))
+            {
+                if (!entry.is_regular_file()) continue;
+
+                files.emplace_back(CacheFileInfo{ entry.path(), entry.file_size(), entry.last_write_time() });
+            }
+        }
+        catch (const fs::filesystem_error& ex)
+        {
+            rWarning() << "Failed to read the texture cache folder " << folder << ": " << ex.what() << std::endl;
+        }
+
+        return files;
+    }
+
+    // RGBA pixels of a single level, used while generating the mipmaps
+    struct PixelLevel
+    {
+        std::size_t width;
+        std::size_t height;
+        std::vector<uint8_t> pixels;
+    };
+
+    bool hasTransparency(const Image& image)
+    {
+        auto numPixels = image.getWidth() * image.getHeight();
+        const auto* pixels = image.getPixels();
+
+        for (std::size_t i = 0; i < numPixels; ++i)
+        {
+            if (pixels[i * 4 + 3] != 255) return true;
+        }
+
+        return false;
+    }
+
+    GLenum getCompressedFormat(const Image& image, BindableTexture::Role role)
+    {
+        if (role == BindableTexture::Role::NORMAL_MAP)
+        {
+            return GL_COMPRESSED_RG_RGTC2;
+        }
+
+        return hasTransparency(image) ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    }
+
+    std::size_t getBlockSize(GLenum format)
+    {
+        return format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 8 : 16;
+    }
+
+    bool isSupportedFormat(GLenum format)
+    {
+        return format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT ||
+            format == GL_COMPRESSED_RG_RGTC2;
+    }
+
+    // Halves the given level using a box filter, odd dimensions are clamped
+    PixelLevel reduceLevel(const PixelLevel& level)
+    {
+        PixelLevel result{ std::max<std::size_t>(level.width / 2, 1), std::max<std::size_t>(level.height / 2, 1) };
+        result.pixels.resize(result.width * result.height * 4);
+
+        for (std::size_t y = 0; y < result.height; ++y)
+        {
+            auto y0 = std::min(y * 2, level.height - 1);
+            auto y1 = std::min(y * 2 + 1, level.height - 1);
+
+            for (std::size_t x = 0; x < result.width; ++x)
+            {
+                auto x0 = std::min(x * 2, level.width - 1);
+                auto x1 = std::min(x * 2 + 1, level.width - 1);
+
+                const auto* p00 = &level.pixels[(y0 * level.width + x0) * 4];
+                const auto* p01 = &level.pixels[(y0 * level.width + x1) * 4];
+                const auto* p10 = &level.pixels[(y1 * level.width + x0) * 4];
+                const auto* p11 = &level.pixels[(y1 * level.width + x1) * 4];
+
+                auto* out = &result.pixels[(y * result.width + x) * 4];
+
+                for (int c = 0; c < 4; ++c)
+                {
+                    out[c] = static_cast<uint8_t>((p00[c] + p01[c] + p10[c] + p11[c] + 2) >> 2);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // Copies the 4x4 block at the given position, repeating the edge pixels of smaller images
+    void fetchBlock(const PixelLevel& level, std::size_t blockX, std::size_t blockY, uint8_t block[16][4])
+    {
+        for (std::size_t y = 0; y < 4; ++y)
+        {
+            auto sourceY = std::min(blockY * 4 + y, level.height - 1);
+
+            for (std::size_t x = 0; x < 4; ++x)
+            {
+                auto sourceX = std::min(blockX * 4 + x, level.width - 1);
+                std::memcpy(block[y * 4 + x], &level.pixels[(sourceY * level.width + sourceX) * 4], 4);
+            }
+        }
+    }
+
+    uint16_t packRGB565(int r, int g, int b)
+    {
+        r = std::clamp(r, 0, 255);
+        g = std::clamp(g, 0, 255);
+        b = std::clamp(b, 0, 255);
+
+        return static_cast<uint16_t>(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+    }
+
+    void unpackRGB565(uint16_t colour, int rgb[3])
+    {
+        auto r = (colour >> 11) & 31;
+        auto g = (colour >> 5) & 63;
+        auto b = colour & 31;
+
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    // Encodes the colour part of a BC1 block in four-colour mode. The endpoints are
+    // chosen along the principal axis of the block's colours.
+    void encodeColourBlock(const uint8_t block[16][4], uint8_t* out)
+    {
+        float mean[3] = { 0, 0, 0 };
+
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 3; ++c) mean[c] += block[i][c];
+        }
+
+        for (int c = 0; c < 3; ++c) mean[c] /= 16;
+
+        // Covariance matrix of the colours
+        float cov[6] = { 0, 0, 0, 0, 0, 0 };
+
+        for (int i = 0; i < 16; ++i)
+        {
+            float r = block[i][0] - mean[0];
+            float g = block[i][1] - mean[1];
+            float b = block[i][2] - mean[2];
+
+            cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+            cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+        }
+
+        // A few power iterations are enough to find the dominant axis
+        float axis[3] = { 1, 1, 1 };
+
+        for (int iteration = 0; iteration < 4; ++iteration)
+        {
+            float x = axis[0] * cov[0] + axis[1] * cov[1] + axis[2] * cov[2];
+            float y = axis[0] * cov[1] + axis[1] * cov[3] + axis[2] * cov[4];
+            float z = axis[0] * cov[2] + axis[1] * cov[4] + axis[2] * cov[5];
+
+            float length = std::max({ std::abs(x), std::abs(y), std::abs(z) });
+
+            if (length < 1e-6f) break;
+
+            axis[0] = x / length;
+            axis[1] = y / length;
+            axis[2] = z / length;
+        }
+
+        // Project the colours onto the axis to find the endpoints
+        float minProjection = std::numeric_limits<float>::max();
+        float maxProjection = std::numeric_limits<float>::lowest();
+        int minIndex = 0, maxIndex = 0;
+
+        for (int i = 0; i < 16; ++i)
+        {
+            float projection = block[i][0] * axis[0] + block[i][1] * axis[1] + block[i][2] * axis[2];
+
+            if (projection < minProjection) { minProjection = projection; minIndex = i; }
+            if (projection > maxProjection) { maxProjection = projection; maxIndex = i; }
+        }
+
+        auto colour0 = packRGB565(block[maxIndex][0], block[maxIndex][1], block[maxIndex][2]);
+        auto colour1 = packRGB565(block[minIndex][0], block[minIndex][1], block[minIndex][2]);
+
+        // Four-colour mode requires colour0 > colour1
+        if (colour0 < colour1)
+        {
+            std::swap(colour0, colour1);
+        }
+
+        uint32_t indices = 0;
+
+        if (colour0 != colour1)
+        {
+            int palette[4][3];
+            unpackRGB565(colour0, palette[0]);
+            unpackRGB565(colour1, palette[1]);
+
+            for (int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            for (int i = 0; i < 16; ++i)
+            {
+                int bestIndex = 0;
+                int bestDistance = std::numeric_limits<int>::max();
+
+                for (int p = 0; p < 4; ++p)
+                {
+                    int dr = block[i][0] - palette[p][0];
+                    int dg = block[i][1] - palette[p][1];
+                    int db = block[i][2] - palette[p][2];
+                    int distance = dr * dr + dg * dg + db * db;
+
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        bestIndex = p;
+                    }
+                }
+
+                indices |= static_cast<uint32_t>(bestIndex) << (i * 2);
+            }
+        }
+
+        out[0] = colour0 & 0xff;
+        out[1] = colour0 >> 8;
+        out[2] = colour1 & 0xff;
+        out[3] = colour1 >> 8;
+        out[4] = indices & 0xff;
+        out[5] = (indices >> 8) & 0xff;
+        out[6] = (indices >> 16) & 0xff;
+        out[7] = (indices >> 24) & 0xff;
+    }
+
+    // Encodes a single channel of the block as BC4, as used for the BC3 alpha and the BC5 channels
+    void encodeChannelBlock(const uint8_t block[16][4], int channel, uint8_t* out)
+    {
+        int maxValue = 0;
+        int minValue = 255;
+
+        for (int i = 0; i < 16; ++i)
+        {
+            maxValue = std::max<int>(maxValue, block[i][channel]);
+            minValue = std::min<int>(minValue, block[i][channel]);
+        }
+
+        uint64_t indices = 0;
+
+        if (maxValue != minValue)
+        {
+            // With value0 > value1 the palette holds value0, value1 and six interpolated values
+            // in between, the interpolated ones are indexed from value0 towards value1.
+            static const uint64_t INDEX_FOR_STEP[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+
+            auto range = maxValue - minValue;
+
+            for (int i = 0; i < 16; ++i)
+            {
+                auto step = ((maxValue - block[i][channel]) * 7 + range / 2) / range;
+                indices |= INDEX_FOR_STEP[step] << (i * 3);
+            }
+        }
+
+        out[0] = static_cast<uint8_t>(maxValue);
+        out[1] = static_cast<uint8_t>(minValue);
+
+        for (int b = 0; b < 6; ++b)
+        {
+            out[2 + b] = static_cast<uint8_t>((indices >> (b * 8)) & 0xff);
+        }
+    }
+
+    std::vector<uint8_t> compressLevel(const PixelLevel& level, GLenum format)
+    {
+        auto blocksX = (level.width + 3) / 4;
+        auto blocksY = (level.height + 3) / 4;
+        auto blockSize = getBlockSize(format);
+
+        std::vector<uint8_t> result(blocksX * blocksY * blockSize);
+        auto* out = result.data();
+
+        uint8_t block[16][4];
+
+        for (std::size_t blockY = 0; blockY < blocksY; ++blockY)
+        {
+            for (std::size_t blockX = 0; blockX < blocksX; ++blockX, out += blockSize)
+            {
+                fetchBlock(level, blockX, blockY, block);
+
+                switch (format)
+                {
+                case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+                    encodeColourBlock(block, out);
+                    break;
+                case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+                    encodeChannelBlock(block, 3, out);
+                    encodeColourBlock(block, out + 8);
+                    break;
+                case GL_COMPRESSED_RG_RGTC2:
+                    encodeChannelBlock(block, 0, out);
+                    encodeChannelBlock(block, 1, out + 8);
+                    break;
+                }
+            }
+        }
+
+        return result;
+    }
+}
+
+TexturePtr BlockCompressedImage::bindTexture(const std::string& name, Role role) const
+{
+    debug::assertNoGlErrors();
+
+    GLuint textureNum;
+    glGenTextures(1, &textureNum);
+    glBindTexture(GL_TEXTURE_2D, textureNum);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    for (std::size_t i = 0; i < _levels.size(); ++i)
+    {
+        const auto& level = _levels[i];
+
+        glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), _format,
+            static_cast<GLsizei>(level.width), static_cast<GLsizei>(level.height), 0,
+            static_cast<GLsizei>(level.data.size()), level.data.data());
+
+        if (glGetError() != GL_NO_ERROR)
+        {
+            rError() << "[shaders] Unable to upload compressed texture " << name << std::endl;
+
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glDeleteTextures(1, &textureNum);
+
+            return TexturePtr();
+        }
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(_levels.size() - 1));
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    auto texture = std::make_shared<BasicTexture2D>(textureNum, name);
+    texture->setWidth(getWidth());
+    texture->setHeight(getHeight());
+
+    debug::assertNoGlErrors();
+
+    return texture;
+}
+
+TextureCompressor::TextureCompressor(const std::string& cachePath) :
+    _cachePath(cachePath),
+    _cacheSize(0)
+{}
+
+std::shared_ptr<BlockCompressedImage> TextureCompressor::loadCached(const MapExpression& expression,
+    BindableTexture::Role role)
+{
+    if (_cachePath.empty())
+    {
+        return {};
+    }
+
+    auto key = getSourceKey(expression, role);
+
+    return key ? loadFromCache(getCacheFilePath(*key), *key) : nullptr;
+}
+
+std::shared_ptr<BlockCompressedImage> TextureCompressor::compress(const MapExpression& expression,
+    const Image& image, BindableTexture::Role role)
+{
+    auto compressed = compressImage(image, role);
+
+    if (_cachePath.empty())
+    {
+        return compressed;
+    }
+
+    // The stamps are taken after decoding, a file changed in between is compressed again next time
+    if (auto key = getSourceKey(expression, role); key)
+    {
+        saveToCache(getCacheFilePath(*key), *key, *compressed);
+    }
+
+    return compressed;
+}
+
+std::shared_ptr<BlockCompressedImage> TextureCompressor::compressImage(const Image& image, BindableTexture::Role role)
+{
+    auto format = getCompressedFormat(image, role);
+
+    PixelLevel level{ image.getWidth(), image.getHeight() };
+    level.pixels.assign(image.getPixels(), image.getPixels() + level.width * level.height * 4);
+
+    std::vector<BlockCompressedImage::Level> levels;
+
+    // Compress the full mipmap chain, glGenerateMipmap can't be used on compressed textures
+    while (true)
+    {
+        levels.emplace_back(BlockCompressedImage::Level{ level.width, level.height, compressLevel(level, format) });
+
+        if (level.width == 1 && level.height == 1) break;
+
+        level = reduceLevel(level);
+    }
+
+    return std::make_shared<BlockCompressedImage>(format, std::move(levels));
+}
+
+std::optional<TextureCompressor::SourceKey> TextureCompressor::getSourceKey(const MapExpression& expression,
+    BindableTexture::Role role)
+{
+    SourceKey key;
+    key.expression = expression.getIdentifier();
+    key.role = static_cast<uint32_t>(role);
+
+    bool valid = true;
+
+    expression.foreachImage([&](const std::string& imageName)
+    {
+        if (!valid) return;
+
+        auto vfsPath = GlobalImageLoader().findImageInVFS(imageName);
+        auto stamp = vfsPath.empty() ? stream::FileStamp() : stream::FileStamp::ofVfsFile(vfsPath);
+
+        if (!stamp.isValid())
+        {
+            valid = false;
+            return;
+        }
+
+        key.files.emplace_back(vfsPath, stamp);
+    });
+
+    if (!valid || key.files.empty())
+    {
+        return std::nullopt;
+    }
+
+    return key;
+}
+
+std::string TextureCompressor::getCacheFilePath(const SourceKey& key) const
+{
+    // Changed source files replace the previous cache file, their stamps are checked when loading
+    std::ostringstream filename;
+    filename << std::hex << std::setfill('0') << std::setw(16) << stream::hashString(key.expression) <<
+        "_" << key.role << ".cache";
+
+    return _cachePath + filename.str();
+}
+
+std::shared_ptr<BlockCompressedImage> TextureCompressor::loadFromCache(const std::string& path, const SourceKey& key)
+{
+    stream::CacheFileReader reader(path, CACHE_IDENTIFIER, CACHE_VERSION);
+
+    if (!reader.isValid())
+    {
+        return {};
+    }
+
+    try
+    {
+        // The full key is compared, different expressions might end up with the same file name
+        if (reader.readString() != key.expression || reader.readUInt32() != key.role ||
+            reader.readUInt32() != key.files.size())
+        {
+            return {};
+        }
+
+        for (const auto& [vfsPath, stamp] : key.files)
+        {
+            if (reader.readString() != vfsPath || reader.readFileStamp() != stamp)
+            {
+                return {};
+            }
+        }
+
+        GLenum format = reader.readUInt32();
+
+        if (!isSupportedFormat(format))
+        {
+            throw stream::CacheFileException("Unsupported format");
+        }
+
+        auto numLevels = reader.readUInt32();
+
+        std::vector<BlockCompressedImage::Level> levels;
+        levels.reserve(numLevels);
+
+        for (uint32_t i = 0; i < numLevels; ++i)
+        {
+            BlockCompressedImage::Level level;
+
+            level.width = reader.readUInt32();
+            level.height = reader.readUInt32();
+            level.data = reader.readBytes();
+
+            if (level.data.size() != ((level.width + 3) / 4) * ((level.height + 3) / 4) * getBlockSize(format))
+            {
+                throw stream::CacheFileException("Invalid level size");
+            }
+
+            levels.emplace_back(std::move(level));
+        }
+
+        if (levels.empty())
+        {
+            throw stream::CacheFileException("No levels");
+        }
+
+        // Touch the file, pruning the cache removes the least recently used files first
+        try
+        {
+            fs::last_write_time(path, fs::file_time_type::clock::now());
+        }
+        catch (const fs::filesystem_error&)
+        {}
+
+        return std::make_shared<BlockCompressedImage>(format, std::move(levels));
+    }
+    catch (const stream::CacheFileException& ex)
+    {
+        rWarning() << "Discarding compressed texture cache file " << path << ": " << ex.what() << std::endl;
+        return {};
+    }
+}
+
+void TextureCompressor::saveToCache(const std::string& path, const SourceKey& key, const BlockCompressedImage& image)
+{
+    stream::CacheFileWriter writer(path, CACHE_IDENTIFIER, CACHE_VERSION);
+
+    writer.writeString(key.expression);
+    writer.writeUInt32(key.role);
+    writer.writeUInt32(static_cast<uint32_t>(key.files.size()));
+
+    for (const auto& [vfsPath, stamp] : key.files)
+    {
+        writer.writeString(vfsPath);
+        writer.writeFileStamp(stamp);
+    }
+
+    writer.writeUInt32(image.getGLFormat());
+    writer.writeUInt32(static_cast<uint32_t>(image.getLevels()));
+
+    for (const auto& level : image.getLevelData())
+    {
+        writer.writeUInt32(static_cast<uint32_t>(level.width));
+        writer.writeUInt32(static_cast<uint32_t>(level.height));
+        writer.writeBytes(level.data.data(), level.data.size());
+    }
+
+    if (!writer.commit()) return;
+
+    uint64_t fileSize = stream::FileStamp::ofFile(path).size;
+
+    std::call_once(_cacheSizeDetermined, [&]()
+    {
+        uint64_t size = 0;
+
+        for (const auto& file : getCacheFiles(_cachePath))
+        {
+            size += file.size;
+        }
+
+        // The file written above is contained already, the size is added below
+        _cacheSize = size - std::min(size, fileSize);
+    });
+
+    if ((_cacheSize += fileSize) > MAX_CACHE_SIZE)
+    {
+        pruneCache();
+    }
+}
+
+void TextureCompressor::pruneCache()
+{
+    // Another thread is already taking care of it
+    std::unique_lock<std::mutex> lock(_pruneLock, std::try_to_lock);
+
+    if (!lock.owns_lock()) return;
+
+    auto files = getCacheFiles(_cachePath);
+
+    std::sort(files.begin(), files.end(), [](const CacheFileInfo& a, const CacheFileInfo& b)
+    {
+        return a.lastWriteTime < b.lastWriteTime;
+    });
+
+    uint64_t size = 0;
+
+    for (const auto& file : files)
+    {
+        size += file.size;
+    }
+
+    std::size_t removedFiles = 0;
+
+    for (const auto& file : files)
+    {
+        if (size <= MAX_CACHE_SIZE / 4 * 3) break;
+
+        try
+        {
+            fs::remove(file.path);
+
+            size -= file.size;
+            ++removedFiles;
+        }
+        catch (const fs::filesystem_error&)
+        {
+            // Might be in use by another thread or process, skip it
+        }
+    }
+
+    _cacheSize = size;
+
+    rMessage() << "Removed " << removedFiles << " files from the texture cache " << _cachePath << std::endl;
+}
+
+}
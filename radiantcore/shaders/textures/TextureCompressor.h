@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "iimage.h"
+#include "stream/CacheFile.h"
+#include "util/Noncopyable.h"
+
+namespace shaders
+{
+
+class MapExpression;
+
+/**
+ * \brief
+ * Image holding block compressed pixel data including all its mipmap levels,
+ * as produced by the TextureCompressor.
+ */
+class BlockCompressedImage :
+    public Image,
+    public util::Noncopyable
+{
+public:
+    struct Level
+    {
+        std::size_t width;
+        std::size_t height;
+        std::vector<uint8_t> data;
+    };
+
+private:
+    GLenum _format;
+    std::vector<Level> _levels;
+
+public:
+    BlockCompressedImage(GLenum format, std::vector<Level>&& levels) :
+        _format(format),
+        _levels(std::move(levels))
+    {}
+
+    const std::vector<Level>& getLevelData() const
+    {
+        return _levels;
+    }
+
+    /* Image implementation */
+    uint8_t* getPixels() const override
+    {
+        return const_cast<uint8_t*>(_levels.front().data.data());
+    }
+
+    std::size_t getWidth(std::size_t level = 0) const override { return _levels[level].width; }
+    std::size_t getHeight(std::size_t level = 0) const override { return _levels[level].height; }
+    std::size_t getLevels() const override { return _levels.size(); }
+    bool isPrecompressed() const override { return true; }
+    GLenum getGLFormat() const override { return _format; }
+
+    /* BindableTexture implementation */
+    TexturePtr bindTexture(const std::string& name, Role role) const override;
+};
+
+/**
+ * \brief
+ * Converts uncompressed RGBA images into block compressed ones, to reduce
+ * the video memory they occupy: BC1 for opaque images, BC3 for images with
+ * transparency and BC5 for normal maps.
+ *
+ * The compressed results are stored in a disk cache, keyed by the map
+ * expression, the texture role and the stamps of the image files the
+ * expression is built from. Later sessions load them directly, without
+ * decoding the source images. Expressions referring to images outside the
+ * VFS (like _white) are not cached. Once the cache exceeds its size limit,
+ * the least recently used files are deleted. All methods can be called from
+ * worker threads.
+ */
+class TextureCompressor
+{
+private:
+    // Identifies the source of a compressed image, stored in the cache file header
+    struct SourceKey
+    {
+        std::string expression;
+        uint32_t role = 0;
+        std::vector<std::pair<std::string, stream::FileStamp>> files;
+    };
+
+    std::string _cachePath;
+
+    // The size of the cache folder, determined when the first file is written
+    std::once_flag _cacheSizeDetermined;
+    std::atomic<std::uint64_t> _cacheSize;
+
+    std::mutex _pruneLock;
+
+public:
+    // Construct a compressor storing its results in the given folder,
+    // leave the path empty to disable the cache.
+    TextureCompressor(const std::string& cachePath);
+
+    // Returns the cached compressed image of the given expression, or an empty pointer if
+    // there is none or the source images have been changed. The sources are not decoded.
+    std::shared_ptr<BlockCompressedImage> loadCached(const MapExpression& expression, BindableTexture::Role role);
+
+    // Compresses the given uncompressed RGBA image, which has been produced by the
+    // given expression, and stores the result in the cache.
+    std::shared_ptr<BlockCompressedImage> compress(const MapExpression& expression, const Image& image,
+        BindableTexture::Role role);
+
+    // Compresses the given image without looking at the cache
+    static std::shared_ptr<BlockCompressedImage> compressImage(const Image& image, BindableTexture::Role role);
+
+private:
+    // Returns an empty value if the expression refers to an image which can't be found in the VFS
+    static std::optional<SourceKey> getSourceKey(const MapExpression& expression, BindableTexture::Role role);
+
+    std::string getCacheFilePath(const SourceKey& key) const;
+
+    std::shared_ptr<BlockCompressedImage> loadFromCache(const std::string& path, const SourceKey& key);
+    void saveToCache(const std::string& path, const SourceKey& key, const BlockCompressedImage& image);
+
+    // Deletes the least recently used files until the cache is well below its size limit
+    void pruneCache();
+};
+
+}
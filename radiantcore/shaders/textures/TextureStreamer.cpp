@@ -0,0 +1,361 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include "itextstream.h"
+#include "imodule.h"
+#include "RGBAImage.h"
+
+namespace shaders
+{
+
+namespace
+{
+    // Size of the placeholder images in pixels
+    constexpr std::size_t PLACEHOLDER_SIZE = 4;
+
+    // Textures drawn within this time (msec) are never evicted
+    constexpr int64_t EVICTION_DELAY_MSEC = 1000;
+
+    TexturePtr createPlaceholder(const std::string& name, const image::RGBAPixel& colour)
+    {
+        image::RGBAImage image(PLACEHOLDER_SIZE, PLACEHOLDER_SIZE);
+        std::fill(image.pixels, image.pixels + PLACEHOLDER_SIZE * PLACEHOLDER_SIZE, colour);
+
+        return image.bindTexture(name, BindableTexture::Role::COLOUR);
+    }
+
+    // Estimates the video memory the given image is going to occupy after upload
+    std::size_t estimateTextureMemory(const Image& image)
+    {
+        std::size_t size = 0;
+
+        for (std::size_t level = 0; level < image.getLevels(); ++level)
+        {
+            auto width = image.getWidth(level);
+            auto height = image.getHeight(level);
+
+            if (!image.isPrecompressed())
+            {
+                size += width * height * 4;
+                continue;
+            }
+
+            // Compressed formats are storing blocks of 4x4 pixels
+            auto numBlocks = ((width + 3) / 4) * ((height + 3) / 4);
+
+            switch (image.getGLFormat())
+            {
+            case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_RED_RGTC1:
+                size += numBlocks * 8;
+                break;
+            default:
+                size += numBlocks * 16;
+                break;
+            }
+        }
+
+        // Single level images get their mipmap chain generated on upload
+        return image.getLevels() == 1 ? size * 4 / 3 : size;
+    }
+}
+
+TextureStreamer::TextureStreamer() :
+    _enabled(RKEY_TEXTURE_STREAMING),
+    _uploadBudgetMsec(RKEY_UPLOAD_BUDGET),
+    _memoryBudgetMB(RKEY_MEMORY_BUDGET),
+    _compressionEnabled(RKEY_TEXTURE_COMPRESSION),
+    _compressor(module::GlobalModuleRegistry().getApplicationContext().getCacheDataPath() + "texturecache/"),
+    _pendingDecodes(0),
+    _evictedTextures(0),
+    _counters(std::make_shared<StreamedTextureCounters>())
+{}
+
+TextureStreamer::~TextureStreamer()
+{
+    cancelPendingDecodes();
+}
+
+bool TextureStreamer::isEnabled() const
+{
+    return _enabled.get();
+}
+
+std::shared_ptr<StreamedTexture> TextureStreamer::requestTexture(const std::string& name,
+    const MapExpressionPtr& expression, BindableTexture::Role role, const TexturePtr& fallback)
+{
+    std::lock_guard<std::mutex> lock(_requestLock);
+
+    removeFinishedTasks();
+
+    auto texture = std::make_shared<StreamedTexture>(name, role, expression, getPlaceholder(role), fallback, _counters);
+    scheduleDecode(texture);
+
+    return texture;
+}
+
+void TextureStreamer::finishLoading(const std::shared_ptr<StreamedTexture>& texture)
+{
+    texture->waitForDecode();
+
+    if (texture->getState() == StreamedTexture::State::Decoded)
+    {
+        upload(texture);
+    }
+}
+
+bool TextureStreamer::processUploads()
+{
+    auto start = std::chrono::steady_clock::now();
+    auto budget = std::chrono::duration<float, std::milli>(_uploadBudgetMsec.get());
+
+    _counters->frameTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+        start.time_since_epoch()).count();
+
+    reloadEvictedTextures();
+
+    while (true)
+    {
+        std::shared_ptr<StreamedTexture> texture;
+
+        {
+            std::lock_guard<std::mutex> lock(_uploadQueueLock);
+
+            if (_uploadQueue.empty()) break;
+
+            texture = _uploadQueue.front().lock();
+            _uploadQueue.pop_front();
+        }
+
+        // Skip textures which have been released or uploaded in the meantime
+        if (!texture || texture->getState() != StreamedTexture::State::Decoded) continue;
+
+        upload(texture);
+
+        // At least one texture is uploaded per frame, even if it exceeds the budget
+        if (std::chrono::steady_clock::now() - start >= budget) break;
+    }
+
+    enforceMemoryBudget();
+
+    {
+        std::lock_guard<std::mutex> lock(_requestLock);
+        removeFinishedTasks();
+    }
+
+    std::lock_guard<std::mutex> lock(_uploadQueueLock);
+    return _pendingDecodes > 0 || !_uploadQueue.empty();
+}
+
+TextureStreamingStatistics TextureStreamer::getStatistics()
+{
+    TextureStreamingStatistics statistics;
+
+    statistics.pendingDecodes = _pendingDecodes;
+    statistics.uploadedTextures = _counters->uploadedTextures;
+    statistics.textureMemory = _counters->textureMemory;
+    statistics.textureMemoryBudget = static_cast<std::size_t>(std::max(_memoryBudgetMB.get(), 0)) << 20;
+    statistics.evictedTextures = _evictedTextures;
+
+    std::lock_guard<std::mutex> lock(_uploadQueueLock);
+    statistics.pendingUploads = _uploadQueue.size();
+
+    return statistics;
+}
+
+void TextureStreamer::cancelPendingDecodes()
+{
+    std::vector<threading::ITaskPtr> decodeTasks;
+
+    {
+        std::lock_guard<std::mutex> lock(_requestLock);
+        decodeTasks.swap(_decodeTasks);
+    }
+
+    for (const auto& task : decodeTasks)
+    {
+        if (task->cancel())
+        {
+            --_pendingDecodes;
+        }
+    }
+
+    for (const auto& task : decodeTasks)
+    {
+        task->wait();
+    }
+
+    std::lock_guard<std::mutex> lock(_uploadQueueLock);
+    _uploadQueue.clear();
+}
+
+const TexturePtr& TextureStreamer::getPlaceholder(BindableTexture::Role role)
+{
+    if (role == BindableTexture::Role::NORMAL_MAP)
+    {
+        if (!_normalMapPlaceholder)
+        {
+            // A flat normal map, pointing straight up
+            _normalMapPlaceholder = createPlaceholder("_streamingPlaceholderNormal", { 128, 128, 255, 255 });
+        }
+
+        return _normalMapPlaceholder;
+    }
+
+    if (!_colourPlaceholder)
+    {
+        _colourPlaceholder = createPlaceholder("_streamingPlaceholder", { 128, 128, 128, 255 });
+    }
+
+    return _colourPlaceholder;
+}
+
+void TextureStreamer::removeFinishedTasks()
+{
+    _decodeTasks.erase(std::remove_if(_decodeTasks.begin(), _decodeTasks.end(),
+        [](const threading::ITaskPtr& task) { return task->isFinished(); }), _decodeTasks.end());
+}
+
+void TextureStreamer::scheduleDecode(const std::shared_ptr<StreamedTexture>& texture)
+{
+    ++_pendingDecodes;
+
+    // The task must not keep the texture alive, it might be released before it's decoded
+    std::weak_ptr<StreamedTexture> weakTexture = texture;
+    auto expression = texture->_expression;
+    auto role = texture->_role;
+    auto compress = _compressionEnabled.get();
+
+    texture->_state = StreamedTexture::State::Decoding;
+    texture->_decodeTask = GlobalThreadPool().schedule([this, weakTexture, expression, role, compress]()
+    {
+        if (weakTexture.expired())
+        {
+            --_pendingDecodes;
+            return;
+        }
+
+        ImagePtr image;
+
+        try
+        {
+            // Compressed images cached in a previous session don't need the source to be decoded
+            if (compress)
+            {
+                image = _compressor.loadCached(*expression, role);
+            }
+
+            if (!image)
+            {
+                image = expression->getImage();
+
+                // DDS images are compressed already
+                if (image && compress && !image->isPrecompressed())
+                {
+                    image = _compressor.compress(*expression, *image, role);
+                }
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            rError() << "[shaders] Failed to load image " << expression->getIdentifier() << ": " << ex.what() << std::endl;
+        }
+
+        if (auto texture = weakTexture.lock(); texture)
+        {
+            texture->setDecodedImage(image);
+
+            if (image)
+            {
+                std::lock_guard<std::mutex> lock(_uploadQueueLock);
+                _uploadQueue.emplace_back(texture);
+            }
+            else
+            {
+                rError() << "[shaders] Unable to load texture: " << texture->getName() << std::endl;
+            }
+        }
+
+        --_pendingDecodes;
+    });
+
+    _decodeTasks.push_back(texture->_decodeTask);
+}
+
+void TextureStreamer::upload(const std::shared_ptr<StreamedTexture>& texture)
+{
+    texture->upload(estimateTextureMemory(*texture->_image));
+
+    // Reloaded textures are tracked already
+    if (texture->getState() == StreamedTexture::State::Uploaded && !texture->_tracked)
+    {
+        texture->_tracked = true;
+        _residentTextures.emplace_back(texture);
+    }
+}
+
+void TextureStreamer::reloadEvictedTextures()
+{
+    std::lock_guard<std::mutex> lock(_requestLock);
+
+    for (const auto& weakTexture : _residentTextures)
+    {
+        if (auto texture = weakTexture.lock(); texture && texture->needsReload())
+        {
+            scheduleDecode(texture);
+        }
+    }
+}
+
+void TextureStreamer::enforceMemoryBudget()
+{
+    // Forget about the textures which have been released
+    _residentTextures.erase(std::remove_if(_residentTextures.begin(), _residentTextures.end(),
+        [](const std::weak_ptr<StreamedTexture>& texture) { return texture.expired(); }), _residentTextures.end());
+
+    // Tracked textures which are not uploaded have been evicted, or are being reloaded
+    _evictedTextures = std::count_if(_residentTextures.begin(), _residentTextures.end(),
+        [](const std::weak_ptr<StreamedTexture>& texture)
+    {
+        auto locked = texture.lock();
+        return locked && locked->getState() != StreamedTexture::State::Uploaded;
+    });
+
+    auto budget = static_cast<std::size_t>(std::max(_memoryBudgetMB.get(), 0)) << 20;
+
+    // A budget of 0 disables eviction
+    if (budget == 0 || _counters->textureMemory <= budget) return;
+
+    auto evictionTime = _counters->frameTime - EVICTION_DELAY_MSEC;
+
+    std::vector<std::shared_ptr<StreamedTexture>> candidates;
+
+    for (const auto& weakTexture : _residentTextures)
+    {
+        auto texture = weakTexture.lock();
+
+        if (texture && texture->getState() == StreamedTexture::State::Uploaded &&
+            texture->getLastUsed() < evictionTime)
+        {
+            candidates.emplace_back(std::move(texture));
+        }
+    }
+
+    // Evict the least recently drawn textures first
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b)
+    {
+        return a->getLastUsed() < b->getLastUsed();
+    });
+
+    for (const auto& texture : candidates)
+    {
+        if (_counters->textureMemory <= budget) break;
+
+        texture->evict();
+        ++_evictedTextures;
+    }
+}
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "ishaders.h"
+#include "registry/CachedKey.h"
+#include "../MapExpression.h"
+#include "StreamedTexture.h"
+#include "TextureCompressor.h"
+
+namespace shaders
+{
+
+/**
+ * \brief
+ * Loads the images of map expressions on the thread pool, such that drawing
+ * a material for the first time doesn't stall the render thread.
+ *
+ * Requested textures are bound to a placeholder first. The decoded images
+ * are uploaded in processUploads(), which is called at the start of a frame
+ * and stops when the configured time budget has been used up.
+ *
+ * The streamer keeps track of the memory used by the uploaded textures. If it
+ * exceeds the configured budget, the textures which haven't been drawn for the
+ * longest time are evicted until the budget is met again.
+ */
+class TextureStreamer
+{
+private:
+    registry::CachedKey<bool> _enabled;
+    registry::CachedKey<float> _uploadBudgetMsec;
+    registry::CachedKey<int> _memoryBudgetMB;
+    registry::CachedKey<bool> _compressionEnabled;
+
+    // Block compresses the decoded images, if enabled
+    TextureCompressor _compressor;
+
+    // Shown while the images are loading, one for colour maps, one for normal maps
+    TexturePtr _colourPlaceholder;
+    TexturePtr _normalMapPlaceholder;
+
+    // Decoded textures in the order they finished
+    std::mutex _uploadQueueLock;
+    std::deque<std::weak_ptr<StreamedTexture>> _uploadQueue;
+
+    // Guards the placeholders and the decode tasks, textures can be requested from any thread
+    std::mutex _requestLock;
+
+    // Tasks which might still be running, to be able to cancel them on shutdown
+    std::vector<threading::ITaskPtr> _decodeTasks;
+    std::atomic<std::size_t> _pendingDecodes;
+
+    // All textures which have been uploaded at some point, including evicted ones
+    std::vector<std::weak_ptr<StreamedTexture>> _residentTextures;
+
+    std::atomic<std::size_t> _evictedTextures;
+
+    std::shared_ptr<StreamedTextureCounters> _counters;
+
+public:
+    // Registry keys
+    static constexpr const char* const RKEY_TEXTURE_STREAMING = "user/ui/textures/streaming";
+    static constexpr const char* const RKEY_UPLOAD_BUDGET = "user/ui/textures/uploadBudget";
+    static constexpr const char* const RKEY_MEMORY_BUDGET = "user/ui/textures/memoryBudget";
+    static constexpr const char* const RKEY_TEXTURE_COMPRESSION = "user/ui/textures/compression";
+
+    TextureStreamer();
+    ~TextureStreamer();
+
+    // Whether textures should be loaded in the background
+    bool isEnabled() const;
+
+    // Schedules the image of the given expression for loading, returning a texture
+    // which is bound to a placeholder until the image has been uploaded.
+    // The fallback texture is used if the image fails to load.
+    std::shared_ptr<StreamedTexture> requestTexture(const std::string& name, const MapExpressionPtr& expression,
+        BindableTexture::Role role, const TexturePtr& fallback);
+
+    // Waits for the given texture to be decoded and uploads it right away
+    void finishLoading(const std::shared_ptr<StreamedTexture>& texture);
+
+    // Uploads decoded images until the time budget is exhausted and evicts
+    // textures exceeding the memory budget. Returns true if there are
+    // textures left to decode or upload
+    bool processUploads();
+
+    TextureStreamingStatistics getStatistics();
+
+    // Cancels all pending decodes and waits for the running ones
+    void cancelPendingDecodes();
+
+private:
+    const TexturePtr& getPlaceholder(BindableTexture::Role role);
+    // These two expect the request lock to be held by the caller
+    void removeFinishedTasks();
+    void scheduleDecode(const std::shared_ptr<StreamedTexture>& texture);
+    void upload(const std::shared_ptr<StreamedTexture>& texture);
+    void reloadEvictedTextures();
+    void enforceMemoryBudget();
+};
+
+}
@@ -0,0 +1,111 @@
+#include "ThumbnailAtlas.h"
+
+#include "BasicTexture2D.h"
+#include "debugging/gl.h"
+
+namespace shaders
+{
+
+ThumbnailAtlas::ThumbnailAtlas(std::size_t cellSize, std::size_t maxPages) :
+    _cellSize(cellSize),
+    _maxPages(maxPages)
+{}
+
+std::optional<ThumbnailAtlas::Slot> ThumbnailAtlas::allocate()
+{
+    if (_freeSlots.empty())
+    {
+        if (_pages.size() >= _maxPages)
+        {
+            return std::nullopt;
+        }
+
+        addPage();
+    }
+
+    auto slot = _freeSlots.back();
+    _freeSlots.pop_back();
+
+    return slot;
+}
+
+void ThumbnailAtlas::release(const Slot& slot)
+{
+    _freeSlots.push_back(slot);
+}
+
+void ThumbnailAtlas::upload(const Slot& slot, const uint8_t* pixels, std::size_t width, std::size_t height)
+{
+    auto cellsPerRow = PAGE_SIZE / _cellSize;
+    auto x = (slot.cell % cellsPerRow) * _cellSize;
+    auto y = (slot.cell / cellsPerRow) * _cellSize;
+
+    glBindTexture(GL_TEXTURE_2D, getTextureNum(slot));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    glTexSubImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(x), static_cast<GLint>(y),
+        static_cast<GLsizei>(width), static_cast<GLsizei>(height), GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    debug::assertNoGlErrors();
+}
+
+GLuint ThumbnailAtlas::getTextureNum(const Slot& slot) const
+{
+    return _pages[slot.page]->getGLTexNum();
+}
+
+float ThumbnailAtlas::getS(const Slot& slot) const
+{
+    auto cellsPerRow = PAGE_SIZE / _cellSize;
+    return static_cast<float>((slot.cell % cellsPerRow) * _cellSize) / PAGE_SIZE;
+}
+
+float ThumbnailAtlas::getT(const Slot& slot) const
+{
+    auto cellsPerRow = PAGE_SIZE / _cellSize;
+    return static_cast<float>((slot.cell / cellsPerRow) * _cellSize) / PAGE_SIZE;
+}
+
+void ThumbnailAtlas::clear()
+{
+    _pages.clear();
+    _freeSlots.clear();
+}
+
+void ThumbnailAtlas::addPage()
+{
+    GLuint textureNum;
+    glGenTextures(1, &textureNum);
+    glBindTexture(GL_TEXTURE_2D, textureNum);
+
+    // Thumbnails are drawn at about their native size, mipmaps are not needed
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, PAGE_SIZE, PAGE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    debug::assertNoGlErrors();
+
+    auto page = std::make_shared<BasicTexture2D>(textureNum, "_thumbnailAtlas");
+    page->setWidth(PAGE_SIZE);
+    page->setHeight(PAGE_SIZE);
+
+    auto pageIndex = _pages.size();
+    _pages.emplace_back(std::move(page));
+
+    // Hand out the cells of the new page in ascending order
+    auto numCells = (PAGE_SIZE / _cellSize) * (PAGE_SIZE / _cellSize);
+
+    for (auto cell = numCells; cell > 0; --cell)
+    {
+        _freeSlots.push_back(Slot{ pageIndex, cell - 1 });
+    }
+}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+#include "igl.h"
+#include "util/Noncopyable.h"
+
+class BasicTexture2D;
+
+namespace shaders
+{
+
+/**
+ * \brief
+ * Texture atlas holding the material thumbnails in cells of a fixed size.
+ *
+ * The atlas consists of square pages, which are allocated on demand until the
+ * maximum number of pages is reached. All methods must be called by the thread
+ * owning the GL context.
+ */
+class ThumbnailAtlas :
+    public util::Noncopyable
+{
+public:
+    // Width and height of a single page in pixels
+    static constexpr std::size_t PAGE_SIZE = 1024;
+
+    struct Slot
+    {
+        std::size_t page;
+        std::size_t cell;
+    };
+
+private:
+    std::size_t _cellSize;
+    std::size_t _maxPages;
+
+    std::vector<std::shared_ptr<BasicTexture2D>> _pages;
+    std::vector<Slot> _freeSlots;
+
+public:
+    ThumbnailAtlas(std::size_t cellSize, std::size_t maxPages);
+
+    // Reserves a free cell, returns an empty value if all pages are occupied
+    std::optional<Slot> allocate();
+
+    // Returns the cell to the pool of free ones
+    void release(const Slot& slot);
+
+    // Copies the RGBA pixels to the cell, the image must not be larger than the cell
+    void upload(const Slot& slot, const uint8_t* pixels, std::size_t width, std::size_t height);
+
+    // The GL texture number of the page the slot is located in
+    GLuint getTextureNum(const Slot& slot) const;
+
+    // Texture coordinates of the top left corner of the given slot
+    float getS(const Slot& slot) const;
+    float getT(const Slot& slot) const;
+
+    // Releases all pages
+    void clear();
+
+private:
+    void addPage();
+};
+
+}
@@ -0,0 +1,748 @@
+#include "ThumbnailCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include "iimage.h"
+#include "ifilesystem.h"
+#include "itextstream.h"
+#include "os/path.h"
+
+namespace shaders
+{
+
+namespace
+{
+    const char* const CACHE_IDENTIFIER = "DarkRadiantThumbnailCache";
+    constexpr uint32_t CACHE_VERSION = 1;
+
+    // The atlas holds up to 1024 thumbnails, 64 per page
+    constexpr std::size_t MAX_ATLAS_PAGES = 16;
+
+    // RGBA pixels of a single image level
+    struct PixelLevel
+    {
+        std::size_t width;
+        std::size_t height;
+        std::vector<uint8_t> pixels;
+    };
+
+    bool isBlockCompressed(GLenum format)
+    {
+        switch (format)
+        {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_RG_RGTC2:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Size of the given level's data in bytes, 0 if the format is not supported
+    std::size_t getLevelDataSize(const Image& image, std::size_t level)
+    {
+        auto width = image.getWidth(level);
+        auto height = image.getHeight(level);
+        auto format = image.getGLFormat();
+
+        if (image.isPrecompressed())
+        {
+            if (!isBlockCompressed(format)) return 0;
+
+            auto blockSize = format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ||
+                format == GL_COMPRESSED_RED_RGTC1 ? 8 : 16;
+
+            return ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+        }
+
+        switch (format)
+        {
+        case GL_RGBA:
+        case GL_BGRA:
+            return width * height * 4;
+        case GL_BGR:
+            return width * height * 3;
+        default:
+            return 0;
+        }
+    }
+
+    void expandColour565(uint16_t colour, uint8_t* rgba)
+    {
+        auto red = (colour >> 11) & 0x1f;
+        auto green = (colour >> 5) & 0x3f;
+        auto blue = colour & 0x1f;
+
+        rgba[0] = static_cast<uint8_t>((red << 3) | (red >> 2));
+        rgba[1] = static_cast<uint8_t>((green << 2) | (green >> 4));
+        rgba[2] = static_cast<uint8_t>((blue << 3) | (blue >> 2));
+        rgba[3] = 255;
+    }
+
+    // Decodes the 8 byte colour part of a DXT block into 16 RGBA pixels. DXT1 blocks
+    // with colour0 <= colour1 use three colours plus a transparent black.
+    void decodeColourBlock(const uint8_t* block, uint8_t* pixels, bool isDXT1, uint8_t transparentAlpha)
+    {
+        uint16_t colour0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+        uint16_t colour1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+
+        uint8_t palette[4][4];
+        expandColour565(colour0, palette[0]);
+        expandColour565(colour1, palette[1]);
+
+        bool fourColours = !isDXT1 || colour0 > colour1;
+
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            int first = palette[0][channel];
+            int second = palette[1][channel];
+
+            if (fourColours)
+            {
+                palette[2][channel] = static_cast<uint8_t>((2 * first + second) / 3);
+                palette[3][channel] = static_cast<uint8_t>((first + 2 * second) / 3);
+            }
+            else
+            {
+                palette[2][channel] = static_cast<uint8_t>((first + second) / 2);
+                palette[3][channel] = 0;
+            }
+        }
+
+        palette[2][3] = 255;
+        palette[3][3] = fourColours ? 255 : transparentAlpha;
+
+        uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+
+        for (int pixel = 0; pixel < 16; ++pixel)
+        {
+            std::copy(palette[(indices >> (2 * pixel)) & 3], palette[(indices >> (2 * pixel)) & 3] + 4, pixels + pixel * 4);
+        }
+    }
+
+    // Decodes an 8 byte block of interpolated values (DXT5 alpha, RGTC) into the given channel
+    void decodeInterpolatedBlock(const uint8_t* block, uint8_t* pixels, int channel)
+    {
+        int first = block[0];
+        int second = block[1];
+
+        uint8_t values[8] = { block[0], block[1] };
+
+        if (first > second)
+        {
+            for (int i = 1; i <= 6; ++i)
+            {
+                values[i + 1] = static_cast<uint8_t>(((7 - i) * first + i * second) / 7);
+            }
+        }
+        else
+        {
+            for (int i = 1; i <= 4; ++i)
+            {
+                values[i + 1] = static_cast<uint8_t>(((5 - i) * first + i * second) / 5);
+            }
+
+            values[6] = 0;
+            values[7] = 255;
+        }
+
+        uint64_t indices = 0;
+
+        for (int i = 0; i < 6; ++i)
+        {
+            indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+        }
+
+        for (int pixel = 0; pixel < 16; ++pixel)
+        {
+            pixels[pixel * 4 + channel] = values[(indices >> (3 * pixel)) & 7];
+        }
+    }
+
+    // Decodes the 4 bits per pixel alpha block of DXT3
+    void decodeExplicitAlphaBlock(const uint8_t* block, uint8_t* pixels)
+    {
+        for (int pixel = 0; pixel < 16; ++pixel)
+        {
+            auto alpha = (block[pixel / 2] >> ((pixel & 1) * 4)) & 0x0f;
+            pixels[pixel * 4 + 3] = static_cast<uint8_t>(alpha * 17);
+        }
+    }
+
+    PixelLevel decodeCompressedLevel(const uint8_t* data, std::size_t width, std::size_t height, GLenum format)
+    {
+        PixelLevel level{ width, height, std::vector<uint8_t>(width * height * 4) };
+
+        auto blocksX = (width + 3) / 4;
+        auto blocksY = (height + 3) / 4;
+        std::size_t blockSize = format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ||
+            format == GL_COMPRESSED_RED_RGTC1 ? 8 : 16;
+
+        uint8_t block[16 * 4];
+
+        for (std::size_t blockY = 0; blockY < blocksY; ++blockY)
+        {
+            for (std::size_t blockX = 0; blockX < blocksX; ++blockX, data += blockSize)
+            {
+                switch (format)
+                {
+                case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+                    decodeColourBlock(data, block, true, 255);
+                    break;
+                case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+                    decodeColourBlock(data, block, true, 0);
+                    break;
+                case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+                    decodeColourBlock(data + 8, block, false, 255);
+                    decodeExplicitAlphaBlock(data, block);
+                    break;
+                case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+                    decodeColourBlock(data + 8, block, false, 255);
+                    decodeInterpolatedBlock(data, block, 3);
+                    break;
+                case GL_COMPRESSED_RED_RGTC1:
+                    decodeInterpolatedBlock(data, block, 0);
+
+                    for (int pixel = 0; pixel < 16; ++pixel)
+                    {
+                        block[pixel * 4 + 1] = block[pixel * 4 + 2] = block[pixel * 4];
+                        block[pixel * 4 + 3] = 255;
+                    }
+                    break;
+                case GL_COMPRESSED_RG_RGTC2:
+                    decodeInterpolatedBlock(data, block, 0);
+                    decodeInterpolatedBlock(data + 8, block, 1);
+
+                    // Reconstruct the Z component of the normal
+                    for (int pixel = 0; pixel < 16; ++pixel)
+                    {
+                        auto x = block[pixel * 4] / 127.5 - 1;
+                        auto y = block[pixel * 4 + 1] / 127.5 - 1;
+                        auto z = std::sqrt(std::max(0.0, 1 - x * x - y * y));
+
+                        block[pixel * 4 + 2] = static_cast<uint8_t>((z * 0.5 + 0.5) * 255);
+                        block[pixel * 4 + 3] = 255;
+                    }
+                    break;
+                }
+
+                // Copy the part of the block which is within the image
+                for (std::size_t y = 0; y < 4 && blockY * 4 + y < height; ++y)
+                {
+                    for (std::size_t x = 0; x < 4 && blockX * 4 + x < width; ++x)
+                    {
+                        std::copy(block + (y * 4 + x) * 4, block + (y * 4 + x) * 4 + 4,
+                            level.pixels.data() + ((blockY * 4 + y) * width + blockX * 4 + x) * 4);
+                    }
+                }
+            }
+        }
+
+        return level;
+    }
+
+    // Converts the given level of the image to RGBA. The levels are expected to be stored
+    // consecutively, like the DDS loader does. Returns an empty value for unsupported formats.
+    std::optional<PixelLevel> getLevelPixels(const Image& image, std::size_t level)
+    {
+        std::size_t offset = 0;
+
+        for (std::size_t i = 0; i <= level; ++i)
+        {
+            if (getLevelDataSize(image, i) == 0)
+            {
+                return std::nullopt;
+            }
+
+            if (i < level)
+            {
+                offset += getLevelDataSize(image, i);
+            }
+        }
+
+        const uint8_t* data = image.getPixels() + offset;
+        auto width = image.getWidth(level);
+        auto height = image.getHeight(level);
+        auto format = image.getGLFormat();
+
+        if (image.isPrecompressed())
+        {
+            return decodeCompressedLevel(data, width, height, format);
+        }
+
+        PixelLevel result{ width, height, std::vector<uint8_t>(width * height * 4) };
+
+        if (format == GL_RGBA)
+        {
+            std::copy(data, data + result.pixels.size(), result.pixels.data());
+            return result;
+        }
+
+        // BGR(A) data of uncompressed DDS files
+        auto bytesPerPixel = format == GL_BGR ? 3 : 4;
+
+        for (std::size_t i = 0; i < width * height; ++i, data += bytesPerPixel)
+        {
+            result.pixels[i * 4 + 0] = data[2];
+            result.pixels[i * 4 + 1] = data[1];
+            result.pixels[i * 4 + 2] = data[0];
+            result.pixels[i * 4 + 3] = bytesPerPixel == 4 ? data[3] : 255;
+        }
+
+        return result;
+    }
+
+    // Box filter, every target pixel is the average of the source pixels it covers
+    std::vector<uint8_t> downscale(const PixelLevel& level, std::size_t width, std::size_t height)
+    {
+        std::vector<uint8_t> pixels(width * height * 4);
+
+        for (std::size_t y = 0; y < height; ++y)
+        {
+            auto sourceY0 = y * level.height / height;
+            auto sourceY1 = std::max(sourceY0 + 1, (y + 1) * level.height / height);
+
+            for (std::size_t x = 0; x < width; ++x)
+            {
+                auto sourceX0 = x * level.width / width;
+                auto sourceX1 = std::max(sourceX0 + 1, (x + 1) * level.width / width);
+
+                uint32_t sum[4] = { 0, 0, 0, 0 };
+
+                for (auto sourceY = sourceY0; sourceY < sourceY1; ++sourceY)
+                {
+                    const uint8_t* source = level.pixels.data() + (sourceY * level.width + sourceX0) * 4;
+
+                    for (auto sourceX = sourceX0; sourceX < sourceX1; ++sourceX, source += 4)
+                    {
+                        sum[0] += source[0];
+                        sum[1] += source[1];
+                        sum[2] += source[2];
+                        sum[3] += source[3];
+                    }
+                }
+
+                auto count = static_cast<uint32_t>((sourceY1 - sourceY0) * (sourceX1 - sourceX0));
+                uint8_t* target = pixels.data() + (y * width + x) * 4;
+
+                for (int channel = 0; channel < 4; ++channel)
+                {
+                    target[channel] = static_cast<uint8_t>((sum[channel] + count / 2) / count);
+                }
+            }
+        }
+
+        return pixels;
+    }
+}
+
+ThumbnailCache::ThumbnailCache(const std::string& cachePath) :
+    _cachePath(cachePath),
+    _atlas(THUMBNAIL_SIZE, MAX_ATLAS_PAGES),
+    _pendingTasks(0),
+    _clock(0)
+{}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    cancelPendingTasks();
+}
+
+MaterialThumbnail ThumbnailCache::getThumbnail(const MapExpressionPtr& expression, const void* view)
+{
+    MaterialThumbnail result;
+
+    if (!expression)
+    {
+        result.failed = true;
+        return result;
+    }
+
+    auto& entry = _entries[expression->getIdentifier()];
+
+    if (!entry)
+    {
+        entry = std::make_shared<Entry>();
+        entry->expression = expression;
+        scheduleGeneration(entry);
+    }
+    else if (entry->state == State::Evicted)
+    {
+        // The thumbnail is drawn again, bring it back from the on-disk cache
+        scheduleGeneration(entry);
+    }
+
+    entry->lastUsed = _clock;
+    entry->view = view;
+
+    return getResult(*entry);
+}
+
+MaterialThumbnail ThumbnailCache::findThumbnail(const MapExpressionPtr& expression)
+{
+    if (!expression)
+    {
+        MaterialThumbnail result;
+        result.failed = true;
+        return result;
+    }
+
+    auto entry = _entries.find(expression->getIdentifier());
+
+    return entry != _entries.end() ? getResult(*entry->second) : MaterialThumbnail();
+}
+
+void ThumbnailCache::beginFrame(const void* view)
+{
+    auto& frames = _views[view];
+
+    frames.previous = frames.current;
+    frames.current = ++_clock;
+}
+
+void ThumbnailCache::releaseView(const void* view)
+{
+    _views.erase(view);
+}
+
+MaterialThumbnail ThumbnailCache::getResult(const Entry& entry)
+{
+    MaterialThumbnail result;
+
+    result.failed = entry.state == State::Failed;
+    result.imageWidth = entry.thumbnail.imageWidth;
+    result.imageHeight = entry.thumbnail.imageHeight;
+
+    if (entry.state == State::Uploaded)
+    {
+        // Stay half a texel inside, such that the linear filter doesn't pick up the neighbouring cells
+        constexpr float halfTexel = 0.5f / ThumbnailAtlas::PAGE_SIZE;
+        const auto& slot = *entry.slot;
+
+        result.textureNum = _atlas.getTextureNum(slot);
+        result.s0 = _atlas.getS(slot) + halfTexel;
+        result.t0 = _atlas.getT(slot) + halfTexel;
+        result.s1 = _atlas.getS(slot) + static_cast<float>(entry.thumbnail.width) / ThumbnailAtlas::PAGE_SIZE - halfTexel;
+        result.t1 = _atlas.getT(slot) + static_cast<float>(entry.thumbnail.height) / ThumbnailAtlas::PAGE_SIZE - halfTexel;
+    }
+
+    return result;
+}
+
+bool ThumbnailCache::processUploads()
+{
+    decltype(_finished) finished;
+
+    {
+        std::lock_guard<std::mutex> lock(_finishedLock);
+        finished.swap(_finished);
+    }
+
+    for (auto& [weakEntry, thumbnail] : finished)
+    {
+        auto entry = weakEntry.lock();
+
+        // Skip entries which have been discarded in the meantime
+        if (!entry || entry->state != State::Generating) continue;
+
+        if (!thumbnail)
+        {
+            entry->state = State::Failed;
+            continue;
+        }
+
+        entry->thumbnail = std::move(*thumbnail);
+        entry->state = State::Generated;
+    }
+
+    // Thumbnails which didn't fit into the atlas before are tried again
+    bool uploadsPending = false;
+
+    for (const auto& [identifier, entry] : _entries)
+    {
+        if (entry->state != State::Generated) continue;
+
+        upload(*entry);
+
+        uploadsPending |= entry->state == State::Generated;
+    }
+
+    _tasks.erase(std::remove_if(_tasks.begin(), _tasks.end(),
+        [](const threading::ITaskPtr& task) { return task->isFinished(); }), _tasks.end());
+
+    return uploadsPending || _pendingTasks > 0;
+}
+
+void ThumbnailCache::clear()
+{
+    cancelPendingTasks();
+
+    _entries.clear();
+    _atlas.clear();
+
+    std::lock_guard<std::mutex> lock(_finishedLock);
+    _finished.clear();
+}
+
+std::optional<ThumbnailCache::Thumbnail> ThumbnailCache::createThumbnail(const Image& image)
+{
+    // Use the smallest mipmap level which is still large enough
+    std::size_t level = 0;
+
+    while (level + 1 < image.getLevels() &&
+        std::max(image.getWidth(level + 1), image.getHeight(level + 1)) >= THUMBNAIL_SIZE)
+    {
+        ++level;
+    }
+
+    auto pixels = getLevelPixels(image, level);
+
+    if (!pixels || pixels->width == 0 || pixels->height == 0)
+    {
+        return std::nullopt;
+    }
+
+    Thumbnail thumbnail;
+    thumbnail.imageWidth = image.getWidth();
+    thumbnail.imageHeight = image.getHeight();
+
+    // Fit the thumbnail into the cell, keeping the aspect ratio
+    auto largestSide = std::max(pixels->width, pixels->height);
+
+    if (largestSide <= THUMBNAIL_SIZE)
+    {
+        thumbnail.width = pixels->width;
+        thumbnail.height = pixels->height;
+        thumbnail.pixels = std::move(pixels->pixels);
+        return thumbnail;
+    }
+
+    thumbnail.width = std::max<std::size_t>(1, (pixels->width * THUMBNAIL_SIZE + largestSide / 2) / largestSide);
+    thumbnail.height = std::max<std::size_t>(1, (pixels->height * THUMBNAIL_SIZE + largestSide / 2) / largestSide);
+    thumbnail.pixels = downscale(*pixels, thumbnail.width, thumbnail.height);
+
+    return thumbnail;
+}
+
+void ThumbnailCache::scheduleGeneration(const EntryPtr& entry)
+{
+    entry->state = State::Generating;
+    ++_pendingTasks;
+
+    // The task must not keep the entry alive, it might be discarded before it's finished
+    std::weak_ptr<Entry> weakEntry = entry;
+    auto expression = entry->expression;
+
+    _tasks.push_back(GlobalThreadPool().schedule([this, weakEntry, expression]()
+    {
+        std::optional<Thumbnail> thumbnail;
+
+        try
+        {
+            thumbnail = generateThumbnail(expression);
+        }
+        catch (const std::exception& ex)
+        {
+            rError() << "[shaders] Failed to create thumbnail of " << expression->getIdentifier() << ": " << ex.what() << std::endl;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_finishedLock);
+            _finished.emplace_back(weakEntry, std::move(thumbnail));
+        }
+
+        --_pendingTasks;
+    }));
+}
+
+std::optional<ThumbnailCache::Thumbnail> ThumbnailCache::generateThumbnail(const MapExpressionPtr& expression)
+{
+    std::string vfsPath;
+    std::string cacheFilePath;
+    stream::FileStamp stamp;
+
+    // Only plain image files can be checked for changes, other expressions are evaluated every session
+    if (!_cachePath.empty() && std::dynamic_pointer_cast<ImageExpression>(expression))
+    {
+        vfsPath = GlobalImageLoader().findImageInVFS(expression->getIdentifier());
+
+        if (!vfsPath.empty())
+        {
+            stamp = stream::FileStamp::ofVfsFile(vfsPath);
+        }
+
+        if (stamp.isValid())
+        {
+            cacheFilePath = getCacheFilePath(vfsPath);
+
+            if (auto cached = loadFromCache(cacheFilePath, vfsPath, stamp); cached)
+            {
+                return cached;
+            }
+        }
+    }
+
+    auto image = expression->getImage();
+
+    if (!image)
+    {
+        return std::nullopt;
+    }
+
+    auto thumbnail = createThumbnail(*image);
+
+    if (thumbnail && !cacheFilePath.empty())
+    {
+        saveToCache(cacheFilePath, vfsPath, stamp, *thumbnail);
+    }
+
+    return thumbnail;
+}
+
+void ThumbnailCache::upload(Entry& entry)
+{
+    auto slot = _atlas.allocate();
+
+    if (!slot && evictLeastRecentlyUsed())
+    {
+        slot = _atlas.allocate();
+    }
+
+    // Try again in the next frame
+    if (!slot) return;
+
+    _atlas.upload(*slot, entry.thumbnail.pixels.data(), entry.thumbnail.width, entry.thumbnail.height);
+
+    entry.slot = slot;
+    entry.state = State::Uploaded;
+
+    // The image dimensions are kept, they're needed for the browser layout
+    std::vector<uint8_t>().swap(entry.thumbnail.pixels);
+}
+
+bool ThumbnailCache::evictLeastRecentlyUsed()
+{
+    Entry* candidate = nullptr;
+
+    for (const auto& [identifier, entry] : _entries)
+    {
+        if (entry->state != State::Uploaded || isInUse(*entry)) continue;
+
+        if (!candidate || entry->lastUsed < candidate->lastUsed)
+        {
+            candidate = entry.get();
+        }
+    }
+
+    if (!candidate)
+    {
+        return false;
+    }
+
+    _atlas.release(*candidate->slot);
+    candidate->slot.reset();
+    candidate->state = State::Evicted;
+
+    return true;
+}
+
+bool ThumbnailCache::isInUse(const Entry& entry) const
+{
+    auto view = _views.find(entry.view);
+
+    // Requests outside of any view's frame don't keep the thumbnail
+    return view != _views.end() && entry.lastUsed >= view->second.previous;
+}
+
+void ThumbnailCache::cancelPendingTasks()
+{
+    for (const auto& task : _tasks)
+    {
+        if (task->cancel())
+        {
+            --_pendingTasks;
+        }
+    }
+
+    for (const auto& task : _tasks)
+    {
+        task->wait();
+    }
+
+    _tasks.clear();
+}
+
+std::string ThumbnailCache::getCacheFilePath(const std::string& vfsPath) const
+{
+    std::ostringstream filename;
+    filename << std::hex << std::setfill('0') << std::setw(16) << stream::hashString(vfsPath) << ".thumb";
+
+    return _cachePath + filename.str();
+}
+
+std::optional<ThumbnailCache::Thumbnail> ThumbnailCache::loadFromCache(const std::string& path,
+    const std::string& vfsPath, const stream::FileStamp& stamp)
+{
+    stream::CacheFileReader reader(path, CACHE_IDENTIFIER, CACHE_VERSION);
+
+    if (!reader.isValid())
+    {
+        return std::nullopt;
+    }
+
+    try
+    {
+        // The file is outdated if the image has been changed or the thumbnail size is different
+        if (reader.readString() != vfsPath || reader.readFileStamp() != stamp ||
+            reader.readUInt32() != THUMBNAIL_SIZE)
+        {
+            return std::nullopt;
+        }
+
+        Thumbnail thumbnail;
+        thumbnail.imageWidth = reader.readUInt32();
+        thumbnail.imageHeight = reader.readUInt32();
+        thumbnail.width = reader.readUInt32();
+        thumbnail.height = reader.readUInt32();
+        thumbnail.pixels = reader.readBytes();
+
+        if (thumbnail.width == 0 || thumbnail.height == 0 ||
+            thumbnail.width > THUMBNAIL_SIZE || thumbnail.height > THUMBNAIL_SIZE ||
+            thumbnail.pixels.size() != thumbnail.width * thumbnail.height * 4)
+        {
+            return std::nullopt;
+        }
+
+        return thumbnail;
+    }
+    catch (const stream::CacheFileException& ex)
+    {
+        rWarning() << "Discarding thumbnail cache file " << path << ": " << ex.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+void ThumbnailCache::saveToCache(const std::string& path, const std::string& vfsPath,
+    const stream::FileStamp& stamp, const Thumbnail& thumbnail)
+{
+    stream::CacheFileWriter writer(path, CACHE_IDENTIFIER, CACHE_VERSION);
+
+    writer.writeString(vfsPath);
+    writer.writeFileStamp(stamp);
+    writer.writeUInt32(THUMBNAIL_SIZE);
+    writer.writeUInt32(static_cast<uint32_t>(thumbnail.imageWidth));
+    writer.writeUInt32(static_cast<uint32_t>(thumbnail.imageHeight));
+    writer.writeUInt32(static_cast<uint32_t>(thumbnail.width));
+    writer.writeUInt32(static_cast<uint32_t>(thumbnail.height));
+    writer.writeBytes(thumbnail.pixels.data(), thumbnail.pixels.size());
+
+    writer.commit();
+}
+
+}
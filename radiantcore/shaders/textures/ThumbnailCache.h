@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "ishaders.h"
+#include "ithreadpool.h"
+#include "stream/CacheFile.h"
+#include "ThumbnailAtlas.h"
+#include "../MapExpression.h"
+
+namespace shaders
+{
+
+/**
+ * \brief
+ * Provides downscaled versions of the editor images for the texture browsers.
+ *
+ * Thumbnails are generated on worker threads and packed into a texture atlas,
+ * the full resolution images are never uploaded. Thumbnails of plain image
+ * files are stored in an on-disk cache, keyed by the file's VFS path, size and
+ * modification time, such that later sessions don't need to decode the image.
+ * DDS files are downscaled from the smallest sufficient mipmap level.
+ *
+ * The thumbnails are identified by the editor image expression, materials
+ * sharing the same editor image share their thumbnail. Thumbnails which
+ * haven't been drawn for a while are dropped from the atlas when it is full,
+ * every view drawing thumbnails counts its own frames for that.
+ * Must be used by the thread owning the GL context.
+ */
+class ThumbnailCache :
+    public util::Noncopyable
+{
+public:
+    // Maximum width and height of the thumbnails in pixels
+    static constexpr std::size_t THUMBNAIL_SIZE = 128;
+
+    // The thumbnail pixels and the dimensions of the image it has been created from
+    struct Thumbnail
+    {
+        std::size_t imageWidth = 0;
+        std::size_t imageHeight = 0;
+        std::size_t width = 0;
+        std::size_t height = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+private:
+    enum class State
+    {
+        Generating,
+        Generated,
+        Uploaded,
+        Failed,
+        Evicted,
+    };
+
+    struct Entry
+    {
+        MapExpressionPtr expression;
+        State state = State::Generating;
+        Thumbnail thumbnail;
+        std::optional<ThumbnailAtlas::Slot> slot;
+
+        // The clock value and the view of the last request
+        std::size_t lastUsed = 0;
+        const void* view = nullptr;
+    };
+    using EntryPtr = std::shared_ptr<Entry>;
+
+    std::string _cachePath;
+    ThumbnailAtlas _atlas;
+
+    // Entries by identifier of their map expression
+    std::map<std::string, EntryPtr> _entries;
+
+    // Thumbnails finished by the worker threads, picked up by processUploads()
+    std::mutex _finishedLock;
+    std::vector<std::pair<std::weak_ptr<Entry>, std::optional<Thumbnail>>> _finished;
+
+    std::vector<threading::ITaskPtr> _tasks;
+    std::atomic<std::size_t> _pendingTasks;
+
+    // Incremented by beginFrame(), used to determine the least recently drawn thumbnails
+    std::size_t _clock;
+
+    // The clock values at the start of the current and the previous frame of each view
+    struct ViewFrames
+    {
+        std::size_t previous = 0;
+        std::size_t current = 0;
+    };
+    std::map<const void*, ViewFrames> _views;
+
+public:
+    // Construct a cache storing its files in the given folder,
+    // leave the path empty to disable the on-disk cache.
+    ThumbnailCache(const std::string& cachePath);
+    ~ThumbnailCache();
+
+    // Returns the thumbnail of the given editor image drawn by the given view, generating it if necessary
+    MaterialThumbnail getThumbnail(const MapExpressionPtr& expression, const void* view);
+
+    // Returns the thumbnail of the given editor image if it has been requested before
+    MaterialThumbnail findThumbnail(const MapExpressionPtr& expression);
+
+    // Starts a new frame of the given view, its thumbnails of this and the previous frame are kept
+    void beginFrame(const void* view);
+
+    // Forgets about the given view, its thumbnails can be dropped afterwards
+    void releaseView(const void* view);
+
+    // Uploads the generated thumbnails to the atlas, returns true if there are still thumbnails pending
+    bool processUploads();
+
+    // Discards all thumbnails, e.g. after the images have been reloaded. The files in
+    // the on-disk cache are kept, they're checked against the image files when loading them.
+    void clear();
+
+    // Creates a thumbnail from the given image, fitting it into THUMBNAIL_SIZE while
+    // keeping its aspect ratio. Returns an empty value if the image format is not supported.
+    static std::optional<Thumbnail> createThumbnail(const Image& image);
+
+private:
+    void scheduleGeneration(const EntryPtr& entry);
+    std::optional<Thumbnail> generateThumbnail(const MapExpressionPtr& expression);
+
+    MaterialThumbnail getResult(const Entry& entry);
+
+    void upload(Entry& entry);
+
+    // True if the thumbnail has been drawn in the current or previous frame of its view
+    bool isInUse(const Entry& entry) const;
+
+    // Drops the least recently drawn thumbnail from the atlas, returns false if every thumbnail is in use
+    bool evictLeastRecentlyUsed();
+
+    void cancelPendingTasks();
+
+    std::string getCacheFilePath(const std::string& vfsPath) const;
+    std::optional<Thumbnail> loadFromCache(const std::string& path, const std::string& vfsPath,
+        const stream::FileStamp& stamp);
+    void saveToCache(const std::string& path, const std::string& vfsPath, const stream::FileStamp& stamp,
+        const Thumbnail& thumbnail);
+};
+
+}
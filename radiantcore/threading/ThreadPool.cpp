@@ -0,0 +1,486 @@
+#include "ThreadPool.h"
+
+#include "itextstream.h"
+#include "module/StaticModule.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace threading
+{
+
+class ThreadPool::Task :
+    public ITask
+{
+private:
+    enum class State
+    {
+        Queued,
+        Running,
+        Finished,
+    };
+
+    std::atomic<State> _state;
+    std::atomic<bool> _cancellationRequested;
+    bool _cancelled;
+
+    TaskFunction _function;
+    std::exception_ptr _exception;
+
+    std::mutex _finishedLock;
+    std::condition_variable _finishedSignal;
+
+    // The task executed by the current thread, used by isCancellationRequested()
+    static thread_local Task* _currentTask;
+
+public:
+    Task(const TaskFunction& function) :
+        _state(State::Queued),
+        _cancellationRequested(false),
+        _cancelled(false),
+        _function(function)
+    {}
+
+    bool isFinished() const override
+    {
+        return _state == State::Finished;
+    }
+
+    bool isCancelled() const override
+    {
+        return isFinished() && _cancelled;
+    }
+
+    bool cancel() override
+    {
+        _cancellationRequested = true;
+
+        if (!tryClaim())
+        {
+            return false; // already running or finished
+        }
+
+        _cancelled = true;
+        finish();
+
+        return true;
+    }
+
+    void wait() override
+    {
+        // Run the task right here if no worker has taken it yet
+        if (tryClaim())
+        {
+            execute();
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(_finishedLock);
+            _finishedSignal.wait(lock, [this] { return isFinished(); });
+        }
+
+        if (_exception)
+        {
+            std::rethrow_exception(_exception);
+        }
+    }
+
+    // Claims the task for execution, returns false if it has been claimed before
+    bool tryClaim()
+    {
+        auto expected = State::Queued;
+        return _state.compare_exchange_strong(expected, State::Running);
+    }
+
+    // Runs the function, the task needs to be claimed by the calling thread
+    void execute()
+    {
+        auto previousTask = _currentTask;
+        _currentTask = this;
+
+        try
+        {
+            _function();
+        }
+        catch (...)
+        {
+            _exception = std::current_exception();
+        }
+
+        _currentTask = previousTask;
+
+        finish();
+    }
+
+    static bool currentTaskIsCancelled()
+    {
+        return _currentTask != nullptr && _currentTask->_cancellationRequested;
+    }
+
+private:
+    void finish()
+    {
+        // Release anything captured by the function
+        _function = TaskFunction();
+
+        {
+            std::lock_guard<std::mutex> lock(_finishedLock);
+            _state = State::Finished;
+        }
+
+        _finishedSignal.notify_all();
+    }
+};
+
+thread_local ThreadPool::Task* ThreadPool::Task::_currentTask = nullptr;
+
+namespace
+{
+    // The pool and worker index of the current thread, if it's a worker
+    thread_local ThreadPool* _currentPool = nullptr;
+    thread_local std::size_t _currentWorkerIndex = 0;
+
+    inline std::size_t getPriorityIndex(TaskPriority priority)
+    {
+        return static_cast<std::size_t>(priority);
+    }
+}
+
+ThreadPool::ThreadPool() :
+    _numQueuedTasks(0),
+    _shutdown(false)
+{}
+
+std::string ThreadPool::getName() const
+{
+    static std::string _name(MODULE_THREADPOOL);
+    return _name;
+}
+
+void ThreadPool::initialiseModule(const IApplicationContext& ctx)
+{
+    // Always have a few workers, some of the tasks are waiting for I/O
+    auto numWorkers = std::max<std::size_t>(std::thread::hardware_concurrency(), 2);
+
+    _shutdown = false;
+
+    for (std::size_t i = 0; i < numWorkers; ++i)
+    {
+        _workers.emplace_back(std::make_unique<Worker>());
+    }
+
+    // Start the threads after all workers are in place, they're stealing from each other
+    for (std::size_t i = 0; i < numWorkers; ++i)
+    {
+        _workers[i]->thread = std::thread(&ThreadPool::runWorker, this, i);
+    }
+
+    rMessage() << getName() << ": started " << numWorkers << " worker threads" << std::endl;
+}
+
+void ThreadPool::shutdownModule()
+{
+    stopWorkers();
+}
+
+std::size_t ThreadPool::getNumWorkers() const
+{
+    return _workers.size();
+}
+
+ITaskPtr ThreadPool::schedule(const TaskFunction& function, TaskPriority priority)
+{
+    auto task = std::make_shared<Task>(function);
+    auto runSynchronously = false;
+
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        if (_shutdown || _workers.empty())
+        {
+            runSynchronously = true;
+        }
+        else
+        {
+            // The counter is increased before the task is queued, it's never
+            // lower than the number of queued tasks
+            ++_numQueuedTasks;
+
+            if (_currentPool != this || priority != TaskPriority::Normal)
+            {
+                _sharedQueues[getPriorityIndex(priority)].push_back(task);
+            }
+        }
+    }
+
+    if (runSynchronously)
+    {
+        // No workers (yet or anymore), execute the task right away
+        task->tryClaim();
+        task->execute();
+        return task;
+    }
+
+    // Tasks scheduled by a worker go to its own queue
+    if (_currentPool == this && priority == TaskPriority::Normal)
+    {
+        auto& worker = *_workers[_currentWorkerIndex];
+
+        std::lock_guard<std::mutex> lock(worker.queueLock);
+        worker.queue.push_back(task);
+    }
+
+    _workAvailable.notify_one();
+
+    return task;
+}
+
+bool ThreadPool::isCancellationRequested() const
+{
+    return Task::currentTaskIsCancelled();
+}
+
+void ThreadPool::parallelFor(std::size_t begin, std::size_t end, const IndexFunction& function, std::size_t grainSize)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    auto count = end - begin;
+
+    if (grainSize == 0)
+    {
+        // Use a few chunks per thread to balance differently expensive indices
+        grainSize = std::max<std::size_t>(count / ((_workers.size() + 1) * 8), 1);
+    }
+
+    auto numChunks = (count + grainSize - 1) / grainSize;
+
+    if (numChunks == 1 || _workers.empty())
+    {
+        for (auto i = begin; i < end; ++i)
+        {
+            function(i);
+        }
+
+        return;
+    }
+
+    std::atomic<std::size_t> nextChunk(0);
+    std::atomic<bool> failed(false);
+    std::mutex exceptionLock;
+    std::exception_ptr exception;
+
+    auto processChunks = [&]()
+    {
+        while (!failed)
+        {
+            auto chunk = nextChunk.fetch_add(1);
+
+            if (chunk >= numChunks) break;
+
+            auto first = begin + chunk * grainSize;
+            auto last = std::min(first + grainSize, end);
+
+            try
+            {
+                for (auto i = first; i < last; ++i)
+                {
+                    function(i);
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(exceptionLock);
+
+                if (!exception)
+                {
+                    exception = std::current_exception();
+                }
+
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<ITaskPtr> helpers;
+    auto numHelpers = std::min(_workers.size(), numChunks - 1);
+
+    for (std::size_t i = 0; i < numHelpers; ++i)
+    {
+        helpers.emplace_back(schedule(processChunks, TaskPriority::High));
+    }
+
+    processChunks();
+
+    // All chunks have been taken, helpers which didn't start yet are not needed
+    for (const auto& helper : helpers)
+    {
+        helper->cancel();
+        helper->wait();
+    }
+
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+void ThreadPool::runWorker(std::size_t workerIndex)
+{
+    _currentPool = this;
+    _currentWorkerIndex = workerIndex;
+
+    while (true)
+    {
+        if (auto task = findTask(workerIndex); task)
+        {
+            task->execute();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_lock);
+        _workAvailable.wait(lock, [this] { return _shutdown || _numQueuedTasks > 0; });
+
+        if (_shutdown)
+        {
+            break;
+        }
+    }
+
+    _currentPool = nullptr;
+}
+
+ThreadPool::TaskPtr ThreadPool::findTask(std::size_t workerIndex)
+{
+    auto& worker = *_workers[workerIndex];
+
+    // Entries might have been run by wait() or cancelled, these are skipped
+    auto claim = [](const TaskPtr& task) { return task && task->tryClaim(); };
+
+    // Own tasks first, most recently scheduled ones first
+    while (auto task = popFromWorker(worker, true))
+    {
+        if (claim(task)) return task;
+    }
+
+    while (auto task = popFromSharedQueue(TaskPriority::High))
+    {
+        if (claim(task)) return task;
+    }
+
+    while (auto task = popFromSharedQueue(TaskPriority::Normal))
+    {
+        if (claim(task)) return task;
+    }
+
+    // Steal from the other workers, starting with the next one
+    for (std::size_t i = 1; i < _workers.size(); ++i)
+    {
+        auto& victim = *_workers[(workerIndex + i) % _workers.size()];
+
+        while (auto task = popFromWorker(victim, false))
+        {
+            if (claim(task)) return task;
+        }
+    }
+
+    while (auto task = popFromSharedQueue(TaskPriority::Low))
+    {
+        if (claim(task)) return task;
+    }
+
+    return TaskPtr();
+}
+
+ThreadPool::TaskPtr ThreadPool::popFromSharedQueue(TaskPriority priority)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    auto& queue = _sharedQueues[getPriorityIndex(priority)];
+
+    if (queue.empty())
+    {
+        return TaskPtr();
+    }
+
+    auto task = std::move(queue.front());
+    queue.pop_front();
+    --_numQueuedTasks;
+
+    return task;
+}
+
+ThreadPool::TaskPtr ThreadPool::popFromWorker(Worker& worker, bool fromBack)
+{
+    TaskPtr task;
+
+    {
+        std::lock_guard<std::mutex> lock(worker.queueLock);
+
+        if (worker.queue.empty())
+        {
+            return task;
+        }
+
+        if (fromBack)
+        {
+            task = std::move(worker.queue.back());
+            worker.queue.pop_back();
+        }
+        else
+        {
+            task = std::move(worker.queue.front());
+            worker.queue.pop_front();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    --_numQueuedTasks;
+
+    return task;
+}
+
+void ThreadPool::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _shutdown = true;
+    }
+
+    _workAvailable.notify_all();
+
+    for (const auto& worker : _workers)
+    {
+        worker->thread.join();
+    }
+
+    // Anything left in the queues is not going to run anymore,
+    // cancel it to release threads waiting for these tasks
+    std::vector<TaskPtr> remainingTasks;
+
+    for (auto& queue : _sharedQueues)
+    {
+        remainingTasks.insert(remainingTasks.end(), queue.begin(), queue.end());
+        queue.clear();
+    }
+
+    for (const auto& worker : _workers)
+    {
+        remainingTasks.insert(remainingTasks.end(), worker->queue.begin(), worker->queue.end());
+    }
+
+    _workers.clear();
+    _numQueuedTasks = 0;
+
+    for (const auto& task : remainingTasks)
+    {
+        task->cancel();
+    }
+}
+
+// Static module instance
+module::StaticModuleRegistration<ThreadPool> threadPoolModule;
+
+}
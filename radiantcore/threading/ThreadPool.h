@@ -0,0 +1,72 @@
+#pragma once
+
+#include "ithreadpool.h"
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace threading
+{
+
+class ThreadPool final :
+    public IThreadPool
+{
+private:
+    class Task;
+    using TaskPtr = std::shared_ptr<Task>;
+
+    struct Worker
+    {
+        std::thread thread;
+
+        // Tasks scheduled by this worker, the worker itself is taking from
+        // the back, other workers are stealing from the front
+        std::mutex queueLock;
+        std::deque<TaskPtr> queue;
+    };
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    // Protects the shared queues, the counter and the shutdown flag
+    std::mutex _lock;
+    std::condition_variable _workAvailable;
+
+    // Queues for tasks not scheduled by a worker, indexed by priority
+    std::array<std::deque<TaskPtr>, 3> _sharedQueues;
+
+    // Number of entries in all queues, including the ones already taken by wait()
+    std::size_t _numQueuedTasks;
+
+    bool _shutdown;
+
+public:
+    ThreadPool();
+
+    // RegisterableModule implementation
+    std::string getName() const override;
+    void initialiseModule(const IApplicationContext& ctx) override;
+    void shutdownModule() override;
+
+    std::size_t getNumWorkers() const override;
+    ITaskPtr schedule(const TaskFunction& function, TaskPriority priority) override;
+    bool isCancellationRequested() const override;
+    void parallelFor(std::size_t begin, std::size_t end, const IndexFunction& function,
+        std::size_t grainSize) override;
+
+private:
+    void runWorker(std::size_t workerIndex);
+
+    // Takes the next task to be executed by the given worker from the queues,
+    // returns an empty pointer if there's nothing to do
+    TaskPtr findTask(std::size_t workerIndex);
+
+    TaskPtr popFromSharedQueue(TaskPriority priority);
+    TaskPtr popFromWorker(Worker& worker, bool fromBack);
+
+    void stopWorkers();
+};
+
+}
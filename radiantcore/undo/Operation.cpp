@@ -0,0 +1,229 @@
+#include "Operation.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <zlib.h>
+#include "UndoMementoData.h"
+
+namespace undo
+{
+
+namespace
+{
+    // The shared_ptr control block of every memento, with the arena allocator stored in it
+    constexpr std::size_t STATE_OVERHEAD = 4 * sizeof(void*);
+}
+
+std::size_t Operation::UndoableState::getMemoryUsage() const
+{
+    return sizeof(UndoableState) + STATE_OVERHEAD + _data->getMemoryUsage();
+}
+
+void Operation::UndoableState::saveData(std::ostream& stream)
+{
+    // Mementos can be shared with other operations (e.g. the brush faces do this if they
+    // didn't change in between), these need to stay in memory for the other ones
+    if (!_dataSaved && _data.use_count() == 1)
+    {
+        _dataSaved = _data->saveData(stream);
+    }
+}
+
+void Operation::UndoableState::loadData(std::istream& stream)
+{
+    if (_dataSaved)
+    {
+        _data->loadData(stream);
+        _dataSaved = false;
+    }
+}
+
+Operation::Operation(const std::string& command) :
+    _command(command),
+    _memoryUsage(sizeof(Operation)),
+    _compressed(false),
+    _uncompressedSize(0),
+    _deflated(false)
+{}
+
+Operation::~Operation()
+{
+    releaseSpilledData();
+}
+
+void Operation::save(IUndoable& undoable)
+{
+    if (!_arena)
+    {
+        _arena = MementoArena::Create();
+    }
+
+    // The arena might grow by another block
+    _memoryUsage -= getArenaOverhead();
+
+    // Record the state of the given undable and push it to the snapshot,
+    // the memento is allocated from this operation's arena
+    ScopedMementoArena arenaScope(*_arena);
+
+    _snapshot.emplace_back(undoable);
+    _memoryUsage += _snapshot.back().getMemoryUsage() + getArenaOverhead();
+}
+
+void Operation::restoreSnapshot()
+{
+    decompress();
+
+    // The order is relevant, the most recently added state is restored first
+    for (auto state = _snapshot.rbegin(); state != _snapshot.rend(); ++state)
+    {
+        state->restore();
+    }
+
+    // After all the snapshots have been restored, notify the undoables to give them a chance to cleanup
+    for (auto state = _snapshot.rbegin(); state != _snapshot.rend(); ++state)
+    {
+        state->notifyOperationRestored();
+    }
+}
+
+std::size_t Operation::getMemoryUsage() const
+{
+    return _memoryUsage;
+}
+
+std::size_t Operation::getSpilledSize() const
+{
+    return _spillFile ? static_cast<std::size_t>(_spillLocation.size) : 0;
+}
+
+bool Operation::isCompressed() const
+{
+    return _compressed;
+}
+
+bool Operation::isSpilled() const
+{
+    return _spillFile != nullptr;
+}
+
+void Operation::compress()
+{
+    if (_compressed) return;
+
+    std::ostringstream stream(std::ios::out | std::ios::binary);
+
+    for (auto& state : _snapshot)
+    {
+        state.saveData(stream);
+    }
+
+    auto data = stream.str();
+    _uncompressedSize = data.size();
+    _compressed = true;
+
+    if (!data.empty())
+    {
+        auto compressedSize = compressBound(static_cast<uLong>(data.size()));
+        _compressedData.resize(compressedSize);
+
+        // Undo data is compressed while the user is working, speed matters more than size
+        auto result = compress2(_compressedData.data(), &compressedSize,
+            reinterpret_cast<const Bytef*>(data.data()), static_cast<uLong>(data.size()), Z_BEST_SPEED);
+
+        _deflated = result == Z_OK;
+
+        if (_deflated)
+        {
+            _compressedData.resize(compressedSize);
+            _compressedData.shrink_to_fit();
+        }
+        else
+        {
+            // Keep the data uncompressed, it must not be lost
+            _compressedData.assign(data.begin(), data.end());
+        }
+    }
+
+    updateMemoryUsage();
+}
+
+void Operation::spill(const SpillFile::Ptr& file)
+{
+    if (!_compressed || _spillFile || _compressedData.empty()) return;
+
+    _spillLocation = file->write(_compressedData);
+    _spillFile = file;
+
+    releaseMemory(_compressedData);
+    updateMemoryUsage();
+}
+
+void Operation::decompress()
+{
+    if (!_compressed) return;
+
+    if (_spillFile)
+    {
+        _compressedData = _spillFile->read(_spillLocation);
+        releaseSpilledData();
+    }
+
+    std::string data;
+
+    if (!_deflated)
+    {
+        data.assign(_compressedData.begin(), _compressedData.end());
+    }
+    else
+    {
+        data.resize(_uncompressedSize);
+        auto size = static_cast<uLongf>(data.size());
+
+        auto result = uncompress(reinterpret_cast<Bytef*>(data.data()), &size,
+            _compressedData.data(), static_cast<uLong>(_compressedData.size()));
+
+        if (result != Z_OK || size != _uncompressedSize)
+        {
+            throw std::runtime_error("Failed to decompress undo operation " + _command);
+        }
+    }
+
+    std::istringstream stream(data, std::ios::in | std::ios::binary);
+
+    for (auto& state : _snapshot)
+    {
+        state.loadData(stream);
+    }
+
+    releaseMemory(_compressedData);
+    _uncompressedSize = 0;
+    _compressed = false;
+
+    updateMemoryUsage();
+}
+
+void Operation::releaseSpilledData()
+{
+    if (_spillFile)
+    {
+        _spillFile->release(_spillLocation);
+        _spillFile.reset();
+    }
+}
+
+std::size_t Operation::getArenaOverhead() const
+{
+    return _arena ? _arena->getUnusedCapacity() : 0;
+}
+
+void Operation::updateMemoryUsage()
+{
+    _memoryUsage = sizeof(Operation) + _compressedData.capacity() + getArenaOverhead();
+
+    for (const auto& state : _snapshot)
+    {
+        _memoryUsage += state.getMemoryUsage();
+    }
+}
+
+} // namespace
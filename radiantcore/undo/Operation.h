@@ -2,9 +2,11 @@
 
 #include "iundo.h"
 
-#include <list>
 #include <memory>
 #include <string>
+#include <vector>
+#include "UndoMementoArena.h"
+#include "SpillFile.h"
 
 namespace undo
 {
@@ -13,6 +15,15 @@ namespace undo
  * A named Undo/Redo Operation summarises the state
  * of all the undoable objects that have been touched
  * between start() and finish().
+ *
+ * Operations sitting deep in the history can be compressed, which moves
+ * the data of all mementos supporting IUndoMemento::saveData() into a
+ * single zlib-compressed buffer. The buffer of a compressed operation can
+ * be spilled to a temporary file. Both steps are reverted transparently
+ * when the snapshot is restored.
+ *
+ * The states are stored in a contiguous vector, the mementos themselves
+ * are allocated from the operation's MementoArena.
  */
 class Operation
 {
@@ -22,42 +33,73 @@ private:
 	class UndoableState
 	{
 	private:
-		IUndoable& _undoable;
+		IUndoable* _undoable;
 		IUndoMementoPtr _data;
 
+		// True if the memento's data has been moved to the compressed buffer
+		bool _dataSaved;
+
 	public:
         UndoableState(IUndoable& undoable) :
-            _undoable(undoable),
-            _data(_undoable.exportState())
+            _undoable(&undoable),
+            _data(undoable.exportState()),
+            _dataSaved(false)
         {}
 
-        // Noncopyable
+        // Noncopyable, but needs to be movable to live in a vector
         UndoableState(const UndoableState& other) = delete;
         UndoableState& operator=(const UndoableState& other) = delete;
 
+        UndoableState(UndoableState&& other) noexcept = default;
+        UndoableState& operator=(UndoableState&& other) noexcept = default;
+
 		void restore()
 		{
-			_undoable.importState(_data);
+			_undoable->importState(_data);
 		}
 
         void notifyOperationRestored()
         {
-            _undoable.onOperationRestored();
+            _undoable->onOperationRestored();
         }
+
+        std::size_t getMemoryUsage() const;
+
+        void saveData(std::ostream& stream);
+        void loadData(std::istream& stream);
 	};
 
-	// The Snapshot (the list of structs containing Undoable+Data)
-	std::list<UndoableState> _snapshot;
+	// The Snapshot (Undoable+Data), in the order they have been recorded
+	std::vector<UndoableState> _snapshot;
+
+    // Memory for the mementos, released when the operation and all its mementos are gone
+    MementoArena::Ptr _arena;
 
 	// The name of the UndoOperaton
 	std::string _command;
 
+    // The approximate memory used by the snapshot, updated on save and compression
+    std::size_t _memoryUsage;
+
+    bool _compressed;
+
+    // The compressed memento data and its original size
+    std::vector<unsigned char> _compressedData;
+    std::size_t _uncompressedSize;
+
+    // False if zlib failed and the data is stored as it is
+    bool _deflated;
+
+    // The location of the compressed data, if it has been moved to the file
+    SpillFile::Ptr _spillFile;
+    SpillFile::Location _spillLocation;
+
 public:
     using Ptr = std::shared_ptr<Operation>;
 
-	Operation(const std::string& command) :
-		_command(command)
-	{}
+	Operation(const std::string& command);
+
+    ~Operation();
 
 	const std::string& getName() const
 	{
@@ -74,27 +116,35 @@ public:
         return _snapshot.empty();
     }
 
-	void save(IUndoable& undoable)
-	{
-		// Record the state of the given undable and push it to the snapshot
-		// The order is relevant, we add to the front
-		_snapshot.emplace_front(undoable);
-	}
+	void save(IUndoable& undoable);
 
-	void restoreSnapshot()
-	{
-        // Walk through the snapshot front-to-back, the most recently added one is at the front
-		for (auto& state : _snapshot)
-		{
-            state.restore();
-		}
+	void restoreSnapshot();
 
-        // After all the snapshots have been restored, notify the undoables to give them a chance to cleanup
-        for (auto& state : _snapshot)
-        {
-            state.notifyOperationRestored();
-        }
-	}
+    // The approximate number of bytes this operation is holding in memory
+    std::size_t getMemoryUsage() const;
+
+    // The number of bytes that have been moved to the spill file
+    std::size_t getSpilledSize() const;
+
+    bool isCompressed() const;
+    bool isSpilled() const;
+
+    // Moves the memento data into a compressed buffer, does nothing if already compressed
+    void compress();
+
+    // Moves the compressed buffer to the given file. Only compressed operations can be
+    // spilled. Throws std::runtime_error if writing to the file fails.
+    void spill(const SpillFile::Ptr& file);
+
+private:
+    // Brings the memento data back, throws std::runtime_error if that fails
+    void decompress();
+
+    void releaseSpilledData();
+    void updateMemoryUsage();
+
+    // The unused part of the memento arena, the mementos in it are counted by their states
+    std::size_t getArenaOverhead() const;
 };
 
 } // namespace
@@ -0,0 +1,117 @@
+#include "SpillFile.h"
+
+#include <atomic>
+#include <stdexcept>
+#include "itextstream.h"
+#include <fmt/format.h>
+
+namespace undo
+{
+
+namespace
+{
+    // Every undo system has its own file, even within the same process
+    std::atomic<std::size_t> _spillFileCounter(0);
+}
+
+SpillFile::SpillFile() :
+    _size(0),
+    _usedSize(0),
+    _numChunks(0)
+{
+    auto uniqueId = reinterpret_cast<std::uintptr_t>(this) ^ static_cast<std::uintptr_t>(
+        fs::file_time_type::clock::now().time_since_epoch().count());
+
+    _path = os::getTemporaryPath() / fmt::format("dr_undo_{0:x}_{1}.tmp", uniqueId, ++_spillFileCounter);
+}
+
+SpillFile::~SpillFile()
+{
+    _stream.close();
+
+    try
+    {
+        if (fs::exists(_path))
+        {
+            fs::remove(_path);
+        }
+    }
+    catch (const fs::filesystem_error& ex)
+    {
+        rWarning() << "Could not remove undo file " << _path.string() << ": " << ex.what() << std::endl;
+    }
+}
+
+void SpillFile::open()
+{
+    _stream.open(_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (!_stream.is_open())
+    {
+        throw std::runtime_error("Could not create undo file " + _path.string());
+    }
+
+    _size = 0;
+}
+
+SpillFile::Location SpillFile::write(const std::vector<unsigned char>& data)
+{
+    if (!_stream.is_open())
+    {
+        open();
+    }
+
+    Location location{ _size, data.size() };
+
+    _stream.seekp(static_cast<std::streamoff>(location.offset));
+    _stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    _stream.flush();
+
+    if (!_stream)
+    {
+        _stream.clear();
+        throw std::runtime_error("Could not write to undo file " + _path.string());
+    }
+
+    _size += location.size;
+    _usedSize += location.size;
+    ++_numChunks;
+
+    return location;
+}
+
+std::vector<unsigned char> SpillFile::read(const Location& location)
+{
+    std::vector<unsigned char> data(static_cast<std::size_t>(location.size));
+
+    _stream.seekg(static_cast<std::streamoff>(location.offset));
+    _stream.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+    if (!_stream)
+    {
+        _stream.clear();
+        throw std::runtime_error("Could not read from undo file " + _path.string());
+    }
+
+    return data;
+}
+
+void SpillFile::release(const Location& location)
+{
+    if (_numChunks == 0) return;
+
+    _usedSize -= location.size;
+
+    // Released space is not reused, the file is truncated by the next write() once it's unused
+    if (--_numChunks == 0)
+    {
+        _stream.close();
+    }
+}
+
+std::uint64_t SpillFile::getSize() const
+{
+    return _usedSize;
+}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include "os/fs.h"
+#include "util/Noncopyable.h"
+
+namespace undo
+{
+
+/**
+ * Temporary file receiving the compressed data of undo operations that
+ * don't fit into the memory budget anymore. Data is appended to the end,
+ * the file is truncated once all chunks have been released, and deleted
+ * when this object is destroyed.
+ */
+class SpillFile final :
+    public util::Noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<SpillFile>;
+
+    struct Location
+    {
+        std::uint64_t offset = 0;
+        std::uint64_t size = 0;
+    };
+
+private:
+    fs::path _path;
+    std::fstream _stream;
+
+    std::uint64_t _size;
+    std::uint64_t _usedSize;
+    std::size_t _numChunks;
+
+public:
+    SpillFile();
+    ~SpillFile();
+
+    // Appends the data to the file, throws std::runtime_error on failure
+    Location write(const std::vector<unsigned char>& data);
+
+    // Reads the data at the given location, throws std::runtime_error on failure
+    std::vector<unsigned char> read(const Location& location);
+
+    // Signals that the chunk at the given location is not needed anymore
+    void release(const Location& location);
+
+    // The number of bytes occupied by chunks that haven't been released yet
+    std::uint64_t getSize() const;
+
+private:
+    void open();
+};
+
+}
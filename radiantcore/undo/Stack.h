@@ -50,6 +50,17 @@ public:
 		return _stack.front();
 	}
 
+	// Iteration from the oldest to the most recent operation
+	std::list<Operation::Ptr>::const_iterator begin() const
+	{
+		return _stack.begin();
+	}
+
+	std::list<Operation::Ptr>::const_iterator end() const
+	{
+		return _stack.end();
+	}
+
 	void pop_front()
 	{
 		_stack.pop_front();
@@ -23,13 +23,17 @@ private:
     IUndoable& _undoable;
 	UndoStack* _stack;
 
+    // The scene node the undoable belongs to, reported when the state is saved
+    scene::INode* _node;
+
 public:
     using Ptr = std::shared_ptr<UndoStackFiller>;
 
-    UndoStackFiller(IUndoSystem& owner, IUndoable& undoable) :
+    UndoStackFiller(IUndoSystem& owner, IUndoable& undoable, scene::INode* node) :
         _owner(owner),
         _undoable(undoable),
-        _stack(nullptr)
+        _stack(nullptr),
+        _node(node)
     {}
 
     // Noncopyable
@@ -48,6 +52,8 @@ public:
         // Make sure the stack is dissociated after saving
         // to make sure further saveState() calls don't have any effect
         _stack = nullptr;
+
+        _owner.signal_nodeChanged().emit(_node);
     }
 
     IUndoSystem& getUndoSystem() override
@@ -10,9 +10,16 @@
 namespace undo 
 {
 
+namespace
+{
+	// The most recent operations are kept uncompressed, they are the most likely to be undone
+	constexpr std::size_t UNCOMPRESSED_OPERATIONS = 8;
+}
+
 UndoSystem::UndoSystem() :
 	_activeUndoStack(nullptr),
-	_undoLevels(RKEY_UNDO_QUEUE_SIZE)
+	_undoLevels(RKEY_UNDO_QUEUE_SIZE),
+	_memoryBudget(RKEY_UNDO_MEMORY_BUDGET)
 {}
 
 UndoSystem::~UndoSystem()
@@ -20,9 +27,9 @@ UndoSystem::~UndoSystem()
 	clear();
 }
 
-IUndoStateSaver* UndoSystem::getStateSaver(IUndoable& undoable)
+IUndoStateSaver* UndoSystem::getStateSaver(IUndoable& undoable, scene::INode* node)
 {
-    auto result = _undoables.try_emplace(&undoable, *this, undoable);
+    auto result = _undoables.try_emplace(&undoable, *this, undoable, node);
 
 	// If we're in the middle of an active undo operation, assign this to the tracker (#4861)
 	if (_activeUndoStack != nullptr)
@@ -66,6 +73,8 @@ void UndoSystem::finish(const std::string& command)
 {
 	if (finishUndo(command))
     {
+		enforceMemoryBudget();
+
 		rMessage() << command << std::endl;
         _eventSignal.emit(EventType::OperationRecorded, command);
 	}
@@ -90,9 +99,25 @@ void UndoSystem::undo()
 	rMessage() << "Undo: " << operationName << std::endl;
 
 	startRedo();
-	operation->restoreSnapshot();
+
+	try
+	{
+		operation->restoreSnapshot();
+	}
+	catch (const std::runtime_error& ex)
+	{
+		// The data couldn't be brought back, nothing has been imported at this point
+		rError() << "Undo: " << ex.what() << std::endl;
+
+		_redoStack.cancel();
+		setActiveUndoStack(nullptr);
+		_undoStack.pop_back();
+		return;
+	}
+
 	finishRedo(operationName);
 	_undoStack.pop_back();
+	enforceMemoryBudget();
     _eventSignal.emit(EventType::OperationUndone, operationName);
 }
 
@@ -115,9 +140,24 @@ void UndoSystem::redo()
 	rMessage() << "Redo: " << operationName << std::endl;
 
 	startUndo();
-	operation->restoreSnapshot();
+
+	try
+	{
+		operation->restoreSnapshot();
+	}
+	catch (const std::runtime_error& ex)
+	{
+		rError() << "Redo: " << ex.what() << std::endl;
+
+		_undoStack.cancel();
+		setActiveUndoStack(nullptr);
+		_redoStack.pop_back();
+		return;
+	}
+
 	finishUndo(operationName);
 	_redoStack.pop_back();
+	enforceMemoryBudget();
     _eventSignal.emit(EventType::OperationRedone, operationName);
 }
 
@@ -126,17 +166,39 @@ void UndoSystem::clear()
 	setActiveUndoStack(nullptr);
 	_undoStack.clear();
 	_redoStack.clear();
+	_spillFile.reset();
     _eventSignal.emit(EventType::AllOperationsCleared, std::string());
 
 	// greebo: This is called on map shutdown, so don't clear the observers,
 	// there are some "persistent" observers like EntityInspector and ShaderClipboard
 }
 
+IUndoSystem::MemoryUsage UndoSystem::getMemoryUsage() const
+{
+	MemoryUsage usage;
+
+	for (const auto& stack : { &_undoStack, &_redoStack })
+	{
+		for (const auto& operation : *stack)
+		{
+			usage.inMemory += operation->getMemoryUsage();
+			usage.onDisk += operation->getSpilledSize();
+		}
+	}
+
+	return usage;
+}
+
 sigc::signal<void(IUndoSystem::EventType, const std::string&)>& UndoSystem::signal_undoEvent()
 {
     return _eventSignal;
 }
 
+sigc::signal<void(scene::INode*)>& UndoSystem::signal_nodeChanged()
+{
+    return _nodeChangedSignal;
+}
+
 void UndoSystem::startUndo()
 {
 	_undoStack.start("unnamedCommand");
@@ -174,4 +236,53 @@ void UndoSystem::setActiveUndoStack(UndoStack* stack)
 	}
 }
 
+void UndoSystem::enforceMemoryBudget()
+{
+	// Compress everything but the most recent operations, usually this is just a single one
+	for (auto* stack : { &_undoStack, &_redoStack })
+	{
+		if (stack->size() <= UNCOMPRESSED_OPERATIONS) continue;
+
+		auto numToCompress = stack->size() - UNCOMPRESSED_OPERATIONS;
+
+		for (auto i = stack->begin(); numToCompress > 0; ++i, --numToCompress)
+		{
+			(*i)->compress();
+		}
+	}
+
+	auto budget = _memoryBudget.get() * 1024 * 1024;
+	auto usage = getMemoryUsage().inMemory;
+
+	// Move the oldest compressed operations out of memory until the budget is met
+	for (auto* stack : { &_undoStack, &_redoStack })
+	{
+		for (auto i = stack->begin(); i != stack->end() && usage > budget; ++i)
+		{
+			const auto& operation = *i;
+
+			if (!operation->isCompressed() || operation->isSpilled()) continue;
+
+			if (!_spillFile)
+			{
+				_spillFile = std::make_shared<SpillFile>();
+			}
+
+			auto previousUsage = operation->getMemoryUsage();
+
+			try
+			{
+				operation->spill(_spillFile);
+			}
+			catch (const std::runtime_error& ex)
+			{
+				rWarning() << "Undo history exceeds its memory budget: " << ex.what() << std::endl;
+				return;
+			}
+
+			usage -= previousUsage - operation->getMemoryUsage();
+		}
+	}
+}
+
 } // namespace undo
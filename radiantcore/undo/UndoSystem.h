@@ -9,6 +9,7 @@
 
 #include "Stack.h"
 #include "StackFiller.h"
+#include "SpillFile.h"
 #include "registry/CachedKey.h"
 
 namespace undo
@@ -16,6 +17,9 @@ namespace undo
 
 constexpr const char* const RKEY_UNDO_QUEUE_SIZE = "user/ui/undo/queueSize";
 
+// Memory in MB the undo history may use before old operations are moved to a temporary file
+constexpr const char* const RKEY_UNDO_MEMORY_BUDGET = "user/ui/undo/memoryBudget";
+
 /**
 * greebo: The UndoSystem (interface: iundo.h) is maintaining two internal
 * stacks of Operations (one for Undo, one for Redo), each containing a list
@@ -33,6 +37,10 @@ constexpr const char* const RKEY_UNDO_QUEUE_SIZE = "user/ui/undo/queueSize";
 *
 * The RedoStack is discarded as soon as a new Undoable Operation is recorded
 * and pushed to the UndoStack.
+*
+* Apart from the most recent ones, the operations in the UndoStack are
+* compressed. If the history exceeds its memory budget, the compressed data
+* of the oldest operations is moved to a temporary file.
 */
 class UndoSystem final :
 	public IUndoSystem
@@ -47,14 +55,19 @@ private:
 	std::map<IUndoable*, UndoStackFiller> _undoables;
 
     registry::CachedKey<std::size_t> _undoLevels;
+    registry::CachedKey<std::size_t> _memoryBudget;
+
+    // Created when the first operation is exceeding the memory budget
+    SpillFile::Ptr _spillFile;
 
     sigc::signal<void(EventType, const std::string&)> _eventSignal;
+    sigc::signal<void(scene::INode*)> _nodeChangedSignal;
 
 public:
 	UndoSystem();
 	~UndoSystem();
 
-	IUndoStateSaver* getStateSaver(IUndoable& undoable) override;
+	IUndoStateSaver* getStateSaver(IUndoable& undoable, scene::INode* node) override;
 	void releaseStateSaver(IUndoable& undoable) override;
 
 	void start() override;
@@ -63,12 +76,15 @@ public:
 
 	bool operationStarted() const override;
 
+	MemoryUsage getMemoryUsage() const override;
+
 	void undo() override;
 	void redo() override;
 
 	void clear() override;
 
     sigc::signal<void(EventType, const std::string&)>& signal_undoEvent() override;
+    sigc::signal<void(scene::INode*)>& signal_nodeChanged() override;
 
 private:
 	void startUndo();
@@ -79,6 +95,9 @@ private:
 
 	// Assigns the given stack to all of the Undoables listed in the map
 	void setActiveUndoStack(UndoStack* stack);
+
+	// Compresses older operations and spills them to disk if the budget is exceeded
+	void enforceMemoryBudget();
 };
 
 }
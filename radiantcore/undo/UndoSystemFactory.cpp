@@ -40,6 +40,7 @@ private:
     {
         IPreferencePage& page = GlobalPreferenceSystem().getPage(_("Undo System"));
         page.appendSpinner(_("Undo Queue Size"), RKEY_UNDO_QUEUE_SIZE, 0, 1024, 1);
+        page.appendSpinner(_("Undo Memory Budget (MB)"), RKEY_UNDO_MEMORY_BUDGET, 16, 65536, 16);
     }
 };
 
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <unordered_map>
+#include "iarchive.h"
+#include "string/case_conv.h"
+
+namespace vfs
+{
+
+/**
+ * Hash index over the contents of the PK4 archives known to the VFS,
+ * mapping every lower-cased file path to the archive with the highest
+ * precedence containing that file.
+ *
+ * Archives need to be added in the order of their precedence, the index is
+ * extended with every archive added. Loose directories are not indexed,
+ * since their contents can change while the VFS is running.
+ */
+class ArchiveIndex
+{
+public:
+    struct Entry
+    {
+        // Position of the first archive containing the file, as passed to addArchive()
+        std::size_t archivePosition;
+
+        // Number of indexed archives containing the file
+        std::size_t numArchives;
+    };
+
+private:
+    std::unordered_map<std::string, Entry> _entries;
+
+    class Collector :
+        public IArchive::Visitor
+    {
+    private:
+        ArchiveIndex& _index;
+        std::size_t _archivePosition;
+
+    public:
+        Collector(ArchiveIndex& index, std::size_t archivePosition) :
+            _index(index),
+            _archivePosition(archivePosition)
+        {}
+
+        void visitFile(const std::string& name, IArchiveFileInfoProvider&) override
+        {
+            auto result = _index._entries.emplace(string::to_lower_copy(name), Entry{ _archivePosition, 1 });
+
+            if (!result.second)
+            {
+                // Already provided by an archive of higher precedence
+                ++result.first->second.numArchives;
+            }
+        }
+
+        bool visitDirectory(const std::string&, std::size_t) override
+        {
+            return false; // always descend
+        }
+    };
+
+public:
+    // Adds all files of the given archive, the position is stored with the entries
+    void addArchive(std::size_t archivePosition, IArchive& archive)
+    {
+        Collector collector(*this, archivePosition);
+        archive.traverse(collector, "");
+    }
+
+    // Returns the entry for the given VFS path, or nullptr if no archive contains it
+    const Entry* find(const std::string& filename) const
+    {
+        auto found = _entries.find(string::to_lower_copy(filename));
+        return found != _entries.end() ? &found->second : nullptr;
+    }
+
+    std::size_t size() const
+    {
+        return _entries.size();
+    }
+
+    void clear()
+    {
+        _entries.clear();
+    }
+};
+
+}
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "iarchive.h"
-#include "stream/FileInputStream.h"
+#include "stream/PositionalFileReader.h"
 #include "DeflatedInputStream.h"
 
 namespace archive
@@ -12,28 +12,23 @@ class DeflatedArchiveFile :
 {
 private:
 	std::string _name;
-	stream::FileInputStream _istream;
-	stream::SubFileInputStream _substream;	// provides a subset of _istream
+	stream::PositionalFileInputStream _substream; // reads the file's range of the archive
 	DeflatedInputStream _zipstream; // inflates data from _subStream
-	stream::FileInputStream::size_type _size;
+	std::size_t _size;
 
 public:
-	typedef stream::FileInputStream::size_type size_type;
-	typedef stream::FileInputStream::position_type position_type;
-
 	DeflatedArchiveFile(const std::string& name,
-						const std::string& archiveName, // path to the ZIP file
-						position_type position,
-						size_type stream_size,
-						size_type file_size) :
+						const std::shared_ptr<stream::PositionalFileReader>& archiveFile,
+						std::size_t position,
+						std::size_t stream_size,
+						std::size_t file_size) :
 		_name(name),
-		_istream(archiveName),
-		_substream(_istream, position, stream_size),
+		_substream(archiveFile, position, stream_size),
 		_zipstream(_substream), 
 		_size(file_size)
 	{}
 
-	size_type size() const override
+	std::size_t size() const override
 	{
 		return _size;
 	}
@@ -3,6 +3,7 @@
 #include "iarchive.h"
 #include "iregistry.h"
 #include "stream/BinaryToTextInputStream.h"
+#include "stream/PositionalFileReader.h"
 
 namespace archive
 {
@@ -15,8 +16,7 @@ class DeflatedArchiveTextFile :
 {
 private:
 	std::string _name;
-	stream::FileInputStream _istream;
-	stream::SubFileInputStream _substream;	// reads subset of _istream
+	stream::PositionalFileInputStream _substream; // reads the file's range of the archive
 	DeflatedInputStream _zipstream;	// inflates data from _substream
 	stream::BinaryToTextInputStream<DeflatedInputStream> _textStream; // converts data from _zipstream
 
@@ -24,9 +24,6 @@ private:
     const std::string _modRoot;
 
 public:
-	typedef stream::FileInputStream::size_type size_type;
-	typedef stream::FileInputStream::position_type position_type;
-
     /**
      * Constructor.
      *
@@ -34,13 +31,12 @@ public:
      * The name of the mod directory this file's archive is located in.
      */
     DeflatedArchiveTextFile(const std::string& name,
-                            const std::string& archiveName, // full path to ZIP file
+                            const std::shared_ptr<stream::PositionalFileReader>& archiveFile,
                             const std::string& modRoot,
-                            position_type position,
-                            size_type stream_size) : 
+                            std::size_t position,
+                            std::size_t stream_size) :
 		_name(name),
-		_istream(archiveName),
-		_substream(_istream, position, stream_size),
+		_substream(archiveFile, position, stream_size),
 		_zipstream(_substream),
 		_textStream(_zipstream),
 		_modRoot(modRoot)
@@ -16,6 +16,7 @@
 #include <stdlib.h>
 
 #include "ifilesystem.h"
+#include "imodule.h"
 #include "itextstream.h"
 
 #include "string/join.h"
@@ -36,6 +37,12 @@
 namespace vfs
 {
 
+Doom3FileSystem::Doom3FileSystem() :
+    _indexHits(0),
+    _directoryHits(0),
+    _misses(0)
+{}
+
 void Doom3FileSystem::initDirectory(const std::string& inputPath)
 {
     // greebo: Normalise path: Replace backslashes and ensure trailing slash
@@ -50,7 +57,7 @@ void Doom3FileSystem::initDirectory(const std::string& inputPath)
         entry.archive = std::make_shared<DirectoryArchive>(path);
         entry.is_pakfile = false;
 
-        _archives.push_back(entry);
+        addArchive(entry);
     }
 
     // Instantiate a new sorting container for the filenames
@@ -123,12 +130,19 @@ void Doom3FileSystem::initialise(const SearchPaths& vfsSearchPaths, const std::s
         _allowedExtensionsDir.insert(allowedExtension + "dir");
     }
 
+    _zipDirectoryCache.load(getZipDirectoryCachePath());
+
     // Initialise the paths, in the given order
     for (const std::string& path : _vfsSearchPaths)
     {
         initDirectory(path);
     }
 
+    _zipDirectoryCache.save(getZipDirectoryCachePath());
+
+    rMessage() << "[vfs] Indexed " << _archiveIndex.size() << " files in " <<
+        (_archives.size() - _directoryArchives.size()) << " archives" << std::endl;
+
     signal_Initialised().emit();
 }
 
@@ -140,11 +154,17 @@ bool Doom3FileSystem::isInitialised() const
 void Doom3FileSystem::shutdown()
 {
     _archives.clear();
+    _directoryArchives.clear();
+    _archiveIndex.clear();
     _directories.clear();
     _vfsSearchPaths.clear();
     _allowedExtensions.clear();
     _allowedExtensionsDir.clear();
 
+    _indexHits = 0;
+    _directoryHits = 0;
+    _misses = 0;
+
     rMessage() << "Filesystem shut down" << std::endl;
 }
 
@@ -153,14 +173,63 @@ const std::set<std::string>& Doom3FileSystem::getArchiveExtensions() const
     return _allowedExtensions;
 }
 
+void Doom3FileSystem::addArchive(const ArchiveDescriptor& descriptor)
+{
+    auto position = _archives.size();
+    _archives.push_back(descriptor);
+
+    if (descriptor.is_pakfile)
+    {
+        _archiveIndex.addArchive(position, *descriptor.archive);
+    }
+    else
+    {
+        _directoryArchives.push_back(position);
+    }
+}
+
+template<typename ArchiveFunction>
+auto Doom3FileSystem::findInArchives(const std::string& filename, const ArchiveFunction& function)
+    -> decltype(function(std::declval<const ArchiveDescriptor&>()))
+{
+    auto indexEntry = _archiveIndex.find(filename);
+    auto indexedPosition = indexEntry ? indexEntry->archivePosition : _archives.size();
+
+    // Loose files in directories preceding the indexed archive take precedence
+    for (auto position : _directoryArchives)
+    {
+        if (position > indexedPosition) break;
+
+        if (auto result = function(_archives[position]); result)
+        {
+            ++_directoryHits;
+            return result;
+        }
+    }
+
+    if (indexEntry)
+    {
+        if (auto result = function(_archives[indexedPosition]); result)
+        {
+            ++_indexHits;
+            return result;
+        }
+    }
+
+    ++_misses;
+    return decltype(function(std::declval<const ArchiveDescriptor&>()))();
+}
+
 int Doom3FileSystem::getFileCount(const std::string& filename)
 {
-    int count = 0;
     std::string fixedFilename(os::standardPath(filename));
 
-    for (const ArchiveDescriptor& descriptor : _archives)
+    auto indexEntry = _archiveIndex.find(fixedFilename);
+    int count = indexEntry ? static_cast<int>(indexEntry->numArchives) : 0;
+
+    for (auto position : _directoryArchives)
     {
-        if (descriptor.archive->containsFile(fixedFilename))
+        if (_archives[position].archive->containsFile(fixedFilename))
         {
             ++count;
         }
@@ -171,13 +240,13 @@ int Doom3FileSystem::getFileCount(const std::string& filename)
 
 FileInfo Doom3FileSystem::getFileInfo(const std::string& vfsRelativePath)
 {
-    for (const auto& descriptor : _archives)
+    auto archive = findInArchives(vfsRelativePath, [&](const ArchiveDescriptor& descriptor)
     {
-        if (!descriptor.archive->containsFile(vfsRelativePath))
-        {
-            continue;
-        }
+        return descriptor.archive->containsFile(vfsRelativePath) ? descriptor.archive : IArchive::Ptr();
+    });
 
+    if (archive)
+    {
         // Determine the visibility of this file
         auto topLevelDir = os::getToplevelDirectory(vfsRelativePath);
 
@@ -191,12 +260,23 @@ FileInfo Doom3FileSystem::getFileInfo(const std::string& vfsRelativePath)
             visibility = assetsList->getVisibility(relativePath);
         }
 
-        return FileInfo("", vfsRelativePath, visibility, *descriptor.archive);
+        return FileInfo("", vfsRelativePath, visibility, *archive);
     }
 
     return FileInfo();
 }
 
+LookupStatistics Doom3FileSystem::getLookupStatistics() const
+{
+    LookupStatistics statistics;
+
+    statistics.indexHits = _indexHits;
+    statistics.directoryHits = _directoryHits;
+    statistics.misses = _misses;
+
+    return statistics;
+}
+
 ArchiveFilePtr Doom3FileSystem::openFile(const std::string& filename)
 {
     if (filename.find("\\") != std::string::npos)
@@ -205,18 +285,10 @@ ArchiveFilePtr Doom3FileSystem::openFile(const std::string& filename)
         return ArchiveFilePtr();
     }
 
-    for (const auto& descriptor : _archives)
+    return findInArchives(filename, [&](const ArchiveDescriptor& descriptor)
     {
-        auto file = descriptor.archive->openFile(filename);
-
-        if (file)
-        {
-            return file;
-        }
-    }
-
-    // not found
-    return ArchiveFilePtr();
+        return descriptor.archive->openFile(filename);
+    });
 }
 
 ArchiveFilePtr Doom3FileSystem::openFileInAbsolutePath(const std::string& filename)
@@ -233,17 +305,10 @@ ArchiveFilePtr Doom3FileSystem::openFileInAbsolutePath(const std::string& filena
 
 ArchiveTextFilePtr Doom3FileSystem::openTextFile(const std::string& filename)
 {
-    for (const auto& descriptor : _archives)
+    return findInArchives(filename, [&](const ArchiveDescriptor& descriptor)
     {
-        auto file = descriptor.archive->openTextFile(filename);
-
-        if (file)
-        {
-            return file;
-        }
-    }
-
-    return ArchiveTextFilePtr();
+        return descriptor.archive->openTextFile(filename);
+    });
 }
 
 ArchiveTextFilePtr Doom3FileSystem::openTextFileInAbsolutePath(const std::string& filename)
@@ -364,9 +429,9 @@ void Doom3FileSystem::initPakFile(const std::string& filename)
         ArchiveDescriptor entry;
 
         entry.name = filename;
-        entry.archive = std::make_shared<archive::ZipArchive>(filename);
+        entry.archive = std::make_shared<archive::ZipArchive>(filename, &_zipDirectoryCache);
         entry.is_pakfile = true;
-        _archives.push_back(entry);
+        addArchive(entry);
 
         rMessage() << "[vfs] pak file: " << filename << std::endl;
     }
@@ -379,12 +444,17 @@ void Doom3FileSystem::initPakFile(const std::string& filename)
         entry.name = path;
         entry.archive = std::make_shared<DirectoryArchive>(path);
         entry.is_pakfile = false;
-        _archives.push_back(entry);
+        addArchive(entry);
 
         rMessage() << "[vfs] pak dir:  " << path << std::endl;
     }
 }
 
+std::string Doom3FileSystem::getZipDirectoryCachePath()
+{
+    return module::GlobalModuleRegistry().getApplicationContext().getCacheDataPath() + "startupcache/vfs.cache";
+}
+
 sigc::signal<void>& Doom3FileSystem::signal_Initialised()
 {
     return _sigInitialised;
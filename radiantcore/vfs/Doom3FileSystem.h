@@ -1,8 +1,12 @@
 #pragma once
 
 #include <vector>
+#include <atomic>
+#include <utility>
 #include "iarchive.h"
 #include "ifilesystem.h"
+#include "ArchiveIndex.h"
+#include "ZipDirectoryCache.h"
 
 namespace vfs
 {
@@ -27,11 +31,27 @@ private:
 		bool is_pakfile;
 	};
 
-    std::list<ArchiveDescriptor> _archives;
+    // All archives and directories, ordered by precedence
+    std::vector<ArchiveDescriptor> _archives;
+
+    // Positions of the loose directories in the _archives vector
+    std::vector<std::size_t> _directoryArchives;
+
+    // Locates the files in the PK4 archives
+    ArchiveIndex _archiveIndex;
+
+    // The central directories of the PK4 archives, stored on disk between sessions
+    archive::ZipDirectoryCache _zipDirectoryCache;
+
+    std::atomic<std::size_t> _indexHits;
+    std::atomic<std::size_t> _directoryHits;
+    std::atomic<std::size_t> _misses;
 
     sigc::signal<void> _sigInitialised;
 
 public:
+    Doom3FileSystem();
+
 	void initialise(const SearchPaths& vfsSearchPaths, const std::set<std::string>& allowedExtensions) override;
     bool isInitialised() const override;
 	void shutdown() override;
@@ -68,6 +88,7 @@ public:
 
 	const SearchPaths& getVfsSearchPaths() override;
     FileInfo getFileInfo(const std::string& vfsRelativePath) override;
+    LookupStatistics getLookupStatistics() const override;
 
 	// RegisterableModule implementation
 	std::string getName() const override;
@@ -77,6 +98,18 @@ private:
 	void initDirectory(const std::string& path);
 	void initPakFile(const std::string& filename);
 
+	// Location of the Zip directory cache file
+	static std::string getZipDirectoryCachePath();
+
+    void addArchive(const ArchiveDescriptor& descriptor);
+
+    // Queries the archives containing the given file in the order of their precedence,
+    // returning the first non-empty result of the given function. Loose directories
+    // are probed directly, PK4 archives are located through the index.
+    template<typename ArchiveFunction>
+    auto findInArchives(const std::string& filename, const ArchiveFunction& function)
+        -> decltype(function(std::declval<const ArchiveDescriptor&>()));
+
     std::shared_ptr<AssetsList> findAssetsList(const std::string& topLevelPath);
 };
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "iarchive.h"
+#include "stream/PositionalFileReader.h"
 
 namespace archive
 {
@@ -11,26 +12,21 @@ class StoredArchiveFile :
 {
 private:
 	std::string _name;
-	stream::FileInputStream _filestream;
-	stream::SubFileInputStream _substream;	// provides a subset of _filestream
-	stream::FileInputStream::size_type _size;
+	stream::PositionalFileInputStream _substream; // reads the file's range of the archive
+	std::size_t _size;
 
 public:
-	typedef stream::FileInputStream::size_type size_type;
-	typedef stream::FileInputStream::position_type position_type;
-
 	StoredArchiveFile(const std::string& name,
-					  const std::string& archiveName, // full path to the archive file
-					  position_type position,
-					  size_type stream_size,
-					  size_type file_size) : 
+					  const std::shared_ptr<stream::PositionalFileReader>& archiveFile,
+					  std::size_t position,
+					  std::size_t stream_size,
+					  std::size_t file_size) :
 		_name(name),
-		_filestream(archiveName),
-		_substream(_filestream, position, stream_size),
+		_substream(archiveFile, position, stream_size),
 		_size(file_size)
 	{}
 
-	size_type size() const override
+	std::size_t size() const override
 	{
 		return _size;
 	}
@@ -2,6 +2,7 @@
 
 #include "iarchive.h"
 #include "stream/BinaryToTextInputStream.h"
+#include "stream/PositionalFileReader.h"
 
 namespace archive
 {
@@ -12,16 +13,12 @@ class StoredArchiveTextFile :
 {
 private:
 	std::string _name;
-	stream::FileInputStream _filestream;
-	stream::SubFileInputStream _substream; // provides a subset of _filestream
-	stream::BinaryToTextInputStream<stream::SubFileInputStream> _textStream; // converts data from _substream
+	stream::PositionalFileInputStream _substream; // reads the file's range of the archive
+	stream::BinaryToTextInputStream<stream::PositionalFileInputStream> _textStream; // converts data from _substream
 
 	// Mod root
 	std::string _modRoot;
 public:
-	typedef stream::FileInputStream::size_type size_type;
-	typedef stream::FileInputStream::position_type position_type;
-
 	/**
 	* Constructor.
 	*
@@ -29,13 +26,12 @@ public:
 	* Name of the mod directory containing this file.
 	*/
 	StoredArchiveTextFile(const std::string& name,
-						  const std::string& archiveName,
+						  const std::shared_ptr<stream::PositionalFileReader>& archiveFile,
 						  const std::string& modRoot,
-						  position_type position,
-						  size_type stream_size) : 
+						  std::size_t position,
+						  std::size_t stream_size) :
 		_name(name),
-		_filestream(archiveName),
-		_substream(_filestream, position, stream_size),
+		_substream(archiveFile, position, stream_size),
 		_textStream(_substream),
 		_modRoot(modRoot)
 	{}
@@ -29,12 +29,36 @@ public:
 };
 
 
-ZipArchive::ZipArchive(const std::string& fullPath) :
+ZipArchive::ZipArchive(const std::string& fullPath, ZipDirectoryCache* directoryCache) :
 	_fullPath(fullPath),
 	_containingFolder(os::standardPathWithSlash(fs::path(_fullPath).remove_filename())),
-	_istream(_fullPath)
+	_file(std::make_shared<stream::PositionalFileReader>(_fullPath))
 {
-	if (_istream.failed())
+	if (!_file->isOpen())
+	{
+		rError() << "Cannot open Zip file stream: " << _fullPath << std::endl;
+		return;
+	}
+
+	auto stamp = directoryCache ? stream::FileStamp::ofFile(_fullPath) : stream::FileStamp();
+
+	if (directoryCache)
+	{
+		if (auto entries = directoryCache->find(_fullPath, stamp); entries)
+		{
+			for (const auto& entry : *entries)
+			{
+				addEntry(entry);
+			}
+
+			return;
+		}
+	}
+
+	// The central directory is read sequentially, through a buffered stream
+	stream::FileInputStream istream(_fullPath);
+
+	if (istream.failed())
 	{
 		rError() << "Cannot open Zip file stream: " << _fullPath << std::endl;
 		return;
@@ -43,7 +67,12 @@ ZipArchive::ZipArchive(const std::string& fullPath) :
 	try
 	{
 		// Try loading the zip file, this will throw exceptoions on any problem
-		loadZipFile();
+		auto entries = loadZipFile(istream);
+
+		if (directoryCache)
+		{
+			directoryCache->store(_fullPath, stamp, std::move(entries));
+		}
 	}
 	catch (ZipFailureException& ex)
 	{
@@ -64,32 +93,19 @@ ArchiveFilePtr ZipArchive::openFile(const std::string& name)
 	{
 		const std::shared_ptr<ZipRecord>& file = i->second.getRecord();
 
-		stream::FileInputStream::size_type position = 0;
+		auto position = getDataPosition(*file);
 
+		if (position == 0)
 		{
-			// Guard against concurrent access
-			std::lock_guard<std::mutex> lock(_streamLock);
-
-			_istream.seek(file->position);
-
-			ZipFileHeader header;
-			stream::readZipFileHeader(_istream, header);
-
-			position = _istream.tell();
-
-			if (header.magic != ZIP_MAGIC_FILE_HEADER)
-			{
-				rError() << "Error reading zip file " << _fullPath << std::endl;
-				return ArchiveFilePtr();
-			}
+			return ArchiveFilePtr();
 		}
 
 		switch (file->mode)
 		{
 		case ZipRecord::eStored:
-			return std::make_shared<StoredArchiveFile>(name, _fullPath, position, file->stream_size, file->file_size);
+			return std::make_shared<StoredArchiveFile>(name, _file, position, file->stream_size, file->file_size);
 		case ZipRecord::eDeflated:
-			return std::make_shared<DeflatedArchiveFile>(name, _fullPath, position, file->stream_size, file->file_size);
+			return std::make_shared<DeflatedArchiveFile>(name, _file, position, file->stream_size, file->file_size);
 		}
 	}
 
@@ -104,17 +120,10 @@ ArchiveTextFilePtr ZipArchive::openTextFile(const std::string& name)
 	{
 		const std::shared_ptr<ZipRecord>& file = i->second.getRecord();
 
-		// Guard against concurrent access
-		std::lock_guard<std::mutex> lock(_streamLock);
-
-		_istream.seek(file->position);
+		auto position = getDataPosition(*file);
 
-		ZipFileHeader header;
-		stream::readZipFileHeader(_istream, header);
-
-		if (header.magic != ZIP_MAGIC_FILE_HEADER)
+		if (position == 0)
 		{
-			rError() << "Error reading zip file " << _fullPath << std::endl;
 			return ArchiveTextFilePtr();
 		}
 
@@ -122,12 +131,12 @@ ArchiveTextFilePtr ZipArchive::openTextFile(const std::string& name)
 		{
 		case ZipRecord::eStored:
 			return std::make_shared<StoredArchiveTextFile>(
-                name, _fullPath, _containingFolder, _istream.tell(), file->stream_size
+                name, _file, _containingFolder, position, file->stream_size
             );
 
 		case ZipRecord::eDeflated:
 			return std::make_shared<DeflatedArchiveTextFile>(
-                name, _fullPath, _containingFolder, _istream.tell(), file->stream_size
+                name, _file, _containingFolder, position, file->stream_size
             );
 		}
 	}
@@ -163,10 +172,39 @@ std::string ZipArchive::getArchivePath(const std::string& relativePath)
     return _fullPath;
 }
 
-void ZipArchive::readZipRecord()
+std::size_t ZipArchive::getDataPosition(ZipRecord& record)
+{
+	auto dataPosition = record.dataPosition.load(std::memory_order_relaxed);
+
+	if (dataPosition != 0)
+	{
+		return dataPosition;
+	}
+
+	// Read the local file header, its name and extra field lengths can differ
+	// from the ones in the central directory. Concurrent calls are all storing
+	// the same value, so there's no need to synchronise them.
+	stream::PositionalFileInputStream headerStream(_file, record.position, ZIP_FILE_HEADER_SIZE);
+
+	ZipFileHeader header;
+	stream::readZipFileHeader(headerStream, header);
+
+	if (header.magic != ZIP_MAGIC_FILE_HEADER)
+	{
+		rError() << "Error reading zip file " << _fullPath << std::endl;
+		return 0;
+	}
+
+	dataPosition = record.position + ZIP_FILE_HEADER_SIZE + header.nameLength + header.extras;
+	record.dataPosition.store(dataPosition, std::memory_order_relaxed);
+
+	return dataPosition;
+}
+
+ZipDirectoryEntry ZipArchive::readZipRecord(stream::FileInputStream& istream)
 {
 	ZipMagic magic;
-	stream::readZipMagic(_istream, magic);
+	stream::readZipMagic(istream, magic);
 
 	if (magic != ZIP_MAGIC_ROOT_DIR_ENTRY)
 	{
@@ -174,14 +212,14 @@ void ZipArchive::readZipRecord()
 	}
 
 	ZipVersion version_encoder;
-	stream::readZipVersion(_istream, version_encoder);
+	stream::readZipVersion(istream, version_encoder);
 	ZipVersion version_extract;
-	stream::readZipVersion(_istream, version_extract);
+	stream::readZipVersion(istream, version_extract);
 
 	//unsigned short flags =
-	stream::readLittleEndian<int16_t>(_istream);
+	stream::readLittleEndian<int16_t>(istream);
 	
-	uint16_t compression_mode = stream::readLittleEndian<uint16_t>(_istream);
+	uint16_t compression_mode = stream::readLittleEndian<uint16_t>(istream);
 
 	if (compression_mode != Z_DEFLATED && compression_mode != 0)
 	{
@@ -189,25 +227,25 @@ void ZipArchive::readZipRecord()
 	}
 
 	ZipDosTime dostime;
-	stream::readZipDosTime(_istream, dostime);
+	stream::readZipDosTime(istream, dostime);
 
 	//unsigned int crc32 =
-	stream::readLittleEndian<uint32_t>(_istream);
+	stream::readLittleEndian<uint32_t>(istream);
 	
-	uint32_t compressed_size = stream::readLittleEndian<uint32_t>(_istream);
-	uint32_t uncompressed_size = stream::readLittleEndian<uint32_t>(_istream);
-	uint16_t namelength = stream::readLittleEndian<uint16_t>(_istream);
-	uint16_t extras = stream::readLittleEndian<uint16_t>(_istream);
-	uint16_t comment = stream::readLittleEndian<uint16_t>(_istream);
+	uint32_t compressed_size = stream::readLittleEndian<uint32_t>(istream);
+	uint32_t uncompressed_size = stream::readLittleEndian<uint32_t>(istream);
+	uint16_t namelength = stream::readLittleEndian<uint16_t>(istream);
+	uint16_t extras = stream::readLittleEndian<uint16_t>(istream);
+	uint16_t comment = stream::readLittleEndian<uint16_t>(istream);
 
 	//unsigned short diskstart =
-	stream::readLittleEndian<uint16_t>(_istream);
+	stream::readLittleEndian<uint16_t>(istream);
 	//unsigned short filetype =
-	stream::readLittleEndian<uint16_t>(_istream);
+	stream::readLittleEndian<uint16_t>(istream);
 	//unsigned int filemode =
-	stream::readLittleEndian<uint32_t>(_istream);
+	stream::readLittleEndian<uint32_t>(istream);
 
-	uint32_t position = stream::readLittleEndian<uint32_t>(_istream);
+	uint32_t position = stream::readLittleEndian<uint32_t>(istream);
 
 	// greebo: Read the filename directly into a newly constructed std::string.
 
@@ -218,59 +256,71 @@ void ZipArchive::readZipRecord()
 
 	std::string path(namelength, '\0');
 
-	_istream.read(
+	istream.read(
 		reinterpret_cast<stream::FileInputStream::byte_type*>(const_cast<char*>(path.data())),
 		namelength);
 
-	_istream.seek(extras + comment, stream::FileInputStream::cur);
+	istream.seek(extras + comment, stream::FileInputStream::cur);
 
-	if (os::isDirectory(path))
+	return ZipDirectoryEntry{ std::move(path), position, compressed_size, uncompressed_size,
+		compression_mode == Z_DEFLATED };
+}
+
+void ZipArchive::addEntry(const ZipDirectoryEntry& directoryEntry)
+{
+	if (os::isDirectory(directoryEntry.path))
 	{
-		_filesystem[path].getRecord().reset();
+		_filesystem[directoryEntry.path].getRecord().reset();
 	}
 	else
 	{
-		ZipFileSystem::entry_type& entry = _filesystem[path];
+		ZipFileSystem::entry_type& entry = _filesystem[directoryEntry.path];
 
 		if (!entry.isDirectory())
 		{
-			rWarning() << "Zip archive " << _fullPath << " contains duplicated file: " << path << std::endl;
+			rWarning() << "Zip archive " << _fullPath << " contains duplicated file: " << directoryEntry.path << std::endl;
 		}
 		else
 		{
-			entry.getRecord().reset(new ZipRecord(position,
-				compressed_size,
-				uncompressed_size,
-				(compression_mode == Z_DEFLATED) ? ZipRecord::eDeflated : ZipRecord::eStored));
+			entry.getRecord().reset(new ZipRecord(directoryEntry.position,
+				directoryEntry.compressedSize,
+				directoryEntry.uncompressedSize,
+				directoryEntry.deflated ? ZipRecord::eDeflated : ZipRecord::eStored));
 		}
 	}
 }
 
-void ZipArchive::loadZipFile()
+std::vector<ZipDirectoryEntry> ZipArchive::loadZipFile(stream::FileInputStream& istream)
 {
-	SeekableStream::position_type pos = findZipDiskTrailerPosition(_istream);
+	SeekableStream::position_type pos = findZipDiskTrailerPosition(istream);
 
 	if (pos == 0)
 	{
 		throw ZipFailureException("Unable to locate Zip disk trailer");
 	}
 
-	_istream.seek(pos);
+	istream.seek(pos);
 
 	ZipDiskTrailer trailer;
-	stream::readZipDiskTrailer(_istream, trailer);
+	stream::readZipDiskTrailer(istream, trailer);
 
 	if (trailer.magic != ZIP_MAGIC_DISK_TRAILER)
 	{
 		throw ZipFailureException("Invalid Zip Magic, maybe this is not a zip file?");
 	}
 
-	_istream.seek(trailer.rootseek);
+	istream.seek(trailer.rootseek);
+
+	std::vector<ZipDirectoryEntry> entries;
+	entries.reserve(trailer.entries);
 
 	for (unsigned short i = 0; i < trailer.entries; ++i)
 	{
-		readZipRecord();
+		entries.emplace_back(readZipRecord(istream));
+		addEntry(entries.back());
 	}
+
+	return entries;
 }
 
 }
@@ -2,8 +2,10 @@
 
 #include "iarchive.h"
 #include "GenericFileSystem.h"
+#include "ZipDirectoryCache.h"
 #include "stream/FileInputStream.h"
-#include <mutex>
+#include "stream/PositionalFileReader.h"
+#include <atomic>
 
 namespace archive
 {
@@ -16,6 +18,9 @@ namespace archive
  * physical directories.
  *
  * Archives are owned and instantiated by the GlobalFileSystem instance.
+ *
+ * If a ZipDirectoryCache is passed to the constructor, the central directory
+ * is taken from the cache if the archive didn't change since it was cached.
  */
 class ZipArchive final :
 	public IArchive
@@ -35,12 +40,18 @@ private:
 				  uint32_t uncompressed_size_,
 				  CompressionMode mode_) :
 			position(position_),
+			dataPosition(0),
 			stream_size(compressed_size_),
 			file_size(uncompressed_size_),
 			mode(mode_)
 		{}
 
+		// Offset of the local file header
 		uint32_t position;
+
+		// Offset of the file data following the local file header, 0 until it's been resolved
+		std::atomic<uint32_t> dataPosition;
+
 		uint32_t stream_size;
 		uint32_t file_size;
 		CompressionMode mode;
@@ -51,11 +62,12 @@ private:
 	std::string _fullPath;			// the full path to the Zip file
 	std::string _containingFolder;  // the folder this Zip is located in
 	mutable std::string _modName;	// mod name, calculated based on the containing folder
-	stream::FileInputStream _istream;
-    std::mutex _streamLock;
+
+	// Shared by all opened files, reading at explicit positions without locking
+	std::shared_ptr<stream::PositionalFileReader> _file;
 
 public:
-	ZipArchive(const std::string& fullPath);
+	ZipArchive(const std::string& fullPath, ZipDirectoryCache* directoryCache = nullptr);
 	virtual ~ZipArchive();
 
 	// Archive implementation
@@ -69,8 +81,15 @@ public:
     std::string getArchivePath(const std::string& relativePath) override;
 
 private:
-	void readZipRecord();
-	void loadZipFile();
+	ZipDirectoryEntry readZipRecord(stream::FileInputStream& stream);
+
+	// Reads the central directory, adding all entries to the filesystem
+	std::vector<ZipDirectoryEntry> loadZipFile(stream::FileInputStream& stream);
+
+	void addEntry(const ZipDirectoryEntry& entry);
+
+	// Returns the offset of the record's data, or 0 if the local file header is invalid
+	std::size_t getDataPosition(ZipRecord& record);
 };
 
 }
@@ -0,0 +1,141 @@
+#include "ZipDirectoryCache.h"
+
+#include "itextstream.h"
+
+namespace archive
+{
+
+namespace
+{
+	const char* const CACHE_IDENTIFIER = "DarkRadiant Zip Directory Cache";
+	const uint32_t CACHE_VERSION = 1;
+}
+
+ZipDirectoryCache::ZipDirectoryCache() :
+	_changed(false)
+{}
+
+void ZipDirectoryCache::load(const std::string& cacheFilePath)
+{
+	_archives.clear();
+	_changed = false;
+
+	stream::CacheFileReader reader(cacheFilePath, CACHE_IDENTIFIER, CACHE_VERSION);
+
+	if (!reader.isValid())
+	{
+		return;
+	}
+
+	try
+	{
+		auto numArchives = reader.readUInt32();
+
+		for (uint32_t i = 0; i < numArchives; ++i)
+		{
+			auto archivePath = reader.readString();
+			auto& archive = _archives[archivePath];
+
+			archive.stamp = reader.readFileStamp();
+
+			auto numEntries = reader.readUInt32();
+			archive.entries.reserve(numEntries);
+
+			for (uint32_t e = 0; e < numEntries; ++e)
+			{
+				ZipDirectoryEntry entry;
+
+				entry.path = reader.readString();
+				entry.position = reader.readUInt32();
+				entry.compressedSize = reader.readUInt32();
+				entry.uncompressedSize = reader.readUInt32();
+				entry.deflated = reader.readUInt32() != 0;
+
+				archive.entries.emplace_back(std::move(entry));
+			}
+		}
+	}
+	catch (const stream::CacheFileException& ex)
+	{
+		rWarning() << "Discarding Zip directory cache " << cacheFilePath << ": " << ex.what() << std::endl;
+		_archives.clear();
+	}
+}
+
+void ZipDirectoryCache::save(const std::string& cacheFilePath)
+{
+	// Forget about the archives which are no longer part of the VFS
+	for (auto i = _archives.begin(); i != _archives.end();)
+	{
+		if (!i->second.used)
+		{
+			i = _archives.erase(i);
+			_changed = true;
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	if (!_changed)
+	{
+		return;
+	}
+
+	stream::CacheFileWriter writer(cacheFilePath, CACHE_IDENTIFIER, CACHE_VERSION);
+
+	writer.writeUInt32(static_cast<uint32_t>(_archives.size()));
+
+	for (const auto& [archivePath, archive] : _archives)
+	{
+		writer.writeString(archivePath);
+		writer.writeFileStamp(archive.stamp);
+		writer.writeUInt32(static_cast<uint32_t>(archive.entries.size()));
+
+		for (const auto& entry : archive.entries)
+		{
+			writer.writeString(entry.path);
+			writer.writeUInt32(entry.position);
+			writer.writeUInt32(entry.compressedSize);
+			writer.writeUInt32(entry.uncompressedSize);
+			writer.writeUInt32(entry.deflated ? 1 : 0);
+		}
+	}
+
+	if (writer.commit())
+	{
+		_changed = false;
+	}
+}
+
+const std::vector<ZipDirectoryEntry>* ZipDirectoryCache::find(const std::string& archivePath, const stream::FileStamp& stamp)
+{
+	auto found = _archives.find(archivePath);
+
+	if (found == _archives.end() || found->second.stamp != stamp || !stamp.isValid())
+	{
+		return nullptr;
+	}
+
+	found->second.used = true;
+	return &found->second.entries;
+}
+
+void ZipDirectoryCache::store(const std::string& archivePath, const stream::FileStamp& stamp, std::vector<ZipDirectoryEntry> entries)
+{
+	if (!stamp.isValid())
+	{
+		return;
+	}
+
+	auto& archive = _archives[archivePath];
+
+	archive.stamp = stamp;
+	archive.entries = std::move(entries);
+	archive.used = true;
+
+	_changed = true;
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "stream/CacheFile.h"
+
+namespace archive
+{
+
+// An entry of the central directory of a Zip archive
+struct ZipDirectoryEntry
+{
+	std::string path;
+	uint32_t position;			// offset of the local file header
+	uint32_t compressedSize;
+	uint32_t uncompressedSize;
+	bool deflated;
+};
+
+/**
+ * Persistent cache of the central directories of Zip archives, such that
+ * unchanged archives don't need to be scanned at startup. The cached entries
+ * of an archive are only used while its size and modification time match
+ * the ones recorded when the archive was scanned.
+ */
+class ZipDirectoryCache
+{
+private:
+	struct CachedArchive
+	{
+		stream::FileStamp stamp;
+		std::vector<ZipDirectoryEntry> entries;
+
+		// Whether this archive has been requested since the cache has been loaded
+		bool used = false;
+	};
+
+	std::map<std::string, CachedArchive> _archives;
+
+	bool _changed;
+
+public:
+	ZipDirectoryCache();
+
+	// Replaces the contents of this cache with the ones stored in the given file
+	void load(const std::string& cacheFilePath);
+
+	// Writes the cache to the given file, archives which haven't been requested
+	// since loading the cache are not written. Does nothing if nothing changed.
+	void save(const std::string& cacheFilePath);
+
+	// Returns the cached directory of the given archive, or nullptr if the archive
+	// is unknown or has been modified since it was stored
+	const std::vector<ZipDirectoryEntry>* find(const std::string& archivePath, const stream::FileStamp& stamp);
+
+	// Stores the directory of the given archive
+	void store(const std::string& archivePath, const stream::FileStamp& stamp, std::vector<ZipDirectoryEntry> entries);
+};
+
+}
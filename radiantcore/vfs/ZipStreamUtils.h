@@ -43,6 +43,9 @@ public:
 
 const ZipMagic ZIP_MAGIC_FILE_HEADER('P', 'K', 0x03, 0x04);
 
+// Size of the local file header, not including the file name and the extra field
+const std::size_t ZIP_FILE_HEADER_SIZE = 30;
+
 struct ZipVersion
 {
 	char version;
@@ -161,7 +164,9 @@ inline void readZipDosTime(InputStream& stream, archive::ZipDosTime& dostime)
 	dostime.date = stream::readLittleEndian<uint16_t>(stream);
 }
 
-inline void readZipFileHeader(SeekableInputStream& stream, archive::ZipFileHeader& header)
+// Reads the fixed-size part of the local file header, the file name
+// and the extra field (nameLength + extras bytes) are not consumed
+inline void readZipFileHeader(InputStream& stream, archive::ZipFileHeader& header)
 {
 	stream::readZipMagic(stream, header.magic);
 	stream::readZipVersion(stream, header.extract);
@@ -173,8 +178,6 @@ inline void readZipFileHeader(SeekableInputStream& stream, archive::ZipFileHeade
 	header.uncompressedSize = stream::readLittleEndian<uint32_t>(stream);
 	header.nameLength = stream::readLittleEndian<uint16_t>(stream);
 	header.extras = stream::readLittleEndian<uint16_t>(stream);
-
-	stream.seek(header.nameLength + header.extras, SeekableInputStream::cur);
 };
 
 inline void readZipFileTrailer(InputStream& stream, archive::ZipFileTrailer& trailer)
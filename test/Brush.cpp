@@ -11,8 +11,12 @@
 #include "algorithm/Primitives.h"
 #include "math/Vector3.h"
 #include "os/path.h"
+#include "math/pi.h"
+#include "registry/registry.h"
 #include "testutil/FileSelectionHelper.h"
 
+#include <chrono>
+
 namespace test
 {
 
@@ -443,4 +447,213 @@ TEST_F(BrushTest, LoadBrushWithDuplicatePlanes)
     }
 }
 
+namespace
+{
+
+std::vector<scene::INodePtr> createRotatedCubes(std::size_t numBrushes)
+{
+    auto worldspawn = GlobalMapModule().findOrInsertWorldspawn();
+    std::vector<scene::INodePtr> brushes;
+
+    for (std::size_t i = 0; i < numBrushes; ++i)
+    {
+        auto brushNode = GlobalBrushCreator().createBrush();
+        worldspawn->addChildNode(brushNode);
+
+        auto& brush = *Node_getIBrush(brushNode);
+
+        auto transform = Matrix4::getTranslation(Vector3((i % 100) * 160.0, (i / 100) * 160.0, 0))
+            .getMultipliedBy(Matrix4::getRotationForEulerXYZDegrees(Vector3(i * 7.3, i * 13.1, i * 3.7)));
+
+        brush.addFace(Plane3(+1, 0, 0, 48).transform(transform));
+        brush.addFace(Plane3(-1, 0, 0, 48).transform(transform));
+        brush.addFace(Plane3(0, +1, 0, 48).transform(transform));
+        brush.addFace(Plane3(0, -1, 0, 48).transform(transform));
+        brush.addFace(Plane3(0, 0, +1, 48).transform(transform));
+        brush.addFace(Plane3(0, 0, -1, 48).transform(transform));
+
+        brush.setShader("textures/numbers/" + std::to_string(i % 10));
+        brushes.push_back(brushNode);
+    }
+
+    return brushes;
+}
+
+// Rotates the brushes around the world origin, the bounds changes are collected by the scenegraph
+void rotateBrushes(const std::vector<scene::INodePtr>& brushes, double angle)
+{
+    for (const auto& brush : brushes)
+    {
+        auto transformable = scene::node_cast<ITransformable>(brush);
+        transformable->setRotation(Quaternion::createForZ(angle));
+        transformable->freezeTransform();
+    }
+}
+
+}
+
+// Compares the serial B-rep evaluation of a brush-heavy map to the parallel rebuild
+// of the scenegraph's bounds change batch, which must produce the same windings
+TEST_F(BrushTest, ParallelBRepEvaluation)
+{
+    auto brushes = createRotatedCubes(20000);
+
+    GlobalSceneGraph().beginBoundsChangeBatch();
+    rotateBrushes(brushes, math::PI / 6);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (const auto& brush : brushes)
+    {
+        Node_getIBrush(brush)->evaluateBRep();
+    }
+
+    auto serialTime = std::chrono::steady_clock::now() - start;
+    GlobalSceneGraph().endBoundsChangeBatch();
+
+    std::vector<AABB> serialBounds;
+
+    for (const auto& brush : brushes)
+    {
+        serialBounds.push_back(brush->localAABB());
+    }
+
+    // Rotate back and forth, ending the batch rebuilds the brushes in parallel
+    GlobalSceneGraph().beginBoundsChangeBatch();
+    rotateBrushes(brushes, -math::PI / 6);
+    GlobalSceneGraph().endBoundsChangeBatch();
+
+    GlobalSceneGraph().beginBoundsChangeBatch();
+    rotateBrushes(brushes, math::PI / 6);
+
+    start = std::chrono::steady_clock::now();
+    GlobalSceneGraph().endBoundsChangeBatch();
+    auto batchTime = std::chrono::steady_clock::now() - start;
+
+    for (std::size_t i = 0; i < brushes.size(); ++i)
+    {
+        auto brush = Node_getIBrush(brushes[i]);
+
+        ASSERT_TRUE(brush->hasContributingFaces()) << "Brush " << i << " became degenerate";
+
+        for (std::size_t f = 0; f < brush->getNumFaces(); ++f)
+        {
+            EXPECT_EQ(brush->getFace(f).getWinding().size(), 4) << "Brush " << i << ", face " << f;
+        }
+
+        EXPECT_TRUE(math::isNear(brushes[i]->localAABB().getOrigin(), serialBounds[i].getOrigin(), 0.01));
+        EXPECT_TRUE(math::isNear(brushes[i]->localAABB().getExtents(), serialBounds[i].getExtents(), 0.01));
+    }
+
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    std::cout << "B-rep evaluation of " << brushes.size() << " brushes: "
+        << "serial " << duration_cast<milliseconds>(serialTime).count() << " ms, "
+        << "parallel batch incl. relink " << duration_cast<milliseconds>(batchTime).count() << " ms" << std::endl;
+}
+
+// Every plane kernel has to produce the same windings and classifications as the scalar one
+TEST_F(BrushTest, PlaneKernelsMatchScalar)
+{
+    auto brushes = createRotatedCubes(2000);
+
+    // A few planes cutting through, touching and missing the cubes
+    std::vector<Plane3> planes;
+
+    for (std::size_t i = 0; i < 64; ++i)
+    {
+        auto normal = Vector3(std::sin(i * 0.7), std::cos(i * 1.3), std::sin(i * 2.1)).getNormalised();
+        planes.emplace_back(normal, (i % 8) * 24.0 - 96);
+    }
+
+    std::vector<std::vector<Vector3>> scalarVertices;
+    std::vector<BrushSplitType> scalarSplits;
+
+    for (const auto& kernel : { "scalar", "sse2", "avx2" })
+    {
+        registry::setValue(RKEY_BRUSH_PLANE_KERNEL, kernel);
+
+        // Force all windings to be rebuilt by the selected kernel
+        rotateBrushes(brushes, math::PI / 4);
+        rotateBrushes(brushes, -math::PI / 4);
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::vector<Vector3>> vertices;
+
+        for (const auto& node : brushes)
+        {
+            auto brush = Node_getIBrush(node);
+            brush->evaluateBRep();
+
+            vertices.emplace_back();
+
+            for (std::size_t f = 0; f < brush->getNumFaces(); ++f)
+            {
+                for (const auto& vertex : brush->getFace(f).getWinding())
+                {
+                    vertices.back().push_back(vertex.vertex);
+                }
+            }
+        }
+
+        auto brepTime = std::chrono::steady_clock::now() - start;
+        start = std::chrono::steady_clock::now();
+
+        std::vector<BrushSplitType> splits;
+
+        for (const auto& node : brushes)
+        {
+            auto brush = Node_getIBrush(node);
+
+            for (const auto& plane : planes)
+            {
+                splits.push_back(brush->classifyPlane(plane));
+            }
+        }
+
+        auto classifyTime = std::chrono::steady_clock::now() - start;
+
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+
+        std::cout << "Plane kernel " << kernel << ": B-rep evaluation "
+            << duration_cast<microseconds>(brepTime).count() << " usec, "
+            << splits.size() << " plane classifications "
+            << duration_cast<microseconds>(classifyTime).count() << " usec" << std::endl;
+
+        if (scalarVertices.empty())
+        {
+            scalarVertices = std::move(vertices);
+            scalarSplits = std::move(splits);
+            continue;
+        }
+
+        ASSERT_EQ(vertices.size(), scalarVertices.size());
+
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            ASSERT_EQ(vertices[i].size(), scalarVertices[i].size()) << kernel << ": brush " << i;
+
+            for (std::size_t v = 0; v < vertices[i].size(); ++v)
+            {
+                EXPECT_TRUE(math::isNear(vertices[i][v], scalarVertices[i][v], 1.0 / 256))
+                    << kernel << ": brush " << i << ", vertex " << v;
+            }
+        }
+
+        ASSERT_EQ(splits.size(), scalarSplits.size());
+
+        for (std::size_t i = 0; i < splits.size(); ++i)
+        {
+            EXPECT_EQ(splits[i].counts[0], scalarSplits[i].counts[0]) << kernel << ": classification " << i;
+            EXPECT_EQ(splits[i].counts[1], scalarSplits[i].counts[1]) << kernel << ": classification " << i;
+            EXPECT_EQ(splits[i].counts[2], scalarSplits[i].counts[2]) << kernel << ": classification " << i;
+        }
+    }
+
+    registry::setValue(RKEY_BRUSH_PLANE_KERNEL, "auto");
+}
+
 }
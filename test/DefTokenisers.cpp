@@ -2,6 +2,10 @@
 
 #include "parser/DefTokeniser.h"
 
+#include <chrono>
+#include <sstream>
+#include <fmt/format.h>
+
 namespace test
 {
 
@@ -128,4 +132,142 @@ TEST(DefTokeniser, EmptyQuotesAtEndOfBlock)
     EXPECT_EQ(keyValuePairs["mins"], "-1 -1 -3");
 }
 
+
+inline std::vector<std::string> getAllTokens(parser::DefTokeniser& tokeniser)
+{
+    std::vector<std::string> tokens;
+
+    while (tokeniser.hasMoreTokens())
+    {
+        tokens.emplace_back(tokeniser.nextTokenView());
+    }
+
+    return tokens;
+}
+
+// Some brush-heavy map text, with quoted key values, comments and escapes
+inline std::string generateMapText(std::size_t numBrushes)
+{
+    std::string text = "Version 2\n// entity 0\n{\n\"classname\" \"worldspawn\"\n\"message\" \"a \\\"quoted\\\" text\"\n";
+
+    for (std::size_t i = 0; i < numBrushes; ++i)
+    {
+        text += fmt::format("// primitive {0}\n{{\nbrushDef3\n{{\n", i);
+
+        for (int face = 0; face < 6; ++face)
+        {
+            text += fmt::format("( 0 0 1 -{0} ) ( ( 0.015625 0 255.9375 ) ( 0 0.015625 {1} ) ) "
+                "\"textures/darkmod/stone/brick/blocks_brown\" 0 0 0\n", i * 8 + face, face);
+        }
+
+        text += "}\n}\n";
+    }
+
+    text += "/* end of worldspawn */ }\n";
+
+    return text;
+}
+
+TEST(DefTokeniser, StringViewTokeniserMatchesStringTokeniser)
+{
+    std::vector<std::string> testStrings =
+    {
+        "",
+        " \t \r\n\t",
+        R"("inherit"					"atdm:mover_handle_base")",
+        R"(		"" )",
+        R"( "inherit"	"atdm:" \
+    "mover_handle_base")",
+        R"( "inherit"	"atdm:" \ 	 
+    "mover_handle_base")",
+        R"("with \"escaped\" quotes\n and\ttabs" "back\slash")",
+        "key//comment\nvalue/*block*/next/**/ ** /***/ a/b /",
+        "( 1 2 3 ){}(),token\"quoted\"token",
+        "\"unterminated",
+        generateMapText(10),
+    };
+
+    for (const auto& testString : testStrings)
+    {
+        parser::BasicDefTokeniser<std::string> stringTokeniser(testString, parser::WHITESPACE, "{}(),");
+        parser::BasicDefTokeniser<std::string_view> viewTokeniser(testString, parser::WHITESPACE, "{}(),");
+
+        EXPECT_EQ(getAllTokens(viewTokeniser), getAllTokens(stringTokeniser)) << "Token mismatch in " << testString;
+    }
+}
+
+TEST(DefTokeniser, StringViewTokeniserPeekAndAssert)
+{
+    std::string testString = R"({ "key" "value" })";
+    parser::BasicDefTokeniser<std::string_view> tokeniser(testString);
+
+    EXPECT_EQ(tokeniser.peek(), "{");
+    tokeniser.assertNextToken("{");
+
+    // Unescaped quoted tokens point into the source buffer
+    auto key = tokeniser.nextTokenView();
+    EXPECT_EQ(key, "key");
+    EXPECT_EQ(key.data(), testString.data() + 3);
+
+    EXPECT_THROW(tokeniser.assertNextToken("{"), parser::ParseException);
+
+    tokeniser.skipTokens(1);
+    EXPECT_FALSE(tokeniser.hasMoreTokens());
+    EXPECT_THROW(tokeniser.nextTokenView(), parser::ParseException);
+}
+
+TEST(DefTokeniser, StringViewTokeniserMissingContinuationQuote)
+{
+    std::string testString = R"("abc" \ def)";
+    parser::BasicDefTokeniser<std::string_view> tokeniser(testString);
+
+    EXPECT_THROW(tokeniser.nextTokenView(), parser::ParseException);
+}
+
+// Compares the time needed to tokenise a large map using the stream-based tokeniser and the view tokeniser
+TEST(DefTokeniser, StringViewTokeniserPerformance)
+{
+    auto mapText = generateMapText(20000);
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::istringstream stream(mapText);
+    parser::BasicDefTokeniser<std::istream> streamTokeniser(stream);
+
+    std::size_t streamTokenCount = 0;
+    std::size_t streamTokenLength = 0;
+
+    while (streamTokeniser.hasMoreTokens())
+    {
+        streamTokenLength += streamTokeniser.nextToken().length();
+        ++streamTokenCount;
+    }
+
+    auto streamTime = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+
+    parser::BasicDefTokeniser<std::string_view> viewTokeniser(mapText, parser::WHITESPACE, "{}(),");
+
+    std::size_t viewTokenCount = 0;
+    std::size_t viewTokenLength = 0;
+
+    while (viewTokeniser.hasMoreTokens())
+    {
+        viewTokenLength += viewTokeniser.nextTokenView().length();
+        ++viewTokenCount;
+    }
+
+    auto viewTime = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(viewTokenCount, streamTokenCount);
+    EXPECT_EQ(viewTokenLength, streamTokenLength);
+
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    std::cout << "Tokenised " << mapText.size() << " bytes (" << viewTokenCount << " tokens): "
+        << "std::istream tokeniser " << duration_cast<milliseconds>(streamTime).count() << " ms, "
+        << "std::string_view tokeniser " << duration_cast<milliseconds>(viewTime).count() << " ms" << std::endl;
+}
+
 }
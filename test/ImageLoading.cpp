@@ -2,6 +2,9 @@
 
 #include "iimage.h"
 #include "RGBAImage.h"
+#include <chrono>
+#include <fstream>
+#include "os/fs.h"
 
 // Helpers for examining pixel data
 using RGB8 = BasicVector3<uint8_t>;
@@ -239,4 +242,282 @@ TEST_F(ImageLoadingTest, LoadDDSCompressedBC5MipMaps)
     EXPECT_EQ(img->getGLFormat(), GL_COMPRESSED_RG_RGTC2);
 }
 
-}
\ No newline at end of file
+namespace
+{
+
+// Fills the image with a gradient, to have the mipmap filter work on something
+void fillTestPattern(image::RGBAImage& image)
+{
+    for (std::size_t y = 0; y < image.getHeight(); ++y)
+    {
+        for (std::size_t x = 0; x < image.getWidth(); ++x)
+        {
+            image.pixels[y * image.getWidth() + x] = image::RGBAPixel{
+                static_cast<uint8_t>(x), static_cast<uint8_t>(y), static_cast<uint8_t>(x ^ y), 255
+            };
+        }
+    }
+}
+
+GLint getTextureLevelSize(GLuint textureNum, GLint level, GLenum dimension)
+{
+    GLint size = 0;
+
+    glBindTexture(GL_TEXTURE_2D, textureNum);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, level, dimension, &size);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return size;
+}
+
+}
+
+// Uploading an RGBA image creates its full mipmap chain, without rescaling non-power-of-two images
+TEST_F(ImageLoadingTest, BindRGBAImageGeneratesMipMaps)
+{
+    image::RGBAImage image(600, 200);
+    fillTestPattern(image);
+
+    auto texture = image.bindTexture("npot", BindableTexture::Role::COLOUR);
+    ASSERT_TRUE(texture);
+
+    EXPECT_EQ(texture->getWidth(), 600);
+    EXPECT_EQ(texture->getHeight(), 200);
+
+    EXPECT_EQ(getTextureLevelSize(texture->getGLTexNum(), 0, GL_TEXTURE_WIDTH), 600);
+    EXPECT_EQ(getTextureLevelSize(texture->getGLTexNum(), 0, GL_TEXTURE_HEIGHT), 200);
+    EXPECT_EQ(getTextureLevelSize(texture->getGLTexNum(), 1, GL_TEXTURE_WIDTH), 300);
+    EXPECT_EQ(getTextureLevelSize(texture->getGLTexNum(), 1, GL_TEXTURE_HEIGHT), 100);
+
+    // The smallest level of the chain is 1x1, which is level 9 for a width of 600
+    EXPECT_EQ(getTextureLevelSize(texture->getGLTexNum(), 9, GL_TEXTURE_WIDTH), 1);
+    EXPECT_EQ(getTextureLevelSize(texture->getGLTexNum(), 9, GL_TEXTURE_HEIGHT), 1);
+}
+
+// Measures the upload time of typically sized textures, including their mipmaps
+TEST_F(ImageLoadingTest, BindRGBAImagePerformance)
+{
+    const std::vector<std::pair<std::size_t, std::size_t>> sizes
+    {
+        { 1024, 1024 }, { 2048, 1024 }, { 2048, 2048 }, { 1536, 1024 },
+    };
+
+    constexpr int NumRuns = 5;
+
+    for (const auto& [width, height] : sizes)
+    {
+        image::RGBAImage image(width, height);
+        fillTestPattern(image);
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < NumRuns; ++i)
+        {
+            auto texture = image.bindTexture("benchmark", BindableTexture::Role::COLOUR);
+            EXPECT_TRUE(texture);
+        }
+
+        glFinish();
+
+        auto msecs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "Uploading a " << width << "x" << height << " image with mipmaps took "
+            << (msecs / NumRuns) << " msec on average" << std::endl;
+    }
+}
+
+namespace
+{
+
+// Colour of the TGA test pattern at the given position, counted from the top left corner
+image::RGBAPixel getTargaTestPixel(std::size_t x, std::size_t y)
+{
+    // Every third row is uniform, to have RLE runs spanning multiple rows
+    if (y % 3 == 0)
+    {
+        return image::RGBAPixel{ 10, static_cast<uint8_t>(y), 200, 128 };
+    }
+
+    return image::RGBAPixel{
+        static_cast<uint8_t>(x), static_cast<uint8_t>(y), static_cast<uint8_t>((x + y) * 7), static_cast<uint8_t>(x * 3)
+    };
+}
+
+// Writes a TGA file containing the test pattern, using the given pixel size, compression and origin attributes
+void writeTargaTestFile(const std::string& path, std::size_t width, std::size_t height,
+    int pixelSize, bool rle, uint8_t attributes)
+{
+    std::vector<uint8_t> data =
+    {
+        0, 0, static_cast<uint8_t>(rle ? 10 : 2), 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        static_cast<uint8_t>(width & 0xff), static_cast<uint8_t>(width >> 8),
+        static_cast<uint8_t>(height & 0xff), static_cast<uint8_t>(height >> 8),
+        static_cast<uint8_t>(pixelSize), attributes
+    };
+
+    // Collect the pixels in file order
+    std::vector<image::RGBAPixel> pixels;
+
+    for (std::size_t row = 0; row < height; ++row)
+    {
+        for (std::size_t column = 0; column < width; ++column)
+        {
+            auto x = (attributes & 0x10) != 0 ? width - 1 - column : column;
+            auto y = (attributes & 0x20) != 0 ? row : height - 1 - row;
+
+            pixels.push_back(getTargaTestPixel(x, y));
+        }
+    }
+
+    auto writePixel = [&](const image::RGBAPixel& pixel)
+    {
+        data.insert(data.end(), { pixel.blue, pixel.green, pixel.red });
+
+        if (pixelSize == 32)
+        {
+            data.push_back(pixel.alpha);
+        }
+    };
+
+    auto isEqual = [](const image::RGBAPixel& a, const image::RGBAPixel& b)
+    {
+        return a.red == b.red && a.green == b.green && a.blue == b.blue && a.alpha == b.alpha;
+    };
+
+    for (std::size_t i = 0; i < pixels.size();)
+    {
+        if (!rle)
+        {
+            writePixel(pixels[i++]);
+            continue;
+        }
+
+        // Runs of equal pixels are written as RLE packets, everything else as raw packets
+        std::size_t count = 1;
+
+        while (i + count < pixels.size() && count < 128 && isEqual(pixels[i + count], pixels[i]))
+        {
+            ++count;
+        }
+
+        if (count > 1)
+        {
+            data.push_back(static_cast<uint8_t>(0x80 | (count - 1)));
+            writePixel(pixels[i]);
+        }
+        else
+        {
+            while (i + count < pixels.size() && count < 128 && !isEqual(pixels[i + count], pixels[i + count - 1]))
+            {
+                ++count;
+            }
+
+            data.push_back(static_cast<uint8_t>(count - 1));
+
+            for (std::size_t j = 0; j < count; ++j)
+            {
+                writePixel(pixels[i + j]);
+            }
+        }
+
+        i += count;
+    }
+
+    std::ofstream stream(path, std::ios::binary);
+    stream.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+}
+
+// All combinations of compression, pixel size and origin should decode to the same pixels,
+// the image is large enough to be decoded by multiple threads
+TEST_F(ImageLoadingTest, LoadTGAVariants)
+{
+    constexpr std::size_t Width = 300;
+    constexpr std::size_t Height = 257;
+
+    for (auto rle : { false, true })
+    {
+        for (auto pixelSize : { 24, 32 })
+        {
+            for (uint8_t attributes : { 0x00, 0x10, 0x20, 0x30 })
+            {
+                auto path = _context.getTemporaryDataPath() + "variant.tga";
+                writeTargaTestFile(path, Width, Height, pixelSize, rle, attributes);
+
+                auto img = GlobalImageLoader().imageFromFile(path);
+                ASSERT_TRUE(img) << "Failed to load TGA, rle: " << rle << ", bits: " << pixelSize
+                    << ", attributes: " << int(attributes);
+
+                EXPECT_EQ(img->getWidth(), Width);
+                EXPECT_EQ(img->getHeight(), Height);
+
+                Pixelator<image::RGBAPixel> pixels(*img);
+                std::size_t mismatches = 0;
+
+                for (std::size_t y = 0; y < Height; ++y)
+                {
+                    for (std::size_t x = 0; x < Width; ++x)
+                    {
+                        auto expected = getTargaTestPixel(x, y);
+                        const auto& actual = pixels(static_cast<int>(x), static_cast<int>(y));
+
+                        if (actual.red != expected.red || actual.green != expected.green || actual.blue != expected.blue ||
+                            actual.alpha != (pixelSize == 32 ? expected.alpha : 255))
+                        {
+                            ++mismatches;
+                        }
+                    }
+                }
+
+                EXPECT_EQ(mismatches, 0) << "Pixel mismatch, rle: " << rle << ", bits: " << pixelSize
+                    << ", attributes: " << int(attributes);
+            }
+        }
+    }
+}
+
+// Truncated files should be rejected instead of reading beyond the end of the data
+TEST_F(ImageLoadingTest, LoadTruncatedTGA)
+{
+    for (auto rle : { false, true })
+    {
+        auto path = _context.getTemporaryDataPath() + "truncated.tga";
+        writeTargaTestFile(path, 64, 64, 32, rle, 0);
+
+        fs::resize_file(path, fs::file_size(path) - 10);
+
+        EXPECT_FALSE(GlobalImageLoader().imageFromFile(path)) << "Truncated image should fail to load, rle: " << rle;
+    }
+}
+
+// Batch requests deliver the images in the requested order, with empty pointers for missing files
+TEST_F(ImageLoadingTest, LoadImageBatch)
+{
+    auto images = GlobalImageLoader().imagesFromFiles({
+        _context.getTestProjectPath() + "textures/a_1024x512.tga",
+        _context.getTestProjectPath() + "textures/pngs/twentyone_8bit.png",
+        _context.getTestProjectPath() + "textures/nonexistent.tga",
+        _context.getTestProjectPath() + "textures/numbers/1.tga",
+    });
+
+    ASSERT_EQ(images.size(), 4);
+    ASSERT_TRUE(images[0]);
+    EXPECT_EQ(images[0]->getWidth(), 1024);
+    EXPECT_EQ(images[0]->getHeight(), 512);
+    ASSERT_TRUE(images[1]);
+    EXPECT_EQ(images[1]->getWidth(), 32);
+    EXPECT_FALSE(images[2]) << "Missing file should result in an empty pointer";
+    ASSERT_TRUE(images[3]);
+    EXPECT_EQ(images[3]->getWidth(), 32);
+
+    auto vfsImages = GlobalImageLoader().imagesFromVFS({ "textures/numbers/2", "textures/a_1024x512" });
+
+    ASSERT_EQ(vfsImages.size(), 2);
+    ASSERT_TRUE(vfsImages[0]);
+    EXPECT_EQ(vfsImages[0]->getWidth(), 32);
+    ASSERT_TRUE(vfsImages[1]);
+    EXPECT_EQ(vfsImages[1]->getWidth(), 1024);
+}
+
+}
@@ -8,9 +8,12 @@
 #include "imapresource.h"
 #include "ifilesystem.h"
 #include "iradiant.h"
+#include "iselection.h"
 #include "iselectiongroup.h"
+#include "ieditstopwatch.h"
 #include "ilightnode.h"
 #include "icommandsystem.h"
+#include "scenelib.h"
 #include "messages/ApplicationShutdownRequest.h"
 #include "messages/FileSelectionRequest.h"
 #include "messages/FileOverwriteConfirmation.h"
@@ -20,12 +23,16 @@
 #include "algorithm/Scene.h"
 #include "algorithm/XmlUtils.h"
 #include "algorithm/Primitives.h"
+#include "algorithm/FileUtils.h"
 #include "os/file.h"
 #include <sigc++/connection.h>
 #include "testutil/FileSelectionHelper.h"
 #include "testutil/FileSaveConfirmationHelper.h"
 #include "registry/registry.h"
 #include "testutil/TemporaryFile.h"
+#include <chrono>
+#include <mutex>
+#include <algorithm>
 
 using namespace std::chrono_literals;
 
@@ -455,6 +462,33 @@ TEST_F(MapLoadingTest, loadMapxInResourceOnly)
     checkAltarScene(resource->getRootNode());
 }
 
+// Loads the given map and returns the text of all its nodes in Doom 3 format
+std::string loadMapAndExportToString(const std::string& mapPath)
+{
+    GlobalCommandSystem().executeCommand("OpenMap", mapPath);
+    GlobalSelectionSystem().setSelectedAll(true);
+
+    auto format = GlobalMapFormatManager().getMapFormatForGameType("doom3", "map");
+
+    std::ostringstream output;
+    GlobalMapModule().exportSelected(output, format);
+
+    return output.str();
+}
+
+TEST_F(MapLoadingTest, parallelLoadingProducesIdenticalScene)
+{
+    registry::setValue(map::RKEY_MAP_PARALLEL_LOADING, false);
+    auto serialText = loadMapAndExportToString("maps/altar.map");
+
+    registry::setValue(map::RKEY_MAP_PARALLEL_LOADING, true);
+    auto parallelText = loadMapAndExportToString("maps/altar.map");
+
+    checkAltarSceneGeometry();
+    EXPECT_FALSE(serialText.empty());
+    EXPECT_EQ(serialText, parallelText) << "Parallel loading produced a different scene";
+}
+
 TEST_F(MapSavingTest, saveMapWithoutModification)
 {
     auto tempPath = createMapCopyInTempDataPath("altar.map", "altar_saveMapWithoutModification.map");
@@ -1231,6 +1265,7 @@ TEST_F(MapSavingTest, AutoSaverDoesntChangeSaveCopyAsFilename)
 
     // Now trigger an autosave
     GlobalAutoSaver().performAutosave();
+    GlobalAutoSaver().finishPendingSave();
 
     // This will (again) ask for a file name, now we check what map file name it remembered and
     // sent to the request handler as default file name
@@ -1242,6 +1277,12 @@ TEST_F(MapSavingTest, AutoSaverDoesntChangeSaveCopyAsFilename)
     EXPECT_EQ(pathThatWasSentAsDefaultPath, tempPath.string()) << "Autosaver overwrote the stored file name for 'Save Copy As'";
 
     GlobalRadiantCore().getMessageBus().removeListener(msgSubscription);
+
+    // Remove the autosave files written next to the map
+    fs::path autosavePath = GlobalFileSystem().findFile(modRelativePath) + "maps/altar_autosave.map";
+    fs::remove(autosavePath);
+    fs::remove(fs::path(autosavePath).replace_extension("darkradiant"));
+    fs::remove(fs::path(autosavePath).replace_extension("journal"));
 }
 
 TEST_F(MapSavingTest, AutoSaveSnapshotsSupportRelativePaths)
@@ -1259,8 +1300,9 @@ TEST_F(MapSavingTest, AutoSaveSnapshotsSupportRelativePaths)
 
     EXPECT_FALSE(GlobalFileSystem().openTextFile(expectedSnapshotPath)) << "Snapshot already exists in " << expectedSnapshotPath;
 
-    // Trigger an auto save now
+    // Trigger an auto save now, the files are written in the background
     GlobalAutoSaver().performAutosave();
+    GlobalAutoSaver().finishPendingSave();
 
     EXPECT_TRUE(GlobalFileSystem().openTextFile(expectedSnapshotPath)) << "Snapshot should now exist in " << expectedSnapshotPath;
 
@@ -1294,8 +1336,9 @@ TEST_F(MapSavingTest, AutoSaveSnapshotsSupportAbsolutePaths)
 
     EXPECT_FALSE(GlobalFileSystem().openTextFileInAbsolutePath(expectedSnapshotPath)) << "Snapshot already exists in " << expectedSnapshotPath;
 
-    // Trigger an auto save now
+    // Trigger an auto save now, the files are written in the background
     GlobalAutoSaver().performAutosave();
+    GlobalAutoSaver().finishPendingSave();
 
     EXPECT_TRUE(GlobalFileSystem().openTextFileInAbsolutePath(expectedSnapshotPath)) << "Snapshot should now exist in " << expectedSnapshotPath;
 
@@ -1307,6 +1350,47 @@ TEST_F(MapSavingTest, AutoSaveSnapshotsSupportAbsolutePaths)
     fs::remove(expectedSnapshotPath);
 }
 
+TEST_F(MapSavingTest, AutoSaveSnapshotReportsProgress)
+{
+    std::string modRelativePath = "maps/altar.map";
+    GlobalCommandSystem().executeCommand("OpenMap", modRelativePath);
+    checkAltarScene();
+
+    auto snapshotFolder = _context.getTemporaryDataPath() + "progresssnapshots/";
+    registry::setValue(map::RKEY_AUTOSAVE_SNAPSHOTS_ENABLED, true);
+    registry::setValue(map::RKEY_AUTOSAVE_SNAPSHOTS_FOLDER, snapshotFolder);
+
+    std::string expectedSnapshotPath = snapshotFolder + "altar.0.map";
+
+    // The signal is emitted on the writer thread
+    std::mutex progressLock;
+    std::vector<float> progress;
+
+    auto conn = GlobalAutoSaver().signal_saveProgress().connect([&](float fraction)
+    {
+        std::lock_guard<std::mutex> lock(progressLock);
+        progress.push_back(fraction);
+    });
+
+    GlobalAutoSaver().performAutosave();
+    GlobalAutoSaver().finishPendingSave();
+    conn.disconnect();
+
+    EXPECT_TRUE(os::fileOrDirExists(expectedSnapshotPath)) << "Snapshot should now exist in " << expectedSnapshotPath;
+    EXPECT_FALSE(os::fileOrDirExists(snapshotFolder + "_altar.0.map")) << "Temporary file has not been removed";
+
+    ASSERT_FALSE(progress.empty()) << "No progress has been reported";
+    EXPECT_TRUE(std::is_sorted(progress.begin(), progress.end())) << "Progress should be increasing";
+    EXPECT_EQ(progress.back(), 1.0f) << "Last progress report should be 1.0";
+
+    // The snapshot must contain the same scene
+    GlobalCommandSystem().executeCommand("OpenMap", expectedSnapshotPath);
+    checkAltarScene();
+
+    fs::remove(os::replaceExtension(expectedSnapshotPath, "darkradiant"));
+    fs::remove(expectedSnapshotPath);
+}
+
 namespace
 {
 
@@ -1660,4 +1744,320 @@ TEST_F(MapSavingTest, EscapeCharactersInEntityKeyValues)
     EXPECT_EQ(savedContent, mapContent) << "Failed to serialise quoted entity key values";
 }
 
+
+namespace
+{
+
+// Creates a large worldspawn with arbitrarily rotated brushes, such that the plane
+// and texture matrix components are using all the available digits
+void createBrushHeavyMap(std::size_t numBrushes)
+{
+    auto worldspawn = GlobalMapModule().findOrInsertWorldspawn();
+
+    UndoableCommand cmd("createBrushes");
+
+    for (std::size_t i = 0; i < numBrushes; ++i)
+    {
+        auto brushNode = GlobalBrushCreator().createBrush();
+        worldspawn->addChildNode(brushNode);
+
+        auto& brush = *Node_getIBrush(brushNode);
+
+        auto transform = Matrix4::getTranslation(Vector3((i % 100) * 160.0, (i / 100) * 160.0, 0))
+            .getMultipliedBy(Matrix4::getRotationForEulerXYZDegrees(Vector3(i * 7.3, i * 13.1, i * 3.7)));
+
+        brush.addFace(Plane3(+1, 0, 0, 48).transform(transform));
+        brush.addFace(Plane3(-1, 0, 0, 48).transform(transform));
+        brush.addFace(Plane3(0, +1, 0, 48).transform(transform));
+        brush.addFace(Plane3(0, -1, 0, 48).transform(transform));
+        brush.addFace(Plane3(0, 0, +1, 48).transform(transform));
+        brush.addFace(Plane3(0, 0, -1, 48).transform(transform));
+
+        brush.setShader("textures/numbers/" + std::to_string(i % 10));
+        brush.evaluateBRep();
+    }
+}
+
+std::string exportSceneToString()
+{
+    GlobalSelectionSystem().setSelectedAll(true);
+
+    std::ostringstream output;
+    GlobalMapModule().exportSelected(output, GlobalMapFormatManager().getMapFormatForGameType("doom3", "map"));
+
+    GlobalSelectionSystem().setSelectedAll(false);
+
+    return output.str();
+}
+
+inline double getMegabytesPerSecond(std::size_t numBytes, std::chrono::steady_clock::duration duration)
+{
+    auto seconds = std::chrono::duration<double>(duration).count();
+    return seconds > 0 ? numBytes / (1024.0 * 1024.0) / seconds : 0;
+}
+
+}
+
+// Measures the save and parse throughput of a brush-heavy map, and checks that
+// the numbers survive the round trip without any change
+TEST_F(MapSavingTest, brushHeavyMapThroughputAndRoundTrip)
+{
+    createBrushHeavyMap(20000);
+
+    auto start = std::chrono::steady_clock::now();
+    auto savedText = exportSceneToString();
+    auto saveTime = std::chrono::steady_clock::now() - start;
+
+    fs::path tempPath = _context.getTemporaryDataPath();
+    tempPath /= "brush_heavy_map.map";
+    TemporaryFile tempFile(tempPath.string(), savedText);
+
+    // Discard the generated scene without asking
+    GlobalMapModule().setModified(false);
+
+    start = std::chrono::steady_clock::now();
+    GlobalCommandSystem().executeCommand("OpenMap", tempPath.string());
+    auto loadTime = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(algorithm::getChildCount(GlobalMapModule().findOrInsertWorldspawn()), 20000);
+
+    // Saving the loaded map again must produce the exact same text
+    EXPECT_EQ(exportSceneToString(), savedText) << "Numbers changed during the save/load round trip";
+
+    std::cout << "Brush-heavy map with " << savedText.size() << " bytes: "
+        << "save " << getMegabytesPerSecond(savedText.size(), saveTime) << " MB/s, "
+        << "load " << getMegabytesPerSecond(savedText.size(), loadTime) << " MB/s" << std::endl;
+}
+
+
+namespace
+{
+
+// Saves a copy of the current map using the given registry setting, returns the text of the map and info file
+std::pair<std::string, std::string> saveMapCopy(const fs::path& path, bool parallelSaving)
+{
+    registry::setValue(map::RKEY_MAP_PARALLEL_SAVING, parallelSaving);
+
+    // The edit timer is part of the info file, keep it from ticking in between
+    GlobalMapEditStopwatch().setTotalSecondsEdited(1000);
+
+    FileSelectionHelper responder(path.string(), GlobalMapFormatManager().getMapFormatForFilename(path.string()));
+    GlobalCommandSystem().executeCommand("SaveMapCopyAs");
+
+    auto infoFilePath = fs::path(path).replace_extension("darkradiant");
+
+    EXPECT_TRUE(os::fileOrDirExists(path));
+    EXPECT_TRUE(os::fileOrDirExists(infoFilePath));
+
+    auto result = std::make_pair(algorithm::loadFileToString(path), algorithm::loadFileToString(infoFilePath));
+
+    fs::remove(path);
+    fs::remove(infoFilePath);
+
+    return result;
+}
+
+}
+
+TEST_F(MapSavingTest, parallelSavingProducesIdenticalFiles)
+{
+    std::string modRelativePath = "maps/altar.map";
+    GlobalCommandSystem().executeCommand("OpenMap", modRelativePath);
+    checkAltarScene();
+
+    // Add enough brushes to have the windings evaluated on multiple threads
+    createBrushHeavyMap(2000);
+
+    fs::path tempPath = _context.getTemporaryDataPath();
+    tempPath /= "altar_parallel_saving.map";
+
+    auto serial = saveMapCopy(tempPath, false);
+    auto parallel = saveMapCopy(tempPath, true);
+
+    EXPECT_NE(serial.first.find("// entity 1"), std::string::npos);
+    EXPECT_EQ(serial.first, parallel.first) << "Parallel saving produced a different map file";
+    EXPECT_EQ(serial.second, parallel.second) << "Parallel saving produced a different info file";
+}
+
+TEST_F(MapSavingTest, AutoSaveJournalIsReplayedOnMapLoad)
+{
+    std::string modRelativePath = "maps/altar.map";
+    GlobalCommandSystem().executeCommand("OpenMap", modRelativePath);
+    checkAltarScene();
+
+    registry::setValue(map::RKEY_AUTOSAVE_SNAPSHOTS_ENABLED, false);
+    registry::setValue(map::RKEY_AUTOSAVE_JOURNAL_ENABLED, true);
+
+    fs::path autosavePath = GlobalFileSystem().findFile(modRelativePath) + "maps/altar_autosave.map";
+    auto autosaveInfoPath = fs::path(autosavePath).replace_extension("darkradiant");
+    auto journalPath = fs::path(autosavePath).replace_extension("journal");
+
+    EXPECT_FALSE(os::fileOrDirExists(autosavePath)) << "Autosave already exists in " << autosavePath;
+
+    // The first autosave writes the full map
+    GlobalAutoSaver().performAutosave();
+    GlobalAutoSaver().finishPendingSave();
+
+    EXPECT_TRUE(os::fileOrDirExists(autosavePath));
+    EXPECT_TRUE(os::fileOrDirExists(journalPath));
+
+    auto baseText = algorithm::loadFileToString(autosavePath);
+
+    // Change a key value and remove an entity, which changes the numbering of the ones after it
+    algorithm::setWorldspawnKeyValue("journal_test_key", "journal_test_value");
+
+    auto entity = algorithm::findFirstEntity(GlobalMapModule().getRoot(), [](const EntityNodePtr& entity)
+    {
+        return !entity->getEntity().isWorldspawn();
+    });
+    ASSERT_TRUE(entity);
+
+    {
+        UndoableCommand cmd("removeTestEntity");
+        scene::removeNodeFromParent(entity);
+    }
+
+    GlobalAutoSaver().performAutosave();
+    GlobalAutoSaver().finishPendingSave();
+
+    // Only the journal has been written to, with the changes and the operation names
+    EXPECT_EQ(algorithm::loadFileToString(autosavePath), baseText) << "The autosave file has been rewritten";
+    EXPECT_LT(fs::file_size(journalPath), baseText.size() / 2) << "The journal should only contain the changes";
+    EXPECT_TRUE(algorithm::fileContainsText(journalPath, "journal_test_value"));
+    EXPECT_TRUE(algorithm::fileContainsText(journalPath, "removeTestEntity"));
+
+    // This is what the autosave file should look like after replaying the journal
+    fs::path copyPath = _context.getTemporaryDataPath();
+    copyPath /= "altar_journal_copy.map";
+    auto expectedText = saveMapCopy(copyPath, true).first;
+
+    // Loading the map again brings the autosave file up to date
+    GlobalCommandSystem().executeCommand("OpenMap", modRelativePath);
+    checkAltarScene();
+
+    EXPECT_FALSE(os::fileOrDirExists(journalPath)) << "The journal should have been removed after replay";
+    EXPECT_EQ(algorithm::loadFileToString(autosavePath), expectedText) << "Replaying the journal produced a different map";
+
+    fs::remove(autosavePath);
+    fs::remove(autosaveInfoPath);
+}
+
+// Automatic saves only export the nodes changed since the previous one,
+// the autosave has to match the full map after every kind of change
+TEST_F(MapSavingTest, AutoSaveOnlyExportsChangedNodes)
+{
+    std::string modRelativePath = "maps/altar.map";
+    GlobalCommandSystem().executeCommand("OpenMap", modRelativePath);
+    checkAltarScene();
+
+    createBrushHeavyMap(20000);
+
+    // Full copies are written without the journal, to compare them to the map
+    registry::setValue(map::RKEY_AUTOSAVE_SNAPSHOTS_ENABLED, false);
+    registry::setValue(map::RKEY_AUTOSAVE_JOURNAL_ENABLED, false);
+
+    fs::path autosavePath = GlobalFileSystem().findFile(modRelativePath) + "maps/altar_autosave.map";
+    auto autosaveInfoPath = fs::path(autosavePath).replace_extension("darkradiant");
+
+    fs::path copyPath = _context.getTemporaryDataPath();
+    copyPath /= "altar_autosave_copy.map";
+
+    // Returns the time the map export took, the file is written in the background
+    auto performAutosave = [&]()
+    {
+        auto start = std::chrono::steady_clock::now();
+        GlobalAutoSaver().performAutosave();
+        auto exportTime = std::chrono::steady_clock::now() - start;
+
+        GlobalAutoSaver().finishPendingSave();
+
+        return exportTime;
+    };
+
+    auto expectAutosaveMatchesMap = [&](const std::string& change)
+    {
+        performAutosave();
+        EXPECT_EQ(algorithm::loadFileToString(autosavePath), saveMapCopy(copyPath, false).first)
+            << "The autosave is different from the map after: " << change;
+    };
+
+    auto fullExportTime = performAutosave();
+    EXPECT_EQ(algorithm::loadFileToString(autosavePath), saveMapCopy(copyPath, false).first);
+
+    auto worldspawn = GlobalMapModule().findOrInsertWorldspawn();
+    auto brush = algorithm::findFirstBrushWithMaterial(worldspawn, "textures/numbers/5");
+    ASSERT_TRUE(brush);
+
+    {
+        UndoableCommand cmd("moveBrush");
+        scene::node_cast<ITransformable>(brush)->setTranslation(Vector3(16, 0, 0));
+        scene::node_cast<ITransformable>(brush)->freezeTransform();
+    }
+
+    auto incrementalExportTime = performAutosave();
+    EXPECT_EQ(algorithm::loadFileToString(autosavePath), saveMapCopy(copyPath, false).first)
+        << "The autosave is different from the map after moving a brush";
+
+    {
+        UndoableCommand cmd("changeShader");
+        Node_getIBrush(brush)->setShader("textures/common/caulk");
+    }
+    expectAutosaveMatchesMap("changing a shader");
+
+    // Removing a brush changes the numbers of the ones following it
+    {
+        UndoableCommand cmd("removeBrush");
+        scene::removeNodeFromParent(algorithm::getNthChild(worldspawn, 10));
+    }
+    expectAutosaveMatchesMap("removing a brush");
+
+    {
+        UndoableCommand cmd("addBrush");
+        algorithm::createCubicBrush(worldspawn, Vector3(0, 0, 1024), "textures/numbers/1");
+    }
+    expectAutosaveMatchesMap("adding a brush");
+
+    // The primitives of func_statics are exported relative to the entity origin
+    auto funcStatic = algorithm::getEntityByName(GlobalMapModule().getRoot(), "func_static_70");
+    ASSERT_TRUE(funcStatic);
+
+    {
+        UndoableCommand cmd("changeOrigin");
+        std::dynamic_pointer_cast<EntityNode>(funcStatic)->getEntity().setKeyValue("origin", "-64 160 -148");
+    }
+    expectAutosaveMatchesMap("changing the origin of a func_static");
+
+    // Removing an entity changes the numbers of the ones following it
+    {
+        UndoableCommand cmd("removeEntity");
+        scene::removeNodeFromParent(algorithm::getEntityByName(GlobalMapModule().getRoot(), "func_static_153"));
+    }
+    expectAutosaveMatchesMap("removing an entity");
+
+    GlobalUndoSystem().undo();
+    expectAutosaveMatchesMap("undo");
+
+    GlobalUndoSystem().undo();
+    GlobalUndoSystem().undo();
+    expectAutosaveMatchesMap("undoing multiple operations");
+
+    GlobalUndoSystem().redo();
+    expectAutosaveMatchesMap("redo");
+
+    // Loading a map starts over with a full export
+    GlobalCommandSystem().executeCommand("OpenMap", modRelativePath);
+    checkAltarScene();
+    expectAutosaveMatchesMap("loading the map");
+
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    std::cout << "Autosave export of a map with 20000 brushes: "
+        << "full " << duration_cast<milliseconds>(fullExportTime).count() << " ms, "
+        << "after moving one brush " << duration_cast<milliseconds>(incrementalExportTime).count() << " ms" << std::endl;
+
+    fs::remove(autosavePath);
+    fs::remove(autosaveInfoPath);
+}
+
 }
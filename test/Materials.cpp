@@ -10,6 +10,11 @@
 #include "math/MatrixUtils.h"
 #include "materials/FrobStageSetup.h"
 #include "testutil/TemporaryFile.h"
+#include "registry/registry.h"
+#include "os/fs.h"
+#include <thread>
+#include <fstream>
+#include <chrono>
 
 namespace test
 {
@@ -2035,4 +2040,220 @@ TEST_F(MaterialsTest, EditorImageUpdatedBeforeMaterialChangedSignalEmission)
     EXPECT_FALSE(material->isEditorImageNoTex()) << "Editor image should have been updated";
 }
 
+// Editor images are loaded in the background, their dimensions are available right away
+// and the uploads are processed until the streaming queue is empty
+TEST_F(MaterialsTest, EditorImageStreaming)
+{
+    auto editorImage = GlobalMaterialManager().getMaterial("textures/a_1024x512")->getEditorImage();
+
+    EXPECT_EQ(editorImage->getWidth(), 1024) << "Width should be available before the upload";
+    EXPECT_EQ(editorImage->getHeight(), 512) << "Height should be available before the upload";
+
+    while (GlobalMaterialManager().processTextureUploads())
+    {}
+
+    auto statistics = GlobalMaterialManager().getTextureStreamingStatistics();
+
+    EXPECT_EQ(statistics.pendingDecodes, 0) << "All textures should have been decoded";
+    EXPECT_EQ(statistics.pendingUploads, 0) << "All textures should have been uploaded";
+    EXPECT_GT(statistics.uploadedTextures, 0) << "The editor image should have been uploaded";
+    EXPECT_GT(statistics.textureMemory, 0) << "The uploaded textures should occupy memory";
+}
+
+// Textures which haven't been drawn for a while are evicted when exceeding the memory budget,
+// and reloaded the next time they are drawn
+TEST_F(MaterialsTest, TextureMemoryBudgetEviction)
+{
+    registry::setValue("user/ui/textures/memoryBudget", 1);
+
+    auto editorImage = GlobalMaterialManager().getMaterial("textures/a_1024x512")->getEditorImage();
+    EXPECT_EQ(editorImage->getWidth(), 1024);
+
+    while (GlobalMaterialManager().processTextureUploads())
+    {}
+
+    auto statistics = GlobalMaterialManager().getTextureStreamingStatistics();
+    EXPECT_EQ(statistics.textureMemoryBudget, std::size_t(1) << 20) << "Budget should be reported in bytes";
+    EXPECT_GT(statistics.textureMemory, statistics.textureMemoryBudget) << "A 1024x512 texture exceeds the budget";
+
+    auto uploadedTextureNumber = editorImage->getGLTexNum();
+
+    // Let the texture become stale, the next frame will evict it
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    GlobalMaterialManager().processTextureUploads();
+
+    statistics = GlobalMaterialManager().getTextureStreamingStatistics();
+    EXPECT_GT(statistics.evictedTextures, 0) << "The stale texture should have been evicted";
+    EXPECT_LE(statistics.textureMemory, statistics.textureMemoryBudget) << "Memory should be within budget after eviction";
+    EXPECT_EQ(editorImage->getWidth(), 1024) << "Evicted textures should keep their dimensions";
+
+    auto memoryAfterEviction = statistics.textureMemory;
+
+    // Binding the texture again gives the placeholder, and brings the texture back
+    auto placeholderNumber = editorImage->getGLTexNum();
+    EXPECT_NE(placeholderNumber, uploadedTextureNumber) << "Evicted textures should be bound to the placeholder";
+
+    while (GlobalMaterialManager().processTextureUploads())
+    {}
+
+    statistics = GlobalMaterialManager().getTextureStreamingStatistics();
+    EXPECT_GT(statistics.textureMemory, memoryAfterEviction) << "The texture should have been reloaded";
+    EXPECT_NE(editorImage->getGLTexNum(), placeholderNumber) << "Reloaded textures should not use the placeholder anymore";
+}
+
+// With compression enabled, uncompressed images are uploaded block compressed and stored in the disk cache
+TEST_F(MaterialsTest, TextureCompression)
+{
+    registry::setValue("user/ui/textures/compression", true);
+
+    auto editorImage = GlobalMaterialManager().getMaterial("textures/a_1024x512")->getEditorImage();
+    EXPECT_EQ(editorImage->getWidth(), 1024);
+    EXPECT_EQ(editorImage->getHeight(), 512);
+
+    while (GlobalMaterialManager().processTextureUploads())
+    {}
+
+    auto statistics = GlobalMaterialManager().getTextureStreamingStatistics();
+
+    EXPECT_GT(statistics.textureMemory, 0) << "The texture should have been uploaded";
+    EXPECT_LT(statistics.textureMemory, 1024 * 512 * 4) << "The texture should be smaller than uncompressed";
+
+    // The compressed image should have been written to the cache
+    auto cachePath = _context.getCacheDataPath() + "texturecache/";
+    ASSERT_TRUE(fs::is_directory(cachePath)) << "Cache folder not created";
+    ASSERT_NE(fs::directory_iterator(cachePath), fs::directory_iterator()) << "No cache file written";
+
+    // The cache file is keyed by the source image, its header names the file it has been created from
+    auto cacheFile = fs::directory_iterator(cachePath)->path();
+    std::ifstream stream(cacheFile, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    EXPECT_NE(contents.find("textures/a_1024x512"), std::string::npos) << "Source image not stored in the cache file";
+
+    // Reloading the images takes the compressed image from the cache, no further file is written
+    GlobalMaterialManager().reloadImages();
+    GlobalMaterialManager().getMaterial("textures/a_1024x512")->getEditorImage();
+
+    while (GlobalMaterialManager().processTextureUploads())
+    {}
+
+    statistics = GlobalMaterialManager().getTextureStreamingStatistics();
+    EXPECT_GT(statistics.textureMemory, 0) << "The texture should have been uploaded again";
+    EXPECT_LT(statistics.textureMemory, 1024 * 512 * 4) << "The reloaded texture should be compressed";
+
+    std::size_t numCacheFiles = 0;
+
+    for (const auto& file : fs::directory_iterator(cachePath))
+    {
+        ++numCacheFiles;
+        EXPECT_EQ(file.path().extension(), ".cache") << "Unexpected file in the texture cache";
+    }
+
+    EXPECT_EQ(numCacheFiles, 1) << "The cached image should have been reused";
+}
+
+// Materials sharing the same compound map expression receive images of the correct dimensions
+TEST_F(MaterialsTest, SharedMapExpressionEvaluation)
+{
+    auto first = GlobalMaterialManager().createEmptyMaterial("textures/test/sharedExpression1");
+    auto second = GlobalMaterialManager().createEmptyMaterial("textures/test/sharedExpression2");
+
+    first->setEditorImageExpressionFromString("addnormals(heightmap(textures/numbers/1, 4), textures/numbers/2)");
+    second->setEditorImageExpressionFromString("addnormals(heightmap(textures/numbers/1, 4), textures/numbers/2)");
+
+    auto firstImage = first->getEditorImage();
+    auto secondImage = second->getEditorImage();
+
+    while (GlobalMaterialManager().processTextureUploads())
+    {}
+
+    EXPECT_FALSE(first->isEditorImageNoTex()) << "Expression should have been evaluated";
+    EXPECT_FALSE(second->isEditorImageNoTex()) << "Expression should have been evaluated";
+    EXPECT_EQ(firstImage->getWidth(), 32);
+    EXPECT_EQ(firstImage->getHeight(), 32);
+    EXPECT_EQ(secondImage->getWidth(), 32);
+    EXPECT_EQ(secondImage->getHeight(), 32);
+
+    auto statistics = GlobalMaterialManager().getTextureStreamingStatistics();
+    EXPECT_EQ(statistics.pendingDecodes, 0) << "All expressions should have been evaluated";
+}
+
+// Compound expressions with a missing operand must not produce an image, operands of
+// different sizes are resampled to the dimensions of the first one, invalid scales are ignored
+TEST_F(MaterialsTest, MapExpressionEvaluationEdgeCases)
+{
+    auto missing = GlobalMaterialManager().createEmptyMaterial("textures/test/missingOperand");
+    auto smallFirst = GlobalMaterialManager().createEmptyMaterial("textures/test/smallFirstOperand");
+    auto largeFirst = GlobalMaterialManager().createEmptyMaterial("textures/test/largeFirstOperand");
+    auto negativeScale = GlobalMaterialManager().createEmptyMaterial("textures/test/negativeScale");
+
+    missing->setEditorImageExpressionFromString("addnormals(heightmap(textures/numbers/1, 4), textures/this_image_is_missing)");
+    smallFirst->setEditorImageExpressionFromString("addnormals(textures/numbers/1, textures/a_1024x512)");
+    largeFirst->setEditorImageExpressionFromString("addnormals(textures/a_1024x512, textures/numbers/1)");
+    negativeScale->setEditorImageExpressionFromString("scale(textures/numbers/1, -1, 1, 1, 1)");
+
+    auto smallFirstImage = smallFirst->getEditorImage();
+    auto largeFirstImage = largeFirst->getEditorImage();
+    auto negativeScaleImage = negativeScale->getEditorImage();
+    missing->getEditorImage();
+
+    while (GlobalMaterialManager().processTextureUploads())
+    {}
+
+    EXPECT_TRUE(missing->isEditorImageNoTex()) << "Expression with a missing operand should not produce an image";
+
+    EXPECT_FALSE(smallFirst->isEditorImageNoTex()) << "Expression should have been evaluated";
+    EXPECT_EQ(smallFirstImage->getWidth(), 32);
+    EXPECT_EQ(smallFirstImage->getHeight(), 32);
+
+    EXPECT_FALSE(largeFirst->isEditorImageNoTex()) << "Expression should have been evaluated";
+    EXPECT_EQ(largeFirstImage->getWidth(), 1024);
+    EXPECT_EQ(largeFirstImage->getHeight(), 512);
+
+    EXPECT_FALSE(negativeScale->isEditorImageNoTex()) << "Negative scales should leave the image unchanged";
+    EXPECT_EQ(negativeScaleImage->getWidth(), 32);
+    EXPECT_EQ(negativeScaleImage->getHeight(), 32);
+
+    EXPECT_EQ(GlobalMaterialManager().getTextureStreamingStatistics().pendingDecodes, 0) << "Failed evaluations should not be left pending";
+}
+
+// Thumbnails are generated in the background and packed into the atlas, the
+// thumbnails of image files are written to the disk cache
+TEST_F(MaterialsTest, MaterialThumbnail)
+{
+    // Looking up a thumbnail which has not been drawn yet doesn't generate it
+    auto thumbnail = GlobalMaterialManager().findMaterialThumbnail("textures/a_1024x512");
+    EXPECT_EQ(thumbnail.imageWidth, 0) << "Thumbnail should not have been generated";
+
+    GlobalMaterialManager().beginThumbnailFrame(this);
+    thumbnail = GlobalMaterialManager().getMaterialThumbnail("textures/a_1024x512", this);
+
+    while (GlobalMaterialManager().processTextureUploads())
+    {}
+
+    thumbnail = GlobalMaterialManager().getMaterialThumbnail("textures/a_1024x512", this);
+
+    EXPECT_FALSE(thumbnail.failed) << "Thumbnail generation failed";
+    EXPECT_NE(thumbnail.textureNum, 0) << "Thumbnail should have been uploaded";
+    EXPECT_EQ(thumbnail.imageWidth, 1024) << "Thumbnail should report the size of the full image";
+    EXPECT_EQ(thumbnail.imageHeight, 512) << "Thumbnail should report the size of the full image";
+
+    // The thumbnail occupies a 128x64 area of the atlas
+    EXPECT_GT(thumbnail.s1, thumbnail.s0);
+    EXPECT_GT(thumbnail.t1, thumbnail.t0);
+    EXPECT_NEAR((thumbnail.s1 - thumbnail.s0) / (thumbnail.t1 - thumbnail.t0), 2.0f, 0.05f);
+
+    auto cachePath = _context.getCacheDataPath() + "thumbnails/";
+    ASSERT_TRUE(fs::is_directory(cachePath)) << "Cache folder not created";
+    EXPECT_NE(fs::directory_iterator(cachePath), fs::directory_iterator()) << "No cache file written";
+
+    // Materials without any image fail
+    auto empty = GlobalMaterialManager().createEmptyMaterial("textures/test/thumbnailWithoutImage");
+    EXPECT_TRUE(GlobalMaterialManager().getMaterialThumbnail(empty->getName(), this).failed);
+
+    // Once generated, the thumbnail can be looked up without drawing it
+    EXPECT_EQ(GlobalMaterialManager().findMaterialThumbnail("textures/a_1024x512").imageWidth, 1024);
+
+    GlobalMaterialManager().releaseThumbnailView(this);
+}
+
 }
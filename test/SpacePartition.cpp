@@ -0,0 +1,517 @@
+#include "RadiantTest.h"
+
+#include "iscenegraph.h"
+#include "ispacepartition.h"
+#include "itransformable.h"
+#include "scene/Node.h"
+#include "scenelib.h"
+#include "render/NopVolumeTest.h"
+#include "registry/registry.h"
+#include "math/Ray.h"
+#include "math/pi.h"
+#include "algorithm/Primitives.h"
+#include "algorithm/View.h"
+
+#include <chrono>
+#include <random>
+#include <unordered_set>
+
+namespace test
+{
+
+using SpacePartitionTest = RadiantTest;
+
+// Runs the tests against every space partition type
+class SpacePartitionTypeTest :
+    public SpacePartitionTest,
+    public testing::WithParamInterface<const char*>
+{
+protected:
+    // Switches the scenegraph to the tested type, returning its space partition
+    scene::ISpacePartitionSystemPtr getSpacePartition()
+    {
+        registry::setValue(scene::RKEY_SPACE_PARTITION_TYPE, std::string(GetParam()));
+        return GlobalSceneGraph().getSpacePartition();
+    }
+};
+
+namespace
+{
+
+// Node with adjustable bounds, not inserted into any scene
+class BoundsTestNode :
+    public scene::Node
+{
+private:
+    AABB _bounds;
+
+public:
+    BoundsTestNode(const AABB& bounds) :
+        _bounds(bounds)
+    {}
+
+    Type getNodeType() const override
+    {
+        return Type::Unknown;
+    }
+
+    AABB localAABB() const override
+    {
+        return _bounds;
+    }
+
+    void setBounds(const AABB& bounds)
+    {
+        _bounds = bounds;
+        boundsChanged();
+    }
+
+    void onPreRender(const VolumeTest& volume) override
+    {}
+
+    void renderHighlights(IRenderableCollector& collector, const VolumeTest& volume) override
+    {}
+
+    std::size_t getHighlightFlags() override
+    {
+        return 0;
+    }
+};
+
+// Volume test intersecting the given box
+class BoxVolumeTest :
+    public render::NopVolumeTest
+{
+private:
+    AABB _box;
+
+public:
+    BoxVolumeTest(const AABB& box) :
+        _box(box)
+    {}
+
+    VolumeIntersectionValue TestAABB(const AABB& aabb) const override
+    {
+        return _box.intersects(aabb) ? VOLUME_PARTIAL : VOLUME_OUTSIDE;
+    }
+};
+
+// Volume test intersecting the given ray, like a selection test would do
+class RayVolumeTest :
+    public render::NopVolumeTest
+{
+private:
+    Ray _ray;
+
+public:
+    RayVolumeTest(const Ray& ray) :
+        _ray(ray)
+    {}
+
+    VolumeIntersectionValue TestAABB(const AABB& aabb) const override
+    {
+        Vector3 intersection;
+        return _ray.intersectAABB(aabb, intersection) ? VOLUME_PARTIAL : VOLUME_OUTSIDE;
+    }
+};
+
+std::vector<scene::INodePtr> createRandomNodes(std::size_t count, double worldSize)
+{
+    std::minstd_rand random(count);
+    std::uniform_real_distribution<double> position(-worldSize, worldSize);
+    std::uniform_real_distribution<double> extents(4, 128);
+
+    std::vector<scene::INodePtr> nodes;
+    nodes.reserve(count);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        nodes.emplace_back(std::make_shared<BoundsTestNode>(AABB(
+            Vector3(position(random), position(random), position(random) / 8),
+            Vector3(extents(random), extents(random), extents(random)))));
+    }
+
+    return nodes;
+}
+
+void moveNode(const scene::INodePtr& node, const Vector3& offset)
+{
+    auto& testNode = dynamic_cast<BoundsTestNode&>(*node);
+    auto bounds = testNode.localAABB();
+    bounds.origin += offset;
+    testNode.setBounds(bounds);
+}
+
+// Returns the set of nodes visited when querying the given box, fails on duplicate visits
+std::unordered_set<scene::INode*> getNodesInBox(const scene::ISpacePartitionSystemPtr& spacePartition, const AABB& box)
+{
+    std::unordered_set<scene::INode*> visited;
+
+    spacePartition->foreachMemberInVolume(BoxVolumeTest(box), [&](const scene::INodePtr& node)
+    {
+        EXPECT_TRUE(visited.insert(node.get()).second) << "Node visited twice";
+        return true;
+    });
+
+    return visited;
+}
+
+// Every node intersecting the box needs to be visited (the query is allowed to visit more)
+void expectNodesInBoxAreVisited(const scene::ISpacePartitionSystemPtr& spacePartition,
+    const std::vector<scene::INodePtr>& nodes, const AABB& box)
+{
+    auto visited = getNodesInBox(spacePartition, box);
+
+    for (const auto& node : nodes)
+    {
+        if (box.intersects(node->worldAABB()))
+        {
+            EXPECT_EQ(visited.count(node.get()), 1) << "Node at " << node->worldAABB().origin << " not visited";
+        }
+    }
+}
+
+}
+
+TEST_P(SpacePartitionTypeTest, LinkAndUnlink)
+{
+    auto spacePartition = getSpacePartition();
+    auto nodes = createRandomNodes(1000, 4096);
+
+    for (const auto& node : nodes)
+    {
+        spacePartition->link(node);
+    }
+
+    expectNodesInBoxAreVisited(spacePartition, nodes, AABB(Vector3(0, 0, 0), Vector3(8192, 8192, 8192)));
+
+    // Unlink every other node, they should not be visited anymore
+    for (std::size_t i = 0; i < nodes.size(); i += 2)
+    {
+        EXPECT_TRUE(spacePartition->unlink(nodes[i]));
+        EXPECT_FALSE(spacePartition->unlink(nodes[i])) << "Second unlink should return false";
+    }
+
+    auto visited = getNodesInBox(spacePartition, AABB(Vector3(0, 0, 0), Vector3(8192, 8192, 8192)));
+
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        EXPECT_EQ(visited.count(nodes[i].get()), i % 2) << "Node " << i << " visited unexpectedly";
+    }
+
+    for (std::size_t i = 1; i < nodes.size(); i += 2)
+    {
+        EXPECT_TRUE(spacePartition->unlink(nodes[i]));
+    }
+}
+
+TEST_P(SpacePartitionTypeTest, NodesOutsideStartSizeAreLinked)
+{
+    auto spacePartition = getSpacePartition();
+
+    // The octree has to grow to encompass these nodes, the tree has to handle invalid bounds
+    auto nodes = createRandomNodes(500, 60000);
+    nodes.emplace_back(std::make_shared<BoundsTestNode>(AABB())); // invalid bounds
+
+    for (const auto& node : nodes)
+    {
+        spacePartition->link(node);
+    }
+
+    auto visited = getNodesInBox(spacePartition, AABB(Vector3(0, 0, 0), Vector3(70000, 70000, 70000)));
+
+    for (const auto& node : nodes)
+    {
+        EXPECT_EQ(visited.count(node.get()), 1);
+        EXPECT_TRUE(spacePartition->unlink(node));
+    }
+}
+
+TEST_P(SpacePartitionTypeTest, RelinkMovedNodes)
+{
+    auto spacePartition = getSpacePartition();
+    auto nodes = createRandomNodes(2000, 8192);
+
+    for (const auto& node : nodes)
+    {
+        spacePartition->link(node);
+    }
+
+    // A node which is not linked should be ignored by relink()
+    auto unlinkedNode = std::make_shared<BoundsTestNode>(AABB(Vector3(0, 0, 0), Vector3(16, 16, 16)));
+    nodes.push_back(unlinkedNode);
+
+    // Move the nodes by different distances, some of them will stay in their SP node
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        moveNode(nodes[i], Vector3(static_cast<double>(i % 7) * 300, -32, 0));
+    }
+
+    spacePartition->relink(nodes);
+
+    EXPECT_FALSE(spacePartition->unlink(unlinkedNode)) << "relink() must not link unknown nodes";
+    nodes.pop_back();
+
+    expectNodesInBoxAreVisited(spacePartition, nodes, AABB(Vector3(3000, 0, 0), Vector3(2048, 2048, 2048)));
+    expectNodesInBoxAreVisited(spacePartition, nodes, AABB(Vector3(-4000, 4000, 0), Vector3(1024, 1024, 1024)));
+
+    for (const auto& node : nodes)
+    {
+        EXPECT_TRUE(spacePartition->unlink(node));
+    }
+}
+
+TEST_P(SpacePartitionTypeTest, VolumeQueryCanBeStopped)
+{
+    auto spacePartition = getSpacePartition();
+    auto nodes = createRandomNodes(200, 2048);
+
+    for (const auto& node : nodes)
+    {
+        spacePartition->link(node);
+    }
+
+    std::size_t visitCount = 0;
+    auto result = spacePartition->foreachMemberInVolume(render::NopVolumeTest(), [&](const scene::INodePtr& node)
+    {
+        return ++visitCount < 10;
+    });
+
+    EXPECT_FALSE(result);
+    EXPECT_EQ(visitCount, 10);
+
+    for (const auto& node : nodes)
+    {
+        spacePartition->unlink(node);
+    }
+}
+
+bool sceneNodeIsInVolume(const scene::INodePtr& node, const AABB& box)
+{
+    auto found = false;
+
+    GlobalSceneGraph().foreachNodeInVolume(BoxVolumeTest(box), [&](const scene::INodePtr& visited)
+    {
+        found = visited == node;
+        return !found;
+    });
+
+    return found;
+}
+
+TEST_P(SpacePartitionTypeTest, BoundsChangesAreBatchedDuringManipulation)
+{
+    getSpacePartition();
+
+    auto worldspawn = GlobalMapModule().findOrInsertWorldspawn();
+
+    // Add enough brushes to let the space partition subdivide
+    std::vector<scene::INodePtr> brushes;
+
+    for (int i = 0; i < 64; ++i)
+    {
+        brushes.push_back(algorithm::createCuboidBrush(worldspawn,
+            AABB(Vector3(i * 64.0, 0, 0), Vector3(16, 16, 16)), "textures/common/caulk"));
+    }
+
+    auto brush = brushes.front();
+    auto erasedBrush = brushes.back();
+
+    GlobalSceneGraph().beginBoundsChangeBatch();
+
+    scene::node_cast<ITransformable>(brush)->setTranslation(Vector3(20000, 0, 0));
+    scene::node_cast<ITransformable>(brush)->freezeTransform();
+
+    // Evaluating the bounds is notifying the scenegraph
+    EXPECT_EQ(brush->worldAABB().getOrigin(), Vector3(20000, 0, 0));
+
+    // The volume traversal has to see the brush at its new place
+    EXPECT_TRUE(sceneNodeIsInVolume(brush, AABB(Vector3(20000, 0, 0), Vector3(64, 64, 64))));
+
+    // Move it once more and remove a brush which is about to be relinked
+    scene::node_cast<ITransformable>(brush)->setTranslation(Vector3(0, -20000, 0));
+    scene::node_cast<ITransformable>(brush)->freezeTransform();
+    scene::node_cast<ITransformable>(erasedBrush)->setTranslation(Vector3(0, 500, 0));
+    scene::node_cast<ITransformable>(erasedBrush)->freezeTransform();
+    erasedBrush->worldAABB();
+    scene::removeNodeFromParent(erasedBrush);
+
+    EXPECT_EQ(brush->worldAABB().getOrigin(), Vector3(20000, -20000, 0));
+
+    GlobalSceneGraph().endBoundsChangeBatch();
+
+    EXPECT_TRUE(sceneNodeIsInVolume(brush, AABB(Vector3(20000, -20000, 0), Vector3(64, 64, 64))));
+    EXPECT_FALSE(sceneNodeIsInVolume(erasedBrush, AABB(Vector3(0, 0, 0), Vector3(65536, 65536, 65536))));
+}
+
+// Measures link, relink, volume queries and unlink of a large number of nodes
+TEST_P(SpacePartitionTypeTest, SpacePartitionPerformance)
+{
+    auto spacePartition = getSpacePartition();
+    auto nodes = createRandomNodes(100000, 30000);
+
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (const auto& node : nodes)
+    {
+        spacePartition->link(node);
+    }
+
+    auto linkTime = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+
+    std::minstd_rand random(17);
+    std::uniform_real_distribution<double> position(-30000, 30000);
+    std::size_t visitCount = 0;
+
+    for (std::size_t i = 0; i < 200; ++i)
+    {
+        BoxVolumeTest volume(AABB(Vector3(position(random), position(random), 0), Vector3(2048, 2048, 4096)));
+
+        spacePartition->foreachMemberInVolume(volume, [&](const scene::INodePtr& node)
+        {
+            ++visitCount;
+            return true;
+        });
+    }
+
+    auto queryTime = std::chrono::steady_clock::now() - start;
+
+    for (const auto& node : nodes)
+    {
+        moveNode(node, Vector3(16, 16, 0));
+    }
+
+    start = std::chrono::steady_clock::now();
+
+    spacePartition->relink(nodes);
+
+    auto relinkTime = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+
+    std::size_t unlinkCount = 0;
+
+    for (const auto& node : nodes)
+    {
+        unlinkCount += spacePartition->unlink(node) ? 1 : 0;
+    }
+
+    auto unlinkTime = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(unlinkCount, nodes.size());
+    EXPECT_GT(visitCount, 0);
+
+    std::cout << GetParam() << " with " << nodes.size() << " nodes: "
+        << "link " << duration_cast<milliseconds>(linkTime).count() << " ms, "
+        << "200 volume queries " << duration_cast<milliseconds>(queryTime).count() << " ms (" << visitCount << " visits), "
+        << "relink " << duration_cast<milliseconds>(relinkTime).count() << " ms, "
+        << "unlink " << duration_cast<milliseconds>(unlinkTime).count() << " ms" << std::endl;
+}
+
+TEST_P(SpacePartitionTypeTest, SwitchingTypeKeepsLinkedNodes)
+{
+    auto spacePartition = getSpacePartition();
+    auto nodes = createRandomNodes(500, 4096);
+    nodes.emplace_back(std::make_shared<BoundsTestNode>(AABB())); // invalid bounds
+
+    for (const auto& node : nodes)
+    {
+        spacePartition->link(node);
+    }
+
+    // Switch to the other type, the nodes should be taken over
+    std::string otherType = std::string(GetParam()) == "octree" ? "aabbtree" : "octree";
+    registry::setValue(scene::RKEY_SPACE_PARTITION_TYPE, otherType);
+
+    auto newSpacePartition = GlobalSceneGraph().getSpacePartition();
+    EXPECT_NE(newSpacePartition, spacePartition) << "Space partition should have been replaced";
+
+    auto visited = getNodesInBox(newSpacePartition, AABB(Vector3(0, 0, 0), Vector3(8192, 8192, 8192)));
+
+    for (const auto& node : nodes)
+    {
+        EXPECT_EQ(visited.count(node.get()), 1);
+        EXPECT_TRUE(newSpacePartition->unlink(node));
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(SpacePartitionTypes, SpacePartitionTypeTest, testing::Values("octree", "aabbtree"));
+
+// Compares the space partition types on camera frustum and ray queries
+TEST_F(SpacePartitionTest, FrustumAndRayQueryPerformance)
+{
+    auto nodes = createRandomNodes(100000, 30000);
+
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    for (auto type : { "octree", "aabbtree" })
+    {
+        registry::setValue(scene::RKEY_SPACE_PARTITION_TYPE, std::string(type));
+        auto spacePartition = GlobalSceneGraph().getSpacePartition();
+
+        for (const auto& node : nodes)
+        {
+            spacePartition->link(node);
+        }
+
+        std::minstd_rand random(17);
+        std::uniform_real_distribution<double> position(-30000, 30000);
+        std::uniform_real_distribution<double> angle(0, 360);
+        std::size_t frustumVisits = 0;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (std::size_t i = 0; i < 200; ++i)
+        {
+            // Cameras looking horizontally into random directions
+            auto yaw = angle(random);
+            Vector3 direction(cos(degrees_to_radians(yaw)), sin(degrees_to_radians(yaw)), 0);
+
+            render::View view(true);
+            algorithm::constructCameraView(view, AABB(Vector3(position(random), position(random), 0), Vector3(64, 64, 64)),
+                direction, Vector3(0, yaw, 0));
+
+            spacePartition->foreachMemberInVolume(view, [&](const scene::INodePtr& node)
+            {
+                ++frustumVisits;
+                return true;
+            });
+        }
+
+        auto frustumTime = std::chrono::steady_clock::now() - start;
+        std::size_t rayVisits = 0;
+
+        start = std::chrono::steady_clock::now();
+
+        for (std::size_t i = 0; i < 2000; ++i)
+        {
+            // Rays shooting down from above, like a selection click in the top view
+            RayVolumeTest volume(Ray(Vector3(position(random), position(random), 32768), Vector3(0, 0, -1)));
+
+            spacePartition->foreachMemberInVolume(volume, [&](const scene::INodePtr& node)
+            {
+                ++rayVisits;
+                return true;
+            });
+        }
+
+        auto rayTime = std::chrono::steady_clock::now() - start;
+
+        EXPECT_GT(frustumVisits, 0);
+
+        std::cout << type << " with " << nodes.size() << " nodes: "
+            << "200 frustum queries " << duration_cast<milliseconds>(frustumTime).count() << " ms (" << frustumVisits << " visits), "
+            << "2000 ray queries " << duration_cast<milliseconds>(rayTime).count() << " ms (" << rayVisits << " visits)" << std::endl;
+
+        for (const auto& node : nodes)
+        {
+            spacePartition->unlink(node);
+        }
+    }
+}
+
+}
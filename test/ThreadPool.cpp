@@ -0,0 +1,175 @@
+#include "RadiantTest.h"
+
+#include "ithreadpool.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace test
+{
+
+using ThreadPoolTest = RadiantTest;
+
+TEST_F(ThreadPoolTest, PoolHasWorkers)
+{
+    EXPECT_GE(GlobalThreadPool().getNumWorkers(), 2) << "The pool should start at least two workers";
+}
+
+TEST_F(ThreadPoolTest, RunAsyncReturnsResult)
+{
+    auto future = threading::runAsync([]() { return 6 * 7; });
+
+    EXPECT_TRUE(future.valid());
+    EXPECT_EQ(future.get(), 42);
+    EXPECT_TRUE(future.isReady());
+}
+
+TEST_F(ThreadPoolTest, RunAsyncAcceptsMoveOnlyFunctions)
+{
+    auto value = std::make_unique<int>(5);
+
+    auto future = threading::runAsync([value = std::move(value)]() { return *value; });
+
+    EXPECT_EQ(future.get(), 5);
+}
+
+TEST_F(ThreadPoolTest, ExceptionIsRethrownByGet)
+{
+    auto future = threading::runAsync([]() -> int { throw std::runtime_error("Task failed"); });
+
+    EXPECT_THROW(future.get(), std::runtime_error);
+
+    // A second call reports the same exception
+    EXPECT_THROW(future.get(), std::runtime_error);
+}
+
+TEST_F(ThreadPoolTest, NestedTasksDontDeadlock)
+{
+    auto numWorkers = GlobalThreadPool().getNumWorkers();
+
+    // Schedule more tasks waiting for sub-tasks than there are workers
+    std::vector<threading::TaskFuture<std::size_t>> futures;
+
+    for (std::size_t i = 0; i < numWorkers * 4; ++i)
+    {
+        futures.emplace_back(threading::runAsync([i]()
+        {
+            auto inner = threading::runAsync([i]() { return i * 2; });
+            return inner.get() + 1;
+        }));
+    }
+
+    for (std::size_t i = 0; i < futures.size(); ++i)
+    {
+        EXPECT_EQ(futures[i].get(), i * 2 + 1);
+    }
+}
+
+TEST_F(ThreadPoolTest, QueuedTaskCanBeCancelled)
+{
+    auto numWorkers = GlobalThreadPool().getNumWorkers();
+
+    // Keep all workers busy until the blocker is released
+    std::atomic<bool> released(false);
+    std::atomic<std::size_t> numBlocked(0);
+    std::vector<threading::ITaskPtr> blockers;
+
+    for (std::size_t i = 0; i < numWorkers; ++i)
+    {
+        blockers.emplace_back(GlobalThreadPool().schedule([&]()
+        {
+            ++numBlocked;
+            while (!released) std::this_thread::yield();
+        }, threading::TaskPriority::High));
+    }
+
+    while (numBlocked < numWorkers) std::this_thread::yield();
+
+    std::atomic<bool> executed(false);
+    auto future = threading::runAsync([&]() { executed = true; }, threading::TaskPriority::Low);
+
+    EXPECT_TRUE(future.cancel()) << "The queued task should have been cancelled";
+
+    released = true;
+
+    for (const auto& blocker : blockers)
+    {
+        blocker->wait();
+    }
+
+    EXPECT_TRUE(future.isReady());
+    EXPECT_TRUE(future.getTask()->isCancelled());
+    EXPECT_THROW(future.get(), threading::TaskCancelledException);
+    EXPECT_FALSE(executed) << "Cancelled task has been run";
+}
+
+TEST_F(ThreadPoolTest, RunningTaskSeesCancellationRequest)
+{
+    std::atomic<bool> started(false);
+
+    auto task = GlobalThreadPool().schedule([&]()
+    {
+        started = true;
+
+        while (!GlobalThreadPool().isCancellationRequested())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    while (!started) std::this_thread::yield();
+
+    EXPECT_FALSE(task->cancel()) << "A running task cannot be prevented from running";
+
+    task->wait();
+
+    EXPECT_TRUE(task->isFinished());
+    EXPECT_FALSE(task->isCancelled());
+    EXPECT_FALSE(GlobalThreadPool().isCancellationRequested()) << "The test thread is not running a task";
+}
+
+TEST_F(ThreadPoolTest, ParallelForVisitsEveryIndexOnce)
+{
+    constexpr std::size_t Count = 10000;
+    std::vector<std::atomic<int>> visits(Count);
+
+    GlobalThreadPool().parallelFor(0, Count, [&](std::size_t i) { ++visits[i]; });
+
+    for (std::size_t i = 0; i < Count; ++i)
+    {
+        EXPECT_EQ(visits[i], 1) << "Index " << i << " has been visited " << visits[i] << " times";
+    }
+
+    // Custom grain size and a range not starting at 0
+    std::atomic<std::size_t> sum(0);
+    GlobalThreadPool().parallelFor(100, 200, [&](std::size_t i) { sum += i; }, 7);
+
+    EXPECT_EQ(sum, (100 + 199) * 100 / 2);
+
+    // Empty range
+    GlobalThreadPool().parallelFor(5, 5, [&](std::size_t) { FAIL() << "Function invoked for empty range"; });
+}
+
+TEST_F(ThreadPoolTest, ParallelForRethrowsException)
+{
+    EXPECT_THROW(GlobalThreadPool().parallelFor(0, 1000, [](std::size_t i)
+    {
+        if (i == 500) throw std::runtime_error("Index failed");
+    }, 10), std::runtime_error);
+}
+
+TEST_F(ThreadPoolTest, NestedParallelFor)
+{
+    std::atomic<std::size_t> count(0);
+
+    GlobalThreadPool().parallelFor(0, 16, [&](std::size_t)
+    {
+        GlobalThreadPool().parallelFor(0, 100, [&](std::size_t) { ++count; }, 5);
+    }, 1);
+
+    EXPECT_EQ(count, 1600);
+}
+
+}
@@ -8,12 +8,19 @@
 #include "iscenegraphfactory.h"
 #include "imap.h"
 #include "icommandsystem.h"
+#include "ipatch.h"
+#include "itransformable.h"
 #include "math/Matrix4.h"
 #include "algorithm/Scene.h"
 #include "algorithm/Primitives.h"
 #include "scenelib.h"
 #include "scene/BasicRootNode.h"
 #include "testutil/FileSelectionHelper.h"
+#include "registry/registry.h"
+#include "UndoMementoArena.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
 
 namespace test
 {
@@ -872,4 +879,715 @@ TEST_F(UndoTest, OperationTracking)
     EXPECT_EQ(tracker.receivedOperationName, "") << "Nothing should fire, already detached";
 }
 
+namespace
+{
+
+struct FaceState
+{
+    Plane3 plane;
+    Matrix3 projection;
+    std::string material;
+};
+
+std::vector<FaceState> getFaceStates(const std::vector<scene::INodePtr>& brushes)
+{
+    std::vector<FaceState> states;
+
+    for (const auto& node : brushes)
+    {
+        auto brush = Node_getIBrush(node);
+
+        for (std::size_t i = 0; i < brush->getNumFaces(); ++i)
+        {
+            auto& face = brush->getFace(i);
+            states.push_back({ face.getPlane3(), face.getProjectionMatrix(), face.getShader() });
+        }
+    }
+
+    return states;
+}
+
+void expectFaceStates(const std::vector<FaceState>& actual, const std::vector<FaceState>& expected, std::size_t level)
+{
+    ASSERT_EQ(actual.size(), expected.size()) << "Face count mismatch at level " << level;
+
+    for (std::size_t i = 0; i < actual.size(); ++i)
+    {
+        // The restored values need to be exact, no epsilon involved
+        EXPECT_EQ(actual[i].plane.normal(), expected[i].plane.normal()) << "Plane mismatch at level " << level;
+        EXPECT_EQ(actual[i].plane.dist(), expected[i].plane.dist()) << "Plane mismatch at level " << level;
+        EXPECT_EQ(actual[i].projection, expected[i].projection) << "Projection mismatch at level " << level;
+        EXPECT_EQ(actual[i].material, expected[i].material) << "Material mismatch at level " << level;
+    }
+}
+
+}
+
+// Runs through a full-size undo stack of texture, material and plane changes, the brush
+// and face mementos are sharing their unchanged parts with each other
+TEST_F(UndoTest, BrushFaceStateHistory)
+{
+    auto worldspawn = GlobalMapModule().findOrInsertWorldspawn();
+
+    std::vector<scene::INodePtr> brushes;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        brushes.push_back(algorithm::createCubicBrush(worldspawn, Vector3(i * 256, 0, 0), "textures/numbers/1"));
+    }
+
+    GlobalMapModule().getRoot()->getUndoSystem().clear();
+
+    constexpr std::size_t NumOperations = 256;
+    std::vector<std::vector<FaceState>> history;
+
+    for (std::size_t level = 0; level < NumOperations; ++level)
+    {
+        history.push_back(getFaceStates(brushes));
+
+        UndoableCommand cmd("operation" + std::to_string(level));
+
+        for (const auto& node : brushes)
+        {
+            auto brush = Node_getIBrush(node);
+
+            switch (level % 4)
+            {
+            case 0: // Nudge the texture of a single face
+                brush->getFace(level % brush->getNumFaces()).shiftTexdef(0.125f, 0);
+                break;
+            case 1: // Change the material of all faces
+                brush->setShader("textures/numbers/" + std::to_string(level % 10));
+                break;
+            case 2: // Move the brush, changes all planes and projections
+            {
+                auto transformable = scene::node_cast<ITransformable>(node);
+                transformable->setTranslation(Vector3(0, 0, 16));
+                transformable->freezeTransform();
+                break;
+            }
+            case 3: // Touch a face without actually changing it
+                brush->getFace(0).setShader(brush->getFace(0).getShader());
+                break;
+            }
+        }
+    }
+
+    auto finalState = getFaceStates(brushes);
+
+    for (std::size_t level = NumOperations; level > 0; --level)
+    {
+        GlobalUndoSystem().undo();
+        expectFaceStates(getFaceStates(brushes), history[level - 1], level - 1);
+    }
+
+    for (std::size_t level = 1; level < NumOperations; ++level)
+    {
+        GlobalUndoSystem().redo();
+        expectFaceStates(getFaceStates(brushes), history[level], level);
+    }
+
+    GlobalUndoSystem().redo();
+    expectFaceStates(getFaceStates(brushes), finalState, NumOperations);
+}
+
+// Reports the memory taken by a full-size undo stack of brush face changes,
+// compared to the size of the face states copied on every operation
+TEST_F(UndoTest, BrushFaceStateHistoryMemory)
+{
+    auto worldspawn = GlobalMapModule().findOrInsertWorldspawn();
+
+    std::vector<scene::INodePtr> brushes;
+
+    for (int i = 0; i < 64; ++i)
+    {
+        brushes.push_back(algorithm::createCubicBrush(worldspawn, Vector3(i * 256, 0, 0), "textures/numbers/1"));
+    }
+
+    // Keep everything in memory, the on-disk part is reported separately
+    registry::setValue("user/ui/undo/memoryBudget", 1024);
+
+    constexpr std::size_t NumOperations = 256;
+
+    std::size_t faceStateSize = 0;
+
+    for (const auto& state : getFaceStates(brushes))
+    {
+        faceStateSize += sizeof(FaceState) + state.material.size();
+    }
+
+    // The same kinds of changes as in BrushFaceStateHistory, -1 is running through all of them
+    auto measureHistory = [&](int kind)
+    {
+        GlobalUndoSystem().clear();
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (std::size_t level = 0; level < NumOperations; ++level)
+        {
+            UndoableCommand cmd("operation" + std::to_string(level));
+
+            for (const auto& node : brushes)
+            {
+                auto brush = Node_getIBrush(node);
+
+                switch (kind < 0 ? level % 4 : kind)
+                {
+                case 0:
+                    brush->getFace(level % brush->getNumFaces()).shiftTexdef(0.125f, 0);
+                    break;
+                case 1:
+                    brush->setShader("textures/numbers/" + std::to_string(level % 10));
+                    break;
+                case 2:
+                {
+                    auto transformable = scene::node_cast<ITransformable>(node);
+                    transformable->setTranslation(Vector3(0, 0, 16));
+                    transformable->freezeTransform();
+                    break;
+                }
+                case 3:
+                    brush->getFace(0).setShader(brush->getFace(0).getShader());
+                    break;
+                }
+            }
+        }
+
+        auto recordTime = std::chrono::steady_clock::now() - start;
+        auto usage = GlobalUndoSystem().getMemoryUsage();
+        auto total = usage.inMemory + usage.onDisk;
+
+        static const char* const names[] = { "texture shift", "material change", "move", "unchanged face" };
+
+        std::cout << (kind < 0 ? "mixed" : names[kind]) << " history of " << NumOperations << " operations: "
+            << usage.inMemory / 1024 << " KB in memory, " << usage.onDisk / 1024 << " KB on disk, "
+            << total / NumOperations << " bytes per operation, recorded in "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(recordTime).count() << " ms" << std::endl;
+
+        return total;
+    };
+
+    std::cout << "Brush face history, " << brushes.size() << " brushes, "
+        << faceStateSize << " bytes of face states per full copy" << std::endl;
+
+    auto mixed = measureHistory(-1);
+    measureHistory(0);
+    measureHistory(1);
+    auto move = measureHistory(2);
+    auto unchanged = measureHistory(3);
+
+    EXPECT_GT(mixed, 0) << "No memory usage reported for the history";
+    EXPECT_LT(mixed, faceStateSize * NumOperations) << "The history is larger than copying all face states";
+    EXPECT_LT(unchanged, move) << "Unchanged faces should share their state with the previous operation";
+}
+
+// Face mementos are shared between operations while the face doesn't change. Compressing an
+// operation must not break the other operations holding the same memento, and a memento whose
+// data has been moved to a compressed operation must not be shared with the next one.
+TEST_F(UndoTest, CompressedBrushFaceStates)
+{
+    auto worldspawn = GlobalMapModule().findOrInsertWorldspawn();
+
+    auto brush = algorithm::createCubicBrush(worldspawn, Vector3(0, 0, 0), "textures/numbers/1");
+    auto other = algorithm::createCubicBrush(worldspawn, Vector3(512, 0, 0), "textures/numbers/1");
+    std::vector<scene::INodePtr> brushes{ brush, other };
+
+    GlobalMapModule().getRoot()->getUndoSystem().clear();
+
+    std::vector<std::vector<FaceState>> history;
+
+    auto runOperation = [&](const scene::INodePtr& node, bool changeFace)
+    {
+        history.push_back(getFaceStates(brushes));
+
+        UndoableCommand cmd("faceOperation");
+        auto& face = Node_getIBrush(node)->getFace(0);
+
+        if (changeFace)
+        {
+            face.shiftTexdef(0.125f, 0);
+        }
+        else
+        {
+            face.setShader(face.getShader());
+        }
+    };
+
+    // The first three operations share the memento of the unchanged face
+    runOperation(brush, false);
+    runOperation(brush, false);
+    runOperation(brush, true);
+
+    // This memento is referenced by a single operation only
+    runOperation(brush, false);
+
+    // Push the operations above out of the uncompressed part of the history
+    for (int i = 0; i < 10; ++i)
+    {
+        runOperation(other, true);
+    }
+
+    // The face is unchanged since the compressed operation above, it needs a new memento
+    runOperation(brush, true);
+    runOperation(brush, true);
+
+    auto finalState = getFaceStates(brushes);
+
+    for (auto level = history.size(); level > 0; --level)
+    {
+        GlobalUndoSystem().undo();
+        expectFaceStates(getFaceStates(brushes), history[level - 1], level - 1);
+    }
+
+    for (std::size_t level = 1; level < history.size(); ++level)
+    {
+        GlobalUndoSystem().redo();
+        expectFaceStates(getFaceStates(brushes), history[level], level);
+    }
+
+    GlobalUndoSystem().redo();
+    expectFaceStates(getFaceStates(brushes), finalState, history.size());
+}
+
+namespace
+{
+
+std::vector<Vector3> getPatchVertices(const std::vector<scene::INodePtr>& patches)
+{
+    std::vector<Vector3> vertices;
+
+    for (const auto& node : patches)
+    {
+        auto patch = Node_getIPatch(node);
+
+        for (std::size_t row = 0; row < patch->getHeight(); ++row)
+        {
+            for (std::size_t col = 0; col < patch->getWidth(); ++col)
+            {
+                vertices.push_back(patch->ctrlAt(row, col).vertex);
+            }
+        }
+    }
+
+    return vertices;
+}
+
+}
+
+// Older operations are compressed and spilled to disk when the history exceeds its memory budget,
+// undo and redo need to bring them back without the caller noticing
+TEST_F(UndoTest, MemoryBoundedHistory)
+{
+    constexpr const char* const RKEY_UNDO_MEMORY_BUDGET = "user/ui/undo/memoryBudget";
+    constexpr std::size_t BudgetMB = 16;
+
+    registry::setValue(RKEY_UNDO_MEMORY_BUDGET, BudgetMB);
+
+    auto worldspawn = GlobalMapModule().findOrInsertWorldspawn();
+    std::vector<scene::INodePtr> patches;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        auto patchNode = algorithm::createPatchFromBounds(worldspawn);
+        auto patch = Node_getIPatch(patchNode);
+        patch->setDims(31, 31);
+
+        for (std::size_t row = 0; row < patch->getHeight(); ++row)
+        {
+            for (std::size_t col = 0; col < patch->getWidth(); ++col)
+            {
+                patch->ctrlAt(row, col).vertex = Vector3(col * 16.0 + i * 512, row * 16.0, std::sin(row * col * 0.1) * 32);
+            }
+        }
+
+        patch->controlPointsChanged();
+        patches.push_back(patchNode);
+    }
+
+    GlobalMapModule().getRoot()->getUndoSystem().clear();
+
+    constexpr std::size_t NumOperations = 200;
+    std::vector<std::vector<Vector3>> history;
+
+    for (std::size_t level = 0; level < NumOperations; ++level)
+    {
+        history.push_back(getPatchVertices(patches));
+
+        UndoableCommand cmd("movePatchVertices");
+
+        for (const auto& node : patches)
+        {
+            auto patch = Node_getIPatch(node);
+            patch->undoSave();
+
+            for (std::size_t row = 0; row < patch->getHeight(); ++row)
+            {
+                for (std::size_t col = 0; col < patch->getWidth(); ++col)
+                {
+                    patch->ctrlAt(row, col).vertex.z() += std::cos(level * 0.3 + row) * 0.5;
+                }
+            }
+
+            patch->controlPointsChanged();
+        }
+    }
+
+    auto finalVertices = getPatchVertices(patches);
+    auto usage = GlobalUndoSystem().getMemoryUsage();
+
+    EXPECT_GT(usage.onDisk, 0) << "Nothing has been moved out of memory";
+    EXPECT_LE(usage.inMemory, BudgetMB * 1024 * 1024) << "Undo history exceeds its memory budget";
+
+    for (std::size_t level = NumOperations; level > 0; --level)
+    {
+        GlobalUndoSystem().undo();
+        EXPECT_EQ(getPatchVertices(patches), history[level - 1]) << "Vertices not restored at level " << (level - 1);
+    }
+
+    EXPECT_EQ(GlobalUndoSystem().getMemoryUsage().onDisk, 0) << "Undone operations should release their data";
+
+    for (std::size_t level = 1; level < NumOperations; ++level)
+    {
+        GlobalUndoSystem().redo();
+        EXPECT_EQ(getPatchVertices(patches), history[level]) << "Vertices not restored at level " << level;
+    }
+
+    GlobalUndoSystem().redo();
+    EXPECT_EQ(getPatchVertices(patches), finalVertices);
+
+    GlobalUndoSystem().clear();
+    EXPECT_EQ(GlobalUndoSystem().getMemoryUsage().inMemory, 0) << "Cleared history should not use memory";
+}
+
+
+namespace
+{
+
+// Memento counting its live instances, to check when the arena memory is released
+class CountingMemento :
+    public IUndoMemento
+{
+private:
+    int _value;
+    std::size_t& _numInstances;
+
+public:
+    CountingMemento(int value, std::size_t& numInstances) :
+        _value(value),
+        _numInstances(numInstances)
+    {
+        ++_numInstances;
+    }
+
+    ~CountingMemento() override
+    {
+        --_numInstances;
+    }
+
+    int getValue() const
+    {
+        return _value;
+    }
+};
+
+// Undoable holding a single value, its mementos are allocated through allocateMemento()
+class CountingUndoable :
+    public IUndoable
+{
+private:
+    int _value;
+    std::size_t& _numMementos;
+    IUndoStateSaver* _undoStateSaver;
+
+    // The last imported memento is kept alive by the undoable
+    IUndoMementoPtr _importedState;
+
+public:
+    CountingUndoable(std::size_t& numMementos) :
+        _value(0),
+        _numMementos(numMementos),
+        _undoStateSaver(GlobalUndoSystem().getStateSaver(*this, nullptr))
+    {}
+
+    ~CountingUndoable() override
+    {
+        GlobalUndoSystem().releaseStateSaver(*this);
+    }
+
+    int getValue() const
+    {
+        return _value;
+    }
+
+    void setValue(int value)
+    {
+        _undoStateSaver->saveState();
+        _value = value;
+    }
+
+    const IUndoMementoPtr& getImportedState() const
+    {
+        return _importedState;
+    }
+
+    void releaseImportedState()
+    {
+        _importedState.reset();
+    }
+
+    IUndoMementoPtr exportState() const override
+    {
+        return undo::allocateMemento<CountingMemento>(_value, _numMementos);
+    }
+
+    void importState(const IUndoMementoPtr& state) override
+    {
+        _undoStateSaver->saveState();
+
+        _importedState = state;
+        _value = std::static_pointer_cast<CountingMemento>(state)->getValue();
+    }
+};
+
+}
+
+TEST(MementoArenaTest, ReleasedWithoutAllocations)
+{
+    auto numArenas = undo::MementoArena::GetNumInstances();
+
+    auto arena = undo::MementoArena::Create();
+    EXPECT_EQ(arena->getReferenceCount(), 1) << "The creator should hold the only reference";
+    EXPECT_EQ(undo::MementoArena::GetNumInstances(), numArenas + 1);
+
+    arena.reset();
+    EXPECT_EQ(undo::MementoArena::GetNumInstances(), numArenas) << "Arena has not been released";
+}
+
+TEST(MementoArenaTest, ReferenceCounting)
+{
+    auto numArenas = undo::MementoArena::GetNumInstances();
+    std::size_t numMementos = 0;
+
+    auto arena = undo::MementoArena::Create();
+    std::vector<std::shared_ptr<CountingMemento>> mementos;
+
+    {
+        undo::ScopedMementoArena scope(*arena);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            mementos.push_back(undo::allocateMemento<CountingMemento>(i, numMementos));
+        }
+    }
+
+    EXPECT_EQ(arena->getReferenceCount(), 4) << "Every memento should hold a reference to the arena";
+    EXPECT_GT(arena->getCapacity(), 0) << "The mementos should be allocated from the arena";
+
+    // Copies of a memento share its control block, they don't add references
+    auto copy = mementos.front();
+    EXPECT_EQ(arena->getReferenceCount(), 4);
+    copy.reset();
+
+    mementos.pop_back();
+    EXPECT_EQ(numMementos, 2);
+    EXPECT_EQ(arena->getReferenceCount(), 3) << "Destroyed memento should give its reference back";
+
+    // Dropping the creator's reference (like the operation does) keeps the arena
+    // alive as long as there are mementos left in it
+    auto* arenaPtr = arena.get();
+    arena.reset();
+
+    EXPECT_EQ(undo::MementoArena::GetNumInstances(), numArenas + 1) << "Arena released while still in use";
+    EXPECT_EQ(arenaPtr->getReferenceCount(), 2);
+    EXPECT_EQ(mementos[0]->getValue(), 0);
+    EXPECT_EQ(mementos[1]->getValue(), 1);
+
+    mementos.clear();
+    EXPECT_EQ(numMementos, 0);
+    EXPECT_EQ(undo::MementoArena::GetNumInstances(), numArenas) << "Arena not released with its last memento";
+}
+
+TEST(MementoArenaTest, AllocationsWithoutActiveArena)
+{
+    std::size_t numMementos = 0;
+    auto numArenas = undo::MementoArena::GetNumInstances();
+
+    EXPECT_EQ(undo::detail::activeArena(), nullptr) << "No arena should be active outside of an operation";
+
+    // Falls back to the heap
+    auto memento = undo::allocateMemento<CountingMemento>(7, numMementos);
+
+    EXPECT_EQ(memento->getValue(), 7);
+    EXPECT_EQ(numMementos, 1);
+    EXPECT_EQ(undo::MementoArena::GetNumInstances(), numArenas) << "No arena should be created on the fly";
+
+    memento.reset();
+    EXPECT_EQ(numMementos, 0);
+}
+
+TEST(MementoArenaTest, NestedScopes)
+{
+    std::size_t numMementos = 0;
+    std::vector<std::shared_ptr<CountingMemento>> mementos;
+
+    auto outer = undo::MementoArena::Create();
+    auto inner = undo::MementoArena::Create();
+
+    {
+        undo::ScopedMementoArena outerScope(*outer);
+        EXPECT_EQ(undo::detail::activeArena(), outer.get());
+
+        mementos.push_back(undo::allocateMemento<CountingMemento>(1, numMementos));
+        EXPECT_EQ(outer->getReferenceCount(), 2);
+
+        {
+            undo::ScopedMementoArena innerScope(*inner);
+            EXPECT_EQ(undo::detail::activeArena(), inner.get());
+
+            mementos.push_back(undo::allocateMemento<CountingMemento>(2, numMementos));
+            EXPECT_EQ(inner->getReferenceCount(), 2) << "Memento should be allocated from the inner arena";
+            EXPECT_EQ(outer->getReferenceCount(), 2) << "Outer arena should not be used in the inner scope";
+        }
+
+        // Leaving the inner scope brings back the outer arena
+        EXPECT_EQ(undo::detail::activeArena(), outer.get());
+
+        mementos.push_back(undo::allocateMemento<CountingMemento>(3, numMementos));
+        EXPECT_EQ(outer->getReferenceCount(), 3);
+        EXPECT_EQ(inner->getReferenceCount(), 2);
+    }
+
+    EXPECT_EQ(undo::detail::activeArena(), nullptr) << "No arena should be active after leaving all scopes";
+
+    mementos.push_back(undo::allocateMemento<CountingMemento>(4, numMementos));
+    EXPECT_EQ(outer->getReferenceCount(), 3) << "Memento should be allocated on the heap";
+    EXPECT_EQ(inner->getReferenceCount(), 2) << "Memento should be allocated on the heap";
+
+    mementos.clear();
+    EXPECT_EQ(outer->getReferenceCount(), 1);
+    EXPECT_EQ(inner->getReferenceCount(), 1);
+}
+
+TEST(MementoArenaTest, ActiveArenaIsThreadLocal)
+{
+    auto arena = undo::MementoArena::Create();
+    undo::ScopedMementoArena scope(*arena);
+
+    std::size_t numMementos = 0;
+    undo::MementoArena* activeArenaOfThread = arena.get();
+
+    std::thread thread([&]()
+    {
+        activeArenaOfThread = undo::detail::activeArena();
+
+        // Allocations of other threads must not touch the arena
+        undo::allocateMemento<CountingMemento>(1, numMementos);
+    });
+    thread.join();
+
+    EXPECT_EQ(activeArenaOfThread, nullptr) << "The arena should only be active on the thread that set it";
+    EXPECT_EQ(arena->getReferenceCount(), 1) << "The other thread allocated from the arena";
+    EXPECT_EQ(undo::detail::activeArena(), arena.get());
+}
+
+// Every operation drops its mementos when it's gone, mementos that are still
+// referenced elsewhere survive the operation
+TEST_F(UndoTest, MementosReleasedWithOperation)
+{
+    std::size_t numMementos = 0;
+    CountingUndoable undoable(numMementos);
+
+    GlobalUndoSystem().clear();
+
+    for (int i = 1; i <= 3; ++i)
+    {
+        UndoableCommand cmd("setValue" + std::to_string(i));
+        undoable.setValue(i);
+    }
+
+    EXPECT_EQ(numMementos, 3) << "Each operation should hold one memento";
+
+    // Undoing records the current state for the redo, the undone operation is dropped
+    GlobalUndoSystem().undo();
+    EXPECT_EQ(undoable.getValue(), 2);
+    ASSERT_TRUE(undoable.getImportedState());
+    EXPECT_EQ(numMementos, 4) << "The redo operation should record the current state";
+
+    // Recording a new operation drops the redo stack, the imported memento stays alive
+    {
+        UndoableCommand cmd("setValue4");
+        undoable.setValue(4);
+    }
+
+    auto importedState = std::static_pointer_cast<CountingMemento>(undoable.getImportedState());
+    EXPECT_EQ(importedState->getValue(), 2);
+
+    GlobalUndoSystem().clear();
+
+    EXPECT_EQ(numMementos, 1) << "Only the memento held by the undoable should be alive";
+    EXPECT_EQ(importedState->getValue(), 2) << "Memento held outside the history should still be valid";
+
+    importedState.reset();
+    undoable.releaseImportedState();
+    EXPECT_EQ(numMementos, 0) << "Last memento should be gone";
+}
+
+// Reports the time needed to record, undo and redo a full undo stack of brush translations
+TEST_F(UndoTest, UndoRedoPerformance)
+{
+    auto worldspawn = GlobalMapModule().findOrInsertWorldspawn();
+
+    std::vector<scene::INodePtr> brushes;
+
+    for (int i = 0; i < 1024; ++i)
+    {
+        brushes.push_back(algorithm::createCubicBrush(worldspawn, Vector3((i % 32) * 256, (i / 32) * 256, 0), "textures/numbers/1"));
+    }
+
+    GlobalUndoSystem().clear();
+
+    constexpr std::size_t NumOperations = 256;
+
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (std::size_t level = 0; level < NumOperations; ++level)
+    {
+        UndoableCommand cmd("translate" + std::to_string(level));
+
+        for (const auto& node : brushes)
+        {
+            auto transformable = scene::node_cast<ITransformable>(node);
+            transformable->setTranslation(Vector3(0, 0, 16));
+            transformable->freezeTransform();
+        }
+    }
+
+    auto recorded = std::chrono::steady_clock::now();
+
+    for (std::size_t level = 0; level < NumOperations; ++level)
+    {
+        GlobalUndoSystem().undo();
+    }
+
+    auto undone = std::chrono::steady_clock::now();
+
+    for (std::size_t level = 0; level < NumOperations; ++level)
+    {
+        GlobalUndoSystem().redo();
+    }
+
+    auto redone = std::chrono::steady_clock::now();
+
+    std::cout << NumOperations << " operations on " << brushes.size() << " brushes: recorded in "
+        << duration_cast<milliseconds>(recorded - start).count() << " ms, undone in "
+        << duration_cast<milliseconds>(undone - recorded).count() << " ms, redone in "
+        << duration_cast<milliseconds>(redone - undone).count() << " ms" << std::endl;
+
+    auto bounds = brushes.front()->worldAABB();
+    EXPECT_NEAR(bounds.getOrigin().z(), NumOperations * 16.0, 0.01) << "Brush not moved back by redo";
+}
+
 }
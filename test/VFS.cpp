@@ -1,9 +1,14 @@
 #include "RadiantTest.h"
 
 #include "ifilesystem.h"
+#include "ideclmanager.h"
 #include "os/path.h"
 #include "os/file.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 namespace test
 {
 
@@ -176,6 +181,92 @@ TEST_F(VfsTest, openArchiveInAbsolutePath)
     ASSERT_NE(contents.find("textures/AFX/AFXmodulate"), std::string::npos);
 }
 
+namespace
+{
+
+std::string readArchiveFile(const ArchiveFilePtr& file)
+{
+    std::string contents;
+    char buffer[4096];
+
+    for (auto bytesRead = file->getInputStream().read(reinterpret_cast<InputStream::byte_type*>(buffer), sizeof(buffer));
+         bytesRead > 0;
+         bytesRead = file->getInputStream().read(reinterpret_cast<InputStream::byte_type*>(buffer), sizeof(buffer)))
+    {
+        contents.append(buffer, bytesRead);
+    }
+
+    return contents;
+}
+
+}
+
+TEST_F(VfsTest, ConcurrentReadsFromArchive)
+{
+    fs::path pk4Path = _context.getTestProjectPath();
+    pk4Path /= "altar.pk4";
+
+    auto archive = GlobalFileSystem().openArchiveInAbsolutePath(pk4Path.string());
+    ASSERT_TRUE(archive) << "Could not open " << pk4Path.string();
+
+    // Collect the contents of every file, read by a single thread
+    std::map<std::string, std::string> expectedContents;
+
+    GlobalFileSystem().forEachFileInArchive(pk4Path.string(), "*", [&](const vfs::FileInfo& fileInfo)
+    {
+        auto file = archive->openFile(fileInfo.name);
+        ASSERT_TRUE(file) << "Could not open " << fileInfo.name;
+
+        expectedContents[fileInfo.name] = readArchiveFile(file);
+        EXPECT_EQ(expectedContents[fileInfo.name].size(), file->size());
+    }, 0);
+
+    ASSERT_FALSE(expectedContents.empty());
+
+    // Let several threads open and read all files of the same archive at once
+    constexpr int NumThreads = 8;
+    constexpr int NumIterations = 50;
+    std::atomic<std::size_t> mismatches(0);
+    std::atomic<std::size_t> bytesRead(0);
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < NumThreads; ++t)
+    {
+        threads.emplace_back([&]()
+        {
+            for (int i = 0; i < NumIterations; ++i)
+            {
+                for (const auto& [name, expected] : expectedContents)
+                {
+                    auto contents = readArchiveFile(archive->openFile(name));
+                    bytesRead += contents.size();
+
+                    if (contents != expected)
+                    {
+                        ++mismatches;
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    EXPECT_EQ(mismatches, 0) << "Concurrent reads returned different contents";
+
+    std::cout << NumThreads << " threads read " << expectedContents.size() * NumThreads * NumIterations
+        << " files (" << bytesRead / 1024 << " KB) from " << pk4Path.filename().string()
+        << " in " << duration.count() << " ms" << std::endl;
+}
+
 TEST_F(VfsTest, VisitEachFileInArchive)
 {
     fs::path pk4Path = _context.getTestProjectPath();
@@ -246,4 +337,95 @@ TEST_F(VfsTest, GetFileInfo)
 
 }
 
+TEST_F(VfsTest, ArchiveLookupIsCaseInsensitive)
+{
+    // This file is located in tdm_example_mtrs.pk4
+    EXPECT_TRUE(GlobalFileSystem().openFile("materials/tdm_bloom_afx.mtr"));
+    EXPECT_TRUE(GlobalFileSystem().openFile("Materials/TDM_Bloom_AFX.mtr"));
+    EXPECT_TRUE(GlobalFileSystem().openTextFile("MATERIALS/tdm_bloom_afx.MTR"));
+    EXPECT_EQ(GlobalFileSystem().getFileCount("materials/TDM_BLOOM_AFX.mtr"), 1);
+}
+
+TEST_F(VfsTest, LookupStatistics)
+{
+    // Other threads might be using the VFS too, only check that the counters increase
+    auto before = GlobalFileSystem().getLookupStatistics();
+
+    // File in a PK4, found through the index
+    EXPECT_TRUE(GlobalFileSystem().openTextFile("materials/tdm_bloom_afx.mtr"));
+    EXPECT_GT(GlobalFileSystem().getLookupStatistics().indexHits, before.indexHits);
+
+    // Loose file
+    EXPECT_TRUE(GlobalFileSystem().openTextFile("materials/example.mtr"));
+    EXPECT_GT(GlobalFileSystem().getLookupStatistics().directoryHits, before.directoryHits);
+
+    // Missing file
+    EXPECT_FALSE(GlobalFileSystem().openFile("materials/___NONEXISTENTFILE.mtr"));
+    EXPECT_GT(GlobalFileSystem().getLookupStatistics().misses, before.misses);
+}
+
+namespace
+{
+
+// Snapshot of the VFS contents and the material sources, to compare startup runs
+std::map<std::string, std::string> captureStartupState()
+{
+    std::map<std::string, std::string> state;
+
+    GlobalFileSystem().forEachFile("", "*", [&](const vfs::FileInfo& fileInfo)
+    {
+        state["file:" + fileInfo.fullPath()] = fileInfo.getArchivePath() + " " + std::to_string(fileInfo.getSize());
+    }, 0);
+
+    GlobalDeclarationManager().foreachDeclaration(decl::Type::Material, [&](const decl::IDeclaration::Ptr& decl)
+    {
+        const auto& source = decl->getDeclSource();
+        state["material:" + decl->getDeclName()] = source.fileInfo.fullPath() + " " + source.modName + " " + source.contents;
+    });
+
+    return state;
+}
+
+// Re-initialises the VFS with its current search paths, which re-parses all declarations
+std::chrono::milliseconds reinitialiseFileSystem()
+{
+    auto searchPaths = GlobalFileSystem().getVfsSearchPaths();
+    auto extensions = GlobalFileSystem().getArchiveExtensions();
+
+    auto start = std::chrono::steady_clock::now();
+
+    GlobalFileSystem().shutdown();
+    GlobalFileSystem().initialise(searchPaths, extensions);
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+}
+
+}
+
+TEST_F(VfsTest, StartupCache)
+{
+    // Wait for the initial parsers, the VFS can't be shut down while they're running
+    GlobalDeclarationManager().reloadDeclarations();
+
+    auto cacheFolder = _context.getCacheDataPath() + "startupcache/";
+    auto expectedState = captureStartupState();
+    ASSERT_FALSE(expectedState.empty());
+
+    // Start without any cache files, this run is writing them
+    fs::remove_all(cacheFolder);
+
+    auto uncachedTime = reinitialiseFileSystem();
+
+    EXPECT_TRUE(fs::exists(cacheFolder + "vfs.cache")) << "Zip directory cache has not been written";
+    EXPECT_EQ(captureStartupState(), expectedState) << "Startup without cache produced different results";
+
+    // Second run is reading the zip directories and decl blocks from the cache
+    auto cachedTime = reinitialiseFileSystem();
+
+    EXPECT_EQ(captureStartupState(), expectedState) << "Startup with cache produced different results";
+
+    std::cout << "VFS and declaration startup took " << uncachedTime.count() << " ms without cache, "
+        << cachedTime.count() << " ms with cache" << std::endl;
+}
+
 }